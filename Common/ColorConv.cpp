@@ -29,6 +29,11 @@
 #include <smmintrin.h>
 #endif
 
+// Only where NEON is always there, since ARMv7 builds leave it to the NEON file and a runtime check.
+#if PPSSPP_ARCH(ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 inline u16 RGBA8888toRGB565(u32 px) {
 	return ((px >> 3) & 0x001F) | ((px >> 5) & 0x07E0) | ((px >> 8) & 0xF800);
 }
@@ -635,6 +640,224 @@ void ConvertRGB565ToBGR565Basic(u16 *dst, const u16 *src, u32 numPixels) {
 	}
 }
 
+// Video frames use BT.601 at MPEG range (Y 16-235, UV 16-240.)  Everything is done with 6 bits of
+// fraction, and any part of a factor below 1 is applied as a 16-bit multiply high of a value shifted
+// up by 7, which is exactly what the SIMD paths do, so all paths give the same result.
+enum {
+	YUV_Y_FRAC = 5387,  // 1.164383 - 1
+	YUV_RV_FRAC = 19531,  // 1.596027 - 1
+	YUV_GU = 12837,  // 0.391762
+	YUV_GV = 26639,  // 0.812968
+	YUV_BU_FRAC = 565,  // 2.017232 - 2
+};
+
+static inline int YUVMulHi(int a, int c) {
+	return (a * c) >> 16;
+}
+
+static inline u8 YUVClamp(int c) {
+	return c < 0 ? 0 : (c > 255 ? 255 : c);
+}
+
+static inline void YUVToRGB(const u8 *y, const u8 *u, const u8 *v, u32 x, u8 &r, u8 &g, u8 &b) {
+	const int yc = y[x] - 16;
+	const int uc = u[x >> 1] - 128;
+	const int vc = v[x >> 1] - 128;
+
+	const int y64 = yc * 64 + YUVMulHi(yc * 128, YUV_Y_FRAC) + 32;
+	const int rc = vc * 64 + YUVMulHi(vc * 128, YUV_RV_FRAC);
+	const int gc = YUVMulHi(uc * 128, YUV_GU) + YUVMulHi(vc * 128, YUV_GV);
+	const int bc = uc * 128 + YUVMulHi(uc * 128, YUV_BU_FRAC);
+
+	r = YUVClamp((y64 + rc) >> 6);
+	g = YUVClamp((y64 - gc) >> 6);
+	b = YUVClamp((y64 + bc) >> 6);
+}
+
+#ifdef _M_SSE
+// Converts 16 pixels starting at an even x, to 16 bytes of each of R, G, and B.
+static inline void YUVToRGB16_SSE2(const u8 *y, const u8 *u, const u8 *v, u32 x, __m128i &r, __m128i &g, __m128i &b) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i ys = _mm_loadu_si128((const __m128i *)(y + x));
+	const __m128i us = _mm_loadl_epi64((const __m128i *)(u + (x >> 1)));
+	const __m128i vs = _mm_loadl_epi64((const __m128i *)(v + (x >> 1)));
+
+	const __m128i y16 = _mm_set1_epi16(16);
+	const __m128i c128 = _mm_set1_epi16(128);
+	const __m128i ylo = _mm_slli_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(ys, zero), y16), 6);
+	const __m128i yhi = _mm_slli_epi16(_mm_sub_epi16(_mm_unpackhi_epi8(ys, zero), y16), 6);
+	const __m128i u7 = _mm_slli_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(us, zero), c128), 7);
+	const __m128i v7 = _mm_slli_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(vs, zero), c128), 7);
+
+	const __m128i round = _mm_set1_epi16(32);
+	const __m128i yfrac = _mm_set1_epi16(YUV_Y_FRAC);
+	const __m128i y64lo = _mm_add_epi16(_mm_add_epi16(ylo, _mm_mulhi_epi16(_mm_add_epi16(ylo, ylo), yfrac)), round);
+	const __m128i y64hi = _mm_add_epi16(_mm_add_epi16(yhi, _mm_mulhi_epi16(_mm_add_epi16(yhi, yhi), yfrac)), round);
+
+	// These are per chroma sample, so each covers two pixels.
+	const __m128i rc = _mm_add_epi16(_mm_srai_epi16(v7, 1), _mm_mulhi_epi16(v7, _mm_set1_epi16(YUV_RV_FRAC)));
+	const __m128i gc = _mm_add_epi16(_mm_mulhi_epi16(u7, _mm_set1_epi16(YUV_GU)), _mm_mulhi_epi16(v7, _mm_set1_epi16(YUV_GV)));
+	const __m128i bc = _mm_add_epi16(u7, _mm_mulhi_epi16(u7, _mm_set1_epi16(YUV_BU_FRAC)));
+
+	// Blue can go past 16 bits for bright pixels, but it'd be clamped to 255 anyway.
+	r = _mm_packus_epi16(
+		_mm_srai_epi16(_mm_adds_epi16(y64lo, _mm_unpacklo_epi16(rc, rc)), 6),
+		_mm_srai_epi16(_mm_adds_epi16(y64hi, _mm_unpackhi_epi16(rc, rc)), 6));
+	g = _mm_packus_epi16(
+		_mm_srai_epi16(_mm_subs_epi16(y64lo, _mm_unpacklo_epi16(gc, gc)), 6),
+		_mm_srai_epi16(_mm_subs_epi16(y64hi, _mm_unpackhi_epi16(gc, gc)), 6));
+	b = _mm_packus_epi16(
+		_mm_srai_epi16(_mm_adds_epi16(y64lo, _mm_unpacklo_epi16(bc, bc)), 6),
+		_mm_srai_epi16(_mm_adds_epi16(y64hi, _mm_unpackhi_epi16(bc, bc)), 6));
+}
+
+// Packs 8 pixels of 8-bit R, G, B (in the low half) into 16-bit lanes, dropping the low bits of each.
+template <int rbits, int gbits, int bbits>
+static inline __m128i YUVPack16_SSE2(__m128i r, __m128i g, __m128i b) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i r16 = _mm_srli_epi16(_mm_unpacklo_epi8(r, zero), 8 - rbits);
+	const __m128i g16 = _mm_slli_epi16(_mm_srli_epi16(_mm_unpacklo_epi8(g, zero), 8 - gbits), rbits);
+	const __m128i b16 = _mm_slli_epi16(_mm_srli_epi16(_mm_unpacklo_epi8(b, zero), 8 - bbits), rbits + gbits);
+	return _mm_or_si128(_mm_or_si128(r16, g16), b16);
+}
+#elif PPSSPP_ARCH(ARM_NEON)
+static inline int16x8_t YUVMulHi_NEON(int16x8_t a, int16_t c) {
+	return vcombine_s16(vshrn_n_s32(vmull_n_s16(vget_low_s16(a), c), 16), vshrn_n_s32(vmull_n_s16(vget_high_s16(a), c), 16));
+}
+
+static inline uint8x16_t YUVCombine_NEON(int16x8_t y64lo, int16x8_t y64hi, int16x8x2_t c, bool sub) {
+	int16x8_t lo = sub ? vqsubq_s16(y64lo, c.val[0]) : vqaddq_s16(y64lo, c.val[0]);
+	int16x8_t hi = sub ? vqsubq_s16(y64hi, c.val[1]) : vqaddq_s16(y64hi, c.val[1]);
+	return vcombine_u8(vqmovun_s16(vshrq_n_s16(lo, 6)), vqmovun_s16(vshrq_n_s16(hi, 6)));
+}
+
+// Converts 16 pixels starting at an even x, to 16 bytes of each of R, G, and B.
+static inline void YUVToRGB16_NEON(const u8 *y, const u8 *u, const u8 *v, u32 x, uint8x16_t &r, uint8x16_t &g, uint8x16_t &b) {
+	const uint8x16_t ys = vld1q_u8(y + x);
+	const int16x8_t us = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(u + (x >> 1))));
+	const int16x8_t vs = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(v + (x >> 1))));
+
+	const int16x8_t ylo = vshlq_n_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(ys))), vdupq_n_s16(16)), 6);
+	const int16x8_t yhi = vshlq_n_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(ys))), vdupq_n_s16(16)), 6);
+	const int16x8_t u7 = vshlq_n_s16(vsubq_s16(us, vdupq_n_s16(128)), 7);
+	const int16x8_t v7 = vshlq_n_s16(vsubq_s16(vs, vdupq_n_s16(128)), 7);
+
+	const int16x8_t round = vdupq_n_s16(32);
+	const int16x8_t y64lo = vaddq_s16(vaddq_s16(ylo, YUVMulHi_NEON(vaddq_s16(ylo, ylo), YUV_Y_FRAC)), round);
+	const int16x8_t y64hi = vaddq_s16(vaddq_s16(yhi, YUVMulHi_NEON(vaddq_s16(yhi, yhi), YUV_Y_FRAC)), round);
+
+	// These are per chroma sample, so each covers two pixels.
+	const int16x8_t rc = vaddq_s16(vshrq_n_s16(v7, 1), YUVMulHi_NEON(v7, YUV_RV_FRAC));
+	const int16x8_t gc = vaddq_s16(YUVMulHi_NEON(u7, YUV_GU), YUVMulHi_NEON(v7, YUV_GV));
+	const int16x8_t bc = vaddq_s16(u7, YUVMulHi_NEON(u7, YUV_BU_FRAC));
+
+	// Blue can go past 16 bits for bright pixels, but it'd be clamped to 255 anyway.
+	r = YUVCombine_NEON(y64lo, y64hi, vzipq_s16(rc, rc), false);
+	g = YUVCombine_NEON(y64lo, y64hi, vzipq_s16(gc, gc), true);
+	b = YUVCombine_NEON(y64lo, y64hi, vzipq_s16(bc, bc), false);
+}
+
+// Packs 8 pixels of 8-bit R, G, B into 16-bit lanes, dropping the low bits of each.
+template <int rbits, int gbits, int bbits>
+static inline uint16x8_t YUVPack16_NEON(uint8x8_t r, uint8x8_t g, uint8x8_t b) {
+	const uint16x8_t r16 = vshrq_n_u16(vmovl_u8(r), 8 - rbits);
+	const uint16x8_t g16 = vshlq_n_u16(vshrq_n_u16(vmovl_u8(g), 8 - gbits), rbits);
+	const uint16x8_t b16 = vshlq_n_u16(vshrq_n_u16(vmovl_u8(b), 8 - bbits), rbits + gbits);
+	return vorrq_u16(vorrq_u16(r16, g16), b16);
+}
+#endif
+
+void ConvertYUV420ToRGBA8888(u32 *dst, const u8 *y, const u8 *u, const u8 *v, u32 x, u32 numPixels) {
+	u8 r, g, b;
+	u32 i = 0;
+	// SIMD needs to start on a pair sharing a chroma sample.
+	if ((x & 1) && numPixels != 0) {
+		YUVToRGB(y, u, v, x, r, g, b);
+		dst[0] = r | (g << 8) | (b << 16);
+		i = 1;
+	}
+
+#ifdef _M_SSE
+	const __m128i zero = _mm_setzero_si128();
+	for (; i + 16 <= numPixels; i += 16) {
+		__m128i r16, g16, b16;
+		YUVToRGB16_SSE2(y, u, v, x + i, r16, g16, b16);
+		const __m128i rglo = _mm_unpacklo_epi8(r16, g16);
+		const __m128i rghi = _mm_unpackhi_epi8(r16, g16);
+		const __m128i b0lo = _mm_unpacklo_epi8(b16, zero);
+		const __m128i b0hi = _mm_unpackhi_epi8(b16, zero);
+		__m128i *dstp = (__m128i *)(dst + i);
+		_mm_storeu_si128(dstp + 0, _mm_unpacklo_epi16(rglo, b0lo));
+		_mm_storeu_si128(dstp + 1, _mm_unpackhi_epi16(rglo, b0lo));
+		_mm_storeu_si128(dstp + 2, _mm_unpacklo_epi16(rghi, b0hi));
+		_mm_storeu_si128(dstp + 3, _mm_unpackhi_epi16(rghi, b0hi));
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	for (; i + 16 <= numPixels; i += 16) {
+		uint8x16x4_t rgba;
+		YUVToRGB16_NEON(y, u, v, x + i, rgba.val[0], rgba.val[1], rgba.val[2]);
+		rgba.val[3] = vdupq_n_u8(0);
+		vst4q_u8((u8 *)(dst + i), rgba);
+	}
+#endif
+
+	for (; i < numPixels; ++i) {
+		YUVToRGB(y, u, v, x + i, r, g, b);
+		dst[i] = r | (g << 8) | (b << 16);
+	}
+}
+
+template <int rbits, int gbits, int bbits>
+static inline u16 YUVPack16(u8 r, u8 g, u8 b) {
+	return (r >> (8 - rbits)) | ((g >> (8 - gbits)) << rbits) | ((b >> (8 - bbits)) << (rbits + gbits));
+}
+
+template <int rbits, int gbits, int bbits>
+static void ConvertYUV420To16(u16 *dst, const u8 *y, const u8 *u, const u8 *v, u32 x, u32 numPixels) {
+	u8 r, g, b;
+	u32 i = 0;
+	// SIMD needs to start on a pair sharing a chroma sample.
+	if ((x & 1) && numPixels != 0) {
+		YUVToRGB(y, u, v, x, r, g, b);
+		dst[0] = YUVPack16<rbits, gbits, bbits>(r, g, b);
+		i = 1;
+	}
+
+#ifdef _M_SSE
+	for (; i + 16 <= numPixels; i += 16) {
+		__m128i r16, g16, b16;
+		YUVToRGB16_SSE2(y, u, v, x + i, r16, g16, b16);
+		__m128i *dstp = (__m128i *)(dst + i);
+		_mm_storeu_si128(dstp + 0, YUVPack16_SSE2<rbits, gbits, bbits>(r16, g16, b16));
+		_mm_storeu_si128(dstp + 1, YUVPack16_SSE2<rbits, gbits, bbits>(_mm_srli_si128(r16, 8), _mm_srli_si128(g16, 8), _mm_srli_si128(b16, 8)));
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	for (; i + 16 <= numPixels; i += 16) {
+		uint8x16_t r16, g16, b16;
+		YUVToRGB16_NEON(y, u, v, x + i, r16, g16, b16);
+		vst1q_u16(dst + i, YUVPack16_NEON<rbits, gbits, bbits>(vget_low_u8(r16), vget_low_u8(g16), vget_low_u8(b16)));
+		vst1q_u16(dst + i + 8, YUVPack16_NEON<rbits, gbits, bbits>(vget_high_u8(r16), vget_high_u8(g16), vget_high_u8(b16)));
+	}
+#endif
+
+	for (; i < numPixels; ++i) {
+		YUVToRGB(y, u, v, x + i, r, g, b);
+		dst[i] = YUVPack16<rbits, gbits, bbits>(r, g, b);
+	}
+}
+
+void ConvertYUV420ToRGB565(u16 *dst, const u8 *y, const u8 *u, const u8 *v, u32 x, u32 numPixels) {
+	ConvertYUV420To16<5, 6, 5>(dst, y, u, v, x, numPixels);
+}
+
+void ConvertYUV420ToRGBA5551(u16 *dst, const u8 *y, const u8 *u, const u8 *v, u32 x, u32 numPixels) {
+	ConvertYUV420To16<5, 5, 5>(dst, y, u, v, x, numPixels);
+}
+
+void ConvertYUV420ToRGBA4444(u16 *dst, const u8 *y, const u8 *u, const u8 *v, u32 x, u32 numPixels) {
+	ConvertYUV420To16<4, 4, 4>(dst, y, u, v, x, numPixels);
+}
+
 // Reuse the logic from the header - if these aren't defined, we need externs.
 #ifndef ConvertRGBA4444ToABGR4444
 Convert16bppTo16bppFunc ConvertRGBA4444ToABGR4444 = &ConvertRGBA4444ToABGR4444Basic;
@@ -139,6 +139,13 @@ void ConvertRGBA4444ToABGR4444Basic(u16 *dst, const u16 *src, u32 numPixels);
 void ConvertRGBA5551ToABGR1555Basic(u16 *dst, const u16 *src, u32 numPixels);
 void ConvertRGB565ToBGR565Basic(u16 *dst, const u16 *src, u32 numPixels);
 
+// Video (BT.601, MPEG range) planar YUV 4:2:0 rows, where u and v are at half width.
+// Converts numPixels starting at pixel x of the row into dst[0], with alpha left at zero.
+void ConvertYUV420ToRGBA8888(u32 *dst, const u8 *y, const u8 *u, const u8 *v, u32 x, u32 numPixels);
+void ConvertYUV420ToRGB565(u16 *dst, const u8 *y, const u8 *u, const u8 *v, u32 x, u32 numPixels);
+void ConvertYUV420ToRGBA5551(u16 *dst, const u8 *y, const u8 *u, const u8 *v, u32 x, u32 numPixels);
+void ConvertYUV420ToRGBA4444(u16 *dst, const u8 *y, const u8 *u, const u8 *v, u32 x, u32 numPixels);
+
 #if PPSSPP_ARCH(ARM64)
 #define ConvertRGBA4444ToABGR4444 ConvertRGBA4444ToABGR4444NEON
 #elif !PPSSPP_ARCH(ARM)
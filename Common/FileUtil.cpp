@@ -40,6 +40,7 @@
 #include <dirent.h>
 #include <errno.h>
 #include <stdlib.h>
+#include <utime.h>
 #endif
 
 #if defined(__DragonFly__) || defined(__FreeBSD__) || defined(__FreeBSD_kernel__)
@@ -475,6 +476,23 @@ bool GetModifTime(const std::string &filename, tm &return_time) {
 	}
 }
 
+bool TouchFile(const std::string &filename) {
+#if PPSSPP_PLATFORM(UWP)
+	return false;
+#elif defined(_WIN32)
+	HANDLE handle = CreateFile(ConvertUTF8ToWString(filename).c_str(), FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (handle == INVALID_HANDLE_VALUE)
+		return false;
+	FILETIME now;
+	GetSystemTimeAsFileTime(&now);
+	bool success = SetFileTime(handle, nullptr, nullptr, &now) != 0;
+	CloseHandle(handle);
+	return success;
+#else
+	return utime(filename.c_str(), nullptr) == 0;
+#endif
+}
+
 std::string GetDir(const std::string &path) {
 	if (path == "/")
 		return path;
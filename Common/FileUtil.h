@@ -76,6 +76,9 @@ std::string GetFilename(std::string path);
 // Returns struct with modification date of file
 bool GetModifTime(const std::string &filename, tm &return_time);
 
+// Sets the modification date of an existing file to now, returns true on success
+bool TouchFile(const std::string &filename);
+
 // Returns the size of filename (64bit)
 u64 GetFileSize(const std::string &filename);
 
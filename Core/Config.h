@@ -135,6 +135,7 @@ struct Config {
 	// Definitely cannot be changed while game is running.
 	bool bSeparateCPUThread;
 	bool bSeparateSASThread;
+	bool bParallelSASVoices;
 	bool bSeparateIOThread;
 	int iIOTimingMethod;
 	int iLockedCPUSpeed;
@@ -158,6 +159,7 @@ struct Config {
 	// GFX
 	int iGPUBackend;
 	bool bSoftwareRendering;
+	bool bSoftwareRenderingThread;  // Run software GE commands on their own thread.
 	bool bHardwareTransform; // only used in the GLES backend
 	bool bSoftwareSkinning;  // may speed up some games
 
@@ -197,9 +199,13 @@ struct Config {
 	bool bTrueColor;
 	bool bReplaceTextures;
 	bool bSaveNewTextures;
+	bool bReplaceTexturesDecodedCache;  // Keep decoded replacement PNGs on disk to skip decoding next time.
+	int iReplaceTexturesMemoryMB;  // Budget for decoded replacements kept in memory.
 	int iTexScalingLevel; // 1 = off, 2 = 2x, ..., 5 = 5x
 	int iTexScalingType; // 0 = xBRZ, 1 = Hybrid
 	bool bTexDeposterize;
+	bool bTexScalingCache;  // Keep scaled textures on disk to skip scaling them next time.
+	int iTexScalingCacheMB;  // Disk budget for the above.
 	int iFpsLimit;
 	int iForceMaxEmulatedFPS;
 	int iMaxRecent;
@@ -433,10 +433,7 @@ void DirectoryFileHandle::Close()
 }
 
 void DirectoryFileSystem::CloseAll() {
-	for (auto iter = entries.begin(); iter != entries.end(); ++iter) {
-		iter->second.hFile.Close();
-	}
-
+	std::lock_guard<std::mutex> guard(entriesLock);
 	entries.clear();
 }
 
@@ -583,9 +580,9 @@ bool DirectoryFileSystem::RemoveFile(const std::string &filename) {
 }
 
 u32 DirectoryFileSystem::OpenFile(std::string filename, FileAccess access, const char *devicename) {
-	OpenFileEntry entry;
+	std::shared_ptr<OpenFileEntry> entry = std::make_shared<OpenFileEntry>();
 	u32 err = 0;
-	bool success = entry.hFile.Open(basePath, filename, access, err);
+	bool success = entry->hFile.Open(basePath, filename, access, err);
 
 	if (!success) {
 #ifdef _WIN32
@@ -598,14 +595,15 @@ u32 DirectoryFileSystem::OpenFile(std::string filename, FileAccess access, const
 	} else {
 #ifdef _WIN32
 		if (access & FILEACCESS_APPEND)
-			entry.hFile.Seek(0,FILEMOVE_END);
+			entry->hFile.Seek(0,FILEMOVE_END);
 #endif
 
 		u32 newHandle = hAlloc->GetNewHandle();
 
-		entry.guestFilename = filename;
-		entry.access = access;
+		entry->guestFilename = filename;
+		entry->access = access;
 
+		std::lock_guard<std::mutex> guard(entriesLock);
 		entries[newHandle] = entry;
 
 		return newHandle;
@@ -613,10 +611,10 @@ u32 DirectoryFileSystem::OpenFile(std::string filename, FileAccess access, const
 }
 
 void DirectoryFileSystem::CloseFile(u32 handle) {
+	std::lock_guard<std::mutex> guard(entriesLock);
 	EntryMap::iterator iter = entries.find(handle);
 	if (iter != entries.end()) {
 		hAlloc->FreeHandle(handle);
-		iter->second.hFile.Close();
 		entries.erase(iter);
 	} else {
 		//This shouldn't happen...
@@ -625,10 +623,19 @@ void DirectoryFileSystem::CloseFile(u32 handle) {
 }
 
 bool DirectoryFileSystem::OwnsHandle(u32 handle) {
+	std::lock_guard<std::mutex> guard(entriesLock);
 	EntryMap::iterator iter = entries.find(handle);
 	return (iter != entries.end());
 }
 
+std::shared_ptr<DirectoryFileSystem::OpenFileEntry> DirectoryFileSystem::GetEntry(u32 handle) {
+	std::lock_guard<std::mutex> guard(entriesLock);
+	EntryMap::iterator iter = entries.find(handle);
+	if (iter != entries.end())
+		return iter->second;
+	return nullptr;
+}
+
 int DirectoryFileSystem::Ioctl(u32 handle, u32 cmd, u32 indataPtr, u32 inlen, u32 outdataPtr, u32 outlen, int &usec) {
 	return SCE_KERNEL_ERROR_ERRNO_FUNCTION_NOT_SUPPORTED;
 }
@@ -643,14 +650,14 @@ size_t DirectoryFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size) {
 }
 
 size_t DirectoryFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size, int &usec) {
-	EntryMap::iterator iter = entries.find(handle);
-	if (iter != entries.end()) {
+	std::shared_ptr<OpenFileEntry> entry = GetEntry(handle);
+	if (entry) {
 		if (size < 0) {
-			ERROR_LOG_REPORT(FILESYS, "Invalid read for %lld bytes from disk %s", size, iter->second.guestFilename.c_str());
+			ERROR_LOG_REPORT(FILESYS, "Invalid read for %lld bytes from disk %s", size, entry->guestFilename.c_str());
 			return 0;
 		}
 
-		size_t bytesRead = iter->second.hFile.Read(pointer,size);
+		size_t bytesRead = entry->hFile.Read(pointer,size);
 		return bytesRead;
 	} else {
 		//This shouldn't happen...
@@ -665,10 +672,10 @@ size_t DirectoryFileSystem::WriteFile(u32 handle, const u8 *pointer, s64 size) {
 }
 
 size_t DirectoryFileSystem::WriteFile(u32 handle, const u8 *pointer, s64 size, int &usec) {
-	EntryMap::iterator iter = entries.find(handle);
-	if (iter != entries.end())
+	std::shared_ptr<OpenFileEntry> entry = GetEntry(handle);
+	if (entry)
 	{
-		size_t bytesWritten = iter->second.hFile.Write(pointer,size);
+		size_t bytesWritten = entry->hFile.Write(pointer,size);
 		return bytesWritten;
 	} else {
 		//This shouldn't happen...
@@ -678,9 +685,9 @@ size_t DirectoryFileSystem::WriteFile(u32 handle, const u8 *pointer, s64 size, i
 }
 
 size_t DirectoryFileSystem::SeekFile(u32 handle, s32 position, FileMove type) {
-	EntryMap::iterator iter = entries.find(handle);
-	if (iter != entries.end()) {
-		return iter->second.hFile.Seek(position,type);
+	std::shared_ptr<OpenFileEntry> entry = GetEntry(handle);
+	if (entry) {
+		return entry->hFile.Seek(position,type);
 	} else {
 		//This shouldn't happen...
 		ERROR_LOG(FILESYS,"Cannot seek in file that hasn't been opened: %08x", handle);
@@ -917,42 +924,49 @@ void DirectoryFileSystem::DoState(PointerWrap &p) {
 	//     u32               seek position
 	//     s64               current truncate position (v2+ only)
 
-	u32 num = (u32) entries.size();
+	u32 num;
+	{
+		std::lock_guard<std::mutex> guard(entriesLock);
+		num = (u32) entries.size();
+	}
 	p.Do(num);
 
 	if (p.mode == p.MODE_READ) {
 		CloseAll();
 		u32 key;
-		OpenFileEntry entry;
 		for (u32 i = 0; i < num; i++) {
+			std::shared_ptr<OpenFileEntry> entry = std::make_shared<OpenFileEntry>();
 			p.Do(key);
-			p.Do(entry.guestFilename);
-			p.Do(entry.access);
+			p.Do(entry->guestFilename);
+			p.Do(entry->access);
 			u32 err;
-			if (!entry.hFile.Open(basePath,entry.guestFilename,entry.access, err)) {
-				ERROR_LOG(FILESYS, "Failed to reopen file while loading state: %s", entry.guestFilename.c_str());
+			if (!entry->hFile.Open(basePath,entry->guestFilename,entry->access, err)) {
+				ERROR_LOG(FILESYS, "Failed to reopen file while loading state: %s", entry->guestFilename.c_str());
 				continue;
 			}
 			u32 position;
 			p.Do(position);
-			if (position != entry.hFile.Seek(position, FILEMOVE_BEGIN)) {
-				ERROR_LOG(FILESYS, "Failed to restore seek position while loading state: %s", entry.guestFilename.c_str());
+			if (position != entry->hFile.Seek(position, FILEMOVE_BEGIN)) {
+				ERROR_LOG(FILESYS, "Failed to restore seek position while loading state: %s", entry->guestFilename.c_str());
 				continue;
 			}
 			if (s >= 2) {
-				p.Do(entry.hFile.needsTrunc_);
+				p.Do(entry->hFile.needsTrunc_);
 			}
+			std::lock_guard<std::mutex> guard(entriesLock);
 			entries[key] = entry;
 		}
 	} else {
+		std::lock_guard<std::mutex> guard(entriesLock);
 		for (auto iter = entries.begin(); iter != entries.end(); ++iter) {
 			u32 key = iter->first;
+			OpenFileEntry &entry = *iter->second;
 			p.Do(key);
-			p.Do(iter->second.guestFilename);
-			p.Do(iter->second.access);
-			u32 position = (u32)iter->second.hFile.Seek(0, FILEMOVE_CURRENT);
+			p.Do(entry.guestFilename);
+			p.Do(entry.access);
+			u32 position = (u32)entry.hFile.Seek(0, FILEMOVE_CURRENT);
 			p.Do(position);
-			p.Do(iter->second.hFile.needsTrunc_);
+			p.Do(entry.hFile.needsTrunc_);
 		}
 	}
 }
@@ -20,6 +20,8 @@
 // TODO: Remove the Windows-specific code, FILE is fine there too.
 
 #include <map>
+#include <memory>
+#include <mutex>
 
 #include "../Core/FileSystems/FileSystem.h"
 
@@ -110,7 +112,7 @@ class DirectoryFileSystem : public IFileSystem {
 	int  RenameFile(const std::string &from, const std::string &to) override;
 	bool RemoveFile(const std::string &filename) override;
 	bool GetHostPath(const std::string &inpath, std::string &outpath) override;
-	int Flags() override { return flags; }
+	int Flags() override { return flags | FILESYSTEM_ASYNC_SAFE_IO; }
 	u64 FreeSpace(const std::string &path) override;
 
 private:
@@ -118,10 +120,19 @@ class DirectoryFileSystem : public IFileSystem {
 		DirectoryFileHandle hFile;
 		std::string guestFilename;
 		FileAccess access;
+
+		// An I/O worker may still be using it after CloseFile(), so it's closed when the last reference goes.
+		~OpenFileEntry() {
+			hFile.Close();
+		}
 	};
 
-	typedef std::map<u32, OpenFileEntry> EntryMap;
+	std::shared_ptr<OpenFileEntry> GetEntry(u32 handle);
+
+	typedef std::map<u32, std::shared_ptr<OpenFileEntry>> EntryMap;
 	EntryMap entries;
+	// Guards entries, since I/O workers may be looking up handles. Hold a reference, not the lock, while doing I/O.
+	std::mutex entriesLock;
 	std::string basePath;
 	IHandleAllocator *hAlloc;
 	int flags;
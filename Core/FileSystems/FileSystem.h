@@ -52,6 +52,8 @@ enum DevType {
 
 enum FileSystemFlags {
 	FILESYSTEM_SIMULATE_FAT32 = 1,
+	// ReadFile/WriteFile may run on an I/O worker concurrently with other handles.
+	FILESYSTEM_ASYNC_SAFE_IO = 2,
 };
 
 class IHandleAllocator {
@@ -572,8 +572,14 @@ size_t MetaFileSystem::WriteFile(u32 handle, const u8 *pointer, s64 size)
 
 size_t MetaFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size, int &usec)
 {
-	std::lock_guard<std::recursive_mutex> guard(lock);
-	IFileSystem *sys = GetHandleOwner(handle);
+	IFileSystem *sys;
+	{
+		std::lock_guard<std::recursive_mutex> guard(lock);
+		sys = GetHandleOwner(handle);
+		if (sys && !(sys->Flags() & FILESYSTEM_ASYNC_SAFE_IO))
+			return sys->ReadFile(handle, pointer, size, usec);
+	}
+	// This lets I/O workers overlap reads on different handles.
 	if (sys)
 		return sys->ReadFile(handle, pointer, size, usec);
 	else
@@ -582,8 +588,13 @@ size_t MetaFileSystem::ReadFile(u32 handle, u8 *pointer, s64 size, int &usec)
 
 size_t MetaFileSystem::WriteFile(u32 handle, const u8 *pointer, s64 size, int &usec)
 {
-	std::lock_guard<std::recursive_mutex> guard(lock);
-	IFileSystem *sys = GetHandleOwner(handle);
+	IFileSystem *sys;
+	{
+		std::lock_guard<std::recursive_mutex> guard(lock);
+		sys = GetHandleOwner(handle);
+		if (sys && !(sys->Flags() & FILESYSTEM_ASYNC_SAFE_IO))
+			return sys->WriteFile(handle, pointer, size, usec);
+	}
 	if (sys)
 		return sys->WriteFile(handle, pointer, size, usec);
 	else
@@ -15,9 +15,11 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
 #include <atomic>
 #include <mutex>
 
+#include "base/timeutil.h"
 #include "Common/CommonTypes.h"
 #include "Common/ChunkFile.h"
 #include "Common/FixedSizeQueue.h"
@@ -46,6 +48,16 @@
 StereoResampler resampler;
 AudioDebugStats g_AudioDebugStats;
 
+// About 6 seconds of host blocks.
+static const int AUDIO_PROFILE_HISTORY = 512;
+std::atomic<bool> g_AudioProfiling;
+// Nanoseconds, added to from whatever thread does the work.
+static std::atomic<uint32_t> profileAccum[(int)AudioProfileStage::COUNT];
+static std::mutex profileLock;
+static AudioProfileFrame profileHistory[AUDIO_PROFILE_HISTORY];
+static int profileHistoryPos;
+static int profileHistoryCount;
+
 // Should be used to lock anything related to the outAudioQueue.
 // atomic locks are used on the lock. TODO: make this lock-free
 std::atomic_flag atomicLock_;
@@ -87,8 +99,25 @@ static void hleAudioUpdate(u64 userdata, int cyclesLate) {
 	__AudioUpdate();
 }
 
+static void EndAudioProfileFrame() {
+	if (!g_AudioProfiling.load(std::memory_order_relaxed))
+		return;
+
+	AudioProfileFrame frame;
+	frame.samples = hostAttemptBlockSize;
+	for (int i = 0; i < (int)AudioProfileStage::COUNT; ++i)
+		frame.us[i] = profileAccum[i].exchange(0, std::memory_order_relaxed) * 0.001f;
+
+	std::lock_guard<std::mutex> guard(profileLock);
+	profileHistory[profileHistoryPos] = frame;
+	profileHistoryPos = (profileHistoryPos + 1) % AUDIO_PROFILE_HISTORY;
+	if (profileHistoryCount < AUDIO_PROFILE_HISTORY)
+		profileHistoryCount++;
+}
+
 static void hleHostAudioUpdate(u64 userdata, int cyclesLate) {
 	CoreTiming::ScheduleEvent(audioHostIntervalCycles - cyclesLate, eventHostAudioUpdate, 0);
+	EndAudioProfileFrame();
 
 	// Not all hosts need this call to poke their audio system once in a while, but those that don't
 	// can just ignore it.
@@ -103,6 +132,13 @@ static void __AudioCPUMHzChange() {
 
 void __AudioInit() {
 	memset(&g_AudioDebugStats, 0, sizeof(g_AudioDebugStats));
+	for (int i = 0; i < (int)AudioProfileStage::COUNT; ++i)
+		profileAccum[i] = 0;
+	{
+		std::lock_guard<std::mutex> guard(profileLock);
+		profileHistoryPos = 0;
+		profileHistoryCount = 0;
+	}
 	mixFrequency = 44100;
 
 	switch (g_Config.iAudioLatency) {
@@ -329,6 +365,8 @@ void __AudioSetOutputFrequency(int freq) {
 // This single sample queue is where __AudioMix should read from. If the sample queue is full, we should
 // just sleep the main emulator thread a little.
 void __AudioUpdate() {
+	AudioProfileScope profile(AudioProfileStage::OUTPUT_MIX);
+
 	// Audio throttle doesn't really work on the PSP since the mixing intervals are so closely tied
 	// to the CPU. Much better to throttle the frame rate on frame display and just throw away audio
 	// if the buffer somehow gets full.
@@ -406,6 +444,7 @@ void __AudioUpdate() {
 // numFrames is number of stereo frames.
 // This is called from *outside* the emulator thread.
 int __AudioMix(short *outstereo, int numFrames, int sampleRate) {
+	AudioProfileScope profile(AudioProfileStage::RESAMPLE);
 	return resampler.Mix(outstereo, numFrames, false, sampleRate);
 }
 
@@ -414,6 +453,39 @@ const AudioDebugStats *__AudioGetDebugStats() {
 	return &g_AudioDebugStats;
 }
 
+void AudioProfileScope::Begin() {
+	start_ = real_time_now();
+}
+
+void AudioProfileScope::End() {
+	const double ns = (real_time_now() - start_) * 1000000000.0;
+	profileAccum[(int)stage_].fetch_add((uint32_t)ns, std::memory_order_relaxed);
+}
+
+void __AudioSetProfiling(bool enabled) {
+	g_AudioProfiling.store(enabled, std::memory_order_relaxed);
+}
+
+int __AudioGetProfileHistory(AudioProfileFrame *frames, int maxFrames) {
+	std::lock_guard<std::mutex> guard(profileLock);
+	const int count = std::min(maxFrames, profileHistoryCount);
+	const int first = profileHistoryPos - count + AUDIO_PROFILE_HISTORY;
+	for (int i = 0; i < count; ++i)
+		frames[i] = profileHistory[(first + i) % AUDIO_PROFILE_HISTORY];
+	return count;
+}
+
+const char *__AudioProfileStageName(AudioProfileStage stage) {
+	switch (stage) {
+	case AudioProfileStage::SAS_VOICES: return "SAS voices";
+	case AudioProfileStage::SAS_REVERB: return "SAS reverb";
+	case AudioProfileStage::DECODE: return "Decode";
+	case AudioProfileStage::OUTPUT_MIX: return "Output mix";
+	case AudioProfileStage::RESAMPLE: return "Resample";
+	default: return "?";
+	}
+}
+
 void __PushExternalAudio(const s32 *audio, int numSamples) {
 	if (audio) {
 		resampler.PushSamples(audio, numSamples);
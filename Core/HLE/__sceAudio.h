@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <atomic>
+
 #include "sceAudio.h"
 
 struct AudioDebugStats {
@@ -27,6 +29,50 @@ struct AudioDebugStats {
 	int overrunCount;
 	int instantSampleRate;
 	int lastPushSize;
+	int latencyMs;
+	int drift;
+};
+
+enum class AudioProfileStage {
+	SAS_VOICES,
+	SAS_REVERB,
+	DECODE,
+	OUTPUT_MIX,
+	RESAMPLE,
+
+	COUNT,
+};
+
+// Real time spent in each stage while the emulator produced one host block of audio.
+// Stages can nest, decoding for a SAS ATRAC voice also counts as SAS voices.
+struct AudioProfileFrame {
+	int samples;
+	float us[(int)AudioProfileStage::COUNT];
+};
+
+// Only set while something shows or saves the profile, see __AudioSetProfiling().
+extern std::atomic<bool> g_AudioProfiling;
+
+// Adds the time until it goes out of scope to the current profile frame. Works from any thread.
+// When profiling is off, this is just one relaxed load.
+class AudioProfileScope {
+public:
+	explicit AudioProfileScope(AudioProfileStage stage) : stage_(stage), active_(g_AudioProfiling.load(std::memory_order_relaxed)) {
+		if (active_)
+			Begin();
+	}
+	~AudioProfileScope() {
+		if (active_)
+			End();
+	}
+
+private:
+	void Begin();
+	void End();
+
+	AudioProfileStage stage_;
+	bool active_;
+	double start_;
 };
 
 // Easy interface for sceAudio to write to, to keep the complexity in check.
@@ -44,6 +90,11 @@ void __AudioWakeThreads(AudioChannel &chan, int result);
 
 int __AudioMix(short *outstereo, int numSamples, int sampleRate);
 const AudioDebugStats *__AudioGetDebugStats();
+// For --audio-profile and the audio debug overlay. Nothing is recorded while off.
+void __AudioSetProfiling(bool enabled);
+// Copies up to maxFrames of the most recent profile frames, oldest first, and returns how many.
+int __AudioGetProfileHistory(AudioProfileFrame *frames, int maxFrames);
+const char *__AudioProfileStageName(AudioProfileStage stage);
 void __PushExternalAudio(const s32 *audio, int numSamples);  // Should not be used in-game, only at the menu!
 
 // Audio Dumping stuff
@@ -16,7 +16,12 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
 
+#include "thread/threadutil.h"
 #include "Core/HLE/HLE.h"
 #include "Core/HLE/FunctionWrappers.h"
 #include "Core/MIPS/MIPS.h"
@@ -29,6 +34,7 @@
 #include "Core/HW/BufferQueue.h"
 #include "Common/ChunkFile.h"
 
+#include "Core/HLE/__sceAudio.h"
 #include "Core/HLE/sceKernel.h"
 #include "Core/HLE/sceUtility.h"
 #include "Core/HLE/sceKernelMemory.h"
@@ -59,6 +65,9 @@
 // Most files will be in RIFF format.  It's also possible to load in an OMA/AA3 format file, but
 // ultimately this will share the same buffer - it's just offset a bit more.
 //
+// When all the data is loaded (state 2), the whole track is decoded on a thread from the start and
+// kept as PCM (see AtracDecodeAhead), so sceAtracDecodeData only copies it, even after looping.
+//
 // Low level decoding doesn't use the buffer, and decodes only a single packet at a time.
 //
 // Lastly, sceSas has some integration with sceAtrac, which allows setting an Atrac id as
@@ -154,6 +163,54 @@ struct Atrac;
 int __AtracSetContext(Atrac *atrac);
 void _AtracGenerateContext(Atrac *atrac, SceAtracId *context);
 
+#ifdef USE_FFMPEG
+// Decodes a track that's entirely in memory on a thread, one frame after another from the start,
+// and keeps all of the converted PCM so that loops just replay it.
+class AtracDecodeAhead {
+public:
+	AtracDecodeAhead(const Atrac *atrac, const u8 *data);
+	~AtracDecodeAhead();
+
+	bool IsValid() const {
+		return thread_ != nullptr;
+	}
+	// Waits for the frame at this file offset to be decoded, and points to its samples if there were any.
+	AtracDecodeResult GetFrame(u32 offset, const s16 **samples, int *numSamples);
+
+	// How much memory the PCM for a track would take.
+	static u64 CacheSize(const Atrac *atrac);
+
+private:
+	struct Frame {
+		AtracDecodeResult result;
+		int numSamples;
+	};
+
+	void Run();
+
+	std::vector<u8> data_;
+	std::vector<s16> pcm_;
+	std::vector<Frame> frames_;
+	u32 dataOff_;
+	u32 bytesPerFrame_;
+	u32 samplesPerFrame_;
+	int outputChannels_;
+	size_t size_;
+
+	AVCodecContext *codecCtx_ = nullptr;
+	SwrContext *swrCtx_ = nullptr;
+	AVFrame *frame_ = nullptr;
+	AVPacket *packet_ = nullptr;
+
+	std::thread *thread_ = nullptr;
+	std::mutex lock_;
+	std::condition_variable decoded_;
+	// Guarded by lock_.
+	int framesDone_ = 0;
+	bool stop_ = false;
+};
+#endif // USE_FFMPEG
+
 struct AtracLoopInfo {
 	int cuePointID;
 	int type;
@@ -195,6 +252,7 @@ struct Atrac {
 
 	void ResetData() {
 #ifdef USE_FFMPEG
+		StopDecodeAhead();
 		ReleaseFFMPEGContext();
 #endif // USE_FFMPEG
 
@@ -236,6 +294,13 @@ struct Atrac {
 		if (!s)
 			return;
 
+#ifdef USE_FFMPEG
+		if (p.mode == p.MODE_READ) {
+			// This will start again from the new data on the next decode.
+			StopDecodeAhead();
+		}
+#endif // USE_FFMPEG
+
 		p.Do(channels_);
 		p.Do(outputChannels_);
 		if (s >= 5) {
@@ -438,6 +503,18 @@ struct Atrac {
 	SwrContext      *swrCtx_ = nullptr;
 	AVFrame         *frame_ = nullptr;
 	AVPacket        *packet_ = nullptr;
+
+	// Decodes the whole track, when it's all loaded.  Then codecCtx_ is left alone.
+	AtracDecodeAhead *decodeAhead_ = nullptr;
+	// File offset of the packet from FillPacket(), and what decodeAhead_ had for it.
+	u32 packetOffset_ = 0;
+	const s16 *cachedSamples_ = nullptr;
+	int cachedNumSamples_ = 0;
+	// codecCtx_ missed frames that came from decodeAhead_, and needs to be primed again.
+	bool codecStale_ = false;
+
+	void StartDecodeAhead();
+	void StopDecodeAhead();
 #endif // USE_FFMPEG
 
 #ifdef USE_FFMPEG
@@ -492,9 +569,10 @@ struct Atrac {
 		const u32 unalignedSamples = (offsetSamples + sample) % SamplesPerFrame();
 		int seekFrame = sample + offsetSamples - unalignedSamples;
 
-		if ((sample != currentSample_ || sample == 0) && codecCtx_ != nullptr) {
+		if ((sample != currentSample_ || sample == 0 || codecStale_) && codecCtx_ != nullptr && !decodeAhead_) {
 			// Prefill the decode buffer with packets before the first sample offset.
 			avcodec_flush_buffers(codecCtx_);
+			codecStale_ = false;
 
 			int adjust = 0;
 			if (sample == 0) {
@@ -523,6 +601,7 @@ struct Atrac {
 		u32 off = FileOffsetBySample(currentSample_ + adjust);
 		if (off < first_.size) {
 #ifdef USE_FFMPEG
+			packetOffset_ = off;
 			av_init_packet(packet_);
 			packet_->data = BufferStart() + off;
 			packet_->size = std::min((u32)bytesPerFrame_, first_.size - off);
@@ -539,6 +618,8 @@ struct Atrac {
 
 	bool FillLowLevelPacket(u8 *ptr) {
 #ifdef USE_FFMPEG
+		// The game feeds the decoder itself now.
+		StopDecodeAhead();
 		av_init_packet(packet_);
 
 		packet_->data = ptr;
@@ -550,10 +631,17 @@ struct Atrac {
 
 	AtracDecodeResult DecodePacket() {
 #ifdef USE_FFMPEG
+		if (decodeAhead_) {
+			AtracDecodeResult res = decodeAhead_->GetFrame(packetOffset_, &cachedSamples_, &cachedNumSamples_);
+			if (res == ATDECODE_FAILED)
+				failedDecode_ = true;
+			return res;
+		}
 		if (codecCtx_ == nullptr) {
 			return ATDECODE_FAILED;
 		}
 
+		AudioProfileScope profile(AudioProfileStage::DECODE);
 		int got_frame = 0;
 		int bytes_read = avcodec_decode_audio4(codecCtx_, frame_, &got_frame, packet_);
 #if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(57, 12, 100)
@@ -1179,6 +1267,10 @@ u32 _AtracDecodeData(int atracID, u8 *outbuf, u32 outbufPtr, u32 *SamplesNum, u3
 			}
 
 			if (!atrac->failedDecode_ && (atrac->codecType_ == PSP_MODE_AT_3 || atrac->codecType_ == PSP_MODE_AT_3_PLUS)) {
+#ifdef USE_FFMPEG
+				// The game may have changed the state, or finished loading the data.
+				atrac->StartDecodeAhead();
+#endif // USE_FFMPEG
 				atrac->SeekToSample(atrac->currentSample_);
 
 				AtracDecodeResult res = ATDECODE_FEEDME;
@@ -1193,9 +1285,10 @@ u32 _AtracDecodeData(int atracID, u8 *outbuf, u32 outbufPtr, u32 *SamplesNum, u3
 					if (res == ATDECODE_GOTFRAME) {
 #ifdef USE_FFMPEG
 						// got a frame
-						int skipped = std::min(skipSamples, atrac->frame_->nb_samples);
+						int frameSamples = atrac->decodeAhead_ ? atrac->cachedNumSamples_ : atrac->frame_->nb_samples;
+						int skipped = std::min(skipSamples, frameSamples);
 						skipSamples -= skipped;
-						numSamples = atrac->frame_->nb_samples - skipped;
+						numSamples = frameSamples - skipped;
 
 						// If we're at the end, clamp to samples we want.  It always returns a full chunk.
 						numSamples = std::min(maxSamples, numSamples);
@@ -1205,7 +1298,14 @@ u32 _AtracDecodeData(int atracID, u8 *outbuf, u32 outbufPtr, u32 *SamplesNum, u3
 							res = ATDECODE_FEEDME;
 						}
 
-						if (outbuf != NULL && numSamples != 0) {
+						if (outbuf != NULL && numSamples != 0 && atrac->decodeAhead_) {
+							// Already converted, so just copy.
+							u32 outBytes = numSamples * atrac->outputChannels_ * sizeof(s16);
+							memcpy(outbuf, atrac->cachedSamples_ + skipped * atrac->outputChannels_, outBytes);
+							if (outbufPtr != 0) {
+								CBreakPoints::ExecMemCheck(outbufPtr, true, outBytes, currentMIPS->pc);
+							}
+						} else if (outbuf != NULL && numSamples != 0) {
 							int inbufOffset = 0;
 							if (skipped != 0) {
 								AVSampleFormat fmt = (AVSampleFormat)atrac->frame_->format;
@@ -1752,91 +1852,269 @@ static u32 sceAtracResetPlayPosition(int atracID, int sample, int bytesWrittenFi
 }
 
 #ifdef USE_FFMPEG
-static int __AtracUpdateOutputMode(Atrac *atrac, int wanted_channels) {
-	if (atrac->swrCtx_ && atrac->outputChannels_ == wanted_channels)
-		return 0;
-	atrac->outputChannels_ = wanted_channels;
+static AVCodecContext *__AtracOpenDecoder(const Atrac *atrac, int *error) {
+	AVCodecID ff_codec;
+	if (atrac->codecType_ == PSP_MODE_AT_3) {
+		ff_codec = AV_CODEC_ID_ATRAC3;
+	} else if (atrac->codecType_ == PSP_MODE_AT_3_PLUS) {
+		ff_codec = AV_CODEC_ID_ATRAC3P;
+	} else {
+		*error = hleReportError(ME, ATRAC_ERROR_UNKNOWN_FORMAT, "unknown codec type in set context");
+		return nullptr;
+	}
+
+	const AVCodec *codec = avcodec_find_decoder(ff_codec);
+	AVCodecContext *codecCtx = avcodec_alloc_context3(codec);
+
+	if (atrac->codecType_ == PSP_MODE_AT_3) {
+		// For ATRAC3, we need the "extradata" in the RIFF header.
+		codecCtx->extradata = (uint8_t *)av_mallocz(14);
+		codecCtx->extradata_size = 14;
+
+		// We don't pull this from the RIFF so that we can support OMA also.
+		// The only thing that changes are the jointStereo_ values.
+		codecCtx->extradata[0] = 1;
+		codecCtx->extradata[3] = atrac->channels_ << 3;
+		codecCtx->extradata[6] = atrac->jointStereo_;
+		codecCtx->extradata[8] = atrac->jointStereo_;
+		codecCtx->extradata[10] = 1;
+	}
+
+	// Appears we need to force mono in some cases. (See CPkmn's comments in issue #4248)
+	if (atrac->channels_ == 1) {
+		codecCtx->channels = 1;
+		codecCtx->channel_layout = AV_CH_LAYOUT_MONO;
+	} else if (atrac->channels_ == 2) {
+		codecCtx->channels = 2;
+		codecCtx->channel_layout = AV_CH_LAYOUT_STEREO;
+	} else {
+		*error = hleReportError(ME, ATRAC_ERROR_UNKNOWN_FORMAT, "unknown channel layout in set context");
+		return codecCtx;
+	}
+
+	// Explicitly set the block_align value (needed by newer FFmpeg versions, see #5772.)
+	if (codecCtx->block_align == 0) {
+		codecCtx->block_align = atrac->bytesPerFrame_;
+	}
+	// Only one supported, it seems?
+	codecCtx->sample_rate = 44100;
+
+	codecCtx->request_sample_fmt = AV_SAMPLE_FMT_S16;
+	int ret;
+	if ((ret = avcodec_open2(codecCtx, codec, nullptr)) < 0) {
+		// This can mean that the frame size is wrong or etc.
+		*error = hleLogError(ME, ATRAC_ERROR_BAD_CODEC_PARAMS, "failed to open decoder %d", ret);
+		return codecCtx;
+	}
+
+	*error = 0;
+	return codecCtx;
+}
+
+static int __AtracCreateResampler(SwrContext **swrCtx, const AVCodecContext *codecCtx, int channels, int wanted_channels) {
 	int64_t wanted_channel_layout = av_get_default_channel_layout(wanted_channels);
-	int64_t dec_channel_layout = av_get_default_channel_layout(atrac->channels_);
+	int64_t dec_channel_layout = av_get_default_channel_layout(channels);
 
-	atrac->swrCtx_ =
+	*swrCtx =
 		swr_alloc_set_opts
 		(
-			atrac->swrCtx_,
+			*swrCtx,
 			wanted_channel_layout,
 			AV_SAMPLE_FMT_S16,
-			atrac->codecCtx_->sample_rate,
+			codecCtx->sample_rate,
 			dec_channel_layout,
-			atrac->codecCtx_->sample_fmt,
-			atrac->codecCtx_->sample_rate,
+			codecCtx->sample_fmt,
+			codecCtx->sample_rate,
 			0,
 			NULL
 		);
-	if (!atrac->swrCtx_) {
+	if (!*swrCtx) {
 		ERROR_LOG(ME, "swr_alloc_set_opts: Could not allocate resampler context");
 		return -1;
 	}
-	if (swr_init(atrac->swrCtx_) < 0) {
+	if (swr_init(*swrCtx) < 0) {
 		ERROR_LOG(ME, "swr_init: Failed to initialize the resampling context");
 		return -1;
 	}
 	return 0;
 }
-#endif // USE_FFMPEG
 
-int __AtracSetContext(Atrac *atrac) {
-#ifdef USE_FFMPEG
-	InitFFmpeg();
+static int __AtracUpdateOutputMode(Atrac *atrac, int wanted_channels) {
+	if (atrac->swrCtx_ && atrac->outputChannels_ == wanted_channels)
+		return 0;
+	atrac->outputChannels_ = wanted_channels;
+	// Whatever it decoded is in the old format.
+	atrac->StopDecodeAhead();
 
-	AVCodecID ff_codec;
-	if (atrac->codecType_ == PSP_MODE_AT_3) {
-		ff_codec = AV_CODEC_ID_ATRAC3;
-	} else if (atrac->codecType_ == PSP_MODE_AT_3_PLUS) {
-		ff_codec = AV_CODEC_ID_ATRAC3P;
-	} else {
-		return hleReportError(ME, ATRAC_ERROR_UNKNOWN_FORMAT, "unknown codec type in set context");
+	return __AtracCreateResampler(&atrac->swrCtx_, atrac->codecCtx_, atrac->channels_, wanted_channels);
+}
+
+// The PCM for every fully loaded track, together, is kept below this.
+static const u64 ATRAC_DECODE_AHEAD_MAX_BYTES = 48 * 1024 * 1024;
+static u64 atracDecodeAheadBytes = 0;
+
+u64 AtracDecodeAhead::CacheSize(const Atrac *atrac) {
+	u64 frames = (atrac->first_.filesize - atrac->dataOff_ + atrac->bytesPerFrame_ - 1) / atrac->bytesPerFrame_;
+	return frames * atrac->SamplesPerFrame() * atrac->outputChannels_ * sizeof(s16) + atrac->first_.filesize;
+}
+
+AtracDecodeAhead::AtracDecodeAhead(const Atrac *atrac, const u8 *data)
+	: data_(data, data + atrac->first_.filesize), dataOff_(atrac->dataOff_), bytesPerFrame_(atrac->bytesPerFrame_),
+	  samplesPerFrame_(atrac->SamplesPerFrame()), outputChannels_(atrac->outputChannels_), size_((size_t)CacheSize(atrac)) {
+	int error = 0;
+	codecCtx_ = __AtracOpenDecoder(atrac, &error);
+	if (error == 0)
+		error = __AtracCreateResampler(&swrCtx_, codecCtx_, atrac->channels_, outputChannels_);
+	frame_ = av_frame_alloc();
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(57, 12, 100)
+	packet_ = av_packet_alloc();
+#else
+	packet_ = new AVPacket;
+	av_init_packet(packet_);
+#endif
+
+	atracDecodeAheadBytes += size_;
+	if (error != 0) {
+		return;
 	}
 
-	const AVCodec *codec = avcodec_find_decoder(ff_codec);
-	atrac->codecCtx_ = avcodec_alloc_context3(codec);
+	frames_.resize((data_.size() - dataOff_ + bytesPerFrame_ - 1) / bytesPerFrame_);
+	pcm_.resize(frames_.size() * samplesPerFrame_ * outputChannels_);
+	thread_ = new std::thread([this] {
+		Run();
+	});
+}
 
-	if (atrac->codecType_ == PSP_MODE_AT_3) {
-		// For ATRAC3, we need the "extradata" in the RIFF header.
-		atrac->codecCtx_->extradata = (uint8_t *)av_mallocz(14);
-		atrac->codecCtx_->extradata_size = 14;
+AtracDecodeAhead::~AtracDecodeAhead() {
+	if (thread_) {
+		{
+			std::lock_guard<std::mutex> guard(lock_);
+			stop_ = true;
+		}
+		thread_->join();
+		delete thread_;
+	}
+	atracDecodeAheadBytes -= size_;
 
-		// We don't pull this from the RIFF so that we can support OMA also.
-		// The only thing that changes are the jointStereo_ values.
-		atrac->codecCtx_->extradata[0] = 1;
-		atrac->codecCtx_->extradata[3] = atrac->channels_ << 3;
-		atrac->codecCtx_->extradata[6] = atrac->jointStereo_;
-		atrac->codecCtx_->extradata[8] = atrac->jointStereo_;
-		atrac->codecCtx_->extradata[10] = 1;
+	av_frame_free(&frame_);
+	swr_free(&swrCtx_);
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(55, 52, 0)
+	avcodec_free_context(&codecCtx_);
+#else
+	avcodec_close(codecCtx_);
+	av_freep(&codecCtx_);
+#endif
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(57, 12, 100)
+	av_packet_free(&packet_);
+#else
+	delete packet_;
+#endif
+}
+
+void AtracDecodeAhead::Run() {
+	setCurrentThreadName("AtracDecode");
+
+	// Straight through, the same as the emu thread would decode the track the first time.
+	for (size_t i = 0; i < frames_.size(); ++i) {
+		const u32 off = dataOff_ + (u32)i * bytesPerFrame_;
+		av_init_packet(packet_);
+		packet_->data = &data_[off];
+		packet_->size = std::min(bytesPerFrame_, (u32)data_.size() - off);
+		packet_->pos = off;
+
+		AudioProfileScope profile(AudioProfileStage::DECODE);
+		Frame decoded = { ATDECODE_FEEDME, 0 };
+		int got_frame = 0;
+		int bytes_read = avcodec_decode_audio4(codecCtx_, frame_, &got_frame, packet_);
+		if (bytes_read == AVERROR_PATCHWELCOME) {
+			ERROR_LOG(ME, "Unsupported feature in ATRAC audio.");
+			decoded.result = ATDECODE_BADFRAME;
+		} else if (bytes_read < 0) {
+			ERROR_LOG_REPORT(ME, "avcodec_decode_audio4: Error decoding audio %d / %08x", bytes_read, bytes_read);
+			decoded.result = ATDECODE_FAILED;
+		} else if (got_frame) {
+			decoded.result = ATDECODE_GOTFRAME;
+			decoded.numSamples = std::min(frame_->nb_samples, (int)samplesPerFrame_);
+			u8 *out = (u8 *)&pcm_[i * samplesPerFrame_ * outputChannels_];
+			int avret = swr_convert(swrCtx_, &out, decoded.numSamples, (const u8 **)frame_->extended_data, decoded.numSamples);
+			if (avret < 0) {
+				ERROR_LOG(ME, "swr_convert: Error while converting %d", avret);
+			}
+		}
+
+		std::lock_guard<std::mutex> guard(lock_);
+		frames_[i] = decoded;
+		framesDone_ = (int)i + 1;
+		if (decoded.result == ATDECODE_FAILED) {
+			// The game won't get any further than this, same as without decoding ahead.
+			for (size_t j = i + 1; j < frames_.size(); ++j)
+				frames_[j] = decoded;
+			framesDone_ = (int)frames_.size();
+		}
+		decoded_.notify_all();
+		if (stop_ || decoded.result == ATDECODE_FAILED)
+			break;
 	}
+}
 
-	// Appears we need to force mono in some cases. (See CPkmn's comments in issue #4248)
-	if (atrac->channels_ == 1) {
-		atrac->codecCtx_->channels = 1;
-		atrac->codecCtx_->channel_layout = AV_CH_LAYOUT_MONO;
-	} else if (atrac->channels_ == 2) {
-		atrac->codecCtx_->channels = 2;
-		atrac->codecCtx_->channel_layout = AV_CH_LAYOUT_STEREO;
-	} else {
-		return hleReportError(ME, ATRAC_ERROR_UNKNOWN_FORMAT, "unknown channel layout in set context");
+AtracDecodeResult AtracDecodeAhead::GetFrame(u32 offset, const s16 **samples, int *numSamples) {
+	if (offset < dataOff_ || offset >= data_.size()) {
+		return ATDECODE_BADFRAME;
 	}
+	const int index = (offset - dataOff_) / bytesPerFrame_;
 
-	// Explicitly set the block_align value (needed by newer FFmpeg versions, see #5772.)
-	if (atrac->codecCtx_->block_align == 0) {
-		atrac->codecCtx_->block_align = atrac->bytesPerFrame_;
+	std::unique_lock<std::mutex> guard(lock_);
+	while (framesDone_ <= index)
+		decoded_.wait(guard);
+
+	*samples = &pcm_[index * samplesPerFrame_ * outputChannels_];
+	*numSamples = frames_[index].numSamples;
+	return frames_[index].result;
+}
+
+void Atrac::StartDecodeAhead() {
+	bool wanted = bufferState_ == ATRAC_STATUS_ALL_DATA_LOADED && first_.size >= first_.filesize;
+	wanted = wanted && codecCtx_ != nullptr && swrCtx_ != nullptr && !failedDecode_;
+	wanted = wanted && bytesPerFrame_ != 0 && (u32)dataOff_ < first_.filesize;
+	if (!wanted) {
+		StopDecodeAhead();
+		return;
+	}
+	if (decodeAhead_) {
+		return;
 	}
-	// Only one supported, it seems?
-	atrac->codecCtx_->sample_rate = 44100;
 
-	atrac->codecCtx_->request_sample_fmt = AV_SAMPLE_FMT_S16;
+	// The game could change the buffer later, so the thread gets a copy.
+	if (ignoreDataBuf_ && !Memory::IsValidRange(first_.addr, first_.filesize)) {
+		return;
+	}
+	if (atracDecodeAheadBytes + AtracDecodeAhead::CacheSize(this) > ATRAC_DECODE_AHEAD_MAX_BYTES) {
+		return;
+	}
+	decodeAhead_ = new AtracDecodeAhead(this, BufferStart());
+	if (!decodeAhead_->IsValid()) {
+		StopDecodeAhead();
+	}
+}
+
+void Atrac::StopDecodeAhead() {
+	if (decodeAhead_) {
+		delete decodeAhead_;
+		decodeAhead_ = nullptr;
+		codecStale_ = true;
+	}
+}
+#endif // USE_FFMPEG
+
+int __AtracSetContext(Atrac *atrac) {
+#ifdef USE_FFMPEG
+	InitFFmpeg();
+
 	int ret;
-	if ((ret = avcodec_open2(atrac->codecCtx_, codec, nullptr)) < 0) {
-		// This can mean that the frame size is wrong or etc.
-		return hleLogError(ME, ATRAC_ERROR_BAD_CODEC_PARAMS, "failed to open decoder %d", ret);
+	atrac->codecCtx_ = __AtracOpenDecoder(atrac, &ret);
+	if (ret < 0) {
+		// Already logged.
+		return ret;
 	}
 
 	if ((ret = __AtracUpdateOutputMode(atrac, atrac->outputChannels_)) < 0)
@@ -1906,6 +2184,10 @@ static int _AtracSetData(Atrac *atrac, u32 buffer, u32 readSize, u32 bufferSize,
 		// Already logged.
 		return ret;
 	}
+#ifdef USE_FFMPEG
+	// If it's all there already, get a head start.
+	atrac->StartDecodeAhead();
+#endif // USE_FFMPEG
 
 	return hleLogSuccessInfoI(ME, successCode, "%s %s audio", codecName, channelName);
 }
@@ -133,6 +133,8 @@ static std::thread *ioManagerThread;
 // TODO: Is it better to just put all on the thread?
 // Let's try. (was 256)
 const int IO_THREAD_MIN_DATA_SIZE = 0;
+// Host reads and writes on different files overlap across this many workers.
+const int IO_THREAD_WORKERS = 4;
 
 #define SCE_STM_FDIR 0x1000
 #define SCE_STM_FREG 0x2000
@@ -590,6 +592,7 @@ void __IoInit() {
 		Core_ListenShutdown(&__IoWakeManager);
 		ioManagerThread = new std::thread(&__IoManagerThread);
 		ioManagerThread->detach();
+		ioManager.StartWorkers(IO_THREAD_WORKERS);
 	}
 
 	__KernelRegisterWaitTypeFuncs(WAITTYPE_ASYNCIO, __IoAsyncBeginCallback, __IoAsyncEndCallback);
@@ -34,6 +34,7 @@
 #include "Core/Reporting.h"
 #include "Core/SaveState.h"
 #include "Core/System.h"
+#include "Core/HW/SasAudio.h"
 #include "GPU/GPUInterface.h"
 #include "GPU/GPUState.h"
 
@@ -361,8 +362,10 @@ int sceKernelDcacheInvalidateRange(u32 addr, int size)
 		if ((addr % 64) != 0 || (size % 64) != 0)
 			return SCE_KERNEL_ERROR_CACHE_ALIGNMENT;
 
-		if (addr != 0)
+		if (addr != 0) {
 			gpu->InvalidateCache(addr, size, GPU_INVALIDATE_HINT);
+			VagCache_Invalidate(addr, size);
+		}
 	}
 	hleEatCycles(190);
 	return 0;
@@ -397,6 +400,7 @@ int sceKernelDcacheWritebackRange(u32 addr, int size)
 
 	if (size > 0 && addr != 0) {
 		gpu->InvalidateCache(addr, size, GPU_INVALIDATE_HINT);
+		VagCache_Invalidate(addr, size);
 	}
 	hleEatCycles(165);
 	return 0;
@@ -412,6 +416,7 @@ int sceKernelDcacheWritebackInvalidateRange(u32 addr, int size)
 
 	if (size > 0 && addr != 0) {
 		gpu->InvalidateCache(addr, size, GPU_INVALIDATE_HINT);
+		VagCache_Invalidate(addr, size);
 	}
 	hleEatCycles(165);
 	return 0;
@@ -1107,6 +1107,7 @@ static u32 sceMpegAvcDecode(u32 mpeg, u32 auAddr, u32 frameWidth, u32 bufferAddr
 		while (pmp_queue.size() != 0){
 			// playing all pmp_queue frames
 			ctx->mediaengine->m_pFrameRGB = pmp_queue.front();
+			ctx->mediaengine->m_directFrame = false;
 			int bufferSize = ctx->mediaengine->writeVideoImage(buffer, frameWidth, ctx->videoPixelMode);
 			gpu->NotifyVideoUpload(buffer, bufferSize, frameWidth, ctx->videoPixelMode);
 			ctx->avc.avcFrameStatus = 1;
@@ -1434,7 +1435,8 @@ void PostPutAction::run(MipsCall &call) {
 	// It seems validation is done only by older mpeg libs.
 	if (mpegLibVersion < 0x0105 && packetsAdded > 0) {
 		// TODO: Faster / less wasteful validation.
-		std::unique_ptr<MpegDemux> demuxer(new MpegDemux(packetsAdded * 2048, 0));
+		// Needs the whole stream, a video-only pack is still valid data.
+		std::unique_ptr<MpegDemux> demuxer(new MpegDemux(packetsAdded * 2048, 0, true));
 		int readOffset = ringbuffer->packetsRead % (s32)ringbuffer->packets;
 		const u8 *buf = Memory::GetPointer(ringbuffer->data + readOffset * 2048);
 		bool invalid = false;
@@ -222,6 +222,7 @@ void __SasShutdown() {
 
 	delete sas;
 	sas = 0;
+	VagCache_Clear();
 }
 
 
@@ -18,6 +18,7 @@
 #include <condition_variable>
 #include <mutex>
 
+#include "thread/threadutil.h"
 #include "Common/ChunkFile.h"
 #include "Core/MIPS/MIPS.h"
 #include "Core/Reporting.h"
@@ -46,6 +47,7 @@ void AsyncIOManager::ScheduleOperation(AsyncIOEvent ev) {
 }
 
 void AsyncIOManager::Shutdown() {
+	StopWorkers();
 	std::lock_guard<std::mutex> guard(resultsLock_);
 	resultsPending_.clear();
 	results_.clear();
@@ -83,7 +85,7 @@ bool AsyncIOManager::ReadResult(u32 handle, AsyncIOResult &result) {
 bool AsyncIOManager::WaitResult(u32 handle, AsyncIOResult &result) {
 	std::unique_lock<std::mutex> guard(resultsLock_);
 	ScheduleEvent(IO_EVENT_SYNC);
-	while (HasEvents() && ThreadEnabled() && resultsPending_.find(handle) != resultsPending_.end()) {
+	while ((HasEvents() || HasWorkerOperations()) && ThreadEnabled() && resultsPending_.find(handle) != resultsPending_.end()) {
 		if (PopResult(handle, result)) {
 			return true;
 		}
@@ -97,7 +99,7 @@ u64 AsyncIOManager::ResultFinishTicks(u32 handle) {
 
 	std::unique_lock<std::mutex> guard(resultsLock_);
 	ScheduleEvent(IO_EVENT_SYNC);
-	while (HasEvents() && ThreadEnabled() && resultsPending_.find(handle) != resultsPending_.end()) {
+	while ((HasEvents() || HasWorkerOperations()) && ThreadEnabled() && resultsPending_.find(handle) != resultsPending_.end()) {
 		if (ReadResult(handle, result)) {
 			return result.finishTicks;
 		}
@@ -113,11 +115,14 @@ u64 AsyncIOManager::ResultFinishTicks(u32 handle) {
 void AsyncIOManager::ProcessEvent(AsyncIOEvent ev) {
 	switch (ev.type) {
 	case IO_EVENT_READ:
-		Read(ev.handle, ev.buf, ev.bytes, ev.invalidateAddr);
-		break;
-
 	case IO_EVENT_WRITE:
-		Write(ev.handle, ev.buf, ev.bytes);
+		if (workers_.empty()) {
+			RunOperation(ev);
+		} else {
+			std::lock_guard<std::mutex> guard(workLock_);
+			workQueue_.push_back(ev);
+			workWait_.notify_one();
+		}
 		break;
 
 	default:
@@ -125,6 +130,88 @@ void AsyncIOManager::ProcessEvent(AsyncIOEvent ev) {
 	}
 }
 
+void AsyncIOManager::RunOperation(const AsyncIOEvent &ev) {
+	if (ev.type == IO_EVENT_READ) {
+		Read(ev.handle, ev.buf, ev.bytes, ev.invalidateAddr);
+	} else {
+		Write(ev.handle, ev.buf, ev.bytes);
+	}
+}
+
+void AsyncIOManager::StartWorkers(int count) {
+	StopWorkers();
+
+	std::lock_guard<std::mutex> guard(workLock_);
+	workersExit_ = false;
+	for (int i = 0; i < count; ++i) {
+		workers_.push_back(std::thread(&AsyncIOManager::WorkerFunc, this));
+	}
+}
+
+void AsyncIOManager::StopWorkers() {
+	{
+		std::lock_guard<std::mutex> guard(workLock_);
+		workersExit_ = true;
+		workWait_.notify_all();
+	}
+	// Anything already queued is still completed, so results match up.
+	for (std::thread &worker : workers_) {
+		worker.join();
+	}
+	workers_.clear();
+}
+
+void AsyncIOManager::WorkerFunc() {
+	setCurrentThreadName("IOWorker");
+
+	std::unique_lock<std::mutex> guard(workLock_);
+	while (true) {
+		// Operations on the same handle must stay in order, so skip any handle already in progress.
+		auto it = workQueue_.begin();
+		while (it != workQueue_.end() && workActive_.find(it->handle) != workActive_.end()) {
+			++it;
+		}
+		if (it == workQueue_.end()) {
+			if (workersExit_ && workQueue_.empty()) {
+				break;
+			}
+			workWait_.wait(guard);
+			continue;
+		}
+
+		AsyncIOEvent ev = *it;
+		workQueue_.erase(it);
+		workActive_.insert(ev.handle);
+
+		guard.unlock();
+		// Results are keyed by handle, so they may complete in any order.
+		RunOperation(ev);
+		guard.lock();
+
+		workActive_.erase(ev.handle);
+		workDone_.notify_all();
+		// Another operation may have been waiting on this handle.
+		workWait_.notify_one();
+	}
+}
+
+bool AsyncIOManager::HasWorkerOperations() {
+	std::lock_guard<std::mutex> guard(workLock_);
+	return !workQueue_.empty() || !workActive_.empty();
+}
+
+void AsyncIOManager::SyncThread(bool force) {
+	IOThreadEventQueue::SyncThread(force);
+	if (workers_.empty()) {
+		return;
+	}
+
+	std::unique_lock<std::mutex> guard(workLock_);
+	while (!workQueue_.empty() || !workActive_.empty()) {
+		workDone_.wait(guard);
+	}
+}
+
 void AsyncIOManager::Read(u32 handle, u8 *buf, size_t bytes, u32 invalidateAddr) {
 	int usec = 0;
 	s64 result = pspFileSystem.ReadFile(handle, buf, bytes, usec);
@@ -15,9 +15,12 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <deque>
 #include <map>
 #include <set>
 #include <mutex>
+#include <thread>
+#include <vector>
 
 #include "Core/ThreadEventQueue.h"
 
@@ -84,6 +87,12 @@ class AsyncIOManager : public IOThreadEventQueue {
 	void ScheduleOperation(AsyncIOEvent ev);
 	void Shutdown();
 
+	// Reads and writes are handed to this many workers, so different handles can overlap.
+	// With zero workers, operations run in order on the event thread.
+	void StartWorkers(int count);
+	// Also waits for operations already handed to workers.
+	void SyncThread(bool force = false);
+
 	bool HasResult(u32 handle);
 	bool WaitResult(u32 handle, AsyncIOResult &result);
 	u64 ResultFinishTicks(u32 handle);
@@ -102,8 +111,22 @@ class AsyncIOManager : public IOThreadEventQueue {
 
 	void EventResult(u32 handle, AsyncIOResult result);
 
+	void RunOperation(const AsyncIOEvent &ev);
+	void WorkerFunc();
+	bool HasWorkerOperations();
+	void StopWorkers();
+
 	std::mutex resultsLock_;
 	std::condition_variable resultsWait_;
 	std::set<u32> resultsPending_;
 	std::map<u32, AsyncIOResult> results_;
+
+	std::vector<std::thread> workers_;
+	std::mutex workLock_;
+	std::condition_variable workWait_;
+	std::condition_variable workDone_;
+	std::deque<AsyncIOEvent> workQueue_;
+	// Handles currently being read or written by a worker.
+	std::set<u32> workActive_;
+	bool workersExit_ = false;
 };
\ No newline at end of file
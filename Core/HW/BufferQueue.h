@@ -108,22 +108,40 @@ struct BufferQueue {
 		return bytesgot;
 	}
 
-	int get_front(unsigned char *buf, int wantedsize) {
+	// Like pop_front, but leaves the data in the queue.  Can start further in.
+	int get_front(unsigned char *buf, int wantedsize, int offset = 0) {
 		if (wantedsize <= 0)
 			return 0;
-		int bytesgot = getQueueSize();
+		int bytesgot = getQueueSize() - offset;
+		if (bytesgot <= 0)
+			return 0;
 		if (wantedsize < bytesgot)
 			bytesgot = wantedsize;
-		if (start + bytesgot <= bufQueueSize) {
-			memcpy(buf, bufQueue + start, bytesgot);
+		int pos = start + offset;
+		if (pos >= bufQueueSize)
+			pos -= bufQueueSize;
+		if (pos + bytesgot <= bufQueueSize) {
+			memcpy(buf, bufQueue + pos, bytesgot);
 		} else {
-			int size = bufQueueSize - start;
-			memcpy(buf, bufQueue + start, size);
+			int size = bufQueueSize - pos;
+			memcpy(buf, bufQueue + pos, size);
 			memcpy(buf + size, bufQueue, bytesgot - size);
 		}
 		return bytesgot;
 	}
 
+	// Like get_front, but points into the queue instead of copying, unless it would wrap around.
+	// Either way, wantedsize bytes can be read at *buf even if fewer are queued.
+	int peek_front(unsigned char *scratch, unsigned char **buf, int wantedsize) {
+		if (start + wantedsize <= bufQueueSize) {
+			*buf = bufQueue + start;
+			int bytesgot = getQueueSize();
+			return wantedsize < bytesgot ? wantedsize : bytesgot;
+		}
+		*buf = scratch;
+		return get_front(scratch, wantedsize);
+	}
+
 	void DoState(PointerWrap &p) {
 		auto s = p.Section("BufferQueue", 0, 1);
 
@@ -15,6 +15,8 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include "thread/threadutil.h"
+#include "Common/ColorConv.h"
 #include "Core/Config.h"
 #include "Core/Debugger/Breakpoints.h"
 #include "Core/HW/MediaEngine.h"
@@ -41,6 +43,9 @@ extern "C" {
 #endif // USE_FFMPEG
 
 #ifdef USE_FFMPEG
+// How many frames the decode thread may get ahead of the game.
+static const size_t MAX_DECODE_AHEAD_FRAMES = 3;
+
 static AVPixelFormat getSwsFormat(int pspFormat)
 {
 	switch (pspFormat)
@@ -124,6 +129,9 @@ MediaEngine::MediaEngine(): m_pdata(0) {
 	m_pFrameRGB = 0;
 	m_pIOContext = 0;
 	m_sws_ctx = 0;
+	m_pFrameYUV = 0;
+	m_directFrame = false;
+	m_directPixelMode = 0;
 #endif
 	m_sws_fmt = 0;
 	m_buffer = 0;
@@ -149,6 +157,17 @@ MediaEngine::MediaEngine(): m_pdata(0) {
 	m_mpegheaderReadPos = 0;
 	m_mpegheaderSize = sizeof(m_mpegheader);
 	m_audioType = PSP_CODEC_AT3PLUS; // in movie, we use only AT3+ audio
+
+	m_decodeThread = nullptr;
+	m_decodeAhead = false;
+	m_decodeStop = false;
+	m_decodePause = false;
+	m_decodeParked = false;
+	m_decodeWaiting = false;
+	m_decodeAheadFrames = 0;
+	m_readAheadBytes = 0;
+	m_decodingReadBytes = 0;
+	m_decodingLastReadSize = 0;
 }
 
 MediaEngine::~MediaEngine() {
@@ -172,6 +191,15 @@ void MediaEngine::DoState(PointerWrap &p) {
 	if (!s)
 		return;
 
+#ifdef USE_FFMPEG
+	if (p.mode == p.MODE_READ) {
+		// Whatever it decoded ahead is about to be stale.
+		stopDecodeAhead();
+	} else {
+		pauseDecodeAhead();
+	}
+#endif
+
 	p.Do(m_videoStream);
 	p.Do(m_audioStream);
 
@@ -224,6 +252,12 @@ void MediaEngine::DoState(PointerWrap &p) {
 	} else {
 		m_audioType = PSP_CODEC_AT3PLUS;
 	}
+
+#ifdef USE_FFMPEG
+	if (p.mode != p.MODE_READ) {
+		resumeDecodeAhead();
+	}
+#endif
 }
 
 static int MpegReadbuffer(void *opaque, uint8_t *buf, int buf_size) {
@@ -234,6 +268,8 @@ static int MpegReadbuffer(void *opaque, uint8_t *buf, int buf_size) {
 		size = std::min(buf_size, mpeg->m_mpegheaderSize - mpeg->m_mpegheaderReadPos);
 		memcpy(buf, mpeg->m_mpegheader + mpeg->m_mpegheaderReadPos, size);
 		mpeg->m_mpegheaderReadPos += size;
+	} else if (mpeg->m_decodeAhead) {
+		size = mpeg->readAhead(buf, buf_size);
 	} else {
 		size = mpeg->m_pdata->pop_front(buf, buf_size);
 		if (size > 0)
@@ -328,6 +364,15 @@ bool MediaEngine::openContext(bool keepReadPos) {
 			return false;
 	}
 
+	// Frames decoded ahead belong to the stream that was selected at the time.  If the game can
+	// switch streams, only decode once it asks for a frame, so nothing it hasn't seen gets used up.
+	int videoStreams = 0;
+	for (int i = 0; i < (int)m_pFormatCtx->nb_streams; i++) {
+		if (m_pFormatCtx->streams[i]->codec->codec_type == AVMEDIA_TYPE_VIDEO)
+			videoStreams++;
+	}
+	m_decodeAheadFrames = videoStreams > 1 ? 0 : MAX_DECODE_AHEAD_FRAMES;
+
 	if (!setVideoStream(m_videoStream, true))
 		return false;
 
@@ -341,12 +386,16 @@ bool MediaEngine::openContext(bool keepReadPos) {
 void MediaEngine::closeContext()
 {
 #ifdef USE_FFMPEG
+	stopDecodeAhead();
 	if (m_buffer)
 		av_free(m_buffer);
 	if (m_pFrameRGB)
 		av_frame_free(&m_pFrameRGB);
 	if (m_pFrame)
 		av_frame_free(&m_pFrame);
+	if (m_pFrameYUV)
+		av_frame_free(&m_pFrameYUV);
+	m_directFrame = false;
 	if (m_pIOContext && m_pIOContext->buffer)
 		av_free(m_pIOContext->buffer);
 	if (m_pIOContext)
@@ -388,8 +437,12 @@ bool MediaEngine::reloadStream()
 int MediaEngine::addStreamData(const u8 *buffer, int addSize) {
 	int size = addSize;
 	if (size > 0 && m_pdata) {
+		std::unique_lock<std::mutex> guard(m_decodeLock);
 		if (!m_pdata->push(buffer, size)) 
 			size  = 0;
+		// The decode thread might have been waiting for this.
+		m_decodeWake.notify_all();
+		guard.unlock();
 		if (m_demux) {
 			m_demux->addStreamData(buffer, addSize);
 		}
@@ -449,9 +502,12 @@ bool MediaEngine::setVideoStream(int streamNum, bool force) {
 	}
 
 #ifdef USE_FFMPEG
+	// The decode thread may be adding streams as it finds them, so hold it still.
+	pauseDecodeAhead();
 	if (m_pFormatCtx && m_pCodecCtxs.find(streamNum) == m_pCodecCtxs.end()) {
 		// Get a pointer to the codec context for the video stream
 		if ((u32)streamNum >= m_pFormatCtx->nb_streams) {
+			resumeDecodeAhead();
 			return false;
 		}
 		AVCodecContext *m_pCodecCtx = m_pFormatCtx->streams[streamNum]->codec;
@@ -459,22 +515,30 @@ bool MediaEngine::setVideoStream(int streamNum, bool force) {
 		// Find the decoder for the video stream
 		AVCodec *pCodec = avcodec_find_decoder(m_pCodecCtx->codec_id);
 		if (pCodec == nullptr) {
+			resumeDecodeAhead();
 			return false;
 		}
 
 		AVDictionary *opt = nullptr;
 		// Allow ffmpeg to use any number of threads it wants.  Without this, it doesn't use threads.
 		av_dict_set(&opt, "threads", "0", 0);
+		// Frames are held in a queue after decoding, so they need to be ours.
+		av_dict_set(&opt, "refcounted_frames", "1", 0);
+		m_pCodecCtx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
 		int openResult = avcodec_open2(m_pCodecCtx, pCodec, &opt);
 		av_dict_free(&opt);
 		if (openResult < 0) {
+			resumeDecodeAhead();
 			return false;
 		}
 
 		m_pCodecCtxs[streamNum] = m_pCodecCtx;
 	}
-#endif
 	m_videoStream = streamNum;
+	resumeDecodeAhead();
+#else
+	m_videoStream = streamNum;
+#endif
 
 	return true;
 }
@@ -490,8 +554,10 @@ bool MediaEngine::setVideoDim(int width, int height)
 	if (width == 0 && height == 0)
 	{
 		// use the orignal video size
-		m_desWidth = m_pCodecCtx->width;
-		m_desHeight = m_pCodecCtx->height;
+		// Once frames come out, go by those - the codec context belongs to the decode thread then.
+		bool haveFrame = m_pFrame && m_pFrame->width != 0;
+		m_desWidth = haveFrame ? m_pFrame->width : m_pCodecCtx->width;
+		m_desHeight = haveFrame ? m_pFrame->height : m_pCodecCtx->height;
 	}
 	else
 	{
@@ -503,6 +569,9 @@ bool MediaEngine::setVideoDim(int width, int height)
 	if (!m_pFrame) {
 		m_pFrame = av_frame_alloc();
 	}
+	if (!m_pFrameYUV) {
+		m_pFrameYUV = av_frame_alloc();
+	}
 
 	sws_freeContext(m_sws_ctx);
 	m_sws_ctx = NULL;
@@ -541,13 +610,15 @@ void MediaEngine::updateSwsFormat(int videoPixelMode) {
 
 	AVPixelFormat swsDesired = getSwsFormat(videoPixelMode);
 	if (swsDesired != m_sws_fmt && m_pCodecCtx != 0) {
+		// As in setVideoDim(), prefer what the decoded frames say.
+		bool haveFrame = m_pFrame && m_pFrame->width != 0;
 		m_sws_fmt = swsDesired;
 		m_sws_ctx = sws_getCachedContext
 			(
 				m_sws_ctx,
-				m_pCodecCtx->width,
-				m_pCodecCtx->height,
-				m_pCodecCtx->pix_fmt,
+				haveFrame ? m_pFrame->width : m_pCodecCtx->width,
+				haveFrame ? m_pFrame->height : m_pCodecCtx->height,
+				haveFrame ? (AVPixelFormat)m_pFrame->format : m_pCodecCtx->pix_fmt,
 				m_desWidth,
 				m_desHeight,
 				(AVPixelFormat)m_sws_fmt,
@@ -571,6 +642,179 @@ void MediaEngine::updateSwsFormat(int videoPixelMode) {
 #endif
 }
 
+#ifdef USE_FFMPEG
+void MediaEngine::startDecodeAhead() {
+	m_decodeStop = false;
+	m_decodePause = false;
+	m_decodeParked = false;
+	m_decodeWaiting = false;
+	m_readAheadBytes = 0;
+	m_decodeAhead = true;
+	m_decodeThread = new std::thread([this] { decodeAheadThread(); });
+}
+
+void MediaEngine::stopDecodeAhead() {
+	if (!m_decodeThread)
+		return;
+
+	{
+		std::lock_guard<std::mutex> guard(m_decodeLock);
+		m_decodeStop = true;
+		m_decodeWake.notify_all();
+	}
+	m_decodeThread->join();
+	delete m_decodeThread;
+	m_decodeThread = nullptr;
+	m_decodeAhead = false;
+
+	// This leaves the data in m_pdata, but the demuxer state is gone with it anyway.
+	for (auto &decoded : m_decodedFrames) {
+		if (decoded.frame)
+			av_frame_free(&decoded.frame);
+	}
+	m_decodedFrames.clear();
+	m_readAheadBytes = 0;
+}
+
+void MediaEngine::pauseDecodeAhead() {
+	if (!m_decodeThread)
+		return;
+
+	std::unique_lock<std::mutex> guard(m_decodeLock);
+	m_decodePause = true;
+	m_decodeWake.notify_all();
+	while (!m_decodeParked)
+		m_decodeDone.wait(guard);
+}
+
+void MediaEngine::resumeDecodeAhead() {
+	if (!m_decodeThread)
+		return;
+
+	std::lock_guard<std::mutex> guard(m_decodeLock);
+	m_decodePause = false;
+	m_decodeWake.notify_all();
+}
+
+// Called by the decode thread with guard held, either between frames or from readAhead().  In the
+// latter case av_read_frame() is still on the stack, but blocked in our read callback, so FFmpeg
+// isn't changing anything while we're parked.  Whoever paused us may read the stream data and
+// open codecs for existing streams, but must not seek or close the format context: that needs
+// stopDecodeAhead(), which makes the read fail and lets av_read_frame() return first.
+void MediaEngine::parkDecodeAhead(std::unique_lock<std::mutex> &guard) {
+	m_decodeParked = true;
+	m_decodeDone.notify_all();
+	while (m_decodePause && !m_decodeStop)
+		m_decodeWake.wait(guard);
+	m_decodeParked = false;
+}
+
+int MediaEngine::readAhead(u8 *buf, int size) {
+	std::unique_lock<std::mutex> guard(m_decodeLock);
+	while (!m_decodeStop) {
+		if (m_decodePause) {
+			parkDecodeAhead(guard);
+			continue;
+		}
+		// A full read gets the same bytes no matter how early it happens.  A short one depends on
+		// how much the game has added so far, so it waits until the game actually wants this frame.
+		if (m_pdata->getQueueSize() - m_readAheadBytes >= size || m_decodeWaiting)
+			break;
+		m_decodeWake.wait(guard);
+	}
+	if (m_decodeStop)
+		return AVERROR_EXIT;
+
+	int got = m_pdata->get_front(buf, size, m_readAheadBytes);
+	m_readAheadBytes += got;
+	m_decodingReadBytes += got;
+	if (got > 0)
+		m_decodingLastReadSize = got;
+	return got;
+}
+
+void MediaEngine::decodeAheadThread() {
+	setCurrentThreadName("VideoDecode");
+
+	AVFrame *frame = av_frame_alloc();
+	AVPacket packet;
+	av_init_packet(&packet);
+
+	std::unique_lock<std::mutex> guard(m_decodeLock);
+	while (!m_decodeStop) {
+		if (m_decodePause) {
+			parkDecodeAhead(guard);
+			continue;
+		}
+		// Even when not decoding ahead, the frame the game is waiting on has to be decoded.
+		size_t maxFrames = m_decodeWaiting ? std::max(m_decodeAheadFrames, (size_t)1) : m_decodeAheadFrames;
+		auto codecIter = m_pCodecCtxs.find(m_videoStream);
+		if (m_decodedFrames.size() >= maxFrames || codecIter == m_pCodecCtxs.end()) {
+			m_decodeWake.wait(guard);
+			continue;
+		}
+
+		AVCodecContext *m_pCodecCtx = codecIter->second;
+		DecodedVideoFrame decoded{};
+		decoded.streamNum = m_videoStream;
+		m_decodingReadBytes = 0;
+		m_decodingLastReadSize = 0;
+		guard.unlock();
+
+		int frameFinished;
+		bool bGetFrame = false;
+		while (!bGetFrame) {
+			bool dataEnd = av_read_frame(m_pFormatCtx, &packet) < 0;
+			// Even if we've read all frames, some may have been re-ordered frames at the end.
+			// Still need to decode those, so keep calling avcodec_decode_video2().
+			if (dataEnd || packet.stream_index == decoded.streamNum) {
+				// avcodec_decode_video2() gives us the re-ordered frames with a NULL packet.
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(57, 12, 100)
+				if (dataEnd)
+					av_packet_unref(&packet);
+#else
+				if (dataEnd)
+					av_free_packet(&packet);
+#endif
+
+				int result = avcodec_decode_video2(m_pCodecCtx, frame, &frameFinished, &packet);
+				if (frameFinished) {
+					decoded.frame = av_frame_alloc();
+					av_frame_ref(decoded.frame, frame);
+					av_frame_unref(frame);
+					bGetFrame = true;
+				}
+				if (result <= 0 && dataEnd) {
+					decoded.dataEnd = true;
+					break;
+				}
+			}
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(57, 12, 100)
+			av_packet_unref(&packet);
+#else
+			av_free_packet(&packet);
+#endif
+		}
+
+		guard.lock();
+		if (m_decodeStop) {
+			if (decoded.frame)
+				av_frame_free(&decoded.frame);
+			break;
+		}
+		decoded.bytesRead = m_decodingReadBytes;
+		decoded.lastReadSize = m_decodingLastReadSize;
+		m_decodedFrames.push_back(decoded);
+		// This was the frame being waited on, so reads for the next one must not come up short.
+		m_decodeWaiting = false;
+		m_decodeDone.notify_all();
+	}
+	guard.unlock();
+
+	av_frame_free(&frame);
+}
+#endif
+
 bool MediaEngine::stepVideo(int videoPixelMode, bool skipFrame) {
 #ifdef USE_FFMPEG
 	auto codecIter = m_pCodecCtxs.find(m_videoStream);
@@ -583,59 +827,80 @@ bool MediaEngine::stepVideo(int videoPixelMode, bool skipFrame) {
 	if (!m_pFrame)
 		return false;
 
-	AVPacket packet;
-	av_init_packet(&packet);
-	int frameFinished;
-	bool bGetFrame = false;
-	while (!bGetFrame) {
-		bool dataEnd = av_read_frame(m_pFormatCtx, &packet) < 0;
-		// Even if we've read all frames, some may have been re-ordered frames at the end.
-		// Still need to decode those, so keep calling avcodec_decode_video2().
-		if (dataEnd || packet.stream_index == m_videoStream) {
-			// avcodec_decode_video2() gives us the re-ordered frames with a NULL packet.
-#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(57, 12, 100)
-			if (dataEnd)
-				av_packet_unref(&packet);
-#else
-			if (dataEnd)
-				av_free_packet(&packet);
-#endif
+	// Frames are decoded on a thread, a few ahead of what the game has asked for.  Any data it reads
+	// only counts as taken from the ringbuffer once the frame is handed out here, so the game sees
+	// exactly what it would if we decoded right now.
+	if (!m_decodeThread)
+		startDecodeAhead();
 
-			int result = avcodec_decode_video2(m_pCodecCtx, m_pFrame, &frameFinished, &packet);
-			if (frameFinished) {
-				if (!m_pFrameRGB) {
-					setVideoDim();
-				}
-				if (m_pFrameRGB && !skipFrame) {
-					updateSwsFormat(videoPixelMode);
-					// TODO: Technically we could set this to frameWidth instead of m_desWidth for better perf.
-					// Update the linesize for the new format too.  We started with the largest size, so it should fit.
-					m_pFrameRGB->linesize[0] = getPixelFormatBytes(videoPixelMode) * m_desWidth;
-
-					sws_scale(m_sws_ctx, m_pFrame->data, m_pFrame->linesize, 0,
-						m_pCodecCtx->height, m_pFrameRGB->data, m_pFrameRGB->linesize);
-				}
+	DecodedVideoFrame decoded;
+	bool queueEmpty;
+	{
+		std::unique_lock<std::mutex> guard(m_decodeLock);
+		do {
+			if (m_decodedFrames.empty()) {
+				m_decodeWaiting = true;
+				m_decodeWake.notify_all();
+				while (m_decodedFrames.empty())
+					m_decodeDone.wait(guard);
+			}
+			decoded = m_decodedFrames.front();
+			m_decodedFrames.pop_front();
+
+			m_pdata->pop_front(0, decoded.bytesRead);
+			m_readAheadBytes -= decoded.bytesRead;
+			if (decoded.lastReadSize > 0)
+				m_decodingsize = decoded.lastReadSize;
+
+			// Decoded before the video stream was switched.  The data is used up either way.
+			if (decoded.streamNum != m_videoStream && decoded.frame)
+				av_frame_free(&decoded.frame);
+		} while (decoded.streamNum != m_videoStream);
+		queueEmpty = m_pdata->getQueueSize() == 0;
+		m_decodeWake.notify_all();
+	}
+
+	bool bGetFrame = decoded.frame != nullptr;
+	if (bGetFrame) {
+		av_frame_unref(m_pFrame);
+		av_frame_move_ref(m_pFrame, decoded.frame);
+		av_frame_free(&decoded.frame);
 
-				if (av_frame_get_best_effort_timestamp(m_pFrame) != AV_NOPTS_VALUE)
-					m_videopts = av_frame_get_best_effort_timestamp(m_pFrame) + av_frame_get_pkt_duration(m_pFrame) - m_firstTimeStamp;
-				else
-					m_videopts += av_frame_get_pkt_duration(m_pFrame);
-				bGetFrame = true;
+		if (!m_pFrameRGB) {
+			setVideoDim();
+		}
+		if (m_pFrameRGB && !skipFrame) {
+			// PSP videos are full size 4:2:0, which we convert right into the game's buffer when it's
+			// written.  Anything else goes through swscale into m_pFrameRGB first.
+			m_directFrame = false;
+			if (m_pFrame->format == AV_PIX_FMT_YUV420P && m_pFrame->width == m_desWidth && m_pFrame->height == m_desHeight && m_pFrameYUV) {
+				av_frame_unref(m_pFrameYUV);
+				m_directFrame = av_frame_ref(m_pFrameYUV, m_pFrame) >= 0;
+				m_directPixelMode = videoPixelMode;
 			}
-			if (result <= 0 && dataEnd) {
-				// Sometimes, m_readSize is less than m_streamSize at the end, but not by much.
-				// This is kinda a hack, but the ringbuffer would have to be prematurely empty too.
-				m_isVideoEnd = !bGetFrame && (m_pdata->getQueueSize() == 0);
-				if (m_isVideoEnd)
-					m_decodingsize = 0;
-				break;
+
+			if (!m_directFrame) {
+				updateSwsFormat(videoPixelMode);
+				// TODO: Technically we could set this to frameWidth instead of m_desWidth for better perf.
+				// Update the linesize for the new format too.  We started with the largest size, so it should fit.
+				m_pFrameRGB->linesize[0] = getPixelFormatBytes(videoPixelMode) * m_desWidth;
+
+				sws_scale(m_sws_ctx, m_pFrame->data, m_pFrame->linesize, 0,
+					m_pFrame->height, m_pFrameRGB->data, m_pFrameRGB->linesize);
 			}
 		}
-#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(57, 12, 100)
-		av_packet_unref(&packet);
-#else
-		av_free_packet(&packet);
-#endif
+
+		if (av_frame_get_best_effort_timestamp(m_pFrame) != AV_NOPTS_VALUE)
+			m_videopts = av_frame_get_best_effort_timestamp(m_pFrame) + av_frame_get_pkt_duration(m_pFrame) - m_firstTimeStamp;
+		else
+			m_videopts += av_frame_get_pkt_duration(m_pFrame);
+	}
+	if (decoded.dataEnd) {
+		// Sometimes, m_readSize is less than m_streamSize at the end, but not by much.
+		// This is kinda a hack, but the ringbuffer would have to be prematurely empty too.
+		m_isVideoEnd = !bGetFrame && queueEmpty;
+		if (m_isVideoEnd)
+			m_decodingsize = 0;
 	}
 	return bGetFrame;
 #else
@@ -684,6 +949,41 @@ inline void writeVideoLineABGR4444(void *destp, const void *srcp, int width) {
 	}
 }
 
+#ifdef USE_FFMPEG
+// Converts part of m_pFrameYUV straight to the PSP format, leaving alpha at zero like the helpers above.
+void MediaEngine::convertDirectFrame(u8 *dest, int destLineSize, int videoPixelMode, int xpos, int ypos, int width, int height) {
+	if (width <= 0)
+		return;
+
+	const AVFrame *frame = m_pFrameYUV;
+	for (int y = 0; y < height; y++) {
+		const int row = ypos + y;
+		const u8 *ysrc = frame->data[0] + row * frame->linesize[0];
+		const u8 *usrc = frame->data[1] + (row >> 1) * frame->linesize[1];
+		const u8 *vsrc = frame->data[2] + (row >> 1) * frame->linesize[2];
+		u8 *line = dest + destLineSize * y;
+
+		switch (videoPixelMode) {
+		case GE_CMODE_32BIT_ABGR8888:
+			ConvertYUV420ToRGBA8888((u32 *)line, ysrc, usrc, vsrc, xpos, width);
+			break;
+		case GE_CMODE_16BIT_BGR5650:
+			ConvertYUV420ToRGB565((u16 *)line, ysrc, usrc, vsrc, xpos, width);
+			break;
+		case GE_CMODE_16BIT_ABGR5551:
+			ConvertYUV420ToRGBA5551((u16 *)line, ysrc, usrc, vsrc, xpos, width);
+			break;
+		case GE_CMODE_16BIT_ABGR4444:
+			ConvertYUV420ToRGBA4444((u16 *)line, ysrc, usrc, vsrc, xpos, width);
+			break;
+		default:
+			ERROR_LOG_REPORT(ME, "Unsupported video pixel format %d", videoPixelMode);
+			return;
+		}
+	}
+}
+#endif
+
 int MediaEngine::writeVideoImage(u32 bufferPtr, int frameWidth, int videoPixelMode) {
 	if (!Memory::IsValidAddress(bufferPtr) || frameWidth > 2048) {
 		// Clearly invalid values.  Let's just not.
@@ -722,38 +1022,42 @@ int MediaEngine::writeVideoImage(u32 bufferPtr, int frameWidth, int videoPixelMo
 		imgbuf = new u8[videoImageSize];
 	}
 
-	switch (videoPixelMode) {
-	case GE_CMODE_32BIT_ABGR8888:
-		for (int y = 0; y < height; y++) {
-			writeVideoLineRGBA(imgbuf + videoLineSize * y, data, width);
-			data += width * sizeof(u32);
-		}
-		break;
+	if (m_directFrame) {
+		convertDirectFrame(imgbuf, videoLineSize, videoPixelMode, 0, 0, width, height);
+	} else {
+		switch (videoPixelMode) {
+		case GE_CMODE_32BIT_ABGR8888:
+			for (int y = 0; y < height; y++) {
+				writeVideoLineRGBA(imgbuf + videoLineSize * y, data, width);
+				data += width * sizeof(u32);
+			}
+			break;
 
-	case GE_CMODE_16BIT_BGR5650:
-		for (int y = 0; y < height; y++) {
-			writeVideoLineABGR5650(imgbuf + videoLineSize * y, data, width);
-			data += width * sizeof(u16);
-		}
-		break;
+		case GE_CMODE_16BIT_BGR5650:
+			for (int y = 0; y < height; y++) {
+				writeVideoLineABGR5650(imgbuf + videoLineSize * y, data, width);
+				data += width * sizeof(u16);
+			}
+			break;
 
-	case GE_CMODE_16BIT_ABGR5551:
-		for (int y = 0; y < height; y++) {
-			writeVideoLineABGR5551(imgbuf + videoLineSize * y, data, width);
-			data += width * sizeof(u16);
-		}
-		break;
+		case GE_CMODE_16BIT_ABGR5551:
+			for (int y = 0; y < height; y++) {
+				writeVideoLineABGR5551(imgbuf + videoLineSize * y, data, width);
+				data += width * sizeof(u16);
+			}
+			break;
 
-	case GE_CMODE_16BIT_ABGR4444:
-		for (int y = 0; y < height; y++) {
-			writeVideoLineABGR4444(imgbuf + videoLineSize * y, data, width);
-			data += width * sizeof(u16);
-		}
-		break;
+		case GE_CMODE_16BIT_ABGR4444:
+			for (int y = 0; y < height; y++) {
+				writeVideoLineABGR4444(imgbuf + videoLineSize * y, data, width);
+				data += width * sizeof(u16);
+			}
+			break;
 
-	default:
-		ERROR_LOG_REPORT(ME, "Unsupported video pixel format %d", videoPixelMode);
-		break;
+		default:
+			ERROR_LOG_REPORT(ME, "Unsupported video pixel format %d", videoPixelMode);
+			break;
+		}
 	}
 
 	if (swizzle) {
@@ -815,58 +1119,67 @@ int MediaEngine::writeVideoImageWithRange(u32 bufferPtr, int frameWidth, int vid
 	if (height > m_desHeight - ypos)
 		height = m_desHeight - ypos;
 
-	switch (videoPixelMode) {
-	case GE_CMODE_32BIT_ABGR8888:
-		data += (ypos * m_desWidth + xpos) * sizeof(u32);
+	if (m_directFrame) {
+		convertDirectFrame(imgbuf, videoLineSize, videoPixelMode, xpos, ypos, width, height);
+#ifndef MOBILE_DEVICE
 		for (int y = 0; y < height; y++) {
-			writeVideoLineRGBA(imgbuf, data, width);
-			data += m_desWidth * sizeof(u32);
-			imgbuf += videoLineSize;
+			CBreakPoints::ExecMemCheck(bufferPtr + y * videoLineSize, true, width * getPixelFormatBytes(videoPixelMode), currentMIPS->pc);
+		}
+#endif
+	} else {
+		switch (videoPixelMode) {
+		case GE_CMODE_32BIT_ABGR8888:
+			data += (ypos * m_desWidth + xpos) * sizeof(u32);
+			for (int y = 0; y < height; y++) {
+				writeVideoLineRGBA(imgbuf, data, width);
+				data += m_desWidth * sizeof(u32);
+				imgbuf += videoLineSize;
 #ifndef MOBILE_DEVICE
-			CBreakPoints::ExecMemCheck(bufferPtr + y * frameWidth * sizeof(u32), true, width * sizeof(u32), currentMIPS->pc);
+				CBreakPoints::ExecMemCheck(bufferPtr + y * frameWidth * sizeof(u32), true, width * sizeof(u32), currentMIPS->pc);
 #endif
-		}
-		break;
-
-	case GE_CMODE_16BIT_BGR5650:
-		data += (ypos * m_desWidth + xpos) * sizeof(u16);
-		for (int y = 0; y < height; y++) {
-			writeVideoLineABGR5650(imgbuf, data, width);
-			data += m_desWidth * sizeof(u16);
-			imgbuf += videoLineSize;
+			}
+			break;
+
+		case GE_CMODE_16BIT_BGR5650:
+			data += (ypos * m_desWidth + xpos) * sizeof(u16);
+			for (int y = 0; y < height; y++) {
+				writeVideoLineABGR5650(imgbuf, data, width);
+				data += m_desWidth * sizeof(u16);
+				imgbuf += videoLineSize;
 #ifndef MOBILE_DEVICE
-			CBreakPoints::ExecMemCheck(bufferPtr + y * frameWidth * sizeof(u16), true, width * sizeof(u16), currentMIPS->pc);
+				CBreakPoints::ExecMemCheck(bufferPtr + y * frameWidth * sizeof(u16), true, width * sizeof(u16), currentMIPS->pc);
 #endif
-		}
-		break;
-
-	case GE_CMODE_16BIT_ABGR5551:
-		data += (ypos * m_desWidth + xpos) * sizeof(u16);
-		for (int y = 0; y < height; y++) {
-			writeVideoLineABGR5551(imgbuf, data, width);
-			data += m_desWidth * sizeof(u16);
-			imgbuf += videoLineSize;
+			}
+			break;
+
+		case GE_CMODE_16BIT_ABGR5551:
+			data += (ypos * m_desWidth + xpos) * sizeof(u16);
+			for (int y = 0; y < height; y++) {
+				writeVideoLineABGR5551(imgbuf, data, width);
+				data += m_desWidth * sizeof(u16);
+				imgbuf += videoLineSize;
 #ifndef MOBILE_DEVICE
-			CBreakPoints::ExecMemCheck(bufferPtr + y * frameWidth * sizeof(u16), true, width * sizeof(u16), currentMIPS->pc);
+				CBreakPoints::ExecMemCheck(bufferPtr + y * frameWidth * sizeof(u16), true, width * sizeof(u16), currentMIPS->pc);
 #endif
-		}
-		break;
-
-	case GE_CMODE_16BIT_ABGR4444:
-		data += (ypos * m_desWidth + xpos) * sizeof(u16);
-		for (int y = 0; y < height; y++) {
-			writeVideoLineABGR4444(imgbuf, data, width);
-			data += m_desWidth * sizeof(u16);
-			imgbuf += videoLineSize;
+			}
+			break;
+
+		case GE_CMODE_16BIT_ABGR4444:
+			data += (ypos * m_desWidth + xpos) * sizeof(u16);
+			for (int y = 0; y < height; y++) {
+				writeVideoLineABGR4444(imgbuf, data, width);
+				data += m_desWidth * sizeof(u16);
+				imgbuf += videoLineSize;
 #ifndef MOBILE_DEVICE
-			CBreakPoints::ExecMemCheck(bufferPtr + y * frameWidth * sizeof(u16), true, width * sizeof(u16), currentMIPS->pc);
+				CBreakPoints::ExecMemCheck(bufferPtr + y * frameWidth * sizeof(u16), true, width * sizeof(u16), currentMIPS->pc);
 #endif
-		}
-		break;
+			}
+			break;
 
-	default:
-		ERROR_LOG_REPORT(ME, "Unsupported video pixel format %d", videoPixelMode);
-		break;
+		default:
+			ERROR_LOG_REPORT(ME, "Unsupported video pixel format %d", videoPixelMode);
+			break;
+		}
 	}
 
 	if (swizzle) {
@@ -889,6 +1202,11 @@ int MediaEngine::writeVideoImageWithRange(u32 bufferPtr, int frameWidth, int vid
 
 u8 *MediaEngine::getFrameImage() {
 #ifdef USE_FFMPEG
+	if (m_directFrame) {
+		// Fill in what swscale would have, in the format of the last frame.
+		m_pFrameRGB->linesize[0] = getPixelFormatBytes(m_directPixelMode) * m_desWidth;
+		convertDirectFrame(m_pFrameRGB->data[0], m_pFrameRGB->linesize[0], m_directPixelMode, 0, 0, m_desWidth, m_desHeight);
+	}
 	return m_pFrameRGB->data[0];
 #else
 	return NULL;
@@ -898,6 +1216,7 @@ u8 *MediaEngine::getFrameImage() {
 int MediaEngine::getRemainSize() {
 	if (!m_pdata)
 		return 0;
+	std::lock_guard<std::mutex> guard(m_decodeLock);
 	return std::max(m_pdata->getRemainSize() - m_decodingsize - 2048, 0);
 }
 
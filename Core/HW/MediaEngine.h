@@ -24,7 +24,12 @@
 
 // An approximation of what the interface will look like. Similar to JPCSP's.
 
+#include <condition_variable>
+#include <deque>
 #include <map>
+#include <mutex>
+#include <thread>
+
 #include "Common/CommonTypes.h"
 #include "Core/HLE/sceMpeg.h"
 #include "Core/HW/MpegDemux.h"
@@ -92,12 +97,37 @@ class MediaEngine
 
 	void DoState(PointerWrap &p);
 
+	// For the FFmpeg read callback, when decoding on the thread.
+	int readAhead(u8 *buf, int size);
+
 private:
 	bool SetupStreams();
 	bool setVideoDim(int width = 0, int height = 0);
 	void updateSwsFormat(int videoPixelMode);
 	int getNextAudioFrame(u8 **buf, int *headerCode1, int *headerCode2);
 
+#ifdef USE_FFMPEG
+	// Video decoding runs ahead of the game on a thread, see stepVideo().
+	struct DecodedVideoFrame {
+		// Null if the data ran out before a frame came out.
+		AVFrame *frame;
+		int streamNum;
+		bool dataEnd;
+		// What was read from m_pdata to get here, only taken out of it once the game gets this frame.
+		int bytesRead;
+		int lastReadSize;
+	};
+
+	void startDecodeAhead();
+	void stopDecodeAhead();
+	void pauseDecodeAhead();
+	void resumeDecodeAhead();
+	void parkDecodeAhead(std::unique_lock<std::mutex> &guard);
+	void decodeAheadThread();
+
+	void convertDirectFrame(u8 *dest, int destLineSize, int videoPixelMode, int xpos, int ypos, int width, int height);
+#endif
+
 public:  // TODO: Very little of this below should be public.
 
 	// Video ffmpeg context - not used for audio
@@ -108,6 +138,10 @@ class MediaEngine
 	AVFrame *m_pFrameRGB;
 	AVIOContext *m_pIOContext;
 	SwsContext *m_sws_ctx;
+	// The last shown frame, when it skipped swscale and is converted as it's written instead.
+	AVFrame *m_pFrameYUV;
+	bool m_directFrame;
+	int m_directPixelMode;
 #endif
 
 	int m_sws_fmt;
@@ -140,4 +174,25 @@ class MediaEngine
 
 	// used for audio type 
 	int m_audioType;
+
+	// Guards m_pdata and the rest of these while the decode thread runs.
+	std::mutex m_decodeLock;
+	std::condition_variable m_decodeWake;
+	std::condition_variable m_decodeDone;
+	std::thread *m_decodeThread;
+	bool m_decodeAhead;
+	bool m_decodeStop;
+	bool m_decodePause;
+	bool m_decodeParked;
+	// The game is waiting on the frame being decoded, so reads shouldn't wait for more data.
+	bool m_decodeWaiting;
+	// How many frames may be decoded before the game asks for them.
+	size_t m_decodeAheadFrames;
+	// Bytes at the front of m_pdata the decode thread has already read.
+	int m_readAheadBytes;
+	int m_decodingReadBytes;
+	int m_decodingLastReadSize;
+#ifdef USE_FFMPEG
+	std::deque<DecodedVideoFrame> m_decodedFrames;
+#endif
 };
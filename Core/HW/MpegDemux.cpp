@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "MpegDemux.h"
 #include "Core/Reporting.h"
 
@@ -19,13 +21,31 @@ const int PRIVATE_STREAM_1         = 0x000001bd;
 const int PADDING_STREAM           = 0x000001be;
 const int PRIVATE_STREAM_2         = 0x000001bf;
 
-MpegDemux::MpegDemux(int size, int offset) : m_audioStream(size) {
+// Packets are at most 64 KB, so this is just "not near one".
+const int SCAN_FAR_FROM_START_CODE = 0x20000;
+// demux() wants 16 bytes after a start code before it'll look at it.
+const int SCAN_NEAR_START_CODE = 4 + 16;
+
+MpegDemux::MpegDemux(int size, int offset, bool keepWholeStream) : m_audioStream(size) {
 	m_buf = new u8[size];
 
 	m_len = size;
-	m_index = offset;
+	m_keepWholeStream = keepWholeStream;
+	m_index = keepWholeStream ? offset : 0;
 	m_audioChannel = -1;
 	m_readSize = 0;
+
+	m_scanCode = 0xFF;
+	m_scanLengthBytes = -1;
+	m_scanLength = 0;
+	// The header isn't demuxed.
+	m_skipRemaining = keepWholeStream ? 0 : offset;
+	m_copyRemaining = 0;
+	m_rawSize = 0;
+	for (int i = 0; i < SCAN_RECENT_START_CODES; ++i)
+		m_sinceStartCode[i] = SCAN_FAR_FROM_START_CODE;
+	m_scanTrailing = 0;
+	m_inPacket = false;
 }
 
 MpegDemux::~MpegDemux() {
@@ -33,7 +53,7 @@ MpegDemux::~MpegDemux() {
 }
 
 void MpegDemux::DoState(PointerWrap &p) {
-	auto s = p.Section("MpegDemux", 1);
+	auto s = p.Section("MpegDemux", 1, 2);
 	if (!s)
 		return;
 
@@ -44,16 +64,159 @@ void MpegDemux::DoState(PointerWrap &p) {
 	if (m_buf)
 		p.DoArray(m_buf, m_len);
 	p.DoClass(m_audioStream);
+
+	if (s >= 2) {
+		p.Do(m_scanCode);
+		p.Do(m_scanLengthBytes);
+		p.Do(m_scanLength);
+		p.Do(m_skipRemaining);
+		p.Do(m_copyRemaining);
+		p.Do(m_rawSize);
+		p.DoArray(m_sinceStartCode, SCAN_RECENT_START_CODES);
+		p.Do(m_scanTrailing);
+		p.Do(m_inPacket);
+	} else if (m_buf) {
+		// This used to keep the whole stream, so pick the audio out of it again.
+		u8 *raw = m_buf;
+		int rawStart = m_index;
+		int rawSize = m_readSize;
+		m_buf = new u8[m_len];
+		m_index = 0;
+		m_readSize = 0;
+		m_scanCode = 0xFF;
+		m_scanLengthBytes = -1;
+		m_scanLength = 0;
+		m_skipRemaining = 0;
+		m_copyRemaining = 0;
+		for (int i = 0; i < SCAN_RECENT_START_CODES; ++i)
+			m_sinceStartCode[i] = SCAN_FAR_FROM_START_CODE;
+		m_scanTrailing = 0;
+		m_inPacket = false;
+		scanStreamData(raw + rawStart, rawSize - rawStart);
+		m_rawSize = rawSize;
+		delete [] raw;
+	}
 }
 
 bool MpegDemux::addStreamData(const u8 *buf, int addSize) {
-	if (m_readSize + addSize > m_len)
+	// Still counts everything, since that's what limits how much a PSMF player reads in.
+	if (m_rawSize + addSize > m_len)
 		return false;
-	memcpy(m_buf + m_readSize, buf, addSize);
-	m_readSize += addSize;
+	m_rawSize += addSize;
+	if (m_keepWholeStream) {
+		memcpy(m_buf + m_readSize, buf, addSize);
+		m_readSize += addSize;
+	} else {
+		scanStreamData(buf, addSize);
+	}
 	return true;
 }
 
+static bool hasPacketLength(u32 startCode) {
+	switch (startCode) {
+	case SYSTEM_HEADER_START_CODE:
+	case PADDING_STREAM:
+	case PRIVATE_STREAM_1:
+	case PRIVATE_STREAM_2:
+		return true;
+	default:
+		return (startCode & 0xFFFFFFF0) == 0x1E0;
+	}
+}
+
+// Video is most of the stream and FFmpeg has its own copy, so only audio packets are kept for demux().
+// Everything else gets skipped over the same way demux() would, without copying it first.
+void MpegDemux::scanStreamData(const u8 *buf, int size) {
+	int pos = 0;
+	while (pos < size) {
+		if (m_skipRemaining > 0 || m_copyRemaining > 0) {
+			int n = std::min(m_skipRemaining + m_copyRemaining, size - pos);
+			if (m_copyRemaining > 0) {
+				memcpy(m_buf + m_readSize, buf + pos, n);
+				m_readSize += n;
+				m_copyRemaining -= n;
+			} else {
+				m_skipRemaining -= n;
+			}
+			pos += n;
+			ageStartCodes(n);
+			if (m_skipRemaining + m_copyRemaining == 0) {
+				m_inPacket = false;
+				m_scanTrailing = 0;
+			}
+			continue;
+		}
+
+		int c = buf[pos++];
+		ageStartCodes(1);
+		if (m_scanLengthBytes >= 0) {
+			m_scanLength = (m_scanLength << 8) | c;
+			if (++m_scanLengthBytes < 2)
+				continue;
+
+			// Keep audio packets whole, start code and all, so demux() can parse them as usual.
+			if (m_scanCode == PRIVATE_STREAM_1 && m_readSize + 6 + m_scanLength <= m_len) {
+				u8 *dest = m_buf + m_readSize;
+				dest[0] = 0x00;
+				dest[1] = 0x00;
+				dest[2] = 0x01;
+				dest[3] = PRIVATE_STREAM_1 & 0xFF;
+				dest[4] = m_scanLength >> 8;
+				dest[5] = m_scanLength & 0xFF;
+				m_readSize += 6;
+				m_copyRemaining = m_scanLength;
+			} else {
+				m_skipRemaining = m_scanLength;
+			}
+			if (m_scanLength == 0) {
+				m_inPacket = false;
+				m_scanTrailing = 0;
+			}
+			m_scanLengthBytes = -1;
+			m_scanCode = 0xFF;
+			continue;
+		}
+
+		m_scanCode = (m_scanCode << 8) | c;
+		m_scanTrailing++;
+		if ((m_scanCode & PACKET_START_CODE_MASK) != PACKET_START_CODE_PREFIX)
+			continue;
+
+		memmove(m_sinceStartCode + 1, m_sinceStartCode, sizeof(m_sinceStartCode) - sizeof(m_sinceStartCode[0]));
+		m_sinceStartCode[0] = 4;
+		if (hasPacketLength(m_scanCode)) {
+			m_scanLengthBytes = 0;
+			m_scanLength = 0;
+			m_inPacket = true;
+		} else {
+			// Pack headers have no start codes inside, this just keeps count like skipPackHeader().
+			if (m_scanCode == PACK_START_CODE)
+				m_skipRemaining = 10;
+			m_scanCode = 0xFF;
+			m_scanTrailing = 0;
+		}
+	}
+}
+
+void MpegDemux::ageStartCodes(int bytes) {
+	for (int i = 0; i < SCAN_RECENT_START_CODES; ++i)
+		m_sinceStartCode[i] = std::min(m_sinceStartCode[i] + bytes, SCAN_FAR_FROM_START_CODE);
+}
+
+// How much demux() would have left unparsed if it had the whole stream, which is some of the
+// current packet, or if there's no packet, a few bytes in case they're part of a start code.
+int MpegDemux::scanLeftoverSize() const {
+	int leftover = m_inPacket ? m_sinceStartCode[0] : 0;
+	// It also stops at the first start code too near the end, even if the packet is complete.
+	for (int i = 0; i < SCAN_RECENT_START_CODES; ++i) {
+		if (m_sinceStartCode[i] < SCAN_NEAR_START_CODE)
+			leftover = std::max(leftover, m_sinceStartCode[i]);
+	}
+	if (leftover == 0 && m_scanTrailing > 0)
+		return 4;
+	return leftover;
+}
+
 int MpegDemux::readPesHeader(PesHeader &pesHeader, int length, int startCode) {
 	int c = 0;
 	while (length > 0) {
@@ -282,18 +445,19 @@ bool MpegDemux::demux(int audioChannel)
 		m_index = 0;
 		m_readSize = 0;
 	}
+	m_rawSize = m_keepWholeStream ? m_readSize : scanLeftoverSize();
 
 	return looksValid;
 }
 
-static bool isHeader(u8* audioStream, int offset)
+static bool isHeader(const u8 *audioStream, int offset)
 {
 	const u8 header1 = (u8)0x0F;
 	const u8 header2 = (u8)0xD0;
 	return (audioStream[offset] == header1) && (audioStream[offset+1] == header2);
 }
 
-static int getNextHeaderPosition(u8* audioStream, int curpos, int limit, int frameSize)
+static int getNextHeaderPosition(const u8 *audioStream, int curpos, int limit, int frameSize)
 {
 	int endScan = limit - 1;
 
@@ -311,31 +475,40 @@ static int getNextHeaderPosition(u8* audioStream, int curpos, int limit, int fra
 
 int MpegDemux::getNextAudioFrame(u8 **buf, int *headerCode1, int *headerCode2, s64 *pts)
 {
+	u8 *frame;
 	int gotsize;
 	int frameSize;
-	if (!hasNextAudioFrame(&gotsize, &frameSize, headerCode1, headerCode2))
+	if (!peekNextAudioFrame(&frame, &gotsize, &frameSize, headerCode1, headerCode2))
 		return 0;
 	int audioPos = 8;
-	int nextHeader = getNextHeaderPosition(m_audioFrame, audioPos, gotsize, frameSize);
+	int nextHeader = getNextHeaderPosition(frame, audioPos, gotsize, frameSize);
 	if (nextHeader >= 0) {
 		audioPos = nextHeader;
 	} else {
 		audioPos = gotsize;
 	}
+	// Nothing is pushed again until the next demux(), so the frame stays put until it's decoded.
 	m_audioStream.pop_front(0, audioPos, pts);
 	if (buf) {
-		*buf = m_audioFrame + 8;
+		*buf = frame + 8;
 	}
 	return frameSize - 8;
 }
 
 bool MpegDemux::hasNextAudioFrame(int *gotsizeOut, int *frameSizeOut, int *headerCode1, int *headerCode2)
 {
-	int gotsize = m_audioStream.get_front(m_audioFrame, 0x2000);
-	if (gotsize < 4 || !isHeader(m_audioFrame, 0))
+	u8 *frame;
+	return peekNextAudioFrame(&frame, gotsizeOut, frameSizeOut, headerCode1, headerCode2);
+}
+
+bool MpegDemux::peekNextAudioFrame(u8 **frame, int *gotsizeOut, int *frameSizeOut, int *headerCode1, int *headerCode2)
+{
+	// The whole 0x2000 is readable either way, which also covers the decoder's input padding.
+	int gotsize = m_audioStream.peek_front(m_audioFrame, frame, 0x2000);
+	if (gotsize < 4 || !isHeader(*frame, 0))
 		return false;
-	u8 code1 = m_audioFrame[2];
-	u8 code2 = m_audioFrame[3];
+	u8 code1 = (*frame)[2];
+	u8 code2 = (*frame)[3];
 	int frameSize = (((code1 & 0x03) << 8) | (code2 * 8)) + 0x10;
 	if (frameSize > gotsize)
 		return false;
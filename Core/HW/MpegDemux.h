@@ -11,7 +11,9 @@ class PointerWrap;
 class MpegDemux
 {
 public:
-	MpegDemux(int size, int offset);
+	// With keepWholeStream, every packet is kept and checked by demux(), not just the audio.
+	// That's slower, but it's what tells whether data looks like a movie stream at all.
+	MpegDemux(int size, int offset, bool keepWholeStream = false);
 	~MpegDemux();
 
 	bool addStreamData(const u8 *buf, int addSize);
@@ -22,7 +24,7 @@ class MpegDemux
 	bool hasNextAudioFrame(int *gotsizeOut, int *frameSizeOut, int *headerCode1, int *headerCode2);
 
 	int getRemainSize() const {
-		return m_len - m_readSize;
+		return m_len - m_rawSize;
 	}
 
 	void DoState(PointerWrap &p);
@@ -66,13 +68,34 @@ class MpegDemux
 	int readPesHeader(PesHeader &pesHeader, int length, int startCode);
 	int demuxStream(bool bdemux, int startCode, int length, int channel);
 	bool skipPackHeader();
+	void scanStreamData(const u8 *buf, int size);
+	void ageStartCodes(int bytes);
+	int scanLeftoverSize() const;
+	bool peekNextAudioFrame(u8 **frame, int *gotsizeOut, int *frameSizeOut, int *headerCode1, int *headerCode2);
 
 	int m_index;
 	int m_len;
+	// Only the audio packets unless m_keepWholeStream, the rest of the stream is skipped as it's added.
 	u8 *m_buf;
 	BufferQueue m_audioStream;
+	// Only used when a frame wraps around m_audioStream.
 	u8  m_audioFrame[0x2000];
 	int m_audioChannel;
 	int m_readSize;
+
+	// Where addStreamData() left off: looking for a start code, reading a packet length, or inside a packet.
+	u32 m_scanCode;
+	int m_scanLengthBytes;
+	int m_scanLength;
+	int m_skipRemaining;
+	int m_copyRemaining;
+	// Bytes since the last few start codes, enough to cover any that fit in 16 bytes.
+	enum { SCAN_RECENT_START_CODES = 5 };
+	int m_sinceStartCode[SCAN_RECENT_START_CODES];
+	int m_scanTrailing;
+	bool m_inPacket;
+	// How much of the stream is still waiting to be demuxed, as if all of it was kept.
+	int m_rawSize;
+	bool m_keepWholeStream;
 };
 
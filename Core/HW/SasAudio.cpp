@@ -16,17 +16,31 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include <algorithm>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
+#include "ppsspp_config.h"
 #include "base/basictypes.h"
 #include "profiler/profiler.h"
+#include "thread/threadpool.h"
+#include "ext/xxhash.h"
 
 #include "Core/MemMapHelpers.h"
+#include "Core/HLE/__sceAudio.h"
 #include "Core/HLE/sceAtrac.h"
 #include "Core/Config.h"
 #include "Core/Reporting.h"
 #include "Core/Util/AudioFormat.h"
 #include "SasAudio.h"
 
+#ifdef _M_SSE
+#include <emmintrin.h>
+#endif
+#if PPSSPP_ARCH(ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 // #define AUDIO_TO_FILE
 
 static const u8 f[16][2] = {
@@ -50,7 +64,139 @@ static const u8 f[16][2] = {
 	{   0, 151 },
 };
 
+// A VAG decoded up to its end, or up to where it first loops back (after which the decoder
+// state differs each time around.)  Shared by every voice playing the same data.
+struct DecodedVag {
+	// What the decoder looks like after each block, so we can pick up decoding anywhere.
+	struct BlockState {
+		s16 s1;
+		s16 s2;
+		int loopStartBlock;
+		bool loopAtNextBlock;
+	};
+
+	u32 addr;
+	u32 hash;
+	u32 hashBytes;
+	u64 lastUsed;
+	// 28 for each block.
+	std::vector<s16> samples;
+	std::vector<BlockState> states;
+
+	int NumBlocks() const {
+		return (int)states.size();
+	}
+};
+
+// Short sound effects are what get played over and over.  Longer ones only have their first
+// blocks cached, and the rest is decoded from memory as it plays.
+static const int VAG_CACHE_MAX_BLOCKS = 4096;
+static const size_t VAG_CACHE_MAX_SAMPLES = 8 * 1024 * 1024;
+
+// Only the sceKernelDcache* calls invalidate this (see VagCache_Invalidate.)  Anything else that
+// writes the data, like Memcpy, DMA or the CPU itself, is caught by the hash check at keyon.
+static std::mutex vagCacheLock;
+static std::unordered_map<u64, std::shared_ptr<DecodedVag>> vagCache;
+static size_t vagCacheSamples = 0;
+static u64 vagCacheTime = 0;
+
+static u64 VagCacheKey(u32 addr, u32 vagSize, bool loopEnabled) {
+	// Sizes are always a multiple of 16, so the low bit is free.
+	return ((u64)addr << 32) | vagSize | (loopEnabled ? 1 : 0);
+}
+
+static void VagCacheRemove(std::unordered_map<u64, std::shared_ptr<DecodedVag>>::iterator it) {
+	vagCacheSamples -= it->second->samples.size();
+	vagCache.erase(it);
+}
+
+void VagCache_Invalidate(u32 addr, int size) {
+	std::lock_guard<std::mutex> guard(vagCacheLock);
+	const u32 end = addr + (u32)size;
+	for (auto it = vagCache.begin(); it != vagCache.end(); ) {
+		const DecodedVag &vag = *it->second;
+		auto next = std::next(it);
+		if (vag.addr < end && addr < vag.addr + vag.hashBytes) {
+			VagCacheRemove(it);
+		}
+		it = next;
+	}
+}
+
+void VagCache_Clear() {
+	std::lock_guard<std::mutex> guard(vagCacheLock);
+	vagCache.clear();
+	vagCacheSamples = 0;
+}
+
+std::shared_ptr<DecodedVag> VagDecoder::DecodeAll(u32 data, u32 vagSize, bool loopEnabled) {
+	VagDecoder dec;
+	dec.Reset(data, vagSize, loopEnabled);
+	// We may read one block past the end, just like GetSamples().
+	const int maxBlocks = std::min(dec.numBlocks_, VAG_CACHE_MAX_BLOCKS);
+	if (!Memory::IsValidRange(data, (maxBlocks + 1) * 16)) {
+		return nullptr;
+	}
+
+	std::shared_ptr<DecodedVag> vag = std::make_shared<DecodedVag>();
+	vag->addr = data;
+	u8 *readp = Memory::GetPointerUnchecked(data);
+	while (vag->NumBlocks() < maxBlocks) {
+		dec.DecodeBlock(readp);
+		if (dec.end_)
+			break;
+		vag->samples.insert(vag->samples.end(), dec.samples, dec.samples + ARRAY_SIZE(dec.samples));
+		vag->states.push_back({ (s16)dec.s_1, (s16)dec.s_2, dec.loopStartBlock_, dec.loopAtNextBlock_ });
+		if (dec.loopAtNextBlock_)
+			break;
+	}
+	if (vag->states.empty()) {
+		return nullptr;
+	}
+
+	// The block that ended it counts too, since its flags decided that.
+	vag->hashBytes = (vag->NumBlocks() + (dec.end_ ? 1 : 0)) * 16;
+	vag->hash = XXH32(Memory::GetPointerUnchecked(data), vag->hashBytes, 0x5A5F5641);
+	return vag;
+}
+
+std::shared_ptr<const DecodedVag> VagDecoder::GetDecoded(u32 data, u32 vagSize, bool loopEnabled) {
+	std::lock_guard<std::mutex> guard(vagCacheLock);
+	const u64 key = VagCacheKey(data, vagSize, loopEnabled);
+	auto it = vagCache.find(key);
+	if (it != vagCache.end()) {
+		DecodedVag &vag = *it->second;
+		// Games may load something else over it without telling us, so check.
+		if (Memory::IsValidRange(data, vag.hashBytes) && XXH32(Memory::GetPointerUnchecked(data), vag.hashBytes, 0x5A5F5641) == vag.hash) {
+			vag.lastUsed = ++vagCacheTime;
+			return it->second;
+		}
+		VagCacheRemove(it);
+	}
+
+	std::shared_ptr<DecodedVag> vag = DecodeAll(data, vagSize, loopEnabled);
+	if (!vag) {
+		return nullptr;
+	}
+
+	vag->lastUsed = ++vagCacheTime;
+	vagCacheSamples += vag->samples.size();
+	vagCache[key] = vag;
+	while (vagCacheSamples > VAG_CACHE_MAX_SAMPLES) {
+		auto oldest = std::min_element(vagCache.begin(), vagCache.end(), [](const std::pair<const u64, std::shared_ptr<DecodedVag>> &a, const std::pair<const u64, std::shared_ptr<DecodedVag>> &b) {
+			return a.second->lastUsed < b.second->lastUsed;
+		});
+		VagCacheRemove(oldest);
+	}
+	return vag;
+}
+
 void VagDecoder::Start(u32 data, u32 vagSize, bool loopEnabled) {
+	Reset(data, vagSize, loopEnabled);
+	cached_ = GetDecoded(data, vagSize, loopEnabled);
+}
+
+void VagDecoder::Reset(u32 data, u32 vagSize, bool loopEnabled) {
 	loopEnabled_ = loopEnabled;
 	loopAtNextBlock_ = false;
 	loopStartBlock_ = -1;
@@ -62,6 +208,23 @@ void VagDecoder::Start(u32 data, u32 vagSize, bool loopEnabled) {
 	curBlock_ = -1;
 	s_1 = 0;	// per block?
 	s_2 = 0;
+	cached_.reset();
+}
+
+// Fills in the decoder as if it had decoded everything streamed from the cache so far.
+void VagDecoder::SyncFromCache() {
+	if (curBlock_ < 0) {
+		// Nothing streamed yet, so it's still as Reset() left it.
+		return;
+	}
+	const DecodedVag::BlockState &state = cached_->states[curBlock_];
+	memcpy(samples, &cached_->samples[curBlock_ * ARRAY_SIZE(samples)], sizeof(samples));
+	s_1 = state.s1;
+	s_2 = state.s2;
+	loopStartBlock_ = state.loopStartBlock;
+	loopAtNextBlock_ = state.loopAtNextBlock;
+	// data_ starts at curBlock = -1.
+	read_ = data_ + 16 * curBlock_ + 16;
 }
 
 void VagDecoder::DecodeBlock(u8 *&read_pointer) {
@@ -114,6 +277,29 @@ void VagDecoder::DecodeBlock(u8 *&read_pointer) {
 }
 
 void VagDecoder::GetSamples(s16 *outSamples, int numSamples) {
+	if (cached_) {
+		const int numBlocks = cached_->NumBlocks();
+		while (numSamples > 0) {
+			if (curSample == 28) {
+				if (curBlock_ + 1 >= numBlocks) {
+					// That's all that was cached, decode the rest (or find the end) as usual.
+					SyncFromCache();
+					cached_.reset();
+					break;
+				}
+				curBlock_++;
+				curSample = 0;
+			}
+			const int count = std::min(28 - curSample, numSamples);
+			memcpy(outSamples, &cached_->samples[curBlock_ * 28 + curSample], count * sizeof(s16));
+			curSample += count;
+			outSamples += count;
+			numSamples -= count;
+		}
+		if (numSamples == 0)
+			return;
+	}
+
 	if (end_) {
 		memset(outSamples, 0, numSamples * sizeof(s16));
 		return;
@@ -156,6 +342,12 @@ void VagDecoder::DoState(PointerWrap &p) {
 	if (!s)
 		return;
 
+	if (p.mode == PointerWrap::MODE_READ) {
+		cached_.reset();
+	} else if (cached_) {
+		SyncFromCache();
+	}
+
 	if (s >= 2) {
 		p.DoArray(samples, ARRAY_SIZE(samples));
 	} else {
@@ -472,96 +664,274 @@ bool SasVoice::HaveSamplesEnded() const {
 	}
 }
 
-void SasInstance::MixVoice(SasVoice &voice) {
+// Linear interpolation. Good enough. Need to make resampleHist bigger if we want more.
+u32 ResampleVoice(int *out, const int16_t *src, u32 sampleFrac, int pitch, int count) {
+	int i = 0;
+	if ((pitch & PSP_SAS_PITCH_MASK) == 0) {
+		// Whole steps (1x, 2x, 4x) keep the same fraction for the entire grain.
+		const int step = pitch >> PSP_SAS_PITCH_BASE_SHIFT;
+		const int f = sampleFrac & PSP_SAS_PITCH_MASK;
+		const int16_t *s = src + (sampleFrac >> PSP_SAS_PITCH_BASE_SHIFT);
+#ifdef _M_SSE
+		// Each pair of (s[0], s[1]) gets multiplied and summed by madd.
+		const __m128i weights = _mm_set1_epi32((PSP_SAS_PITCH_MASK - f) | (f << 16));
+		if (step == 1) {
+			for (; i + 8 <= count; i += 8) {
+				const __m128i s0 = _mm_loadu_si128((const __m128i *)(s + i));
+				const __m128i s1 = _mm_loadu_si128((const __m128i *)(s + i + 1));
+				const __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi16(s0, s1), weights);
+				const __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi16(s0, s1), weights);
+				_mm_storeu_si128((__m128i *)(out + i), _mm_srai_epi32(lo, PSP_SAS_PITCH_BASE_SHIFT));
+				_mm_storeu_si128((__m128i *)(out + i + 4), _mm_srai_epi32(hi, PSP_SAS_PITCH_BASE_SHIFT));
+			}
+		} else if (step == 2) {
+			// Here the pairs are already next to each other.
+			for (; i + 4 <= count; i += 4) {
+				const __m128i pairs = _mm_loadu_si128((const __m128i *)(s + i * 2));
+				_mm_storeu_si128((__m128i *)(out + i), _mm_srai_epi32(_mm_madd_epi16(pairs, weights), PSP_SAS_PITCH_BASE_SHIFT));
+			}
+		}
+#elif PPSSPP_ARCH(ARM_NEON)
+		const int16_t w0 = PSP_SAS_PITCH_MASK - f;
+		const int16_t w1 = f;
+		if (step == 1) {
+			for (; i + 4 <= count; i += 4) {
+				int32x4_t sum = vmull_n_s16(vld1_s16(s + i), w0);
+				sum = vmlal_n_s16(sum, vld1_s16(s + i + 1), w1);
+				vst1q_s32(out + i, vshrq_n_s32(sum, PSP_SAS_PITCH_BASE_SHIFT));
+			}
+		} else if (step == 2) {
+			for (; i + 4 <= count; i += 4) {
+				const int16x4x2_t pairs = vld2_s16(s + i * 2);
+				int32x4_t sum = vmull_n_s16(pairs.val[0], w0);
+				sum = vmlal_n_s16(sum, pairs.val[1], w1);
+				vst1q_s32(out + i, vshrq_n_s32(sum, PSP_SAS_PITCH_BASE_SHIFT));
+			}
+		}
+#endif
+		for (; i < count; i++) {
+			const int16_t *si = s + i * step;
+			out[i] = (si[0] * (PSP_SAS_PITCH_MASK - f) + si[1] * f) >> PSP_SAS_PITCH_BASE_SHIFT;
+		}
+		return sampleFrac + (u32)pitch * (u32)count;
+	}
+
+	for (; i < count; i++) {
+		const int16_t *s = src + (sampleFrac >> PSP_SAS_PITCH_BASE_SHIFT);
+		int f = sampleFrac & PSP_SAS_PITCH_MASK;
+		out[i] = (s[0] * (PSP_SAS_PITCH_MASK - f) + s[1] * f) >> PSP_SAS_PITCH_BASE_SHIFT;
+		sampleFrac += pitch;
+	}
+	return sampleFrac;
+}
+
+// Scales samples by the envelope, and then adds them into both stereo buffers by volume.
+static void MixScaledSamples(int *mix, int *send, const int *samples, const int *envelope, int count, const SasVoice &voice) {
+	int i = 0;
+#ifdef _M_SSE
+	const __m128i dryVolume = _mm_setr_epi32(voice.volumeLeft, voice.volumeRight, voice.volumeLeft, voice.volumeRight);
+	const __m128i sendVolume = _mm_setr_epi32(voice.effectLeft, voice.effectRight, voice.effectLeft, voice.effectRight);
+	const __m128i round = _mm_set1_epi32(1 << 14);
+	for (; i + 4 <= count; i += 4) {
+		const __m128i s = _mm_loadu_si128((const __m128i *)(samples + i));
+		const __m128i e = _mm_loadu_si128((const __m128i *)(envelope + i));
+		const __m128i v = _mm_srai_epi32(_mm_add_epi32(MulLo32(s, e), round), 15);
+		// Duplicate each sample for the left and right channels.
+		const __m128i v01 = _mm_unpacklo_epi32(v, v);
+		const __m128i v23 = _mm_unpackhi_epi32(v, v);
+
+		__m128i *m = (__m128i *)(mix + i * 2);
+		_mm_storeu_si128(m, _mm_add_epi32(_mm_loadu_si128(m), _mm_srai_epi32(MulLo32(v01, dryVolume), 12)));
+		_mm_storeu_si128(m + 1, _mm_add_epi32(_mm_loadu_si128(m + 1), _mm_srai_epi32(MulLo32(v23, dryVolume), 12)));
+		__m128i *fx = (__m128i *)(send + i * 2);
+		_mm_storeu_si128(fx, _mm_add_epi32(_mm_loadu_si128(fx), _mm_srai_epi32(MulLo32(v01, sendVolume), 12)));
+		_mm_storeu_si128(fx + 1, _mm_add_epi32(_mm_loadu_si128(fx + 1), _mm_srai_epi32(MulLo32(v23, sendVolume), 12)));
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	const int32x4_t round = vdupq_n_s32(1 << 14);
+	for (; i + 4 <= count; i += 4) {
+		int32x4_t v = vmulq_s32(vld1q_s32(samples + i), vld1q_s32(envelope + i));
+		v = vshrq_n_s32(vaddq_s32(v, round), 15);
+
+		int32x4x2_t dry = vld2q_s32(mix + i * 2);
+		dry.val[0] = vaddq_s32(dry.val[0], vshrq_n_s32(vmulq_n_s32(v, voice.volumeLeft), 12));
+		dry.val[1] = vaddq_s32(dry.val[1], vshrq_n_s32(vmulq_n_s32(v, voice.volumeRight), 12));
+		vst2q_s32(mix + i * 2, dry);
+		int32x4x2_t fx = vld2q_s32(send + i * 2);
+		fx.val[0] = vaddq_s32(fx.val[0], vshrq_n_s32(vmulq_n_s32(v, voice.effectLeft), 12));
+		fx.val[1] = vaddq_s32(fx.val[1], vshrq_n_s32(vmulq_n_s32(v, voice.effectRight), 12));
+		vst2q_s32(send + i * 2, fx);
+	}
+#endif
+	for (; i < count; i++) {
+		// We just scale by the envelope before we scale by volumes.
+		// Again, we round up by adding (1 << 14) first (*after* multiplying.)
+		int sample = ((samples[i] * envelope[i]) + (1 << 14)) >> 15;
+
+		// We mix into this 32-bit temp buffer and clip in a second loop
+		// Ideally, the shift right should be there too but for now I'm concerned about
+		// not overflowing.
+		mix[i * 2] += (sample * voice.volumeLeft) >> 12;
+		mix[i * 2 + 1] += (sample * voice.volumeRight) >> 12;
+		send[i * 2] += sample * voice.effectLeft >> 12;
+		send[i * 2 + 1] += sample * voice.effectRight >> 12;
+	}
+}
+
+// Reads the voice's samples for this grain, the only part of mixing that touches emulated memory.
+// Returns false if the voice has nothing to play.
+bool SasInstance::ReadVoice(SasVoice &voice, int16_t *temp, VoiceRead &read) {
 	switch (voice.type) {
 	case VOICETYPE_VAG:
 		if (voice.type == VOICETYPE_VAG && !voice.vagAddr)
-			break;
+			return false;
 		// else fallthrough! Don't change the check above.
 	case VOICETYPE_PCM:
 		if (voice.type == VOICETYPE_PCM && !voice.pcmAddr)
-			break;
+			return false;
 		// else fallthrough! Don't change the check above.
 	default:
-		// This feels a bit hacky.  The first 32 samples after a keyon are 0s.
-		int delay = 0;
-		if (voice.envelope.NeedsKeyOn()) {
-			const bool ignorePitch = voice.type == VOICETYPE_PCM && voice.pitch > PSP_SAS_PITCH_BASE;
-			delay = ignorePitch ? 32 : (32 * (u32)voice.pitch) >> PSP_SAS_PITCH_BASE_SHIFT;
-			// VAG seems to have an extra sample delay (not shared by PCM.)
-			if (voice.type == VOICETYPE_VAG)
-				++delay;
-		}
+		break;
+	}
 
-		// Resample to the correct pitch, writing exactly "grainSize" samples. We need a buffer that can
-		// fit 4x that, as the max pitch is 0x4000.
-		// TODO: Special case no-resample case (and 2x and 0.5x) for speed, it's not uncommon
+	// This feels a bit hacky.  The first 32 samples after a keyon are 0s.
+	int delay = 0;
+	if (voice.envelope.NeedsKeyOn()) {
+		const bool ignorePitch = voice.type == VOICETYPE_PCM && voice.pitch > PSP_SAS_PITCH_BASE;
+		delay = ignorePitch ? 32 : (32 * (u32)voice.pitch) >> PSP_SAS_PITCH_BASE_SHIFT;
+		// VAG seems to have an extra sample delay (not shared by PCM.)
+		if (voice.type == VOICETYPE_VAG)
+			++delay;
+	}
 
-		// Two passes: First read, then resample.
-		mixTemp_[0] = voice.resampleHist[0];
-		mixTemp_[1] = voice.resampleHist[1];
+	// Resample to the correct pitch, writing exactly "grainSize" samples. We need a buffer that can
+	// fit 4x that, as the max pitch is 0x4000.
 
-		int voicePitch = voice.pitch;
-		u32 sampleFrac = voice.sampleFrac;
-		int samplesToRead = (sampleFrac + voicePitch * std::max(0, grainSize - delay)) >> PSP_SAS_PITCH_BASE_SHIFT;
-		if (samplesToRead > ARRAY_SIZE(mixTemp_) - 2) {
-			ERROR_LOG(SCESAS, "Too many samples to read (%d)! This shouldn't happen.", samplesToRead);
-			samplesToRead = ARRAY_SIZE(mixTemp_) - 2;
-		}
-		voice.ReadSamples(&mixTemp_[2], samplesToRead);
-		int tempPos = 2 + samplesToRead;
-
-		for (int i = delay; i < grainSize; i++) {
-			const int16_t *s = mixTemp_ + (sampleFrac >> PSP_SAS_PITCH_BASE_SHIFT);
-
-			// Linear interpolation. Good enough. Need to make resampleHist bigger if we want more.
-			int f = sampleFrac & PSP_SAS_PITCH_MASK;
-			int sample = (s[0] * (PSP_SAS_PITCH_MASK - f) + s[1] * f) >> PSP_SAS_PITCH_BASE_SHIFT;
-			sampleFrac += voicePitch;
-
-			// The maximum envelope height (PSP_SAS_ENVELOPE_HEIGHT_MAX) is (1 << 30) - 1.
-			// Reduce it to 14 bits, by shifting off 15.  Round up by adding (1 << 14) first.
-			int envelopeValue = voice.envelope.GetHeight();
-			voice.envelope.Step();
-			envelopeValue = (envelopeValue + (1 << 14)) >> 15;
-
-			// We just scale by the envelope before we scale by volumes.
-			// Again, we round up by adding (1 << 14) first (*after* multiplying.)
-			sample = ((sample * envelopeValue) + (1 << 14)) >> 15;
-
-			// We mix into this 32-bit temp buffer and clip in a second loop
-			// Ideally, the shift right should be there too but for now I'm concerned about
-			// not overflowing.
-			mixBuffer[i * 2] += (sample * voice.volumeLeft) >> 12;
-			mixBuffer[i * 2 + 1] += (sample * voice.volumeRight) >> 12;
-			sendBuffer[i * 2] += sample * voice.effectLeft >> 12;
-			sendBuffer[i * 2 + 1] += sample * voice.effectRight >> 12;
-		}
+	// Three passes: First read, then resample, then scale and mix.
+	temp[0] = voice.resampleHist[0];
+	temp[1] = voice.resampleHist[1];
 
-		voice.resampleHist[0] = mixTemp_[tempPos - 2];
-		voice.resampleHist[1] = mixTemp_[tempPos - 1];
+	int voicePitch = voice.pitch;
+	u32 sampleFrac = voice.sampleFrac;
+	int samplesToRead = (sampleFrac + voicePitch * std::max(0, grainSize - delay)) >> PSP_SAS_PITCH_BASE_SHIFT;
+	if (samplesToRead > ARRAY_SIZE(mixTemp_) - 2) {
+		ERROR_LOG(SCESAS, "Too many samples to read (%d)! This shouldn't happen.", samplesToRead);
+		samplesToRead = ARRAY_SIZE(mixTemp_) - 2;
+	}
+	voice.ReadSamples(&temp[2], samplesToRead);
+	int tempPos = 2 + samplesToRead;
+
+	read.delay = delay;
+	read.count = grainSize - delay;
+	read.sampleFrac = sampleFrac;
+	read.samplesEnded = voice.HaveSamplesEnded();
+
+	// Resampling always ends up at the same place, so the voice can move on already.
+	if (read.count > 0)
+		sampleFrac += (u32)voicePitch * (u32)read.count;
+	voice.resampleHist[0] = temp[tempPos - 2];
+	voice.resampleHist[1] = temp[tempPos - 1];
+
+	voice.sampleFrac = sampleFrac - (tempPos - 2) * PSP_SAS_PITCH_BASE;;
+	return true;
+}
 
-		voice.sampleFrac = sampleFrac - (tempPos - 2) * PSP_SAS_PITCH_BASE;;
+// Resamples what ReadVoice() read, and steps the envelope, adding the result into mix and send.
+void SasInstance::MixVoiceSamples(SasVoice &voice, const int16_t *temp, const VoiceRead &read, int *mix, int *send, int *resampleTemp, int *envelopeTemp) {
+	if (read.count > 0) {
+		ResampleVoice(resampleTemp, temp, read.sampleFrac, voice.pitch, read.count);
+		voice.envelope.StepBlock(envelopeTemp, read.count);
+		MixScaledSamples(mix + read.delay * 2, send + read.delay * 2, resampleTemp, envelopeTemp, read.count, voice);
+	}
 
-		if (voice.HaveSamplesEnded())
-			voice.envelope.End();
-		if (voice.envelope.HasEnded()) {
-			// NOTICE_LOG(SASMIX, "Hit end of envelope");
-			voice.playing = false;
-			voice.on = false;
-		}
+	if (read.samplesEnded)
+		voice.envelope.End();
+	if (voice.envelope.HasEnded()) {
+		// NOTICE_LOG(SASMIX, "Hit end of envelope");
+		voice.playing = false;
+		voice.on = false;
 	}
 }
 
-void SasInstance::Mix(u32 outAddr, u32 inAddr, int leftVol, int rightVol) {
-	int voicesPlayingCount = 0;
+void SasInstance::MixVoice(SasVoice &voice) {
+	VoiceRead read;
+	if (ReadVoice(voice, mixTemp_, read))
+		MixVoiceSamples(voice, mixTemp_, read, mixBuffer, sendBuffer, resampleTemp_, envelopeTemp_);
+}
+
+// More threads rarely help, since there are at most 32 voices and each is only a grain long.
+static const int SAS_MIX_THREADS_MAX = 4;
 
+// Reads every voice first, in order, on the thread doing the mix, then resamples and mixes slices of them
+// on worker threads. Integer sums don't depend on order, but the slices are still added up in voice order.
+int SasInstance::MixVoicesParallel() {
+	const size_t tempSize = ARRAY_SIZE(mixTemp_);
+	if (parallelTemp_.empty())
+		parallelTemp_.resize(tempSize * PSP_SAS_VOICES_MAX);
+
+	int playing[PSP_SAS_VOICES_MAX];
+	VoiceRead reads[PSP_SAS_VOICES_MAX];
+	int count = 0;
+	int voicesPlayingCount = 0;
 	for (int v = 0; v < PSP_SAS_VOICES_MAX; v++) {
 		SasVoice &voice = voices[v];
 		if (!voice.playing || voice.paused)
 			continue;
 		voicesPlayingCount++;
-		MixVoice(voice);
+		if (ReadVoice(voice, &parallelTemp_[count * tempSize], reads[count]))
+			playing[count++] = v;
+	}
+	if (count == 0)
+		return voicesPlayingCount;
+
+	if (!mixPool_) {
+		// Our own few threads, so voices never wait behind texture scaling or other users of the global pool.
+		mixPool_.reset(new ThreadPool(std::min(g_Config.iNumWorkerThreads, SAS_MIX_THREADS_MAX)));
+	}
+
+	const size_t mixSize = grainSize * 2;
+	auto mixSlice = [&](int lower, int upper) {
+		// Named by the first voice, so the same slices are always summed in the same order.
+		VoiceSlice &slice = parallelSlices_[lower];
+		slice.mix.assign(mixSize, 0);
+		slice.send.assign(mixSize, 0);
+		slice.resampleTemp.resize(grainSize);
+		slice.envelopeTemp.resize(grainSize);
+		for (int i = lower; i < upper; ++i)
+			MixVoiceSamples(voices[playing[i]], &parallelTemp_[i * tempSize], reads[i], &slice.mix[0], &slice.send[0], &slice.resampleTemp[0], &slice.envelopeTemp[0]);
+		slice.used = true;
+	};
+	mixPool_->ParallelLoop(mixSlice, 0, count);
+
+	for (int i = 0; i < count; ++i) {
+		VoiceSlice &slice = parallelSlices_[i];
+		if (!slice.used)
+			continue;
+		for (size_t j = 0; j < mixSize; ++j) {
+			mixBuffer[j] += slice.mix[j];
+			sendBuffer[j] += slice.send[j];
+		}
+		slice.used = false;
+	}
+	return voicesPlayingCount;
+}
+
+void SasInstance::Mix(u32 outAddr, u32 inAddr, int leftVol, int rightVol) {
+	int voicesPlayingCount = 0;
+
+	{
+		AudioProfileScope profile(AudioProfileStage::SAS_VOICES);
+		if (g_Config.bParallelSASVoices) {
+			voicesPlayingCount = MixVoicesParallel();
+		} else {
+			for (int v = 0; v < PSP_SAS_VOICES_MAX; v++) {
+				SasVoice &voice = voices[v];
+				if (!voice.playing || voice.paused)
+					continue;
+				voicesPlayingCount++;
+				MixVoice(voice);
+			}
+		}
 	}
 
 	// Then mix the send buffer in with the rest.
@@ -658,8 +1028,27 @@ void SasInstance::SetWaveformEffectType(int type) {
 // See http://report.ppsspp.org/logs/kind/772 for a list of games that use different types. Maybe can help us figure out
 // which is which.
 void SasInstance::ApplyWaveformEffect() {
+	AudioProfileScope profile(AudioProfileStage::SAS_REVERB);
+
 	// First, downsample the send buffer to 22khz. We do this naively for now.
-	for (int i = 0; i < grainSize / 2; i++) {
+	int i = 0;
+#ifdef _M_SSE
+	for (; i + 4 <= grainSize / 2; i += 4) {
+		const __m128i *s = (const __m128i *)(sendBuffer + i * 4);
+		const __m128i frames01 = _mm_unpacklo_epi64(_mm_loadu_si128(s), _mm_loadu_si128(s + 1));
+		const __m128i frames23 = _mm_unpacklo_epi64(_mm_loadu_si128(s + 2), _mm_loadu_si128(s + 3));
+		_mm_storeu_si128((__m128i *)(sendBufferDownsampled + i * 2), _mm_packs_epi32(frames01, frames23));
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	for (; i + 4 <= grainSize / 2; i += 4) {
+		const int32x4x4_t frames = vld4q_s32(sendBuffer + i * 4);
+		int16x4x2_t lr;
+		lr.val[0] = vqmovn_s32(frames.val[0]);
+		lr.val[1] = vqmovn_s32(frames.val[1]);
+		vst2_s16(sendBufferDownsampled + i * 2, lr);
+	}
+#endif
+	for (; i < grainSize / 2; i++) {
 		sendBufferDownsampled[i * 2] = clamp_s16(sendBuffer[i * 4]);
 		sendBufferDownsampled[i * 2 + 1] = clamp_s16(sendBuffer[i * 4 + 1]);
 	}
@@ -863,7 +1252,7 @@ void ADSREnvelope::SetState(ADSRState state) {
 	state_ = state;
 }
 
-inline void ADSREnvelope::Step() {
+void ADSREnvelope::Step() {
 	switch (state_) {
 	case STATE_ATTACK:
 		WalkCurve(attackType, attackRate);
@@ -910,6 +1299,99 @@ inline void ADSREnvelope::Step() {
 	}
 }
 
+// The maximum envelope height (PSP_SAS_ENVELOPE_HEIGHT_MAX) is (1 << 30) - 1.
+// Reduce it to 14 bits, by shifting off 15.  Round up by adding (1 << 14) first.
+static inline int ReduceEnvelope(int height) {
+	return (height + (1 << 14)) >> 15;
+}
+
+// For a linear curve, the per-step delta and how many Step()s until the phase ends (including that one.)
+bool ADSREnvelope::LinearStepsLeft(s64 &delta, s64 &steps) const {
+	// More than any grain, for phases that won't end by themselves.
+	const s64 never = PSP_SAS_MAX_GRAIN + 1;
+
+	int type, rate;
+	switch (state_) {
+	case STATE_ATTACK: type = attackType; rate = attackRate; break;
+	case STATE_DECAY: type = decayType; rate = decayRate; break;
+	case STATE_SUSTAIN: type = sustainType; rate = sustainRate; break;
+	case STATE_RELEASE: type = releaseType; rate = releaseRate; break;
+	case STATE_OFF:
+		delta = 0;
+		steps = never;
+		return true;
+	default:
+		return false;
+	}
+
+	if (type == PSP_SAS_ADSR_CURVE_MODE_LINEAR_INCREASE)
+		delta = rate;
+	else if (type == PSP_SAS_ADSR_CURVE_MODE_LINEAR_DECREASE)
+		delta = -(s64)rate;
+	else
+		return false;
+
+	// These match the checks in Step(), for when they go one way only.
+	switch (state_) {
+	case STATE_ATTACK:
+		if (height_ < 0 || delta < 0)
+			return false;
+		if (height_ >= PSP_SAS_ENVELOPE_HEIGHT_MAX)
+			steps = 1;
+		else
+			steps = delta == 0 ? never : (PSP_SAS_ENVELOPE_HEIGHT_MAX - height_ + delta - 1) / delta;
+		return true;
+	case STATE_DECAY:
+		if (delta > 0)
+			return false;
+		if (height_ < sustainLevel)
+			steps = 1;
+		else
+			steps = delta == 0 ? never : (height_ - sustainLevel) / -delta + 1;
+		return true;
+	default:
+		if (delta > 0)
+			return false;
+		if (height_ <= 0)
+			steps = 1;
+		else
+			steps = delta == 0 ? never : (height_ - delta - 1) / -delta;
+		return true;
+	}
+}
+
+void ADSREnvelope::StepBlock(int *envelope, int count) {
+	int i = 0;
+	while (i < count) {
+		s64 delta, steps;
+		if (!LinearStepsLeft(delta, steps)) {
+			// Curves, and keyon.  Just go one at a time until the state changes.
+			const ADSRState state = state_;
+			do {
+				envelope[i++] = ReduceEnvelope(GetHeight());
+				Step();
+			} while (i < count && state_ == state);
+			continue;
+		}
+
+		const int n = (int)std::min(steps, (s64)(count - i));
+		s64 height = height_;
+		for (int j = 0; j < n; ++j) {
+			envelope[i + j] = ReduceEnvelope(height > (s64)PSP_SAS_ENVELOPE_HEIGHT_MAX ? PSP_SAS_ENVELOPE_HEIGHT_MAX : (int)height);
+			height += delta;
+		}
+		i += n;
+
+		if (n == steps) {
+			// Let Step() take the last one, so the phase changes exactly as usual.
+			height_ = height - delta;
+			Step();
+		} else {
+			height_ = height;
+		}
+	}
+}
+
 void ADSREnvelope::KeyOn() {
 	SetState(STATE_KEYON);
 }
@@ -22,11 +22,15 @@
 
 #pragma once
 
+#include <memory>
+#include <vector>
+
 #include "Common/CommonTypes.h"
 #include "Core/HW/BufferQueue.h"
 #include "Core/HW/SasReverb.h"
 
 class PointerWrap;
+class ThreadPool;
 
 enum {
 	PSP_SAS_VOICES_MAX = 32,
@@ -93,6 +97,8 @@ enum VoiceType {
 
 // VAG is a Sony ADPCM audio compression format, which goes all the way back to the PSX.
 // It compresses 28 16-bit samples into a block of 16 bytes.
+struct DecodedVag;
+
 class VagDecoder {
 public:
 	VagDecoder() : data_(0), read_(0), end_(true) {
@@ -110,6 +116,11 @@ class VagDecoder {
 	u32 GetReadPtr() const { return read_; }
 
 private:
+	void Reset(u32 dataPtr, u32 vagSize, bool loopEnabled);
+	void SyncFromCache();
+	static std::shared_ptr<const DecodedVag> GetDecoded(u32 dataPtr, u32 vagSize, bool loopEnabled);
+	static std::shared_ptr<DecodedVag> DecodeAll(u32 dataPtr, u32 vagSize, bool loopEnabled);
+
 	s16 samples[28];
 	int curSample;
 
@@ -126,8 +137,18 @@ class VagDecoder {
 	bool loopEnabled_;
 	bool loopAtNextBlock_;
 	bool end_;
+
+	// While set, samples come from here instead of being decoded.  Not saved in states.
+	std::shared_ptr<const DecodedVag> cached_;
 };
 
+// Forgets decoded VAG data overlapping the range, when the game has told us it changed.
+void VagCache_Invalidate(u32 addr, int size);
+void VagCache_Clear();
+
+// Writes count samples from src starting at sampleFrac, and returns the new sampleFrac.
+u32 ResampleVoice(int *out, const int16_t *src, u32 sampleFrac, int pitch, int count);
+
 class SasAtrac3 {
 public:
 	SasAtrac3() : contextAddr_(0), atracID_(-1), sampleQueue_(0), end_(false) {}
@@ -158,7 +179,9 @@ class ADSREnvelope {
 	void KeyOff();
 	void End();
 
-	inline void Step();
+	void Step();
+	// Writes the envelope, reduced to 15 bits, for each of the next count samples and steps past them.
+	void StepBlock(int *envelope, int count);
 
 	int GetHeight() const {
 		return height_ > (s64)PSP_SAS_ENVELOPE_HEIGHT_MAX ? PSP_SAS_ENVELOPE_HEIGHT_MAX : height_;
@@ -196,14 +219,13 @@ class ADSREnvelope {
 		STATE_RELEASE = 3,
 	};
 	void SetState(ADSRState state);
+	bool LinearStepsLeft(s64 &delta, s64 &steps) const;
 
 	ADSRState state_;
 	s64 height_;  // s64 to avoid having to care about overflow when calculating. TODO: this should be fine as s32
 };
 
 // A SAS voice.
-// TODO: Look into pre-decoding the VAG samples on SetVoice instead of decoding them on the fly.
-// It's not very likely that games encode VAG dynamically.
 struct SasVoice {
 	SasVoice()
 		: playing(false),
@@ -309,7 +331,37 @@ class SasInstance {
 	WaveformEffect waveformEffect;
 
 private:
+	// What was read for a voice, enough to resample and mix it without touching emulated memory.
+	struct VoiceRead {
+		int delay;
+		int count;
+		u32 sampleFrac;
+		bool samplesEnded;
+	};
+
+	// Private buffers for a slice of voices mixed on a worker thread.
+	struct VoiceSlice {
+		VoiceSlice() : used(false) {}
+
+		std::vector<int> mix;
+		std::vector<int> send;
+		std::vector<int> resampleTemp;
+		std::vector<int> envelopeTemp;
+		bool used;
+	};
+
+	bool ReadVoice(SasVoice &voice, int16_t *temp, VoiceRead &read);
+	void MixVoiceSamples(SasVoice &voice, const int16_t *temp, const VoiceRead &read, int *mix, int *send, int *resampleTemp, int *envelopeTemp);
+	int MixVoicesParallel();
+
 	SasReverb reverb_;
 	int grainSize;
 	int16_t mixTemp_[PSP_SAS_MAX_GRAIN * 4 + 2 + 8];  // some extra margin for very high pitches.
+	int resampleTemp_[PSP_SAS_MAX_GRAIN];
+	int envelopeTemp_[PSP_SAS_MAX_GRAIN];
+
+	// Only allocated once voices are mixed in parallel: a mixTemp_ per voice, buffers per slice, and threads.
+	std::vector<int16_t> parallelTemp_;
+	VoiceSlice parallelSlices_[PSP_SAS_VOICES_MAX];
+	std::unique_ptr<ThreadPool> mixPool_;
 };
@@ -15,13 +15,23 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
 #include <cstdint>
+#include <cstdlib>
 #include <cstring>
 
+#include "ppsspp_config.h"
 #include "base/basictypes.h"
 #include "Core/HW/SasReverb.h"
 #include "Core/Util/AudioFormat.h"
 
+#ifdef _M_SSE
+#include <emmintrin.h>
+#endif
+#if PPSSPP_ARCH(ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 // This is under the assumption that the reverb used in Sas is the same as the PSX SPU reverb.
 
 // Source: http://problemkaputt.de/psx-spx.htm#spureverbformula
@@ -152,7 +162,135 @@ static const SasReverbData presets[10] = {
 	},
 };
 
-SasReverb::SasReverb() : preset_(-1), pos_(0) {
+// Every buffer position the network touches, relative to the current one.
+enum ReverbTap {
+	TAP_LSAME,
+	TAP_LSAME_PREV,
+	TAP_DLSAME,
+	TAP_RSAME,
+	TAP_RSAME_PREV,
+	TAP_DRSAME,
+	TAP_LDIFF,
+	TAP_LDIFF_PREV,
+	TAP_DRDIFF,
+	TAP_RDIFF,
+	TAP_RDIFF_PREV,
+	TAP_DLDIFF,
+	TAP_LCOMB1,
+	TAP_LCOMB2,
+	TAP_LCOMB3,
+	TAP_LCOMB4,
+	TAP_RCOMB1,
+	TAP_RCOMB2,
+	TAP_RCOMB3,
+	TAP_RCOMB4,
+	TAP_LAPF1,
+	TAP_LAPF1_DELAY,
+	TAP_RAPF1,
+	TAP_RAPF1_DELAY,
+	TAP_LAPF2,
+	TAP_LAPF2_DELAY,
+	TAP_RAPF2,
+	TAP_RAPF2_DELAY,
+
+	TAP_COUNT,
+};
+
+static void GetTapOffsets(const SasReverbData &d, int offsets[TAP_COUNT]) {
+	offsets[TAP_LSAME] = d.mLSAME;
+	offsets[TAP_LSAME_PREV] = d.mLSAME - 1;
+	offsets[TAP_DLSAME] = d.dLSAME;
+	offsets[TAP_RSAME] = d.mRSAME;
+	offsets[TAP_RSAME_PREV] = d.mRSAME - 1;
+	offsets[TAP_DRSAME] = d.dRSAME;
+	offsets[TAP_LDIFF] = d.mLDIFF;
+	offsets[TAP_LDIFF_PREV] = d.mLDIFF - 1;
+	offsets[TAP_DRDIFF] = d.dRDIFF;
+	offsets[TAP_RDIFF] = d.mRDIFF;
+	offsets[TAP_RDIFF_PREV] = d.mRDIFF - 1;
+	offsets[TAP_DLDIFF] = d.dLDIFF;
+	offsets[TAP_LCOMB1] = d.mLCOMB1;
+	offsets[TAP_LCOMB2] = d.mLCOMB2;
+	offsets[TAP_LCOMB3] = d.mLCOMB3;
+	offsets[TAP_LCOMB4] = d.mLCOMB4;
+	offsets[TAP_RCOMB1] = d.mRCOMB1;
+	offsets[TAP_RCOMB2] = d.mRCOMB2;
+	offsets[TAP_RCOMB3] = d.mRCOMB3;
+	offsets[TAP_RCOMB4] = d.mRCOMB4;
+	offsets[TAP_LAPF1] = d.mLAPF1;
+	offsets[TAP_LAPF1_DELAY] = d.mLAPF1 - d.dAPF1;
+	offsets[TAP_RAPF1] = d.mRAPF1;
+	offsets[TAP_RAPF1_DELAY] = d.mRAPF1 - d.dAPF1;
+	offsets[TAP_LAPF2] = d.mLAPF2;
+	offsets[TAP_LAPF2_DELAY] = d.mLAPF2 - d.dAPF2;
+	offsets[TAP_RAPF2] = d.mRAPF2;
+	offsets[TAP_RAPF2_DELAY] = d.mRAPF2 - d.dAPF2;
+}
+
+// The vectorized path runs a run of samples in three phases: first all the reads for the comb and
+// all-pass filters, then the (recursive) reflections one sample at a time, then the all-pass writes.
+// This finds how long a run can be while every access to the same spot still happens in the original order.
+static int MaxReorderedRun(const SasReverbData &d, const int offsets[TAP_COUNT]) {
+	enum {
+		PHASE_LATE_READ,
+		PHASE_REFLECT,
+		PHASE_LATE_WRITE,
+	};
+	struct Access {
+		int tap;
+		bool write;
+		int phase;
+	};
+	// The order the plain loop goes in for each sample.
+	static const Access accesses[] = {
+		{ TAP_DLSAME, false, PHASE_REFLECT }, { TAP_LSAME_PREV, false, PHASE_REFLECT }, { TAP_LSAME, true, PHASE_REFLECT },
+		{ TAP_DRSAME, false, PHASE_REFLECT }, { TAP_RSAME_PREV, false, PHASE_REFLECT }, { TAP_RSAME, true, PHASE_REFLECT },
+		{ TAP_DRDIFF, false, PHASE_REFLECT }, { TAP_LDIFF_PREV, false, PHASE_REFLECT }, { TAP_LDIFF, true, PHASE_REFLECT },
+		{ TAP_DLDIFF, false, PHASE_REFLECT }, { TAP_RDIFF_PREV, false, PHASE_REFLECT }, { TAP_RDIFF, true, PHASE_REFLECT },
+		{ TAP_LCOMB1, false, PHASE_LATE_READ }, { TAP_LCOMB2, false, PHASE_LATE_READ }, { TAP_LCOMB3, false, PHASE_LATE_READ }, { TAP_LCOMB4, false, PHASE_LATE_READ },
+		{ TAP_RCOMB1, false, PHASE_LATE_READ }, { TAP_RCOMB2, false, PHASE_LATE_READ }, { TAP_RCOMB3, false, PHASE_LATE_READ }, { TAP_RCOMB4, false, PHASE_LATE_READ },
+		{ TAP_LAPF1_DELAY, false, PHASE_LATE_READ }, { TAP_LAPF1, true, PHASE_LATE_WRITE },
+		{ TAP_RAPF1_DELAY, false, PHASE_LATE_READ }, { TAP_RAPF1, true, PHASE_LATE_WRITE },
+		{ TAP_LAPF2_DELAY, false, PHASE_LATE_READ }, { TAP_LAPF2, true, PHASE_LATE_WRITE },
+		{ TAP_RAPF2_DELAY, false, PHASE_LATE_READ }, { TAP_RAPF2, true, PHASE_LATE_WRITE },
+	};
+	const int16_t combs[4] = { d.vCOMB1, d.vCOMB2, d.vCOMB3, d.vCOMB4 };
+
+	int run = SasReverb::MAX_REORDERED_RUN;
+	for (size_t i = 0; i < ARRAY_SIZE(accesses); ++i) {
+		const Access &a = accesses[i];
+		for (size_t j = 0; j < ARRAY_SIZE(accesses); ++j) {
+			const Access &b = accesses[j];
+			if (i == j || (!a.write && !b.write))
+				continue;
+			// A comb tap multiplied by zero doesn't care what it reads.
+			if ((a.tap >= TAP_LCOMB1 && a.tap <= TAP_RCOMB4 && combs[(a.tap - TAP_LCOMB1) & 3] == 0) || (b.tap >= TAP_LCOMB1 && b.tap <= TAP_RCOMB4 && combs[(b.tap - TAP_LCOMB1) & 3] == 0))
+				continue;
+
+			if (a.phase == b.phase) {
+				// The late writes go out four samples at a time, one filter after the other.
+				if (a.phase == PHASE_LATE_WRITE) {
+					int diff = ((offsets[a.tap] - offsets[b.tap]) % d.size + d.size) % d.size;
+					if ((diff != 0 && diff < 4) || d.size - diff < 4)
+						return 0;
+				}
+				continue;
+			}
+
+			// b, this many samples after a, touches the same spot.
+			const int diff = ((offsets[a.tap] - offsets[b.tap]) % d.size + d.size) % d.size;
+			const int dists[2] = { diff, diff - d.size };
+			for (int dist : dists) {
+				const bool inOrder = dist > 0 || (dist == 0 && i < j);
+				if (inOrder != (a.phase < b.phase))
+					run = std::min(run, std::abs(dist));
+			}
+		}
+	}
+	return run;
+}
+
+SasReverb::SasReverb() : preset_(-1), pos_(0), reorderedRun_(0) {
 	workspace_ = new int16_t[BUFSIZE];
 }
 
@@ -173,38 +311,192 @@ void SasReverb::SetPreset(int preset) {
 	if (preset_ != -1) {
 		pos_ = BUFSIZE - presets[preset_].size;
 		memset(workspace_, 0, sizeof(int16_t) * BUFSIZE);
+
+		int offsets[TAP_COUNT];
+		GetTapOffsets(presets[preset_], offsets);
+		reorderedRun_ = MaxReorderedRun(presets[preset_], offsets);
+		// Not worth the setup below this.
+		if (reorderedRun_ < 8)
+			reorderedRun_ = 0;
 	} else {
 		pos_ = 0;
+		reorderedRun_ = 0;
 	}
 }
 
-// Wraps around the upper part of a buffer.
-template<int bufsize>
-class BufferWrapper {
-public:
-	BufferWrapper(int16_t *buffer, int position, int usedSize) : buf_(buffer), pos_(position), end_(bufsize), base_(bufsize - usedSize), size_(usedSize) {}
-	int16_t &operator [](int index) {
-		int addr = pos_ + index;
-		if (addr >= end_) { addr -= size_; }
-		if (addr < base_) { addr += size_; }
-		return buf_[addr];
+#ifdef _M_SSE
+// Clamps to 16 bits, but leaves them sign extended in each 32-bit lane.
+static inline __m128i Clamp16(__m128i v) {
+	const __m128i packed = _mm_packs_epi32(v, v);
+	return _mm_srai_epi32(_mm_unpacklo_epi16(packed, packed), 16);
+}
+
+// For lanes already within 16 bits, multiplies by a 16-bit constant (from _mm_set1_epi32(v & 0xFFFF).)
+static inline __m128i Mul16(__m128i v, __m128i factor) {
+	return _mm_madd_epi16(v, factor);
+}
+#endif
+
+// ____Same Side Reflection(left - to - left and right - to - right)___________________
+// ___Different Side Reflection(left - to - right and right - to - left)_______________
+static inline void ReflectSample(int16_t *const t[TAP_COUNT], const SasReverbData &d, const int16_t *input, int i) {
+	// Dividing by two here is an incorrect hack. Some multiplication factor is needed to prevent the reverb from getting too loud, though.
+	int16_t Lin = input[i * 2] >> 1; //  (d.vLIN * LeftInput) >> 15;
+	int16_t Rin = input[i * 2 + 1] >> 1; // (d.vRIN * RightInput) >> 15;
+
+	t[TAP_LSAME][i] = clamp_s16(Lin + (t[TAP_DLSAME][i] * d.vWALL >> 15) - (t[TAP_LSAME_PREV][i] * d.vIIR >> 15) + t[TAP_LSAME_PREV][i]); // L - to - L
+	t[TAP_RSAME][i] = clamp_s16(Rin + (t[TAP_DRSAME][i] * d.vWALL >> 15) - (t[TAP_RSAME_PREV][i] * d.vIIR >> 15) + t[TAP_RSAME_PREV][i]); // R - to - R
+	t[TAP_LDIFF][i] = clamp_s16(Lin + (t[TAP_DRDIFF][i] * d.vWALL >> 15) - (t[TAP_LDIFF_PREV][i] * d.vIIR >> 15) + t[TAP_LDIFF_PREV][i]); // R - to - L
+	t[TAP_RDIFF][i] = clamp_s16(Rin + (t[TAP_DLDIFF][i] * d.vWALL >> 15) - (t[TAP_RDIFF_PREV][i] * d.vIIR >> 15) + t[TAP_RDIFF_PREV][i]); // L - to - R
+}
+
+// ___Late Reverb APF(All Pass Filter)________________
+static inline int AllPass(int in, int16_t delayed, int16_t v, int16_t *dest) {
+	*dest = clamp_s16(in - (v * delayed >> 15));
+	return delayed + (*dest * v >> 15);
+}
+
+// ___Early Echo(Comb Filter, with input from buffer)__________________________
+static inline int Comb(const SasReverbData &d, int16_t b1, int16_t b2, int16_t b3, int16_t b4) {
+	return (d.vCOMB1 * b1 + d.vCOMB2 * b2 + d.vCOMB3 * b3 + d.vCOMB4 * b4) >> 15;
+}
+
+// ___Output to Mixer(Output volume multiplied with input from APF2)___________
+static inline void OutputSample(int16_t *output, int i, int Lout, int Rout, uint16_t volLeft, uint16_t volRight) {
+	output[i * 4 + 0] = clamp_s16(Lout * volLeft >> 15);
+	output[i * 4 + 1] = clamp_s16(Rout * volRight >> 15);
+	output[i * 4 + 2] = 0;
+	output[i * 4 + 3] = 0;
+}
+
+// Straight from the description, one sample after the other.
+static void ProcessSamples(int16_t *const t[TAP_COUNT], const SasReverbData &d, int16_t *output, const int16_t *input, int count, uint16_t volLeft, uint16_t volRight) {
+	for (int i = 0; i < count; i++) {
+		ReflectSample(t, d, input, i);
+		int Lout = Comb(d, t[TAP_LCOMB1][i], t[TAP_LCOMB2][i], t[TAP_LCOMB3][i], t[TAP_LCOMB4][i]);
+		int Rout = Comb(d, t[TAP_RCOMB1][i], t[TAP_RCOMB2][i], t[TAP_RCOMB3][i], t[TAP_RCOMB4][i]);
+		Lout = AllPass(Lout, t[TAP_LAPF1_DELAY][i], d.vAPF1, &t[TAP_LAPF1][i]);
+		Rout = AllPass(Rout, t[TAP_RAPF1_DELAY][i], d.vAPF1, &t[TAP_RAPF1][i]);
+		Lout = AllPass(Lout, t[TAP_LAPF2_DELAY][i], d.vAPF2, &t[TAP_LAPF2][i]);
+		Rout = AllPass(Rout, t[TAP_RAPF2_DELAY][i], d.vAPF2, &t[TAP_RAPF2][i]);
+		OutputSample(output, i, Lout, Rout, volLeft, volRight);
 	}
+}
 
-	int GetPosition() { return pos_; }
-	void Next() {
-		pos_++;
-		if (pos_ >= end_) {
-			pos_ -= size_;
+// The same thing, reordered as described in MaxReorderedRun(), so the late reverb can be vectorized.
+static void ProcessSamplesReordered(int16_t *const t[TAP_COUNT], const SasReverbData &d, int16_t *output, const int16_t *input, int count, uint16_t volLeft, uint16_t volRight) {
+	int combL[SasReverb::MAX_REORDERED_RUN];
+	int combR[SasReverb::MAX_REORDERED_RUN];
+	int16_t delayed[4][SasReverb::MAX_REORDERED_RUN];
+
+	int i = 0;
+#ifdef _M_SSE
+	const __m128i comb12 = _mm_set1_epi32((d.vCOMB1 & 0xFFFF) | (d.vCOMB2 << 16));
+	const __m128i comb34 = _mm_set1_epi32((d.vCOMB3 & 0xFFFF) | (d.vCOMB4 << 16));
+	for (; i + 8 <= count; i += 8) {
+		for (int side = 0; side < 2; ++side) {
+			int16_t *const *taps = t + (side == 0 ? TAP_LCOMB1 : TAP_RCOMB1);
+			const __m128i b1 = _mm_loadu_si128((const __m128i *)(taps[0] + i));
+			const __m128i b2 = _mm_loadu_si128((const __m128i *)(taps[1] + i));
+			const __m128i b3 = _mm_loadu_si128((const __m128i *)(taps[2] + i));
+			const __m128i b4 = _mm_loadu_si128((const __m128i *)(taps[3] + i));
+			const __m128i lo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(b1, b2), comb12), _mm_madd_epi16(_mm_unpacklo_epi16(b3, b4), comb34));
+			const __m128i hi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(b1, b2), comb12), _mm_madd_epi16(_mm_unpackhi_epi16(b3, b4), comb34));
+			int *dest = side == 0 ? combL : combR;
+			_mm_storeu_si128((__m128i *)(dest + i), _mm_srai_epi32(lo, 15));
+			_mm_storeu_si128((__m128i *)(dest + i + 4), _mm_srai_epi32(hi, 15));
 		}
 	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	for (; i + 4 <= count; i += 4) {
+		int32x4_t l = vmull_n_s16(vld1_s16(t[TAP_LCOMB1] + i), d.vCOMB1);
+		l = vmlal_n_s16(l, vld1_s16(t[TAP_LCOMB2] + i), d.vCOMB2);
+		l = vmlal_n_s16(l, vld1_s16(t[TAP_LCOMB3] + i), d.vCOMB3);
+		l = vmlal_n_s16(l, vld1_s16(t[TAP_LCOMB4] + i), d.vCOMB4);
+		vst1q_s32(combL + i, vshrq_n_s32(l, 15));
+		int32x4_t r = vmull_n_s16(vld1_s16(t[TAP_RCOMB1] + i), d.vCOMB1);
+		r = vmlal_n_s16(r, vld1_s16(t[TAP_RCOMB2] + i), d.vCOMB2);
+		r = vmlal_n_s16(r, vld1_s16(t[TAP_RCOMB3] + i), d.vCOMB3);
+		r = vmlal_n_s16(r, vld1_s16(t[TAP_RCOMB4] + i), d.vCOMB4);
+		vst1q_s32(combR + i, vshrq_n_s32(r, 15));
+	}
+#endif
+	for (; i < count; i++) {
+		combL[i] = Comb(d, t[TAP_LCOMB1][i], t[TAP_LCOMB2][i], t[TAP_LCOMB3][i], t[TAP_LCOMB4][i]);
+		combR[i] = Comb(d, t[TAP_RCOMB1][i], t[TAP_RCOMB2][i], t[TAP_RCOMB3][i], t[TAP_RCOMB4][i]);
+	}
+	memcpy(delayed[0], t[TAP_LAPF1_DELAY], count * sizeof(int16_t));
+	memcpy(delayed[1], t[TAP_RAPF1_DELAY], count * sizeof(int16_t));
+	memcpy(delayed[2], t[TAP_LAPF2_DELAY], count * sizeof(int16_t));
+	memcpy(delayed[3], t[TAP_RAPF2_DELAY], count * sizeof(int16_t));
+
+	// The reflections feed back into themselves right away, so they have to go one by one.
+	for (i = 0; i < count; i++) {
+		ReflectSample(t, d, input, i);
+	}
 
-private:
-	int16_t *buf_;
-	int pos_;
-	int end_;
-	int base_;
-	int size_;
-};
+	i = 0;
+#ifdef _M_SSE
+	const __m128i apf1 = _mm_set1_epi32(d.vAPF1 & 0xFFFF);
+	const __m128i apf2 = _mm_set1_epi32(d.vAPF2 & 0xFFFF);
+	const __m128i vol = _mm_setr_epi32(volLeft, volRight, 0, 0);
+	const __m128i volL = _mm_shuffle_epi32(vol, _MM_SHUFFLE(0, 0, 0, 0));
+	const __m128i volR = _mm_shuffle_epi32(vol, _MM_SHUFFLE(1, 1, 1, 1));
+	for (; i + 4 <= count; i += 4) {
+		__m128i out[2];
+		for (int side = 0; side < 2; ++side) {
+			const __m128i comb = _mm_loadu_si128((const __m128i *)((side == 0 ? combL : combR) + i));
+			const __m128i delayed1 = _mm_loadl_epi64((const __m128i *)(delayed[side] + i));
+			const __m128i delayed2 = _mm_loadl_epi64((const __m128i *)(delayed[side + 2] + i));
+			const __m128i a1 = _mm_srai_epi32(_mm_unpacklo_epi16(delayed1, delayed1), 16);
+			const __m128i a2 = _mm_srai_epi32(_mm_unpacklo_epi16(delayed2, delayed2), 16);
+
+			const __m128i w1 = Clamp16(_mm_sub_epi32(comb, _mm_srai_epi32(Mul16(a1, apf1), 15)));
+			_mm_storel_epi64((__m128i *)(t[side == 0 ? TAP_LAPF1 : TAP_RAPF1] + i), _mm_packs_epi32(w1, w1));
+			const __m128i out1 = _mm_add_epi32(a1, _mm_srai_epi32(Mul16(w1, apf1), 15));
+
+			const __m128i w2 = Clamp16(_mm_sub_epi32(out1, _mm_srai_epi32(Mul16(a2, apf2), 15)));
+			_mm_storel_epi64((__m128i *)(t[side == 0 ? TAP_LAPF2 : TAP_RAPF2] + i), _mm_packs_epi32(w2, w2));
+			const __m128i out2 = _mm_add_epi32(a2, _mm_srai_epi32(Mul16(w2, apf2), 15));
+
+			out[side] = _mm_srai_epi32(MulLo32(out2, side == 0 ? volL : volR), 15);
+		}
+		// L R L R..., then pad each pair with two zeroes.
+		const __m128i lr = _mm_unpacklo_epi16(_mm_packs_epi32(out[0], out[0]), _mm_packs_epi32(out[1], out[1]));
+		_mm_storeu_si128((__m128i *)(output + i * 4), _mm_unpacklo_epi32(lr, _mm_setzero_si128()));
+		_mm_storeu_si128((__m128i *)(output + i * 4 + 8), _mm_unpackhi_epi32(lr, _mm_setzero_si128()));
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	for (; i + 4 <= count; i += 4) {
+		int16x4x4_t out;
+		for (int side = 0; side < 2; ++side) {
+			const int32x4_t comb = vld1q_s32((side == 0 ? combL : combR) + i);
+			const int16x4_t a1 = vld1_s16(delayed[side] + i);
+			const int16x4_t a2 = vld1_s16(delayed[side + 2] + i);
+
+			const int16x4_t w1 = vqmovn_s32(vsubq_s32(comb, vshrq_n_s32(vmull_n_s16(a1, d.vAPF1), 15)));
+			vst1_s16(t[side == 0 ? TAP_LAPF1 : TAP_RAPF1] + i, w1);
+			const int32x4_t out1 = vaddq_s32(vmovl_s16(a1), vshrq_n_s32(vmull_n_s16(w1, d.vAPF1), 15));
+
+			const int16x4_t w2 = vqmovn_s32(vsubq_s32(out1, vshrq_n_s32(vmull_n_s16(a2, d.vAPF2), 15)));
+			vst1_s16(t[side == 0 ? TAP_LAPF2 : TAP_RAPF2] + i, w2);
+			const int32x4_t out2 = vaddq_s32(vmovl_s16(a2), vshrq_n_s32(vmull_n_s16(w2, d.vAPF2), 15));
+
+			out.val[side] = vqmovn_s32(vshrq_n_s32(vmulq_n_s32(out2, side == 0 ? volLeft : volRight), 15));
+		}
+		out.val[2] = vdup_n_s16(0);
+		out.val[3] = vdup_n_s16(0);
+		vst4_s16(output + i * 4, out);
+	}
+#endif
+	for (; i < count; i++) {
+		int Lout = AllPass(combL[i], delayed[0][i], d.vAPF1, &t[TAP_LAPF1][i]);
+		int Rout = AllPass(combR[i], delayed[1][i], d.vAPF1, &t[TAP_RAPF1][i]);
+		Lout = AllPass(Lout, delayed[2][i], d.vAPF2, &t[TAP_LAPF2][i]);
+		Rout = AllPass(Rout, delayed[3][i], d.vAPF2, &t[TAP_RAPF2][i]);
+		OutputSample(output, i, Lout, Rout, volLeft, volRight);
+	}
+}
 
 void SasReverb::ProcessReverb(int16_t *output, const int16_t *input, size_t inputSize, uint16_t volLeft, uint16_t volRight) {
 	// This means replicate the input signal in the processed buffer.
@@ -221,50 +513,41 @@ void SasReverb::ProcessReverb(int16_t *output, const int16_t *input, size_t inpu
 	}
 
 	const SasReverbData &d = presets[preset_];
-
-	// We put this on the stack instead of in the object to let the compiler optimize better (avoid mem r/w).
-	BufferWrapper<BUFSIZE> b(workspace_, pos_, d.size);
+	const int base = BUFSIZE - d.size;
+	int offsets[TAP_COUNT];
+	GetTapOffsets(d, offsets);
 
 	// This runs at 22khz.
-	// Very unoptimized, straight from the description. Can probably be reformulated into something way more efficient.
-	// Or we could actually template the whole thing with the parameters as template arguments, as the presets are fixed.
-	for (size_t i = 0; i < inputSize; i++) {
-		// Dividing by two here is an incorrect hack. Some multiplication factor is needed to prevent the reverb from getting too loud, though.
-		int16_t LeftInput = input[i * 2] >> 1;
-		int16_t RightInput = input[i * 2 + 1] >> 1;
-
-		int16_t Lin = LeftInput; //  (d.vLIN * LeftInput) >> 15;
-		int16_t Rin = RightInput; // (d.vRIN * RightInput) >> 15;
-
-		// ____Same Side Reflection(left - to - left and right - to - right)___________________
-		b[d.mLSAME] = clamp_s16(Lin + (b[d.dLSAME] * d.vWALL >> 15) - (b[d.mLSAME - 1]*d.vIIR >> 15) + b[d.mLSAME - 1]); // L - to - L
-		b[d.mRSAME] = clamp_s16(Rin + (b[d.dRSAME] * d.vWALL >> 15) - (b[d.mRSAME - 1]*d.vIIR >> 15) + b[d.mRSAME - 1]); // R - to - R
-		// ___Different Side Reflection(left - to - right and right - to - left)_______________
-		b[d.mLDIFF] = clamp_s16(Lin + (b[d.dRDIFF] * d.vWALL >> 15) - (b[d.mLDIFF - 1]*d.vIIR >> 15) + b[d.mLDIFF - 1]); // R - to - L
-		b[d.mRDIFF] = clamp_s16(Rin + (b[d.dLDIFF] * d.vWALL >> 15) - (b[d.mRDIFF - 1]*d.vIIR >> 15) + b[d.mRDIFF - 1]); // L - to - R
-		// ___Early Echo(Comb Filter, with input from buffer)__________________________
-		int32_t Lout = ((d.vCOMB1*b[d.mLCOMB1] + d.vCOMB2*b[d.mLCOMB2] + d.vCOMB3*b[d.mLCOMB3] + d.vCOMB4*b[d.mLCOMB4]) >> 15);
-		int32_t Rout = ((d.vCOMB1*b[d.mRCOMB1] + d.vCOMB2*b[d.mRCOMB2] + d.vCOMB3*b[d.mRCOMB3] + d.vCOMB4*b[d.mRCOMB4]) >> 15);
-		// ___Late Reverb APF1(All Pass Filter 1, with input from COMB)________________
-		b[d.mLAPF1] = clamp_s16(Lout - (d.vAPF1*b[(d.mLAPF1 - d.dAPF1)] >> 15));
-		Lout = b[(d.mLAPF1 - d.dAPF1)] + (b[d.mLAPF1] * d.vAPF1 >> 15);
-		b[d.mRAPF1] = clamp_s16(Rout - (d.vAPF1*b[(d.mRAPF1 - d.dAPF1)] >> 15));
-		Rout = b[(d.mRAPF1 - d.dAPF1)] + (b[d.mRAPF1] * d.vAPF1 >> 15);
-		// ___Late Reverb APF2(All Pass Filter 2, with input from APF1)________________
-		b[d.mLAPF2] = clamp_s16(Lout - (d.vAPF2*b[(d.mLAPF2 - d.dAPF2)] >> 15));
-		Lout = b[(d.mLAPF2 - d.dAPF2)] + (b[d.mLAPF2] * d.vAPF2 >> 15);
-		b[d.mRAPF2] = clamp_s16(Rout - (d.vAPF2*b[(d.mRAPF2 - d.dAPF2)] >> 15));
-		Rout = b[(d.mRAPF2 - d.dAPF2)] + (b[d.mRAPF2] * d.vAPF2 >> 15);
-		// ___Output to Mixer(Output volume multiplied with input from APF2)___________
-		output[i * 4 + 0] = clamp_s16(Lout * volLeft >> 15);
-		output[i * 4 + 1] = clamp_s16(Rout * volRight >> 15);
-		output[i * 4 + 2] = 0;
-		output[i * 4 + 3] = 0;
-
-		b.Next();
-	}
+	// The workspace wraps around, so go in blocks where none of the taps wrap, and then just index them.
+	size_t done = 0;
+	while (done < inputSize) {
+		int16_t *t[TAP_COUNT];
+		int count = (int)std::min(inputSize - done, (size_t)d.size);
+		for (int i = 0; i < TAP_COUNT; ++i) {
+			int addr = pos_ + offsets[i];
+			if (addr >= BUFSIZE) { addr -= d.size; }
+			if (addr < base) { addr += d.size; }
+			t[i] = workspace_ + addr;
+			count = std::min(count, BUFSIZE - addr);
+		}
 
-	// Save the state in the object.
-	pos_ = b.GetPosition();
-}
+		if (reorderedRun_ != 0) {
+			for (int i = 0; i < count; ) {
+				int run = std::min(reorderedRun_, count - i);
+				ProcessSamplesReordered(t, d, output + (done + i) * 4, input + (done + i) * 2, run, volLeft, volRight);
+				for (int j = 0; j < TAP_COUNT; ++j) {
+					t[j] += run;
+				}
+				i += run;
+			}
+		} else {
+			ProcessSamples(t, d, output + done * 4, input + done * 2, count, volLeft, volRight);
+		}
 
+		done += count;
+		pos_ += count;
+		if (pos_ >= BUFSIZE) {
+			pos_ -= d.size;
+		}
+	}
+}
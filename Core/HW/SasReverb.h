@@ -33,6 +33,11 @@ class SasReverb {
 	// Output is written back at 44khz.
 	void ProcessReverb(int16_t *output, const int16_t *input, size_t inputSize, uint16_t volLeft, uint16_t volRight);
 
+	enum {
+		// Longest run of samples we vectorize the late reverb for at once.
+		MAX_REORDERED_RUN = 256,
+	};
+
 private:
 	enum {
 		BUFSIZE = 0x20000,
@@ -41,4 +46,6 @@ class SasReverb {
 	int16_t *workspace_;
 	int preset_;
 	int pos_;
+	// How many samples at a time can take the vectorized path, or 0 if none.
+	int reorderedRun_;
 };
\ No newline at end of file
@@ -19,6 +19,7 @@
 
 #include "Core/Config.h"
 #include "Core/HLE/FunctionWrappers.h"
+#include "Core/HLE/__sceAudio.h"
 #include "Core/HW/SimpleAudioDec.h"
 #include "Core/HW/MediaEngine.h"
 #include "Core/HW/BufferQueue.h"
@@ -173,6 +174,7 @@ bool SimpleAudio::IsOK() const {
 
 bool SimpleAudio::Decode(void *inbuf, int inbytes, uint8_t *outbuf, int *outbytes) {
 #ifdef USE_FFMPEG
+	AudioProfileScope profile(AudioProfileStage::DECODE);
 	if (!codecOpen_) {
 		OpenCodec(inbytes);
 	}
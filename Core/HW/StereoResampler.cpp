@@ -24,11 +24,31 @@
 
 #define LOW_WATERMARK_DEFAULT   1680 // 40 ms
 #define LOW_WATERMARK_EXTRA 3360 // 80 ms
+#define LOW_WATERMARK_MIN   512  // 12 ms, the least the adaptive watermark goes down to
+
+// The low watermark follows how far the buffer dips below its average between pushes,
+// which is mostly the host's frame pacing jitter. It rises right away and falls slowly.
+#define LATENCY_MARGIN      128  // frames kept in hand beyond the worst dip seen
+#define LATENCY_STEP_UP     256  // extra frames after a partial underrun
+#define LATENCY_STEP_DOWN   32   // most frames to drop per window
+#define LATENCY_WINDOW_DIV  2    // windows per second of output
+
+// Windowed sinc for upsampling (mainly 44.1 -> 48 kHz), selected by the top bits of m_frac.
+#define POLYPHASE_TAPS       16
+#define POLYPHASE_HISTORY    (POLYPHASE_TAPS / 2 - 1)  // taps before the current sample
+#define POLYPHASE_LOOKAHEAD  (POLYPHASE_TAPS / 2)      // and after it
+#define POLYPHASE_PHASE_BITS 9
+#define POLYPHASE_PHASES     (1 << POLYPHASE_PHASE_BITS)
+#define POLYPHASE_CUTOFF     0.9    // of the input's Nyquist frequency
+#define POLYPHASE_BETA       5.0    // Kaiser window
+#define POLYPHASE_MAX_RATIO  0x10800 // beyond a little downsampling, the cutoff is too high
 
 #define MAX_FREQ_SHIFT  200  // per 32000 Hz
 #define CONTROL_FACTOR  0.2f // in freq_shift per fifo size offset
 #define CONTROL_AVG     32
 
+#include <algorithm>
+#include <cmath>
 #include <cstring>
 
 #include "base/logging.h"
@@ -60,9 +80,16 @@ StereoResampler::StereoResampler()
 		, underrunCount_(0)
 		, overrunCount_(0)
 		, sample_rate_(0.0f)
-		, lastBufSize_(0) {
+		, lastBufSize_(0)
+		, lastPushSize_(0)
+		, minWatermark_(LOW_WATERMARK_MIN)
+		, windowSwing_(0)
+		, windowFrames_(0)
+		, windowUnderrun_(false) {
 	// Need to have space for the worst case in case it changes.
-	m_buffer = new int16_t[MAX_SAMPLES_EXTRA * 2]();
+	// The taps past the end mirror the start, so the filter never has to wrap.
+	m_buffer = new int16_t[MAX_SAMPLES_EXTRA * 2 + POLYPHASE_TAPS * 2]();
+	InitPolyphaseTable();
 
 	// Some Android devices are v-synced to non-60Hz framerates. We simply timestretch audio to fit.
 	// TODO: should only do this if auto frameskip is off?
@@ -81,15 +108,108 @@ StereoResampler::~StereoResampler() {
 }
 
 void StereoResampler::UpdateBufferSize() {
+	// The low watermark itself is adapted in Mix(), this only sets its floor.
 	if (g_Config.bExtraAudioBuffering) {
 		m_bufsize = MAX_SAMPLES_EXTRA;
-		m_lowwatermark = LOW_WATERMARK_EXTRA;
+		minWatermark_ = LOW_WATERMARK_EXTRA;
 	} else {
 		m_bufsize = MAX_SAMPLES_DEFAULT;
-		m_lowwatermark = LOW_WATERMARK_DEFAULT;
+		minWatermark_ = LOW_WATERMARK_MIN;
 	}
 }
 
+static s16 polyphaseTable[POLYPHASE_PHASES][POLYPHASE_TAPS];
+
+static double BesselI0(double x) {
+	double sum = 1.0;
+	double term = 1.0;
+	for (int k = 1; k < 32; ++k) {
+		term *= (x / (2 * k)) * (x / (2 * k));
+		sum += term;
+	}
+	return sum;
+}
+
+void StereoResampler::InitPolyphaseTable() {
+	static bool initialized = false;
+	if (initialized)
+		return;
+
+	for (int phase = 0; phase < POLYPHASE_PHASES; ++phase) {
+		const double frac = phase / (double)POLYPHASE_PHASES;
+		double coefs[POLYPHASE_TAPS];
+		double sum = 0.0;
+		for (int k = 0; k < POLYPHASE_TAPS; ++k) {
+			const double t = k - POLYPHASE_HISTORY - frac;
+			const double x = t / (POLYPHASE_TAPS / 2);
+			const double window = x * x < 1.0 ? BesselI0(POLYPHASE_BETA * sqrt(1.0 - x * x)) / BesselI0(POLYPHASE_BETA) : 0.0;
+			const double arg = 3.14159265358979323846 * POLYPHASE_CUTOFF * t;
+			coefs[k] = (t == 0.0 ? 1.0 : sin(arg) / arg) * window;
+			sum += coefs[k];
+		}
+
+		// Each phase gets exactly unity gain, or the phases would modulate a DC offset into a tone.
+		int total = 0;
+		int largest = 0;
+		for (int k = 0; k < POLYPHASE_TAPS; ++k) {
+			polyphaseTable[phase][k] = (s16)floor(coefs[k] / sum * 16384.0 + 0.5);
+			total += polyphaseTable[phase][k];
+			if (coefs[k] > coefs[largest])
+				largest = k;
+		}
+		polyphaseTable[phase][largest] += 16384 - total;
+	}
+	initialized = true;
+}
+
+// One stereo frame from POLYPHASE_TAPS interleaved frames, with 2.14 coefficients.
+// The sums can't overflow, since no phase's coefficients add up to more than 2.0 in magnitude.
+static inline void PolyphaseFrame(s16 *out, const s16 *in, const s16 *coefs) {
+#ifdef _M_SSE
+	__m128i acc = _mm_setzero_si128();
+	for (int i = 0; i < POLYPHASE_TAPS; i += 8) {
+		const __m128i c = _mm_loadu_si128((const __m128i *)(coefs + i));
+		__m128i s0 = _mm_loadu_si128((const __m128i *)(in + i * 2));
+		__m128i s1 = _mm_loadu_si128((const __m128i *)(in + i * 2 + 8));
+		// L0 R0 L1 R1 -> L0 L1 R0 R1, so madd against c0 c1 c0 c1 keeps the channels apart.
+		s0 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s0, _MM_SHUFFLE(3, 1, 2, 0)), _MM_SHUFFLE(3, 1, 2, 0));
+		s1 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s1, _MM_SHUFFLE(3, 1, 2, 0)), _MM_SHUFFLE(3, 1, 2, 0));
+		acc = _mm_add_epi32(acc, _mm_madd_epi16(s0, _mm_unpacklo_epi32(c, c)));
+		acc = _mm_add_epi32(acc, _mm_madd_epi16(s1, _mm_unpackhi_epi32(c, c)));
+	}
+	// Now L R L R, fold the halves together.
+	acc = _mm_add_epi32(acc, _mm_srli_si128(acc, 8));
+	acc = _mm_srai_epi32(_mm_add_epi32(acc, _mm_set1_epi32(1 << 13)), 14);
+	acc = _mm_packs_epi32(acc, acc);
+	out[0] = (s16)_mm_extract_epi16(acc, 0);
+	out[1] = (s16)_mm_extract_epi16(acc, 1);
+#elif PPSSPP_ARCH(ARM_NEON)
+	int32x4_t accL = vdupq_n_s32(0);
+	int32x4_t accR = vdupq_n_s32(0);
+	for (int i = 0; i < POLYPHASE_TAPS; i += 8) {
+		const int16x8_t c = vld1q_s16(coefs + i);
+		const int16x8x2_t s = vld2q_s16(in + i * 2);
+		accL = vmlal_s16(accL, vget_low_s16(s.val[0]), vget_low_s16(c));
+		accL = vmlal_s16(accL, vget_high_s16(s.val[0]), vget_high_s16(c));
+		accR = vmlal_s16(accR, vget_low_s16(s.val[1]), vget_low_s16(c));
+		accR = vmlal_s16(accR, vget_high_s16(s.val[1]), vget_high_s16(c));
+	}
+	const int32x2_t sum = vpadd_s32(vadd_s32(vget_low_s32(accL), vget_high_s32(accL)), vadd_s32(vget_low_s32(accR), vget_high_s32(accR)));
+	const int16x4_t result = vqrshrn_n_s32(vcombine_s32(sum, sum), 14);
+	out[0] = vget_lane_s16(result, 0);
+	out[1] = vget_lane_s16(result, 1);
+#else
+	int sumL = 0;
+	int sumR = 0;
+	for (int i = 0; i < POLYPHASE_TAPS; ++i) {
+		sumL += in[i * 2] * coefs[i];
+		sumR += in[i * 2 + 1] * coefs[i];
+	}
+	out[0] = clamp_s16((sumL + (1 << 13)) >> 14);
+	out[1] = clamp_s16((sumR + (1 << 13)) >> 14);
+#endif
+}
+
 template<bool useShift>
 inline void ClampBufferToS16(s16 *out, const s32 *in, size_t size, s8 volShift) {
 #ifdef _M_SSE
@@ -141,7 +261,37 @@ inline void ClampBufferToS16WithVolume(s16 *out, const s32 *in, size_t size) {
 }
 
 void StereoResampler::Clear() {
-	memset(m_buffer, 0, m_bufsize * 2 * sizeof(int16_t));
+	memset(m_buffer, 0, (m_bufsize * 2 + POLYPHASE_TAPS * 2) * sizeof(int16_t));
+}
+
+// Called from Mix() with how many input frames were buffered before the call, and how many it wanted.
+void StereoResampler::UpdateWatermark(int numLeft, int needed, bool underrun) {
+	// How far below the average we are, plus what this call needs, is what has to be kept in hand.
+	const int swing = std::max((int)m_numLeftI - numLeft, 0) + needed;
+	windowSwing_ = std::max(windowSwing_, swing);
+	// A partial underrun means the producer is running, but late: the swing estimate was too low.
+	// When nothing was buffered at all, it's more likely paused or loading, which says nothing about jitter.
+	if (underrun && numLeft > POLYPHASE_LOOKAHEAD && !windowUnderrun_) {
+		m_lowwatermark += LATENCY_STEP_UP;
+		windowUnderrun_ = true;
+	}
+
+	int target = windowSwing_ + LATENCY_MARGIN;
+	if (target > m_lowwatermark) {
+		m_lowwatermark = target;
+	}
+
+	windowFrames_ += needed;
+	if (windowFrames_ >= (int)m_input_sample_rate / LATENCY_WINDOW_DIV) {
+		if (target < m_lowwatermark && !windowUnderrun_) {
+			m_lowwatermark -= std::min(m_lowwatermark - target, LATENCY_STEP_DOWN);
+		}
+		windowSwing_ = 0;
+		windowFrames_ = 0;
+		windowUnderrun_ = false;
+	}
+
+	m_lowwatermark = std::max(minWatermark_, std::min(m_lowwatermark, m_bufsize / 2));
 }
 
 // Executed from sound stream thread
@@ -184,22 +334,34 @@ unsigned int StereoResampler::Mix(short* samples, unsigned int numSamples, bool
 		sample_rate_ = (float)(m_input_sample_rate + offset);
 		const u32 ratio = (u32)(65536.0 * sample_rate_ / (double)sample_rate);
 
-		// TODO: consider a higher-quality resampling algorithm.
-		// TODO: Add a fast path for 1:1.
-		for (; currentSample < numSamples * 2 && ((indexW - indexR) & INDEX_MASK) > 2; currentSample += 2) {
-			u32 indexR2 = indexR + 2; //next sample
-			s16 l1 = m_buffer[indexR & INDEX_MASK]; //current
-			s16 r1 = m_buffer[(indexR + 1) & INDEX_MASK]; //current
-			s16 l2 = m_buffer[indexR2 & INDEX_MASK]; //next
-			s16 r2 = m_buffer[(indexR2 + 1) & INDEX_MASK]; //next
-			int sampleL = ((l1 << 16) + (l2 - l1) * (u16)m_frac) >> 16;
-			int sampleR = ((r1 << 16) + (r2 - r1) * (u16)m_frac) >> 16;
-			samples[currentSample] = sampleL;
-			samples[currentSample + 1] = sampleR;
-			m_frac += ratio;
-			indexR += 2 * (u16)(m_frac >> 16);
-			m_frac &= 0xffff;
+		if (ratio <= POLYPHASE_MAX_RATIO) {
+			for (; currentSample < numSamples * 2 && ((indexW - indexR) & INDEX_MASK) > POLYPHASE_LOOKAHEAD * 2; currentSample += 2) {
+				const s16 *in = &m_buffer[(indexR - POLYPHASE_HISTORY * 2) & INDEX_MASK];
+				PolyphaseFrame(&samples[currentSample], in, polyphaseTable[m_frac >> (16 - POLYPHASE_PHASE_BITS)]);
+				m_frac += ratio;
+				indexR += 2 * (u16)(m_frac >> 16);
+				m_frac &= 0xffff;
+			}
+		} else {
+			// Downsampling, which the polyphase filter would alias.
+			for (; currentSample < numSamples * 2 && ((indexW - indexR) & INDEX_MASK) > 2; currentSample += 2) {
+				u32 indexR2 = indexR + 2; //next sample
+				s16 l1 = m_buffer[indexR & INDEX_MASK]; //current
+				s16 r1 = m_buffer[(indexR + 1) & INDEX_MASK]; //current
+				s16 l2 = m_buffer[indexR2 & INDEX_MASK]; //next
+				s16 r2 = m_buffer[(indexR2 + 1) & INDEX_MASK]; //next
+				int sampleL = ((l1 << 16) + (l2 - l1) * (u16)m_frac) >> 16;
+				int sampleR = ((r1 << 16) + (r2 - r1) * (u16)m_frac) >> 16;
+				samples[currentSample] = sampleL;
+				samples[currentSample + 1] = sampleR;
+				m_frac += ratio;
+				indexR += 2 * (u16)(m_frac >> 16);
+				m_frac &= 0xffff;
+			}
 		}
+
+		const int needed = (int)(((u64)numSamples * ratio) >> 16);
+		UpdateWatermark((int)numLeft, needed, currentSample < numSamples * 2);
 	}
 
 	int realSamples = currentSample;
@@ -234,7 +396,8 @@ void StereoResampler::PushSamples(const s32 *samples, unsigned int num_samples)
 	// needs to get updates to not deadlock.
 	u32 indexW = Common::AtomicLoad(m_indexW);
 
-	u32 cap = m_bufsize * 2;
+	// The polyphase filter still reads a few frames behind m_indexR, so leave those alone.
+	u32 cap = m_bufsize * 2 - POLYPHASE_HISTORY * 2;
 	// If unthottling, no need to fill up the entire buffer, just screws up timing after releasing unthrottle.
 	if (PSP_CoreParameter().unthrottle)
 		cap = m_lowwatermark * 2;
@@ -255,6 +418,7 @@ void StereoResampler::PushSamples(const s32 *samples, unsigned int num_samples)
 	} else {
 		ClampBufferToS16WithVolume(&m_buffer[indexW & INDEX_MASK], samples, num_samples * 2);
 	}
+	memcpy(&m_buffer[m_bufsize * 2], &m_buffer[0], POLYPHASE_TAPS * 2 * sizeof(int16_t));
 
 	Common::AtomicAdd(m_indexW, num_samples * 2);
 	lastPushSize_ = num_samples;
@@ -270,6 +434,8 @@ void StereoResampler::GetAudioDebugStats(AudioDebugStats *stats) {
 	stats->bufsize = m_bufsize * 2;
 	stats->instantSampleRate = (int)sample_rate_;
 	stats->lastPushSize = lastPushSize_;
+	stats->latencyMs = (int)(m_numLeftI * 1000.0f / m_input_sample_rate);
+	stats->drift = (int)(sample_rate_ - (float)m_input_sample_rate);
 }
 
 void StereoResampler::SetInputSampleRate(unsigned int rate) {
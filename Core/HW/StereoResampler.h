@@ -46,7 +46,9 @@ class StereoResampler {
 
 protected:
 	void UpdateBufferSize();
+	void UpdateWatermark(int numLeft, int needed, bool underrun);
 	void SetInputSampleRate(unsigned int rate);
+	static void InitPolyphaseTable();
 
 	int m_bufsize;
 	int m_lowwatermark;
@@ -61,4 +63,10 @@ class StereoResampler {
 	float sample_rate_;
 	int lastBufSize_;
 	int lastPushSize_;
+
+	// Adaptive latency, only used on the audio thread.
+	int minWatermark_;
+	int windowSwing_;
+	int windowFrames_;
+	bool windowUnderrun_;
 };
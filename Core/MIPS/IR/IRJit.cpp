@@ -16,6 +16,7 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include "base/logging.h"
+#include "base/timeutil.h"
 #include "profiler/profiler.h"
 #include "Common/ChunkFile.h"
 #include "Common/StringUtils.h"
@@ -116,7 +117,14 @@ void IRJit::RunLoopUntil(u64 globalticks) {
 				mips_->pc = IRInterpret(mips_, block->GetInstructions(), block->GetConstants(), block->GetNumInstructions());
 			} else {
 				// RestoreRoundingMode(true);
-				Compile(mips_->pc);
+				if (compileStats.enabled) {
+					double start = real_time_now();
+					Compile(mips_->pc);
+					compileStats.blocks++;
+					compileStats.seconds += real_time_now() - start;
+				} else {
+					Compile(mips_->pc);
+				}
 				// ApplyRoundingMode(true);
 			}
 		}
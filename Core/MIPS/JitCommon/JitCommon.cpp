@@ -19,6 +19,7 @@
 
 #include "ext/disarm.h"
 #include "ext/udis86/udis86.h"
+#include "base/timeutil.h"
 
 #include "Common/StringUtils.h"
 #include "Core/Util/DisArm64.h"
@@ -42,8 +43,17 @@
 
 namespace MIPSComp {
 	JitInterface *jit;
+	CompileStats compileStats;
+
 	void JitAt() {
+		if (!compileStats.enabled) {
+			jit->Compile(currentMIPS->pc);
+			return;
+		}
+		double start = real_time_now();
 		jit->Compile(currentMIPS->pc);
+		compileStats.blocks++;
+		compileStats.seconds += real_time_now() - start;
 	}
 
 	JitInterface *CreateNativeJit(MIPSState *mips) {
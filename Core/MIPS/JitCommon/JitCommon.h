@@ -42,6 +42,15 @@ class MIPSState;
 namespace MIPSComp {
 	void JitAt();
 
+	// Block compiles since the last reset, collected for benchmarking.  Only counted while enabled,
+	// so normal runs don't pay for the timer.
+	struct CompileStats {
+		bool enabled;
+		u32 blocks;
+		double seconds;
+	};
+	extern CompileStats compileStats;
+
 	class MIPSFrontendInterface {
 	public:
 		virtual ~MIPSFrontendInterface() {}
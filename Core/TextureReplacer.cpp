@@ -20,8 +20,12 @@
 #endif
 
 #include <algorithm>
+#include <memory>
+#include <snappy-c.h>
 #include "ext/xxhash.h"
+#include "base/timeutil.h"
 #include "file/ini_file.h"
+#include "thread/threadutil.h"
 #include "Common/ColorConv.h"
 #include "Common/FileUtil.h"
 #include "Core/Config.h"
@@ -32,14 +36,35 @@
 
 static const std::string INI_FILENAME = "textures.ini";
 static const std::string NEW_TEXTURE_DIR = "new/";
+static const std::string DECODED_CACHE_DIR = "cache/";
 static const int VERSION = 1;
 static const int MAX_MIP_LEVELS = 64;
-
-TextureReplacer::TextureReplacer() : enabled_(false), allowVideo_(false), ignoreAddress_(false), hash_(ReplacedTextureHash::QUICK) {
+static const int MAX_PREPARE_WORKERS = 4;
+// Texture dumps waiting to be encoded, beyond this the render thread waits.
+static const int MAX_PENDING_SAVES = 32;
+// Decoded replacements used more recently than this are never purged, even over budget.
+static const double PREPARED_PURGE_AGE = 10.0;
+
+static const u32 DECODED_CACHE_MAGIC = 0x54445050;  // PPDT
+static const u32 DECODED_CACHE_VERSION = 1;
+
+struct DecodedCacheHeader {
+	u32 magic;
+	u32 version;
+	u32 w;
+	u32 h;
+	u64 srcSize;
+	u64 srcMtime;
+	u32 alpha;
+	u32 compressedSize;
+};
+
+TextureReplacer::TextureReplacer() : enabled_(false), allowVideo_(false), ignoreAddress_(false), hash_(ReplacedTextureHash::QUICK), preparedBytes_(0) {
 	none_.alphaStatus_ = ReplacedTextureAlpha::UNKNOWN;
 }
 
 TextureReplacer::~TextureReplacer() {
+	StopWorkers();
 }
 
 void TextureReplacer::Init() {
@@ -64,6 +89,72 @@ void TextureReplacer::NotifyConfigChanged() {
 	if (enabled_) {
 		enabled_ = LoadIni();
 	}
+
+	if (enabled_ && workers_.empty()) {
+		StartWorkers();
+	}
+}
+
+void TextureReplacer::StartWorkers() {
+	int count = std::max(1, std::min((int)std::thread::hardware_concurrency() / 2, MAX_PREPARE_WORKERS));
+
+	std::lock_guard<std::mutex> guard(workLock_);
+	workersExit_ = false;
+	for (int i = 0; i < count; ++i) {
+		workers_.push_back(std::thread(&TextureReplacer::WorkerFunc, this));
+	}
+}
+
+void TextureReplacer::StopWorkers() {
+	{
+		std::lock_guard<std::mutex> guard(workLock_);
+		workersExit_ = true;
+		// Nothing waits on queued decoding at shutdown, but queued dumps are still written.
+		for (auto it = work_.begin(); it != work_.end(); ) {
+			if (it->discardOnExit) {
+				it = work_.erase(it);
+			} else {
+				++it;
+			}
+		}
+		workWait_.notify_all();
+	}
+	for (std::thread &worker : workers_) {
+		worker.join();
+	}
+	workers_.clear();
+}
+
+void TextureReplacer::QueueWork(const std::function<void()> &work, bool discardOnExit) {
+	if (workers_.empty()) {
+		work();
+		return;
+	}
+
+	std::lock_guard<std::mutex> guard(workLock_);
+	work_.push_back(ReplacerWork{ work, discardOnExit });
+	workWait_.notify_one();
+}
+
+void TextureReplacer::WorkerFunc() {
+	setCurrentThreadName("TexReplacer");
+
+	std::unique_lock<std::mutex> guard(workLock_);
+	while (true) {
+		if (work_.empty()) {
+			if (workersExit_) {
+				break;
+			}
+			workWait_.wait(guard);
+			continue;
+		}
+
+		std::function<void()> work = work_.front().run;
+		work_.pop_front();
+		guard.unlock();
+		work();
+		guard.lock();
+	}
 }
 
 bool TextureReplacer::LoadIni() {
@@ -252,16 +343,112 @@ ReplacedTexture &TextureReplacer::FindReplacement(u64 cachekey, u32 hash, int w,
 	ReplacementCacheKey replacementKey(cachekey, hash);
 	auto it = cache_.find(replacementKey);
 	if (it != cache_.end()) {
-		return it->second;
+		ReplacedTexture &result = it->second;
+		if (result.Valid() && result.prepareState_ == (int)ReplacedTexturePrepare::NONE) {
+			// Was purged to save memory, but it's wanted again.
+			QueuePrepare(&result);
+		}
+		return result;
 	}
 
 	// Okay, let's construct the result.
 	ReplacedTexture &result = cache_[replacementKey];
 	result.alphaStatus_ = ReplacedTextureAlpha::UNKNOWN;
 	PopulateReplacement(&result, cachekey, hash, w, h);
+	if (result.Valid()) {
+		// Start decoding right away, the caller will use the original until it's ready.
+		QueuePrepare(&result);
+	}
 	return result;
 }
 
+void TextureReplacer::QueuePrepare(ReplacedTexture *texture) {
+	texture->prepareState_ = (int)ReplacedTexturePrepare::QUEUED;
+
+	const std::string basePath = basePath_;
+	const bool useCache = g_Config.bReplaceTexturesDecodedCache;
+	QueueWork([this, texture, basePath, useCache] {
+		Prepare(texture, basePath, useCache);
+		preparedBytes_ += texture->PreparedSize();
+		texture->prepareState_ = (int)ReplacedTexturePrepare::READY;
+	}, true);
+}
+
+void TextureReplacer::Prepare(ReplacedTexture *texture, const std::string &basePath, bool useCache) {
+	std::vector<ReplacedLevelData> data(texture->levels_.size());
+	for (size_t i = 0; i < texture->levels_.size(); ++i) {
+		PrepareLevel(texture->levels_[i], basePath, useCache, data[i]);
+	}
+
+	texture->levelData_ = std::move(data);
+}
+
+bool TextureReplacer::PrepareLevel(const ReplacedTextureLevel &info, const std::string &basePath, bool useCache, ReplacedLevelData &out) {
+	std::shared_ptr<PreparingLevel> preparing;
+	{
+		std::unique_lock<std::mutex> guard(preparingLock_);
+		auto it = preparing_.find(info.file);
+		if (it != preparing_.end()) {
+			// Another worker already has this file, so just wait for its result.
+			preparing = it->second;
+			preparingDone_.wait(guard, [&] { return preparing->done; });
+			if (preparing->success) {
+				out = preparing->data;
+			}
+			return preparing->success;
+		}
+		preparing = std::make_shared<PreparingLevel>();
+		preparing_[info.file] = preparing;
+	}
+
+	// This is the only worker on this file, so also the only one writing its cache file.
+	bool success = false;
+	std::string cacheFile;
+	if (useCache && info.file.compare(0, basePath.size(), basePath) == 0) {
+		cacheFile = basePath + DECODED_CACHE_DIR + info.file.substr(basePath.size()) + ".bin";
+		success = ReplacedTexture::ReadCachedLevel(cacheFile, info, out);
+	}
+	if (!success) {
+		success = ReplacedTexture::PrepareLevel(info, out);
+		if (success && !cacheFile.empty()) {
+			ReplacedTexture::WriteCachedLevel(cacheFile, info, out);
+		}
+	}
+
+	std::lock_guard<std::mutex> guard(preparingLock_);
+	// Everyone waiting took a reference under the lock, so this tells if anyone needs a copy.
+	if (success && preparing.use_count() > 2) {
+		preparing->data = out;
+	}
+	preparing->success = success;
+	preparing->done = true;
+	preparing_.erase(info.file);
+	preparingDone_.notify_all();
+	return success;
+}
+
+void TextureReplacer::Decimate() {
+	const size_t budget = (size_t)std::max(0, g_Config.iReplaceTexturesMemoryMB) * 1024 * 1024;
+	if (preparedBytes_ <= budget) {
+		return;
+	}
+
+	// Textures already uploaded don't need their data until rebuilt, so drop the oldest.
+	const double threshold = time_now_d() - PREPARED_PURGE_AGE;
+	for (auto &it : cache_) {
+		ReplacedTexture &texture = it.second;
+		if (texture.prepareState_ != (int)ReplacedTexturePrepare::READY || texture.lastUsed_ > threshold) {
+			continue;
+		}
+
+		preparedBytes_ -= texture.PreparedSize();
+		texture.PurgePrepared();
+		if (preparedBytes_ <= budget) {
+			break;
+		}
+	}
+}
+
 void TextureReplacer::PopulateReplacement(ReplacedTexture *result, u64 cachekey, u32 hash, int w, int h) {
 	int newW = w;
 	int newH = h;
@@ -360,26 +547,13 @@ void TextureReplacer::NotifyTextureDecoded(const ReplacedTextureDecodeInfo &repl
 
 	ReplacementCacheKey replacementKey(cachekey, replacedInfo.hash);
 	auto it = savedCache_.find(replacementKey);
-	if (it != savedCache_.end() && File::Exists(saveFilename)) {
-		// We've already saved this texture.  Let's only save if it's bigger (e.g. scaled now.)
+	if (it != savedCache_.end()) {
+		// We've already saved (or queued) this texture.  Let's only save if it's bigger (e.g. scaled now.)
 		if (it->second.w >= w && it->second.h >= h) {
 			return;
 		}
 	}
 
-#ifdef _WIN32
-	size_t slash = hashfile.find_last_of("/\\");
-#else
-	size_t slash = hashfile.find_last_of("/");
-#endif
-	if (slash != hashfile.npos) {
-		// Create any directory structure as needed.
-		const std::string saveDirectory = basePath_ + NEW_TEXTURE_DIR + hashfile.substr(0, slash);
-		if (!File::Exists(saveDirectory)) {
-			File::CreateFullPath(saveDirectory);
-		}
-	}
-
 	// Only save the hashed portion of the PNG.
 	int lookupW = w / replacedInfo.scaleFactor;
 	int lookupH = h / replacedInfo.scaleFactor;
@@ -391,56 +565,82 @@ void TextureReplacer::NotifyTextureDecoded(const ReplacedTextureDecodeInfo &repl
 #ifdef USING_QT_UI
 	ERROR_LOG(G3D, "Replacement texture saving not implemented for Qt");
 #else
+	// The data is only valid during this call, so copy it (converting as we go) for the workers.
+	std::shared_ptr<std::vector<u32>> saveBuf = std::make_shared<std::vector<u32>>();
 	if (replacedInfo.fmt != ReplacedTextureFormat::F_8888) {
-		saveBuf.resize((pitch * h) / sizeof(u16));
+		saveBuf->resize((pitch * h) / sizeof(u16));
 		switch (replacedInfo.fmt) {
 		case ReplacedTextureFormat::F_5650:
-			ConvertRGBA565ToRGBA8888(saveBuf.data(), (const u16 *)data, (pitch * h) / sizeof(u16));
+			ConvertRGBA565ToRGBA8888(saveBuf->data(), (const u16 *)data, (pitch * h) / sizeof(u16));
 			break;
 		case ReplacedTextureFormat::F_5551:
-			ConvertRGBA5551ToRGBA8888(saveBuf.data(), (const u16 *)data, (pitch * h) / sizeof(u16));
+			ConvertRGBA5551ToRGBA8888(saveBuf->data(), (const u16 *)data, (pitch * h) / sizeof(u16));
 			break;
 		case ReplacedTextureFormat::F_4444:
-			ConvertRGBA4444ToRGBA8888(saveBuf.data(), (const u16 *)data, (pitch * h) / sizeof(u16));
+			ConvertRGBA4444ToRGBA8888(saveBuf->data(), (const u16 *)data, (pitch * h) / sizeof(u16));
 			break;
 		case ReplacedTextureFormat::F_0565_ABGR:
-			ConvertABGR565ToRGBA8888(saveBuf.data(), (const u16 *)data, (pitch * h) / sizeof(u16));
+			ConvertABGR565ToRGBA8888(saveBuf->data(), (const u16 *)data, (pitch * h) / sizeof(u16));
 			break;
 		case ReplacedTextureFormat::F_1555_ABGR:
-			ConvertABGR1555ToRGBA8888(saveBuf.data(), (const u16 *)data, (pitch * h) / sizeof(u16));
+			ConvertABGR1555ToRGBA8888(saveBuf->data(), (const u16 *)data, (pitch * h) / sizeof(u16));
 			break;
 		case ReplacedTextureFormat::F_4444_ABGR:
-			ConvertABGR4444ToRGBA8888(saveBuf.data(), (const u16 *)data, (pitch * h) / sizeof(u16));
+			ConvertABGR4444ToRGBA8888(saveBuf->data(), (const u16 *)data, (pitch * h) / sizeof(u16));
 			break;
 		case ReplacedTextureFormat::F_8888_BGRA:
-			ConvertBGRA8888ToRGBA8888(saveBuf.data(), (const u32 *)data, (pitch * h) / sizeof(u32));
+			ConvertBGRA8888ToRGBA8888(saveBuf->data(), (const u32 *)data, (pitch * h) / sizeof(u32));
 			break;
 		case ReplacedTextureFormat::F_8888:
 			// Impossible.  Just so we can get warnings on other missed formats.
 			break;
 		}
 
-		data = saveBuf.data();
 		if (replacedInfo.fmt != ReplacedTextureFormat::F_8888_BGRA) {
 			// We doubled our pitch.
 			pitch *= 2;
 		}
+	} else {
+		saveBuf->resize((pitch * h) / sizeof(u32));
+		memcpy(saveBuf->data(), data, pitch * h);
 	}
 
-	png_image png;
-	memset(&png, 0, sizeof(png));
-	png.version = PNG_IMAGE_VERSION;
-	png.format = PNG_FORMAT_RGBA;
-	png.width = w;
-	png.height = h;
-	bool success = WriteTextureToPNG(&png, saveFilename, 0, data, pitch, nullptr);
-	png_image_free(&png);
-
-	if (png.warning_or_error >= 2) {
-		ERROR_LOG(COMMON, "Saving screenshot to PNG produced errors.");
-	} else if (success) {
-		NOTICE_LOG(G3D, "Saving texture for replacement: %08x / %dx%d", replacedInfo.hash, w, h);
+	// Back-pressure: if the workers are behind, wait rather than letting dumps pile up in memory.
+	{
+		std::unique_lock<std::mutex> guard(saveLock_);
+		while (savesPending_ >= MAX_PENDING_SAVES) {
+			saveDone_.wait(guard);
+		}
+		savesPending_++;
 	}
+
+	const std::string saveDirectory = File::GetDir(saveFilename);
+	const u32 hash = replacedInfo.hash;
+	QueueWork([this, saveBuf, saveDirectory, saveFilename, pitch, w, h, hash] {
+		// Create any directory structure as needed.
+		if (!File::Exists(saveDirectory)) {
+			File::CreateFullPath(saveDirectory);
+		}
+
+		png_image png;
+		memset(&png, 0, sizeof(png));
+		png.version = PNG_IMAGE_VERSION;
+		png.format = PNG_FORMAT_RGBA;
+		png.width = w;
+		png.height = h;
+		bool success = WriteTextureToPNG(&png, saveFilename, 0, saveBuf->data(), pitch, nullptr);
+		png_image_free(&png);
+
+		if (png.warning_or_error >= 2) {
+			ERROR_LOG(COMMON, "Saving screenshot to PNG produced errors.");
+		} else if (success) {
+			NOTICE_LOG(G3D, "Saving texture for replacement: %08x / %dx%d", hash, w, h);
+		}
+
+		std::lock_guard<std::mutex> guard(saveLock_);
+		savesPending_--;
+		saveDone_.notify_one();
+	}, false);
 #endif
 
 	// Remember that we've saved this for next time.
@@ -523,10 +723,178 @@ bool TextureReplacer::LookupHashRange(u32 addr, int &w, int &h) {
 	return false;
 }
 
+bool ReplacedTexture::IsReady() {
+	lastUsed_ = time_now_d();
+	return prepareState_ == (int)ReplacedTexturePrepare::READY;
+}
+
+bool ReplacedTexture::PrepareLevel(const ReplacedTextureLevel &info, ReplacedLevelData &out) {
+#ifdef USING_QT_UI
+	ERROR_LOG(G3D, "Replacement texture loading not implemented for Qt");
+	return false;
+#else
+	png_image png = {};
+	png.version = PNG_IMAGE_VERSION;
+
+	FILE *fp = File::OpenCFile(info.file, "rb");
+	if (!fp) {
+		ERROR_LOG(G3D, "Could not open texture replacement: %s", info.file.c_str());
+		return false;
+	}
+	if (!png_image_begin_read_from_stdio(&png, fp)) {
+		ERROR_LOG(G3D, "Could not load texture replacement info: %s - %s", info.file.c_str(), png.message);
+		fclose(fp);
+		return false;
+	}
+
+	bool hasAlpha = (png.format & PNG_FORMAT_FLAG_ALPHA) != 0;
+	png.format = PNG_FORMAT_RGBA;
+
+	out.w = png.width;
+	out.h = png.height;
+	out.data.resize(out.w * out.h * 4);
+	if (!png_image_finish_read(&png, nullptr, &out.data[0], out.w * 4, nullptr)) {
+		ERROR_LOG(G3D, "Could not load texture replacement: %s - %s", info.file.c_str(), png.message);
+		out.data.clear();
+		fclose(fp);
+		png_image_free(&png);
+		return false;
+	}
+	fclose(fp);
+	png_image_free(&png);
+
+	if (!hasAlpha) {
+		// Well, we know for sure it doesn't have alpha.
+		out.alpha = CHECKALPHA_FULL;
+	} else {
+		// This will only check the hashed bits.
+		out.alpha = CheckAlphaRGBA8888Basic((const u32 *)&out.data[0], out.w, out.w, out.h);
+	}
+	return true;
+#endif
+}
+
+bool ReplacedTexture::ReadCachedLevel(const std::string &cacheFile, const ReplacedTextureLevel &info, ReplacedLevelData &out) {
+	File::FileDetails details;
+	if (!File::GetFileDetails(info.file, &details)) {
+		return false;
+	}
+
+	File::IOFile file(cacheFile, "rb");
+	DecodedCacheHeader header;
+	if (!file.IsOpen() || !file.ReadArray(&header, 1)) {
+		return false;
+	}
+	// If the PNG changed since, we decode it again and overwrite the cache.
+	if (header.magic != DECODED_CACHE_MAGIC || header.version != DECODED_CACHE_VERSION || header.srcSize != details.size || header.srcMtime != details.mtime) {
+		return false;
+	}
+
+	std::vector<char> compressed(header.compressedSize);
+	if (header.compressedSize == 0 || !file.ReadBytes(&compressed[0], compressed.size())) {
+		return false;
+	}
+
+	size_t size = header.w * header.h * 4;
+	size_t uncompressedSize = 0;
+	if (snappy_uncompressed_length(&compressed[0], compressed.size(), &uncompressedSize) != SNAPPY_OK || uncompressedSize != size) {
+		return false;
+	}
+
+	out.w = header.w;
+	out.h = header.h;
+	out.alpha = (u8)header.alpha;
+	out.data.resize(size);
+	if (snappy_uncompress(&compressed[0], compressed.size(), (char *)&out.data[0], &uncompressedSize) != SNAPPY_OK) {
+		ERROR_LOG(G3D, "Corrupt decoded texture cache: %s", cacheFile.c_str());
+		out.data.clear();
+		return false;
+	}
+	return true;
+}
+
+void ReplacedTexture::WriteCachedLevel(const std::string &cacheFile, const ReplacedTextureLevel &info, const ReplacedLevelData &data) {
+	File::FileDetails details;
+	if (!File::GetFileDetails(info.file, &details)) {
+		return;
+	}
+
+	const std::string dir = File::GetDir(cacheFile);
+	if (!File::Exists(dir)) {
+		File::CreateFullPath(dir);
+	}
+
+	size_t compressedSize = snappy_max_compressed_length(data.data.size());
+	std::vector<char> compressed(compressedSize);
+	if (snappy_compress((const char *)&data.data[0], data.data.size(), &compressed[0], &compressedSize) != SNAPPY_OK) {
+		return;
+	}
+
+	DecodedCacheHeader header;
+	header.magic = DECODED_CACHE_MAGIC;
+	header.version = DECODED_CACHE_VERSION;
+	header.w = data.w;
+	header.h = data.h;
+	header.srcSize = details.size;
+	header.srcMtime = details.mtime;
+	header.alpha = data.alpha;
+	header.compressedSize = (u32)compressedSize;
+
+	// Written to the side first, so a reader (or a crash) never sees half a file.
+	const std::string tempFile = cacheFile + ".tmp";
+	File::IOFile file(tempFile, "wb");
+	if (!file.IsOpen() || !file.WriteArray(&header, 1) || !file.WriteBytes(&compressed[0], compressedSize)) {
+		ERROR_LOG(G3D, "Unable to write decoded texture cache: %s", cacheFile.c_str());
+		file.Close();
+		File::Delete(tempFile);
+		return;
+	}
+	file.Close();
+
+#ifdef _WIN32
+	// Rename won't replace an existing file here. Until the rename, it's just a cache miss.
+	if (File::Exists(cacheFile)) {
+		File::Delete(cacheFile);
+	}
+#endif
+	if (!File::Rename(tempFile, cacheFile)) {
+		File::Delete(tempFile);
+	}
+}
+
+size_t ReplacedTexture::PreparedSize() const {
+	size_t total = 0;
+	for (const ReplacedLevelData &data : levelData_) {
+		total += data.data.size();
+	}
+	return total;
+}
+
+void ReplacedTexture::PurgePrepared() {
+	levelData_.clear();
+	prepareState_ = (int)ReplacedTexturePrepare::NONE;
+}
+
 void ReplacedTexture::Load(int level, void *out, int rowPitch) {
 	_assert_msg_(G3D, (size_t)level < levels_.size(), "Invalid miplevel");
 	_assert_msg_(G3D, out != nullptr && rowPitch > 0, "Invalid out/pitch");
 
+	if (prepareState_ == (int)ReplacedTexturePrepare::READY && (size_t)level < levelData_.size() && !levelData_[level].data.empty()) {
+		const ReplacedLevelData &data = levelData_[level];
+		const int srcPitch = data.w * 4;
+		for (int y = 0; y < data.h; ++y) {
+			memcpy((u8 *)out + rowPitch * y, &data.data[srcPitch * y], srcPitch);
+		}
+
+		CheckAlphaResult res = (CheckAlphaResult)data.alpha;
+		if (res == CHECKALPHA_ANY || level == 0) {
+			alphaStatus_ = ReplacedTextureAlpha(res);
+		} else if (res == CHECKALPHA_ZERO && alphaStatus_ == ReplacedTextureAlpha::FULL) {
+			alphaStatus_ = ReplacedTextureAlpha(res);
+		}
+		return;
+	}
+
 	const ReplacedTextureLevel &info = levels_[level];
 
 #ifdef USING_QT_UI
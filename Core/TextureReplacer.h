@@ -17,8 +17,15 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 #include "Common/Common.h"
@@ -121,11 +128,31 @@ namespace std {
 	};
 }
 
+// A level decoded ahead of time, always RGBA8888 at the PNG's own size.
+struct ReplacedLevelData {
+	int w;
+	int h;
+	u8 alpha;
+	std::vector<u8> data;
+};
+
+enum class ReplacedTexturePrepare {
+	NONE,
+	QUEUED,
+	READY,
+};
+
 struct ReplacedTexture {
+	ReplacedTexture() : alphaStatus_(ReplacedTextureAlpha::UNKNOWN), prepareState_((int)ReplacedTexturePrepare::NONE), lastUsed_(0.0) {
+	}
+
 	inline bool Valid() {
 		return !levels_.empty();
 	}
 
+	// False while the levels are still being decoded by a worker.
+	bool IsReady();
+
 	bool GetSize(int level, int &w, int &h) {
 		if ((size_t)level < levels_.size()) {
 			w = levels_[level].w;
@@ -153,8 +180,17 @@ struct ReplacedTexture {
 	void Load(int level, void *out, int rowPitch);
 
 protected:
+	static bool PrepareLevel(const ReplacedTextureLevel &info, ReplacedLevelData &out);
+	static bool ReadCachedLevel(const std::string &cacheFile, const ReplacedTextureLevel &info, ReplacedLevelData &out);
+	static void WriteCachedLevel(const std::string &cacheFile, const ReplacedTextureLevel &info, const ReplacedLevelData &data);
+	size_t PreparedSize() const;
+	void PurgePrepared();
+
 	std::vector<ReplacedTextureLevel> levels_;
+	std::vector<ReplacedLevelData> levelData_;
 	ReplacedTextureAlpha alphaStatus_;
+	std::atomic<int> prepareState_;
+	double lastUsed_;
 
 	friend TextureReplacer;
 };
@@ -187,6 +223,13 @@ class TextureReplacer {
 
 	void NotifyTextureDecoded(const ReplacedTextureDecodeInfo &replacedInfo, const void *data, int pitch, int level, int w, int h);
 
+	// Drops decoded replacements that haven't been used lately, if over the memory budget.
+	void Decimate();
+
+	ReplacedTexture &FindNone() {
+		return none_;
+	}
+
 protected:
 	bool LoadIni();
 	void ParseHashRange(const std::string &key, const std::string &value);
@@ -194,8 +237,15 @@ class TextureReplacer {
 	std::string LookupHashFile(u64 cachekey, u32 hash, int level);
 	std::string HashName(u64 cachekey, u32 hash, int level);
 	void PopulateReplacement(ReplacedTexture *result, u64 cachekey, u32 hash, int w, int h);
+	void QueuePrepare(ReplacedTexture *texture);
+	void Prepare(ReplacedTexture *texture, const std::string &basePath, bool useCache);
+	bool PrepareLevel(const ReplacedTextureLevel &info, const std::string &basePath, bool useCache, ReplacedLevelData &out);
+
+	void StartWorkers();
+	void StopWorkers();
+	void QueueWork(const std::function<void()> &work, bool discardOnExit);
+	void WorkerFunc();
 
-	SimpleBuf<u32> saveBuf;
 	bool enabled_;
 	bool allowVideo_;
 	bool ignoreAddress_;
@@ -210,4 +260,30 @@ class TextureReplacer {
 	ReplacedTexture none_;
 	std::unordered_map<ReplacementCacheKey, ReplacedTexture> cache_;
 	std::unordered_map<ReplacementCacheKey, ReplacedTextureLevel> savedCache_;
+	std::atomic<size_t> preparedBytes_;
+
+	struct ReplacerWork {
+		std::function<void()> run;
+		bool discardOnExit;
+	};
+
+	std::vector<std::thread> workers_;
+	std::mutex workLock_;
+	std::condition_variable workWait_;
+	std::deque<ReplacerWork> work_;
+	bool workersExit_ = false;
+
+	std::mutex saveLock_;
+	std::condition_variable saveDone_;
+	int savesPending_ = 0;
+
+	// Files being decoded right now. Several hashes can alias one PNG, and only one worker should decode it.
+	struct PreparingLevel {
+		bool done = false;
+		bool success = false;
+		ReplacedLevelData data;
+	};
+	std::mutex preparingLock_;
+	std::condition_variable preparingDone_;
+	std::unordered_map<std::string, std::shared_ptr<PreparingLevel>> preparing_;
 };
@@ -21,6 +21,10 @@
 #include "Common/Common.h"
 #include "Common/CommonTypes.h"
 
+#ifdef _M_SSE
+#include <emmintrin.h>
+#endif
+
 #define IS_LITTLE_ENDIAN (*(const u16 *)"\0\xff" >= 0x100)
 
 static inline u8 clamp_u8(int i) {
@@ -59,6 +63,15 @@ static inline s16 ApplySampleVolume(s16 sample, int vol) {
 #endif
 }
 
+#ifdef _M_SSE
+// SSE2 has no 32-bit multiply, but the low halves of the unsigned products are the same as signed.
+static inline __m128i MulLo32(__m128i a, __m128i b) {
+	const __m128i even = _mm_mul_epu32(a, b);
+	const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+#endif
+
 void SetupAudioFormats();
 void AdjustVolumeBlockStandard(s16 *out, s16 *in, size_t size, int leftVol, int rightVol);
 void ConvertS16ToF32(float *ou, const s16 *in, size_t size);
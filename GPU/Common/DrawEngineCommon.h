@@ -23,9 +23,11 @@
 #include "Common/CommonTypes.h"
 #include "Common/Hashmaps.h"
 
+#include "GPU/GPU.h"
 #include "GPU/GPUState.h"
 #include "GPU/Common/GPUDebugInterface.h"
 #include "GPU/Common/IndexGenerator.h"
+#include "GPU/Common/SplineCommon.h"
 #include "GPU/Common/VertexDecoderCommon.h"
 
 class VertexDecoder;
@@ -129,7 +131,7 @@ class DrawEngineCommon {
 		u16 indexUpperBound;
 	};
 
-	enum { MAX_DEFERRED_DRAW_CALLS = 128 };
+	enum { MAX_DEFERRED_DRAW_CALLS = 512 };
 	DeferredDrawCall drawCalls[MAX_DEFERRED_DRAW_CALLS];
 	int numDrawCalls = 0;
 	int vertexCountInDrawCalls_ = 0;
@@ -147,6 +149,19 @@ class DrawEngineCommon {
 	// Fixed index buffer for easy quad generation from spline/bezier
 	u16 *quadIndices_ = nullptr;
 
+	// Software tessellation results, reused while a patch's inputs stay the same.
+	struct TessCacheEntry {
+		std::vector<u8> verts;
+		std::vector<u16> indices;
+		int lastFrame;
+	};
+	bool LookupTessCache(const TessCacheKey &key, u8 *&dest, int &count);
+	void StoreTessCache(const TessCacheKey &key, const u8 *dest, int count);
+	void DecimateTessCache(size_t neededBytes);
+
+	std::unordered_map<TessCacheKey, TessCacheEntry> tessCache_;
+	size_t tessCacheBytes_ = 0;
+
 	// Shader blending state
 	bool fboTexNeedBind_ = false;
 	bool fboTexBound_ = false;
@@ -16,10 +16,18 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include <cstring>
+#include "ppsspp_config.h"
 #include "IndexGenerator.h"
 
 #include "Common/Common.h"
 
+#if defined(_M_SSE)
+#include <emmintrin.h>
+#endif
+#if PPSSPP_ARCH(ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 // Points don't need indexing...
 const u8 IndexGenerator::indexedPrimitiveType[7] = {
 	GE_PRIM_POINTS,
@@ -31,6 +39,159 @@ const u8 IndexGenerator::indexedPrimitiveType[7] = {
 	GE_PRIM_RECTANGLES,
 };
 
+// Two triangles per row, the second wound the other way.  Eight triangles (three vectors) per pass.
+alignas(16) static const u16 stripOffsets[24] = {
+	0, 1, 2, 1, 3, 2, 2, 3,
+	4, 3, 5, 4, 4, 5, 6, 5,
+	7, 6, 6, 7, 8, 7, 9, 8,
+};
+alignas(16) static const u16 stripIncrements[24] = {
+	8, 8, 8, 8, 8, 8, 8, 8,
+	8, 8, 8, 8, 8, 8, 8, 8,
+	8, 8, 8, 8, 8, 8, 8, 8,
+};
+
+// The lanes holding the center vertex (0) stay put, the others advance by 8 per pass.
+alignas(16) static const u16 fanOffsets[24] = {
+	0, 1, 2, 0, 2, 3, 0, 3,
+	4, 0, 4, 5, 0, 5, 6, 0,
+	6, 7, 0, 7, 8, 0, 8, 9,
+};
+alignas(16) static const u16 fanIncrements[24] = {
+	0, 8, 8, 0, 8, 8, 0, 8,
+	8, 0, 8, 8, 0, 8, 8, 0,
+	8, 8, 0, 8, 8, 0, 8, 8,
+};
+
+// Writes 24 indices per pass: base + offsets, then offsets += increments.
+static void GenerateIndexPattern(u16 *outInds, int passes, u16 base, const u16 *offsets, const u16 *increments) {
+#if defined(_M_SSE)
+	const __m128i base8 = _mm_set1_epi16(base);
+	__m128i ind0 = _mm_add_epi16(base8, _mm_load_si128((const __m128i *)offsets));
+	__m128i ind1 = _mm_add_epi16(base8, _mm_load_si128((const __m128i *)offsets + 1));
+	__m128i ind2 = _mm_add_epi16(base8, _mm_load_si128((const __m128i *)offsets + 2));
+	const __m128i inc0 = _mm_load_si128((const __m128i *)increments);
+	const __m128i inc1 = _mm_load_si128((const __m128i *)increments + 1);
+	const __m128i inc2 = _mm_load_si128((const __m128i *)increments + 2);
+	__m128i *dst = (__m128i *)outInds;
+	for (int i = 0; i < passes; i++) {
+		_mm_storeu_si128(dst, ind0);
+		_mm_storeu_si128(dst + 1, ind1);
+		_mm_storeu_si128(dst + 2, ind2);
+		ind0 = _mm_add_epi16(ind0, inc0);
+		ind1 = _mm_add_epi16(ind1, inc1);
+		ind2 = _mm_add_epi16(ind2, inc2);
+		dst += 3;
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	const uint16x8_t base8 = vdupq_n_u16(base);
+	uint16x8_t ind0 = vaddq_u16(base8, vld1q_u16(offsets));
+	uint16x8_t ind1 = vaddq_u16(base8, vld1q_u16(offsets + 8));
+	uint16x8_t ind2 = vaddq_u16(base8, vld1q_u16(offsets + 16));
+	const uint16x8_t inc0 = vld1q_u16(increments);
+	const uint16x8_t inc1 = vld1q_u16(increments + 8);
+	const uint16x8_t inc2 = vld1q_u16(increments + 16);
+	for (int i = 0; i < passes; i++) {
+		vst1q_u16(outInds, ind0);
+		vst1q_u16(outInds + 8, ind1);
+		vst1q_u16(outInds + 16, ind2);
+		ind0 = vaddq_u16(ind0, inc0);
+		ind1 = vaddq_u16(ind1, inc1);
+		ind2 = vaddq_u16(ind2, inc2);
+		outInds += 24;
+	}
+#else
+	u16 offs[24];
+	memcpy(offs, offsets, sizeof(offs));
+	for (int i = 0; i < passes; i++) {
+		for (int j = 0; j < 24; j++) {
+			*outInds++ = base + offs[j];
+			offs[j] += increments[j];
+		}
+	}
+#endif
+}
+
+// Adds indexOffset to each index, truncated to 16 bits like everything else here.
+static void RebaseIndices(u16 *outInds, const u8 *inds, int numInds, u16 indexOffset) {
+	int i = 0;
+#if defined(_M_SSE)
+	const __m128i offset = _mm_set1_epi16(indexOffset);
+	const __m128i zero = _mm_setzero_si128();
+	for (; i + 16 <= numInds; i += 16) {
+		__m128i in = _mm_loadu_si128((const __m128i *)(inds + i));
+		_mm_storeu_si128((__m128i *)(outInds + i), _mm_add_epi16(_mm_unpacklo_epi8(in, zero), offset));
+		_mm_storeu_si128((__m128i *)(outInds + i + 8), _mm_add_epi16(_mm_unpackhi_epi8(in, zero), offset));
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	const uint16x8_t offset = vdupq_n_u16(indexOffset);
+	for (; i + 16 <= numInds; i += 16) {
+		uint8x16_t in = vld1q_u8(inds + i);
+		vst1q_u16(outInds + i, vaddw_u8(offset, vget_low_u8(in)));
+		vst1q_u16(outInds + i + 8, vaddw_u8(offset, vget_high_u8(in)));
+	}
+#endif
+	for (; i < numInds; i++)
+		outInds[i] = indexOffset + inds[i];
+}
+
+static void RebaseIndices(u16 *outInds, const u16_le *inds, int numInds, u16 indexOffset) {
+	int i = 0;
+#if defined(_M_SSE)
+	const __m128i offset = _mm_set1_epi16(indexOffset);
+	for (; i + 8 <= numInds; i += 8) {
+		__m128i in = _mm_loadu_si128((const __m128i *)(inds + i));
+		_mm_storeu_si128((__m128i *)(outInds + i), _mm_add_epi16(in, offset));
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	const uint16x8_t offset = vdupq_n_u16(indexOffset);
+	for (; i + 8 <= numInds; i += 8) {
+		vst1q_u16(outInds + i, vaddq_u16(vld1q_u16((const u16 *)(inds + i)), offset));
+	}
+#endif
+	for (; i < numInds; i++)
+		outInds[i] = indexOffset + inds[i];
+}
+
+static void RebaseIndices(u16 *outInds, const u32_le *inds, int numInds, u16 indexOffset) {
+	int i = 0;
+#if defined(_M_SSE)
+	const __m128i offset = _mm_set1_epi16(indexOffset);
+	for (; i + 8 <= numInds; i += 8) {
+		// Sign extend the low 16 bits so the saturating pack keeps them as is.
+		__m128i lo = _mm_loadu_si128((const __m128i *)(inds + i));
+		__m128i hi = _mm_loadu_si128((const __m128i *)(inds + i + 4));
+		lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+		hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+		_mm_storeu_si128((__m128i *)(outInds + i), _mm_add_epi16(_mm_packs_epi32(lo, hi), offset));
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	const uint16x8_t offset = vdupq_n_u16(indexOffset);
+	for (; i + 8 <= numInds; i += 8) {
+		uint16x4_t lo = vmovn_u32(vld1q_u32((const u32 *)(inds + i)));
+		uint16x4_t hi = vmovn_u32(vld1q_u32((const u32 *)(inds + i + 4)));
+		vst1q_u16(outInds + i, vaddq_u16(vcombine_u16(lo, hi), offset));
+	}
+#endif
+	for (; i < numInds; i++)
+		outInds[i] = indexOffset + inds[i];
+}
+
+#if PPSSPP_ARCH(ARM_NEON)
+// Loads eight indices widened or narrowed to 16 bits.
+static inline uint16x8_t LoadIndices(const u8 *inds) {
+	return vmovl_u8(vld1_u8(inds));
+}
+
+static inline uint16x8_t LoadIndices(const u16_le *inds) {
+	return vld1q_u16((const u16 *)inds);
+}
+
+static inline uint16x8_t LoadIndices(const u32_le *inds) {
+	return vcombine_u16(vmovn_u32(vld1q_u32((const u32 *)inds)), vmovn_u32(vld1q_u32((const u32 *)inds + 4)));
+}
+#endif
+
 void IndexGenerator::Setup(u16 *inds) {
 	this->indsBase_ = inds;
 	Reset();
@@ -82,7 +243,16 @@ void IndexGenerator::AddStrip(int numVerts) {
 	const int numTris = numVerts - 2;
 	u16 *outInds = inds_;
 	int ibase = index_;
-	for (int i = 0; i < numTris; i++) {
+	int i = 0;
+	if (numTris >= 8) {
+		// An even number of triangles at a time, so the winding below starts over.
+		int passes = numTris / 8;
+		GenerateIndexPattern(outInds, passes, ibase, stripOffsets, stripIncrements);
+		outInds += passes * 24;
+		ibase += passes * 8;
+		i = passes * 8;
+	}
+	for (; i < numTris; i++) {
 		*outInds++ = ibase;
 		*outInds++ = ibase + wind;
 		wind ^= 3;  // toggle between 1 and 2
@@ -109,14 +279,22 @@ void IndexGenerator::AddFan(int numVerts) {
 	const int numTris = numVerts - 2;
 	u16 *outInds = inds_;
 	const int startIndex = index_;
-	for (int i = 0; i < numTris; i++) {
+	int i = 0;
+	if (numTris >= 8) {
+		int passes = numTris / 8;
+		GenerateIndexPattern(outInds, passes, startIndex, fanOffsets, fanIncrements);
+		outInds += passes * 24;
+		i = passes * 8;
+	}
+	for (; i < numTris; i++) {
 		*outInds++ = startIndex;
 		*outInds++ = startIndex + i + 1;
 		*outInds++ = startIndex + i + 2;
 	}
 	inds_ = outInds;
 	index_ += numVerts;
-	count_ += numTris * 3;
+	if (numTris > 0)
+		count_ += numTris * 3;
 	prim_ = GE_PRIM_TRIANGLES;
 	seenPrims_ |= 1 << GE_PRIM_TRIANGLE_FAN;
 }
@@ -146,7 +324,8 @@ void IndexGenerator::AddLineStrip(int numVerts) {
 	}
 	inds_ = outInds;
 	index_ += numVerts;
-	count_ += numLines * 2;
+	if (numLines > 0)
+		count_ += numLines * 2;
 	prim_ = GE_PRIM_LINES;
 	seenPrims_ |= 1 << GE_PRIM_LINE_STRIP;
 }
@@ -170,10 +349,8 @@ void IndexGenerator::AddRectangles(int numVerts) {
 template <class ITypeLE, int flag>
 void IndexGenerator::TranslatePoints(int numInds, const ITypeLE *inds, int indexOffset) {
 	indexOffset = index_ - indexOffset;
-	u16 *outInds = inds_;
-	for (int i = 0; i < numInds; i++)
-		*outInds++ = indexOffset + inds[i];
-	inds_ = outInds;
+	RebaseIndices(inds_, inds, numInds, indexOffset);
+	inds_ += numInds;
 	count_ += numInds;
 	prim_ = GE_PRIM_POINTS;
 	seenPrims_ |= (1 << GE_PRIM_POINTS) | flag;
@@ -182,13 +359,9 @@ void IndexGenerator::TranslatePoints(int numInds, const ITypeLE *inds, int index
 template <class ITypeLE, int flag>
 void IndexGenerator::TranslateLineList(int numInds, const ITypeLE *inds, int indexOffset) {
 	indexOffset = index_ - indexOffset;
-	u16 *outInds = inds_;
 	numInds = numInds & ~1;
-	for (int i = 0; i < numInds; i += 2) {
-		*outInds++ = indexOffset + inds[i];
-		*outInds++ = indexOffset + inds[i + 1];
-	}
-	inds_ = outInds;
+	RebaseIndices(inds_, inds, numInds, indexOffset);
+	inds_ += numInds;
 	count_ += numInds;
 	prim_ = GE_PRIM_LINES;
 	seenPrims_ |= (1 << GE_PRIM_LINES) | flag;
@@ -204,7 +377,8 @@ void IndexGenerator::TranslateLineStrip(int numInds, const ITypeLE *inds, int in
 		*outInds++ = indexOffset + inds[i + 1];
 	}
 	inds_ = outInds;
-	count_ += numLines * 2;
+	if (numLines > 0)
+		count_ += numLines * 2;
 	prim_ = GE_PRIM_LINES;
 	seenPrims_ |= (1 << GE_PRIM_LINE_STRIP) | flag;
 }
@@ -219,15 +393,10 @@ void IndexGenerator::TranslateList(int numInds, const ITypeLE *inds, int indexOf
 		inds_ += numInds;
 		count_ += numInds;
 	} else {
-		u16 *outInds = inds_;
 		int numTris = numInds / 3;  // Round to whole triangles
 		numInds = numTris * 3;
-		for (int i = 0; i < numInds; i += 3) {
-			*outInds++ = indexOffset + inds[i];
-			*outInds++ = indexOffset + inds[i + 1];
-			*outInds++ = indexOffset + inds[i + 2];
-		}
-		inds_ = outInds;
+		RebaseIndices(inds_, inds, numInds, indexOffset);
+		inds_ += numInds;
 		count_ += numInds;
 	}
 	prim_ = GE_PRIM_TRIANGLES;
@@ -236,18 +405,49 @@ void IndexGenerator::TranslateList(int numInds, const ITypeLE *inds, int indexOf
 
 template <class ITypeLE, int flag>
 void IndexGenerator::TranslateStrip(int numInds, const ITypeLE *inds, int indexOffset) {
-	int wind = 1;
 	indexOffset = index_ - indexOffset;
 	int numTris = numInds - 2;
 	u16 *outInds = inds_;
-	for (int i = 0; i < numTris; i++) {
+	int i = 0;
+#if PPSSPP_ARCH(ARM_NEON)
+	// Eight triangles at a time, vst3 interleaves the corners.  Odd triangles swap the last two.
+	static const u16 evenLanes[8] = { 0xFFFF, 0, 0xFFFF, 0, 0xFFFF, 0, 0xFFFF, 0 };
+	const uint16x8_t even = vld1q_u16(evenLanes);
+	const uint16x8_t offset = vdupq_n_u16((u16)indexOffset);
+	for (; i + 8 <= numTris; i += 8) {
+		uint16x8_t first = vaddq_u16(LoadIndices(inds + i), offset);
+		uint16x8_t second = vaddq_u16(LoadIndices(inds + i + 1), offset);
+		uint16x8_t third = vaddq_u16(LoadIndices(inds + i + 2), offset);
+		uint16x8x3_t tris;
+		tris.val[0] = first;
+		tris.val[1] = vbslq_u16(even, second, third);
+		tris.val[2] = vbslq_u16(even, third, second);
+		vst3q_u16(outInds, tris);
+		outInds += 24;
+	}
+#endif
+	// Two triangles at a time, so the winding doesn't need tracking and each index is read once.
+	for (; i + 2 <= numTris; i += 2) {
+		u16 ind0 = indexOffset + inds[i];
+		u16 ind1 = indexOffset + inds[i + 1];
+		u16 ind2 = indexOffset + inds[i + 2];
+		u16 ind3 = indexOffset + inds[i + 3];
+		outInds[0] = ind0;
+		outInds[1] = ind1;
+		outInds[2] = ind2;
+		outInds[3] = ind1;
+		outInds[4] = ind3;
+		outInds[5] = ind2;
+		outInds += 6;
+	}
+	if (i < numTris) {
 		*outInds++ = indexOffset + inds[i];
-		*outInds++ = indexOffset + inds[i + wind];
-		wind ^= 3;  // Toggle between 1 and 2
-		*outInds++ = indexOffset + inds[i + wind];
+		*outInds++ = indexOffset + inds[i + 1];
+		*outInds++ = indexOffset + inds[i + 2];
 	}
 	inds_ = outInds;
-	count_ += numTris * 3;
+	if (numTris > 0)
+		count_ += numTris * 3;
 	prim_ = GE_PRIM_TRIANGLES;
 	seenPrims_ |= (1 << GE_PRIM_TRIANGLE_STRIP) | flag;
 }
@@ -258,13 +458,27 @@ void IndexGenerator::TranslateFan(int numInds, const ITypeLE *inds, int indexOff
 	indexOffset = index_ - indexOffset;
 	int numTris = numInds - 2;
 	u16 *outInds = inds_;
-	for (int i = 0; i < numTris; i++) {
+	int i = 0;
+#if PPSSPP_ARCH(ARM_NEON)
+	const uint16x8_t offset = vdupq_n_u16((u16)indexOffset);
+	const uint16x8_t center = vdupq_n_u16((u16)(indexOffset + inds[0]));
+	for (; i + 8 <= numTris; i += 8) {
+		uint16x8x3_t tris;
+		tris.val[0] = center;
+		tris.val[1] = vaddq_u16(LoadIndices(inds + i + 1), offset);
+		tris.val[2] = vaddq_u16(LoadIndices(inds + i + 2), offset);
+		vst3q_u16(outInds, tris);
+		outInds += 24;
+	}
+#endif
+	for (; i < numTris; i++) {
 		*outInds++ = indexOffset + inds[0];
 		*outInds++ = indexOffset + inds[i + 1];
 		*outInds++ = indexOffset + inds[i + 2];
 	}
 	inds_ = outInds;
-	count_ += numTris * 3;
+	if (numTris > 0)
+		count_ += numTris * 3;
 	prim_ = GE_PRIM_TRIANGLES;
 	seenPrims_ |= (1 << GE_PRIM_TRIANGLE_FAN) | flag;
 }
@@ -272,14 +486,10 @@ void IndexGenerator::TranslateFan(int numInds, const ITypeLE *inds, int indexOff
 template <class ITypeLE, int flag>
 inline void IndexGenerator::TranslateRectangles(int numInds, const ITypeLE *inds, int indexOffset) {
 	indexOffset = index_ - indexOffset;
-	u16 *outInds = inds_;
 	//rectangles always need 2 vertices, disregard the last one if there's an odd number
 	numInds = numInds & ~1;
-	for (int i = 0; i < numInds; i += 2) {
-		*outInds++ = indexOffset + inds[i];
-		*outInds++ = indexOffset + inds[i+1];
-	}
-	inds_ = outInds;
+	RebaseIndices(inds_, inds, numInds, indexOffset);
+	inds_ += numInds;
 	count_ += numInds;
 	prim_ = GE_PRIM_RECTANGLES;
 	seenPrims_ |= (1 << GE_PRIM_RECTANGLES) | flag;
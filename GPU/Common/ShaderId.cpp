@@ -1,6 +1,7 @@
 #include <string>
 #include <sstream>
 
+#include "Common/Log.h"
 #include "Common/StringUtils.h"
 #include "Core/Config.h"
 
@@ -298,3 +299,19 @@ void ComputeFragmentShaderID(ShaderID *id_out) {
 
 	*id_out = id;
 }
+
+void ValidateVertexShaderID(const ShaderID &id, u32 vertType, bool useHWTransform) {
+	ShaderID expected;
+	ComputeVertexShaderID(&expected, vertType, useHWTransform);
+	if (expected != id) {
+		ERROR_LOG(G3D, "Stale vertex shader ID: %s, state says %s", VertexShaderDesc(id).c_str(), VertexShaderDesc(expected).c_str());
+	}
+}
+
+void ValidateFragmentShaderID(const ShaderID &id) {
+	ShaderID expected;
+	ComputeFragmentShaderID(&expected);
+	if (expected != id) {
+		ERROR_LOG(G3D, "Stale fragment shader ID: %s, state says %s", FragmentShaderDesc(id).c_str(), FragmentShaderDesc(expected).c_str());
+	}
+}
@@ -149,6 +149,55 @@ struct ShaderID {
 };
 
 
+// Remembers what the last few vertex/fragment ID pairs resolved to, so that state toggling back
+// and forth between draws can skip the shader map lookups.  Direct mapped, collisions replace.
+template <class T>
+class ShaderPairCache {
+public:
+	ShaderPairCache() {
+		Clear();
+	}
+
+	void Clear() {
+		for (size_t i = 0; i < ARRAY_SIZE(entries_); i++) {
+			entries_[i].valid = false;
+		}
+	}
+
+	bool Get(const ShaderID &VSID, const ShaderID &FSID, T *value) const {
+		const Entry &entry = entries_[Slot(VSID, FSID)];
+		if (entry.valid && entry.VSID == VSID && entry.FSID == FSID) {
+			*value = entry.value;
+			return true;
+		}
+		return false;
+	}
+
+	void Set(const ShaderID &VSID, const ShaderID &FSID, const T &value) {
+		Entry &entry = entries_[Slot(VSID, FSID)];
+		entry.VSID = VSID;
+		entry.FSID = FSID;
+		entry.value = value;
+		entry.valid = true;
+	}
+
+private:
+	enum { SIZE = 16 };
+
+	static int Slot(const ShaderID &VSID, const ShaderID &FSID) {
+		uint32_t h = (VSID.d[0] * 0x9E3779B1U) ^ (VSID.d[1] * 0x85EBCA77U) ^ (FSID.d[0] * 0xC2B2AE3DU) ^ (FSID.d[1] * 0x27D4EB2FU);
+		return (h ^ (h >> 16)) & (SIZE - 1);
+	}
+
+	struct Entry {
+		ShaderID VSID;
+		ShaderID FSID;
+		T value;
+		bool valid;
+	};
+	Entry entries_[SIZE];
+};
+
 bool CanUseHardwareTransform(int prim);
 void ComputeVertexShaderID(ShaderID *id, uint32_t vertexType, bool useHWTransform);
 // Generates a compact string that describes the shader. Useful in a list to get an overview
@@ -157,3 +206,8 @@ std::string VertexShaderDesc(const ShaderID &id);
 
 void ComputeFragmentShaderID(ShaderID *id);
 std::string FragmentShaderDesc(const ShaderID &id);
+
+// Debug check for IDs reused because their dirty flag was clean.  Logs if the state says otherwise,
+// which means some state change is missing a DIRTY_VERTEXSHADER_STATE / DIRTY_FRAGMENTSHADER_STATE.
+void ValidateVertexShaderID(const ShaderID &id, uint32_t vertexType, bool useHWTransform);
+void ValidateFragmentShaderID(const ShaderID &id);
@@ -26,7 +26,9 @@
 
 #include "GPU/Common/SplineCommon.h"
 #include "GPU/Common/DrawEngineCommon.h"
+#include "GPU/Common/TextureDecoder.h"  // for ReliableHash
 #include "GPU/ge_constants.h"
+#include "GPU/GPU.h"
 #include "GPU/GPUState.h"  // only needed for UVScale stuff
 
 #if defined(_M_SSE)
@@ -844,6 +846,81 @@ void TessellateBezierPatch(u8 *&dest, u16 *&indices, int &count, int tess_u, int
 // This maps GEPatchPrimType to GEPrimitiveType.
 const GEPrimitiveType primType[] = { GE_PRIM_TRIANGLES, GE_PRIM_LINES, GE_PRIM_POINTS, GE_PRIM_POINTS };
 
+enum {
+	TESS_CACHE_MAX_BYTES = 16 * 1024 * 1024,
+	TESS_CACHE_KILL_AGE = 120,
+};
+
+u64 ComputeTessPointsHash(const SimpleVertex *points, int lowerBound, int upperBound, const void *indices, int indexCount, u32 vertType) {
+	// The indices decide which points go where, so they seed the hash of the points themselves.
+	// Always 64-bit, DoReliableHash is only 32 bits on some platforms and this is the whole cache key.
+	u64 seed = 0x3A8E1F52;
+	if (indices) {
+		const u32 indexType = vertType & GE_VTYPE_IDX_MASK;
+		const int indexSize = indexType == GE_VTYPE_IDX_16BIT ? 2 : (indexType == GE_VTYPE_IDX_32BIT ? 4 : 1);
+		seed = DoReliableHash64((const char *)indices, indexCount * indexSize, 0x7F4A7C15);
+	}
+	return DoReliableHash64((const char *)(points + lowerBound), (upperBound - lowerBound + 1) * sizeof(SimpleVertex), seed);
+}
+
+bool DrawEngineCommon::LookupTessCache(const TessCacheKey &key, u8 *&dest, int &count) {
+	auto it = tessCache_.find(key);
+	if (it == tessCache_.end()) {
+		return false;
+	}
+
+	TessCacheEntry &entry = it->second;
+	memcpy(dest, entry.verts.data(), entry.verts.size());
+	dest += entry.verts.size();
+	memcpy(quadIndices_, entry.indices.data(), entry.indices.size() * sizeof(u16));
+	count = (int)entry.indices.size();
+	entry.lastFrame = gpuStats.numFlips;
+	return true;
+}
+
+void DrawEngineCommon::StoreTessCache(const TessCacheKey &key, const u8 *dest, int count) {
+	size_t size = (dest - splineBuffer) + count * sizeof(u16);
+	// Not worth throwing out everything else for a single huge patch.
+	if (size > TESS_CACHE_MAX_BYTES / 4) {
+		return;
+	}
+	if (tessCacheBytes_ + size > TESS_CACHE_MAX_BYTES) {
+		DecimateTessCache(size);
+	}
+
+	TessCacheEntry &entry = tessCache_[key];
+	entry.verts.assign((const u8 *)splineBuffer, dest);
+	entry.indices.assign(quadIndices_, quadIndices_ + count);
+	entry.lastFrame = gpuStats.numFlips;
+	tessCacheBytes_ += size;
+}
+
+void DrawEngineCommon::DecimateTessCache(size_t neededBytes) {
+	auto entrySize = [](const TessCacheEntry &entry) {
+		return entry.verts.size() + entry.indices.size() * sizeof(u16);
+	};
+
+	// First drop anything that hasn't been drawn in a while.
+	const int threshold = gpuStats.numFlips - TESS_CACHE_KILL_AGE;
+	for (auto it = tessCache_.begin(); it != tessCache_.end(); ) {
+		if (it->second.lastFrame < threshold) {
+			tessCacheBytes_ -= entrySize(it->second);
+			it = tessCache_.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	// Then the least recently drawn, until there's room.
+	while (!tessCache_.empty() && tessCacheBytes_ + neededBytes > TESS_CACHE_MAX_BYTES) {
+		auto oldest = std::min_element(tessCache_.begin(), tessCache_.end(), [](const std::pair<const TessCacheKey, TessCacheEntry> &a, const std::pair<const TessCacheKey, TessCacheEntry> &b) {
+			return a.second.lastFrame < b.second.lastFrame;
+		});
+		tessCacheBytes_ -= entrySize(oldest->second);
+		tessCache_.erase(oldest);
+	}
+}
+
 void DrawEngineCommon::SubmitSpline(const void *control_points, const void *indices, int tess_u, int tess_v, int count_u, int count_v, int type_u, int type_v, GEPatchPrimType prim_type, bool computeNormals, bool patchFacing, u32 vertType, int *bytesRead) {
 	PROFILE_THIS_SCOPE("spline");
 	DispatchFlush();
@@ -923,8 +1000,26 @@ void DrawEngineCommon::SubmitSpline(const void *control_points, const void *indi
 		TessellateSplinePatchHardware(dest, quadIndices_, count, patch);
 		numPatches = (count_u - 3) * (count_v - 3);
 	} else {
-		int maxVertexCount = SPLINE_BUFFER_SIZE / vertexSize;
-		TessellateSplinePatch(dest, quadIndices_, count, patch, origVertType, maxVertexCount);
+		TessCacheKey key{};
+		key.pointsHash = ComputeTessPointsHash(simplified_control_points, index_lower_bound, index_upper_bound, indices, count_u * count_v, origVertType);
+		key.vertType = origVertType;
+		key.tess_u = tess_u;
+		key.tess_v = tess_v;
+		key.count_u = count_u;
+		key.count_v = count_v;
+		key.type_u = type_u;
+		key.type_v = type_v;
+		key.primType = prim_type;
+		key.quality = g_Config.iSplineBezierQuality;
+		key.spline = true;
+		key.computeNormals = computeNormals;
+		key.patchFacing = patchFacing;
+
+		if (!LookupTessCache(key, dest, count)) {
+			int maxVertexCount = SPLINE_BUFFER_SIZE / vertexSize;
+			TessellateSplinePatch(dest, quadIndices_, count, patch, origVertType, maxVertexCount);
+			StoreTessCache(key, dest, count);
+		}
 	}
 	delete[] points;
 
@@ -995,7 +1090,6 @@ void DrawEngineCommon::SubmitBezier(const void *control_points, const void *indi
 	// Bezier patches share less control points than spline patches. Otherwise they are pretty much the same (except bezier don't support the open/close thing)
 	int num_patches_u = (count_u - 1) / 3;
 	int num_patches_v = (count_v - 1) / 3;
-	BezierPatch *patches = nullptr;
 	if (g_Config.bHardwareTessellation && g_Config.bHardwareTransform && !g_Config.bSoftwareRendering) {
 		tessDataTransfer->PrepareBuffers(pos, tex, col, count_u * count_v, hasColor, hasTexCoords);
 		for (int idx = 0; idx < count_u * count_v; idx++) {
@@ -1010,23 +1104,6 @@ void DrawEngineCommon::SubmitBezier(const void *control_points, const void *indi
 			SimpleVertex *point = simplified_control_points + (indices ? idxConv.convert(0) : 0);
 			memcpy(col, Vec4f::FromRGBA(point->color_32).AsArray(), 4 * sizeof(float));
 		}
-	} else {
-		patches = new BezierPatch[num_patches_u * num_patches_v];
-		for (int patch_u = 0; patch_u < num_patches_u; patch_u++) {
-			for (int patch_v = 0; patch_v < num_patches_v; patch_v++) {
-				BezierPatch& patch = patches[patch_u + patch_v * num_patches_u];
-				for (int point = 0; point < 16; ++point) {
-					int idx = (patch_u * 3 + point % 4) + (patch_v * 3 + point / 4) * count_u;
-					patch.points[point] = simplified_control_points + (indices ? idxConv.convert(idx) : idx);
-				}
-				patch.u_index = patch_u * 3;
-				patch.v_index = patch_v * 3;
-				patch.index = patch_v * num_patches_u + patch_u;
-				patch.primType = prim_type;
-				patch.computeNormals = computeNormals;
-				patch.patchFacing = patchFacing;
-			}
-		}
 	}
 
 	int count = 0;
@@ -1055,11 +1132,44 @@ void DrawEngineCommon::SubmitBezier(const void *control_points, const void *indi
 			tess_u /= 2;
 			tess_v /= 2;
 		}
-		for (int patch_idx = 0; patch_idx < num_patches_u*num_patches_v; ++patch_idx) {
-			const BezierPatch &patch = patches[patch_idx];
-			TessellateBezierPatch(dest, inds, count, tess_u, tess_v, patch, origVertType);
+
+		TessCacheKey key{};
+		key.pointsHash = ComputeTessPointsHash(simplified_control_points, index_lower_bound, index_upper_bound, indices, count_u * count_v, origVertType);
+		key.vertType = origVertType;
+		key.tess_u = tess_u;
+		key.tess_v = tess_v;
+		key.count_u = count_u;
+		key.count_v = count_v;
+		key.primType = prim_type;
+		key.quality = g_Config.iSplineBezierQuality;
+		key.spline = false;
+		key.computeNormals = computeNormals;
+		key.patchFacing = patchFacing;
+
+		if (!LookupTessCache(key, dest, count)) {
+			BezierPatch *patches = new BezierPatch[num_patches_u * num_patches_v];
+			for (int patch_u = 0; patch_u < num_patches_u; patch_u++) {
+				for (int patch_v = 0; patch_v < num_patches_v; patch_v++) {
+					BezierPatch& patch = patches[patch_u + patch_v * num_patches_u];
+					for (int point = 0; point < 16; ++point) {
+						int idx = (patch_u * 3 + point % 4) + (patch_v * 3 + point / 4) * count_u;
+						patch.points[point] = simplified_control_points + (indices ? idxConv.convert(idx) : idx);
+					}
+					patch.u_index = patch_u * 3;
+					patch.v_index = patch_v * 3;
+					patch.index = patch_v * num_patches_u + patch_u;
+					patch.primType = prim_type;
+					patch.computeNormals = computeNormals;
+					patch.patchFacing = patchFacing;
+				}
+			}
+			for (int patch_idx = 0; patch_idx < num_patches_u*num_patches_v; ++patch_idx) {
+				const BezierPatch &patch = patches[patch_idx];
+				TessellateBezierPatch(dest, inds, count, tess_u, tess_v, patch, origVertType);
+			}
+			delete[] patches;
+			StoreTessCache(key, dest, count);
 		}
-		delete[] patches;
 	}
 
 	u32 vertTypeWithIndex16 = (vertType & ~GE_VTYPE_IDX_MASK) | GE_VTYPE_IDX_16BIT;
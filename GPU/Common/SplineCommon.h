@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <functional>
+
 #include "Common/CommonTypes.h"
 #include "Common/Swap.h"
 #include "GPU/Math3D.h"
@@ -60,6 +62,47 @@ struct SplinePatchLocal {
 	GEPatchPrimType primType;
 };
 
+// Everything a software tessellation result depends on.  The control points are covered by
+// a hash of the normalized points and the indices used to reach them.
+struct TessCacheKey {
+	u64 pointsHash;
+	u32 vertType;
+	u16 tess_u;
+	u16 tess_v;
+	u8 count_u;
+	u8 count_v;
+	u8 type_u;
+	u8 type_v;
+	u8 primType;
+	u8 quality;
+	bool spline;
+	bool computeNormals;
+	bool patchFacing;
+
+	bool operator == (const TessCacheKey &other) const {
+		return pointsHash == other.pointsHash && vertType == other.vertType &&
+			tess_u == other.tess_u && tess_v == other.tess_v && count_u == other.count_u && count_v == other.count_v &&
+			type_u == other.type_u && type_v == other.type_v && primType == other.primType && quality == other.quality &&
+			spline == other.spline && computeNormals == other.computeNormals && patchFacing == other.patchFacing;
+	}
+};
+
+// Covers the points actually used, and the indices if any, since those decide which point goes where.
+u64 ComputeTessPointsHash(const SimpleVertex *points, int lowerBound, int upperBound, const void *indices, int indexCount, u32 vertType);
+
+namespace std {
+
+template <>
+struct hash<TessCacheKey> {
+	std::size_t operator()(const TessCacheKey &k) const {
+		u64 params = ((u64)k.tess_u << 48) ^ ((u64)k.tess_v << 32) ^ (k.count_u << 24) ^ (k.count_v << 16) ^ (k.type_u << 12) ^ (k.type_v << 8) ^
+			(k.primType << 4) ^ (k.quality << 2) ^ (k.spline ? 1 : 0) ^ (k.computeNormals ? 0x100000 : 0) ^ (k.patchFacing ? 0x200000 : 0);
+		return hash<u64>()(k.pointsHash ^ ((u64)k.vertType << 32) ^ params);
+	}
+};
+
+};
+
 enum SplineQuality {
 	LOW_QUALITY = 0,
 	MEDIUM_QUALITY = 1,
@@ -355,6 +355,16 @@ void TextureCacheCommon::SetTexture(bool force) {
 			}
 		}
 
+		if (match && (entry->status & TexCacheEntry::STATUS_TO_REPLACE) && replacer_.Enabled()) {
+			int replaceW = w;
+			int replaceH = h;
+			if (FindReplacement(entry, replaceW, replaceH).Valid()) {
+				// The replacement finished loading in the background, switch to it.
+				match = false;
+				reason = "replacing";
+			}
+		}
+
 		if (match) {
 			// TODO: Mark the entry reliable if it's been safe for long enough?
 			//got one!
@@ -476,9 +486,31 @@ void TextureCacheCommon::Decimate() {
 		VERBOSE_LOG(G3D, "Decimated second texture cache, saved %d estimated bytes - now %d bytes", had - secondCacheSizeEstimate_, secondCacheSizeEstimate_);
 	}
 
+	if (replacer_.Enabled()) {
+		replacer_.Decimate();
+	}
+
 	DecimateVideos();
 }
 
+ReplacedTexture &TextureCacheCommon::FindReplacement(TexCacheEntry *entry, int &w, int &h) {
+	// Short circuit the non-enabled case.
+	if (!replacer_.Enabled()) {
+		entry->status &= ~TexCacheEntry::STATUS_TO_REPLACE;
+		return replacer_.FindNone();
+	}
+
+	ReplacedTexture &replaced = replacer_.FindReplacement(entry->CacheKey(), entry->fullhash, w, h);
+	if (!replaced.Valid() || replaced.IsReady()) {
+		entry->status &= ~TexCacheEntry::STATUS_TO_REPLACE;
+		return replaced;
+	}
+
+	// Use the original texture for now, SetTexture() will rebuild once it's loaded.
+	entry->status |= TexCacheEntry::STATUS_TO_REPLACE;
+	return replacer_.FindNone();
+}
+
 void TextureCacheCommon::DecimateVideos() {
 	if (!videos_.empty()) {
 		for (auto iter = videos_.begin(); iter != videos_.end(); ) {
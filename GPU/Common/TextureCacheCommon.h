@@ -113,6 +113,7 @@ struct TexCacheEntry {
 		STATUS_FREE_CHANGE = 0x200,    // Allow one change before marking "frequent".
 
 		STATUS_BAD_MIPS = 0x400,       // Has bad or unusable mipmap levels.
+		STATUS_TO_REPLACE = 0x800,     // Pending texture replacement, still being loaded.
 	};
 
 	// Status, but int so we can zero initialize.
@@ -231,6 +232,8 @@ class TextureCacheCommon {
 	virtual void BuildTexture(TexCacheEntry *const entry, bool replaceImages) = 0;
 	virtual void UpdateCurrentClut(GEPaletteFormat clutFormat, u32 clutBase, bool clutIndexIsSimple) = 0;
 	bool CheckFullHash(TexCacheEntry *entry, bool &doDelete);
+	// Returns an empty replacement (and flags the entry) if the replacement isn't loaded yet.
+	ReplacedTexture &FindReplacement(TexCacheEntry *entry, int &w, int &h);
 
 	// Separate to keep main texture cache size down.
 	struct AttachedFramebufferInfo {
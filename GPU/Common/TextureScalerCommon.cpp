@@ -25,17 +25,32 @@
 #include <cstdlib>
 #include <cstring>
 #include <cmath>
+#include <condition_variable>
+#include <ctime>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <snappy-c.h>
 
 #include "GPU/Common/TextureScalerCommon.h"
 
+#include "base/stringutil.h"
+#include "file/file_util.h"
+#include "thread/threadutil.h"
 #include "Core/Config.h"
+#include "Core/System.h"
 #include "Common/Common.h"
+#include "Common/FileUtil.h"
 #include "Common/Log.h"
 #include "Common/MsgHandler.h"
 #include "Common/CommonFuncs.h"
 #include "Common/ThreadPools.h"
 #include "Common/CPUDetect.h"
 #include "ext/xbrz/xbrz.h"
+#include "ext/xxhash.h"
 
 #if _M_SSE >= 0x401
 #include <smmintrin.h>
@@ -48,6 +63,292 @@
 #include "base/timeutil.h"
 #endif
 
+/////////////////////////////////////// Disk cache of scaled textures
+
+static const u32 SCALED_CACHE_MAGIC = 0x53545050;  // PPTS
+static const u32 SCALED_CACHE_VERSION = 1;
+static const char *const SCALED_CACHE_DIR = "texscaling";
+static const char *const SCALED_CACHE_EXT = "ppts";
+// Each holds a copy of a scaled texture, so don't let too many pile up if the disk is slow.
+static const size_t SCALED_CACHE_MAX_PENDING = 8;
+
+struct ScaledCacheHeader {
+	u32 magic;
+	u32 version;
+	u64 key;
+	u32 w;
+	u32 h;
+	u32 compressedSize;
+	u32 reserved;
+};
+
+// Scaled results only depend on the source data and the scaling settings, so they stay valid
+// across sessions.  Files are snappy compressed and the least recently used are deleted once
+// the directory goes over budget.  Shared by all scalers, since the files are.  Compressing and
+// writing happen on a background thread, like texture dumps.
+class ScaledTextureDiskCache {
+public:
+	~ScaledTextureDiskCache();
+
+	bool Load(u64 key, u32 *out, int w, int h);
+	void Store(u64 key, const u32 *data, int w, int h);
+
+private:
+	struct Entry {
+		u64 size;
+		u64 lastUsed;
+	};
+
+	struct PendingStore {
+		u64 key;
+		int w;
+		int h;
+		std::vector<u32> data;
+	};
+
+	void ScanDirectory();
+	void Decimate(u64 budget);
+	std::string FilePath(u64 key) const;
+	bool IsPending(u64 key) const;
+	u64 WriteCacheFile(const PendingStore &store);
+	void StoreThread();
+
+	std::mutex lock_;
+	std::string dir_;
+	bool scanned_ = false;
+	std::unordered_map<u64, Entry> entries_;
+	u64 totalBytes_ = 0;
+
+	// Stays at the front while it's being written, so it's not queued again meanwhile.
+	std::deque<PendingStore> pending_;
+	std::condition_variable storeWait_;
+	std::condition_variable storeDone_;
+	std::thread storeThread_;
+	bool storeExit_ = false;
+};
+
+static ScaledTextureDiskCache scaledDiskCache;
+
+ScaledTextureDiskCache::~ScaledTextureDiskCache() {
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		storeExit_ = true;
+		storeWait_.notify_one();
+	}
+	// Anything still queued gets written first.
+	if (storeThread_.joinable()) {
+		storeThread_.join();
+	}
+}
+
+std::string ScaledTextureDiskCache::FilePath(u64 key) const {
+	return StringFromFormat("%s/%016llx.%s", dir_.c_str(), (unsigned long long)key, SCALED_CACHE_EXT);
+}
+
+void ScaledTextureDiskCache::ScanDirectory() {
+	scanned_ = true;
+	dir_ = GetSysDirectory(DIRECTORY_APP_CACHE) + SCALED_CACHE_DIR;
+	if (!File::Exists(dir_)) {
+		File::CreateFullPath(dir_);
+		return;
+	}
+
+	std::vector<FileInfo> files;
+	getFilesInDir(dir_.c_str(), &files, "ppts:");
+	for (const FileInfo &file : files) {
+		u64 key;
+		if (file.isDirectory || sscanf(file.name.c_str(), "%016llx", (unsigned long long *)&key) != 1) {
+			continue;
+		}
+		// The modification time stands in for the last use from earlier sessions.
+		File::FileDetails details;
+		Entry &entry = entries_[key];
+		entry.size = file.size;
+		entry.lastUsed = File::GetFileDetails(file.fullName, &details) ? details.mtime : 0;
+		totalBytes_ += file.size;
+	}
+	INFO_LOG(G3D, "Scaled texture cache: %d files, %lld bytes", (int)entries_.size(), (long long)totalBytes_);
+}
+
+bool ScaledTextureDiskCache::Load(u64 key, u32 *out, int w, int h) {
+	std::string filename;
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		if (!scanned_) {
+			ScanDirectory();
+		}
+		if (entries_.find(key) == entries_.end()) {
+			return false;
+		}
+		filename = FilePath(key);
+	}
+
+	// Reading and decompressing happen without the lock, so other scaling threads and the
+	// writer aren't held up.  At worst the file was deleted meanwhile, and this just fails.
+	File::IOFile file(filename, "rb");
+	ScaledCacheHeader header;
+	bool valid = file.IsOpen() && file.ReadArray(&header, 1);
+	valid = valid && header.magic == SCALED_CACHE_MAGIC && header.version == SCALED_CACHE_VERSION;
+	valid = valid && header.key == key && header.w == (u32)w && header.h == (u32)h && header.compressedSize != 0;
+
+	std::vector<char> compressed;
+	size_t uncompressedSize = 0;
+	if (valid) {
+		compressed.resize(header.compressedSize);
+		valid = file.ReadBytes(&compressed[0], compressed.size());
+	}
+	valid = valid && snappy_uncompressed_length(&compressed[0], compressed.size(), &uncompressedSize) == SNAPPY_OK;
+	valid = valid && uncompressedSize == (size_t)w * h * sizeof(u32);
+	valid = valid && snappy_uncompress(&compressed[0], compressed.size(), (char *)out, &uncompressedSize) == SNAPPY_OK;
+	file.Close();
+
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		auto it = entries_.find(key);
+		if (!valid) {
+			// Stale or corrupt, forget it so it gets scaled and written again.  Unless it was
+			// decimated meanwhile, in which case it's not ours to delete anymore.
+			if (it == entries_.end() || IsPending(key)) {
+				return false;
+			}
+			ERROR_LOG(G3D, "Bad scaled texture cache file: %s", filename.c_str());
+			totalBytes_ -= it->second.size;
+			entries_.erase(it);
+			File::Delete(filename);
+			return false;
+		}
+		if (it != entries_.end()) {
+			it->second.lastUsed = (u64)time(nullptr);
+		}
+	}
+
+	// The modification time is what orders files from earlier sessions, so keep it current.
+	File::TouchFile(filename);
+	return true;
+}
+
+bool ScaledTextureDiskCache::IsPending(u64 key) const {
+	for (const PendingStore &store : pending_) {
+		if (store.key == key) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void ScaledTextureDiskCache::Store(u64 key, const u32 *data, int w, int h) {
+	std::unique_lock<std::mutex> guard(lock_);
+	if (!scanned_) {
+		ScanDirectory();
+	}
+	// Back-pressure: if the writer is behind, wait rather than letting copies pile up in memory.
+	while (pending_.size() >= SCALED_CACHE_MAX_PENDING) {
+		storeDone_.wait(guard);
+	}
+	if (entries_.find(key) != entries_.end() || IsPending(key)) {
+		return;
+	}
+
+	PendingStore store;
+	store.key = key;
+	store.w = w;
+	store.h = h;
+	store.data.assign(data, data + (size_t)w * h);
+	pending_.push_back(std::move(store));
+
+	if (!storeThread_.joinable()) {
+		storeThread_ = std::thread(&ScaledTextureDiskCache::StoreThread, this);
+	}
+	storeWait_.notify_one();
+}
+
+// Returns the size of the file written, or 0 on failure.
+u64 ScaledTextureDiskCache::WriteCacheFile(const PendingStore &store) {
+	const size_t size = store.data.size() * sizeof(u32);
+	size_t compressedSize = snappy_max_compressed_length(size);
+	std::vector<char> compressed(compressedSize);
+	if (snappy_compress((const char *)&store.data[0], size, &compressed[0], &compressedSize) != SNAPPY_OK) {
+		return 0;
+	}
+
+	ScaledCacheHeader header;
+	header.magic = SCALED_CACHE_MAGIC;
+	header.version = SCALED_CACHE_VERSION;
+	header.key = store.key;
+	header.w = store.w;
+	header.h = store.h;
+	header.compressedSize = (u32)compressedSize;
+	header.reserved = 0;
+
+	const std::string filename = FilePath(store.key);
+	File::IOFile file(filename, "wb");
+	if (!file.IsOpen() || !file.WriteArray(&header, 1) || !file.WriteBytes(&compressed[0], compressedSize)) {
+		ERROR_LOG(G3D, "Unable to write scaled texture cache: %s", filename.c_str());
+		file.Close();
+		File::Delete(filename);
+		return 0;
+	}
+	file.Close();
+	return sizeof(header) + compressedSize;
+}
+
+void ScaledTextureDiskCache::StoreThread() {
+	setCurrentThreadName("TexScaleCache");
+
+	std::unique_lock<std::mutex> guard(lock_);
+	while (true) {
+		if (pending_.empty()) {
+			if (storeExit_) {
+				break;
+			}
+			storeWait_.wait(guard);
+			continue;
+		}
+
+		// Only this thread removes from pending_, and adding doesn't move the front.
+		const PendingStore &store = pending_.front();
+		guard.unlock();
+		const u64 written = WriteCacheFile(store);
+		guard.lock();
+
+		if (written != 0) {
+			Entry &entry = entries_[store.key];
+			entry.size = written;
+			entry.lastUsed = (u64)time(nullptr);
+			totalBytes_ += entry.size;
+
+			const u64 budget = (u64)std::max(0, g_Config.iTexScalingCacheMB) * 1024 * 1024;
+			if (totalBytes_ > budget) {
+				Decimate(budget);
+			}
+		}
+		pending_.pop_front();
+		storeDone_.notify_all();
+	}
+}
+
+void ScaledTextureDiskCache::Decimate(u64 budget) {
+	// Go a bit under, so we're not deleting a file on every store.
+	const u64 goal = budget - budget / 8;
+
+	std::vector<std::pair<u64, u64>> byAge;
+	byAge.reserve(entries_.size());
+	for (const auto &it : entries_) {
+		byAge.push_back(std::make_pair(it.second.lastUsed, it.first));
+	}
+	std::sort(byAge.begin(), byAge.end());
+
+	for (const auto &oldest : byAge) {
+		if (totalBytes_ <= goal) {
+			break;
+		}
+		auto it = entries_.find(oldest.second);
+		totalBytes_ -= it->second.size;
+		entries_.erase(it);
+		File::Delete(FilePath(oldest.second));
+	}
+}
+
 /////////////////////////////////////// Helper Functions (mostly math for parallelization)
 
 namespace {
@@ -535,11 +836,32 @@ void TextureScalerCommon::ScaleAlways(u32 *out, u32 *src, u32 &dstFmt, int &widt
 	}
 }
 
+u64 TextureScalerCommon::ScaledCacheKey(const u32 *src, u32 fmt, int width, int height, int factor) {
+	// Everything that changes the output, the backend's formats included.
+	const u32 params[] = {
+		fmt, Get8888Format(), (u32)width, (u32)height, (u32)factor,
+		(u32)g_Config.iTexScalingType, g_Config.bTexDeposterize ? 1U : 0U,
+	};
+	u64 seed = XXH64(params, sizeof(params), 0x5CA1ED);
+	return XXH64(src, width * height * BytesPerPixel(fmt), seed);
+}
+
 bool TextureScalerCommon::ScaleInto(u32 *outputBuf, u32 *src, u32 &dstFmt, int &width, int &height, int factor) {
 #ifdef SCALING_MEASURE_TIME
 	double t_start = real_time_now();
 #endif
 
+	u64 cacheKey = 0;
+	if (g_Config.bTexScalingCache) {
+		cacheKey = ScaledCacheKey(src, dstFmt, width, height, factor);
+		if (scaledDiskCache.Load(cacheKey, outputBuf, width * factor, height * factor)) {
+			dstFmt = Get8888Format();
+			width *= factor;
+			height *= factor;
+			return true;
+		}
+	}
+
 	bufInput.resize(width*height); // used to store the input image image if it needs to be reformatted
 	u32 *inputBuf = bufInput.data();
 
@@ -576,6 +898,10 @@ bool TextureScalerCommon::ScaleInto(u32 *outputBuf, u32 *src, u32 &dstFmt, int &
 	width *= factor;
 	height *= factor;
 
+	if (g_Config.bTexScalingCache) {
+		scaledDiskCache.Store(cacheKey, outputBuf, width, height);
+	}
+
 #ifdef SCALING_MEASURE_TIME
 	if (width*height > 64 * 64 * factor*factor) {
 		double t = real_time_now() - t_start;
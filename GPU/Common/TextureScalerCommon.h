@@ -47,6 +47,7 @@ class TextureScalerCommon {
 	void DePosterize(u32* source, u32* dest, int width, int height);
 
 	bool IsEmptyOrFlat(u32* data, int pixels, int fmt);
+	u64 ScaledCacheKey(const u32 *src, u32 fmt, int width, int height, int factor);
 
 	// depending on the factor and texture sizes, these can get pretty large 
 	// maximum is (100 MB total for a 512 by 512 texture with scaling factor 5 and hybrid scaling)
@@ -268,8 +268,12 @@ inline void DrawEngineD3D11::SetupVertexDecoderInternal(u32 vertType) {
 }
 
 void DrawEngineD3D11::SubmitPrim(void *verts, void *inds, GEPrimitiveType prim, int vertexCount, u32 vertType, int *bytesRead) {
-	if (!indexGen.PrimCompatible(prevPrim_, prim) || numDrawCalls >= MAX_DEFERRED_DRAW_CALLS || vertexCountInDrawCalls_ + vertexCount > VERTEX_BUFFER_MAX)
-		Flush();
+	if (!indexGen.PrimCompatible(prevPrim_, prim))
+		Flush(FLUSH_REASON_PRIM_TYPE);
+	else if (numDrawCalls >= MAX_DEFERRED_DRAW_CALLS)
+		Flush(FLUSH_REASON_DRAW_CALLS_FULL);
+	else if (vertexCountInDrawCalls_ + vertexCount > VERTEX_BUFFER_MAX)
+		Flush(FLUSH_REASON_VERTICES_FULL);
 
 	// TODO: Is this the right thing to do?
 	if (prim == GE_PRIM_KEEP_PREVIOUS) {
@@ -328,7 +332,7 @@ void DrawEngineD3D11::SubmitPrim(void *verts, void *inds, GEPrimitiveType prim,
 		// Rendertarget == texture?
 		if (!g_Config.bDisableSlowFramebufEffects) {
 			gstate_c.Dirty(DIRTY_TEXTURE_PARAMS);
-			Flush();
+			Flush(FLUSH_REASON_RENDER_TO_TEXTURE);
 		}
 	}
 }
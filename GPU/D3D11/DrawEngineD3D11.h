@@ -124,9 +124,10 @@ class DrawEngineD3D11 : public DrawEngineCommon {
 	void SetupVertexDecoderInternal(u32 vertType);
 
 	// So that this can be inlined
-	void Flush() {
+	void Flush(FlushReason reason = FLUSH_REASON_OTHER) {
 		if (!numDrawCalls)
 			return;
+		gpuStats.numFlushesByReason[reason]++;
 		DoFlush();
 	}
 
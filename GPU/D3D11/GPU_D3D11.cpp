@@ -390,7 +390,16 @@ void GPU_D3D11::FastRunLoop(DisplayList &list) {
 	PROFILE_THIS_SCOPE("gpuloop");
 	const CommandInfo *cmdInfo = cmdInfo_;
 	int dc = downcount;
+	bool runStart = true;
 	for (; dc > 0; --dc) {
+		if (runStart) {
+			runStart = false;
+			const int applied = ApplyStateRun(list.pc, dc, cmdInfo);
+			list.pc += applied * 4;
+			dc -= applied;
+			if (dc <= 0)
+				break;
+		}
 		// We know that display list PCs have the upper nibble == 0 - no need to mask the pointer
 		const u32 op = *(const u32 *)(Memory::base + list.pc);
 		const u32 cmd = op >> 24;
@@ -405,7 +414,11 @@ void GPU_D3D11::FastRunLoop(DisplayList &list) {
 		} else {
 			uint64_t flags = info.flags;
 			if (flags & FLAG_FLUSHBEFOREONCHANGE) {
-				drawEngine_.Flush();
+				if ((flags & FLAG_FLUSHIFUSED) && !IsStateUsed(cmd)) {
+					gpuStats.numUnusedStateChanges++;
+				} else {
+					drawEngine_.Flush(FLUSH_REASON_STATE_CHANGE);
+				}
 			}
 			gstate.cmdmem[cmd] = op;
 			if (flags & (FLAG_EXECUTE | FLAG_EXECUTEONCHANGE)) {
@@ -418,6 +431,7 @@ void GPU_D3D11::FastRunLoop(DisplayList &list) {
 					gstate_c.Dirty(dirty);
 			}
 		}
+		runStart = (info.flags & FLAG_ENDS_STATE_RUN) != 0;
 		list.pc += 4;
 	}
 	downcount = 0;
@@ -434,7 +448,7 @@ inline void GPU_D3D11::CheckFlushOp(int cmd, u32 diff) {
 		if (dumpThisFrame_) {
 			NOTICE_LOG(G3D, "================ FLUSH ================");
 		}
-		drawEngine_.Flush();
+		drawEngine_.Flush(FLUSH_REASON_STATE_CHANGE);
 	}
 }
 
@@ -718,7 +732,10 @@ void GPU_D3D11::GetStats(char *buffer, size_t bufsize) {
 	snprintf(buffer, bufsize - 1,
 		"DL processing time: %0.2f ms\n"
 		"Draw calls: %i, flushes %i\n"
+		"Flushes by reason: state %i, prim %i, full %i/%i, rtt %i, other %i\n"
+		"Unused state changes (no flush): %i\n"
 		"Cached Draw calls: %i\n"
+		"State runs replayed: %i (%i commands)\n"
 		"Num Tracked Vertex Arrays: %i\n"
 		"GPU cycles executed: %d (%f per vertex)\n"
 		"Commands per call level: %i %i %i %i\n"
@@ -730,7 +747,16 @@ void GPU_D3D11::GetStats(char *buffer, size_t bufsize) {
 		gpuStats.msProcessingDisplayLists * 1000.0f,
 		gpuStats.numDrawCalls,
 		gpuStats.numFlushes,
+		gpuStats.numFlushesByReason[FLUSH_REASON_STATE_CHANGE],
+		gpuStats.numFlushesByReason[FLUSH_REASON_PRIM_TYPE],
+		gpuStats.numFlushesByReason[FLUSH_REASON_DRAW_CALLS_FULL],
+		gpuStats.numFlushesByReason[FLUSH_REASON_VERTICES_FULL],
+		gpuStats.numFlushesByReason[FLUSH_REASON_RENDER_TO_TEXTURE],
+		gpuStats.numFlushesByReason[FLUSH_REASON_OTHER],
+		gpuStats.numUnusedStateChanges,
 		gpuStats.numCachedDrawCalls,
+		gpuStats.numStateRunsReplayed,
+		gpuStats.numStateRunCommands,
 		gpuStats.numTrackedVertexArrays,
 		gpuStats.vertexGPUCycles + gpuStats.otherGPUCycles,
 		vertexAverageCycles,
@@ -124,6 +124,7 @@ void ShaderManagerD3D11::Clear() {
 	}
 	fsCache_.clear();
 	vsCache_.clear();
+	recentShaders_.Clear();
 	lastFSID_.set_invalid();
 	lastVSID_.set_invalid();
 	gstate_c.Dirty(DIRTY_VERTEXSHADER_STATE | DIRTY_FRAGMENTSHADER_STATE);
@@ -186,6 +187,9 @@ void ShaderManagerD3D11::GetShaders(int prim, u32 vertType, D3D11VertexShader **
 		ComputeVertexShaderID(&VSID, vertType, useHWTransform);
 	} else {
 		VSID = lastVSID_;
+#ifdef _DEBUG
+		ValidateVertexShaderID(VSID, vertType, useHWTransform);
+#endif
 	}
 
 	if (gstate_c.IsDirty(DIRTY_FRAGMENTSHADER_STATE)) {
@@ -193,6 +197,9 @@ void ShaderManagerD3D11::GetShaders(int prim, u32 vertType, D3D11VertexShader **
 		ComputeFragmentShaderID(&FSID);
 	} else {
 		FSID = lastFSID_;
+#ifdef _DEBUG
+		ValidateFragmentShaderID(FSID);
+#endif
 	}
 
 	// Just update uniforms if this is the same shader as last time.
@@ -203,6 +210,17 @@ void ShaderManagerD3D11::GetShaders(int prim, u32 vertType, D3D11VertexShader **
 		return;
 	}
 
+	ShaderPair recent;
+	if (recentShaders_.Get(VSID, FSID, &recent)) {
+		lastVSID_ = VSID;
+		lastFSID_ = FSID;
+		lastVShader_ = recent.vs;
+		lastFShader_ = recent.fs;
+		*vshader = recent.vs;
+		*fshader = recent.fs;
+		return;
+	}
+
 	VSCache::iterator vsIter = vsCache_.find(VSID);
 	D3D11VertexShader *vs;
 	if (vsIter == vsCache_.end()) {
@@ -231,6 +249,7 @@ void ShaderManagerD3D11::GetShaders(int prim, u32 vertType, D3D11VertexShader **
 
 	lastVShader_ = vs;
 	lastFShader_ = fs;
+	recentShaders_.Set(VSID, FSID, { vs, fs });
 
 	*vshader = vs;
 	*fshader = fs;
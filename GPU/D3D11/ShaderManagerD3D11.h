@@ -146,4 +146,10 @@ class ShaderManagerD3D11 : public ShaderManagerCommon {
 
 	ShaderID lastFSID_;
 	ShaderID lastVSID_;
+
+	struct ShaderPair {
+		D3D11VertexShader *vs;
+		D3D11FragmentShader *fs;
+	};
+	ShaderPairCache<ShaderPair> recentShaders_;
 };
\ No newline at end of file
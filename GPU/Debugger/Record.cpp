@@ -20,6 +20,7 @@
 #include <vector>
 #include <snappy-c.h>
 #include "base/stringutil.h"
+#include "base/timeutil.h"
 #include "Common/Common.h"
 #include "Common/FileUtil.h"
 #include "Common/Log.h"
@@ -45,6 +46,7 @@ static const char *HEADER = "PPSSPPGE";
 static const int VERSION = 2;
 
 static bool active = false;
+static ReplayFrameCallback replayFrameCallback = nullptr;
 static bool nextFrame = false;
 static bool writePending = false;
 
@@ -1029,9 +1031,19 @@ bool RunMountedReplay(const std::string &filename) {
 		return false;
 	}
 
+	double start = real_time_now();
 	bool success = ExecuteCommands();
+	double elapsed = real_time_now() - start;
 	ExecuteFree();
+
+	if (success && replayFrameCallback) {
+		replayFrameCallback(elapsed);
+	}
 	return success;
 }
 
+void SetReplayFrameCallback(ReplayFrameCallback callback) {
+	replayFrameCallback = callback;
+}
+
 };
@@ -33,4 +33,8 @@ void NotifyFrame();
 
 bool RunMountedReplay(const std::string &filename);
 
+// Called after each successful replay with the host time it took, in seconds.
+typedef void (*ReplayFrameCallback)(double seconds);
+void SetReplayFrameCallback(ReplayFrameCallback callback);
+
 };
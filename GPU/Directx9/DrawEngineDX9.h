@@ -121,9 +121,10 @@ class DrawEngineDX9 : public DrawEngineCommon {
 	void DecimateTrackedVertexArrays();
 
 	// So that this can be inlined
-	void Flush() {
+	void Flush(FlushReason reason = FLUSH_REASON_OTHER) {
 		if (!numDrawCalls)
 			return;
+		gpuStats.numFlushesByReason[reason]++;
 		DoFlush();
 	}
 
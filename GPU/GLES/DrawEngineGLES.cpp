@@ -253,8 +253,12 @@ static void SetupDecFmtForDraw(LinkedShader *program, const DecVtxFormat &decFmt
 }
 
 void DrawEngineGLES::SubmitPrim(void *verts, void *inds, GEPrimitiveType prim, int vertexCount, u32 vertType, int *bytesRead) {
-	if (!indexGen.PrimCompatible(prevPrim_, prim) || numDrawCalls >= MAX_DEFERRED_DRAW_CALLS || vertexCountInDrawCalls_ + vertexCount > VERTEX_BUFFER_MAX)
-		Flush();
+	if (!indexGen.PrimCompatible(prevPrim_, prim))
+		Flush(FLUSH_REASON_PRIM_TYPE);
+	else if (numDrawCalls >= MAX_DEFERRED_DRAW_CALLS)
+		Flush(FLUSH_REASON_DRAW_CALLS_FULL);
+	else if (vertexCountInDrawCalls_ + vertexCount > VERTEX_BUFFER_MAX)
+		Flush(FLUSH_REASON_VERTICES_FULL);
 
 	// TODO: Is this the right thing to do?
 	if (prim == GE_PRIM_KEEP_PREVIOUS) {
@@ -311,7 +315,7 @@ void DrawEngineGLES::SubmitPrim(void *verts, void *inds, GEPrimitiveType prim, i
 		// Rendertarget == texture?
 		if (!g_Config.bDisableSlowFramebufEffects) {
 			gstate_c.Dirty(DIRTY_TEXTURE_PARAMS);
-			Flush();
+			Flush(FLUSH_REASON_RENDER_TO_TEXTURE);
 		}
 	}
 }
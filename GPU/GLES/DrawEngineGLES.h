@@ -129,9 +129,10 @@ class DrawEngineGLES : public DrawEngineCommon, public GfxResourceHolder {
 	void DecimateTrackedVertexArrays();
 
 	// So that this can be inlined
-	void Flush() {
+	void Flush(FlushReason reason = FLUSH_REASON_OTHER) {
 		if (!numDrawCalls)
 			return;
+		gpuStats.numFlushesByReason[reason]++;
 		DoFlush();
 	}
 
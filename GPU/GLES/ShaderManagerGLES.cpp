@@ -762,6 +762,7 @@ void ShaderManagerGLES::Clear() {
 		delete shader;
 	});
 	linkedShaderCache_.clear();
+	recentLinked_.Clear();
 	fsCache_.Clear();
 	vsCache_.Clear();
 	DirtyShader();
@@ -817,6 +818,9 @@ Shader *ShaderManagerGLES::ApplyVertexShader(int prim, u32 vertType, ShaderID *V
 		ComputeVertexShaderID(VSID, vertType, useHWTransform);
 	} else {
 		*VSID = lastVSID_;
+#ifdef _DEBUG
+		ValidateVertexShaderID(*VSID, vertType, useHWTransform);
+#endif
 	}
 
 	if (lastShader_ != 0 && *VSID == lastVSID_) {
@@ -863,6 +867,9 @@ LinkedShader *ShaderManagerGLES::ApplyFragmentShader(ShaderID VSID, Shader *vs,
 		ComputeFragmentShaderID(&FSID);
 	} else {
 		FSID = lastFSID_;
+#ifdef _DEBUG
+		ValidateFragmentShaderID(FSID);
+#endif
 	}
 
 	if (lastVShaderSame_ && FSID == lastFSID_) {
@@ -872,37 +879,55 @@ LinkedShader *ShaderManagerGLES::ApplyFragmentShader(ShaderID VSID, Shader *vs,
 
 	lastFSID_ = FSID;
 
-	Shader *fs = fsCache_.Get(FSID);
-	if (!fs)	{
-		// Fragment shader not in cache. Let's compile it.
-		fs = CompileFragmentShader(FSID);
-		fsCache_.Insert(FSID, fs);
-		diskCacheDirty_ = true;
-	}
-
-	// Okay, we have both shaders. Let's see if there's a linked one.
 	LinkedShader *ls = nullptr;
+	if (!recentLinked_.Get(VSID, FSID, &ls)) {
+		Shader *fs = fsCache_.Get(FSID);
+		if (!fs)	{
+			// Fragment shader not in cache. Let's compile it.
+			fs = CompileFragmentShader(FSID);
+			fsCache_.Insert(FSID, fs);
+			diskCacheDirty_ = true;
+		}
 
-	u64 switchDirty = shaderSwitchDirtyUniforms_;
-	for (auto iter = linkedShaderCache_.begin(); iter != linkedShaderCache_.end(); ++iter) {
-		// Deferred dirtying! Let's see if we can make this even more clever later.
-		iter->ls->dirtyUniforms |= switchDirty;
+		// Okay, we have both shaders. Let's see if there's a linked one.
+		for (auto iter = linkedShaderCache_.begin(); iter != linkedShaderCache_.end(); ++iter) {
+			if (iter->vs == vs && iter->fs == fs) {
+				ls = iter->ls;
+				break;
+			}
+		}
 
-		if (iter->vs == vs && iter->fs == fs) {
-			ls = iter->ls;
+		if (ls == nullptr) {
+			// Check if we can link these.
+			ls = new LinkedShader(VSID, vs, FSID, fs, vs->UseHWTransform());
+			const LinkedShaderCacheEntry entry(vs, fs, ls);
+			linkedShaderCache_.push_back(entry);
 		}
+		recentLinked_.Set(VSID, FSID, ls);
 	}
-	shaderSwitchDirtyUniforms_ = 0;
 
-	if (ls == nullptr) {
-		// Check if we can link these.
-		ls = new LinkedShader(VSID, vs, FSID, fs, vs->UseHWTransform());
-		ls->use(VSID, lastShader_);
-		const LinkedShaderCacheEntry entry(vs, fs, ls);
-		linkedShaderCache_.push_back(entry);
-	} else {
-		ls->use(VSID, lastShader_);
+	// Deferred dirtying: rather than flagging every program on each switch, remember when each
+	// uniform changed and let a program catch up when it's used again.
+	if (shaderSwitchDirtyUniforms_) {
+		shaderSwitchCount_++;
+		u64 switchDirty = shaderSwitchDirtyUniforms_;
+		for (int i = 0; switchDirty != 0; i++, switchDirty >>= 1) {
+			if (switchDirty & 1) {
+				uniformDirtySwitch_[i] = shaderSwitchCount_;
+			}
+		}
+		shaderSwitchDirtyUniforms_ = 0;
 	}
+	if (ls->dirtySync != shaderSwitchCount_) {
+		for (int i = 0; i < 64; i++) {
+			if (uniformDirtySwitch_[i] > ls->dirtySync) {
+				ls->dirtyUniforms |= 1ULL << i;
+			}
+		}
+		ls->dirtySync = shaderSwitchCount_;
+	}
+
+	ls->use(VSID, lastShader_);
 	ls->UpdateUniforms(vertType, VSID);
 
 	lastShader_ = ls;
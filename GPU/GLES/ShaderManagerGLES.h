@@ -57,6 +57,8 @@ class LinkedShader {
 	uint32_t program;
 	uint64_t availableUniforms;
 	uint64_t dirtyUniforms;
+	// Program switch count when this last caught up with uniforms dirtied while it wasn't in use.
+	uint64_t dirtySync = 0;
 
 	// Present attributes in the shader.
 	int attrMask;  // 1 << ATTR_ ... or-ed together.
@@ -189,6 +191,10 @@ class ShaderManagerGLES : public ShaderManagerCommon {
 
 	LinkedShader *lastShader_;
 	u64 shaderSwitchDirtyUniforms_;
+	// Switch count at which each uniform dirty bit was last set, for catching up programs lazily.
+	u64 uniformDirtySwitch_[64]{};
+	u64 shaderSwitchCount_ = 0;
+	ShaderPairCache<LinkedShader *> recentLinked_;
 	char *codeBuffer_;
 
 	typedef DenseHashMap<ShaderID, Shader *, nullptr> FSCache;
@@ -50,6 +50,17 @@ inline unsigned int toFloat24(float f) {
 	return i >> 8;
 }
 
+// Why the draw engine flushed its queued draws.  Only counted when there were draws queued.
+enum FlushReason {
+	FLUSH_REASON_OTHER,
+	FLUSH_REASON_STATE_CHANGE,
+	FLUSH_REASON_PRIM_TYPE,
+	FLUSH_REASON_DRAW_CALLS_FULL,
+	FLUSH_REASON_VERTICES_FULL,
+	FLUSH_REASON_RENDER_TO_TEXTURE,
+	FLUSH_REASON_COUNT,
+};
+
 struct GPUStatistics {
 	void Reset() {
 		// Never add a vtable :)
@@ -66,6 +77,10 @@ struct GPUStatistics {
 		numTextureSwitches = 0;
 		numShaderSwitches = 0;
 		numFlushes = 0;
+		memset(numFlushesByReason, 0, sizeof(numFlushesByReason));
+		numUnusedStateChanges = 0;
+		numStateRunsReplayed = 0;
+		numStateRunCommands = 0;
 		numTexturesDecoded = 0;
 		msProcessingDisplayLists = 0;
 		vertexGPUCycles = 0;
@@ -77,6 +92,11 @@ struct GPUStatistics {
 	int numDrawCalls;
 	int numCachedDrawCalls;
 	int numFlushes;
+	int numFlushesByReason[FLUSH_REASON_COUNT];
+	// Changes to state the queued draws don't use, which didn't need a flush.
+	int numUnusedStateChanges;
+	int numStateRunsReplayed;
+	int numStateRunCommands;
 	int numVertsSubmitted;
 	int numCachedVertsDrawn;
 	int numUncachedVertsDrawn;
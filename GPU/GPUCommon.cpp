@@ -53,9 +53,9 @@ const CommonCommandTableEntry commonCommandTable[] = {
 	{ GE_CMD_ZBUFPTR, FLAG_FLUSHBEFOREONCHANGE },
 	{ GE_CMD_ZBUFWIDTH, FLAG_FLUSHBEFOREONCHANGE },
 
-	{ GE_CMD_FOGCOLOR, FLAG_FLUSHBEFOREONCHANGE, DIRTY_FOGCOLOR },
-	{ GE_CMD_FOG1, FLAG_FLUSHBEFOREONCHANGE, DIRTY_FOGCOEF },
-	{ GE_CMD_FOG2, FLAG_FLUSHBEFOREONCHANGE, DIRTY_FOGCOEF },
+	{ GE_CMD_FOGCOLOR, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_FOGCOLOR },
+	{ GE_CMD_FOG1, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_FOGCOEF },
+	{ GE_CMD_FOG2, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_FOGCOEF },
 
 	// These affect the fragment shader so need flushing.
 	{ GE_CMD_CLEARMODE, FLAG_FLUSHBEFOREONCHANGE, DIRTY_BLEND_STATE | DIRTY_DEPTHSTENCIL_STATE | DIRTY_RASTER_STATE | DIRTY_VIEWPORTSCISSOR_STATE | DIRTY_VERTEXSHADER_STATE | DIRTY_FRAGMENTSHADER_STATE },
@@ -73,18 +73,18 @@ const CommonCommandTableEntry commonCommandTable[] = {
 	// These change the vertex shader so need flushing.
 	{ GE_CMD_REVERSENORMAL, FLAG_FLUSHBEFOREONCHANGE, DIRTY_VERTEXSHADER_STATE },
 	{ GE_CMD_LIGHTINGENABLE, FLAG_FLUSHBEFOREONCHANGE, DIRTY_VERTEXSHADER_STATE | DIRTY_FRAGMENTSHADER_STATE },
-	{ GE_CMD_LIGHTENABLE0, FLAG_FLUSHBEFOREONCHANGE, DIRTY_VERTEXSHADER_STATE  },
-	{ GE_CMD_LIGHTENABLE1, FLAG_FLUSHBEFOREONCHANGE, DIRTY_VERTEXSHADER_STATE  },
-	{ GE_CMD_LIGHTENABLE2, FLAG_FLUSHBEFOREONCHANGE, DIRTY_VERTEXSHADER_STATE  },
-	{ GE_CMD_LIGHTENABLE3, FLAG_FLUSHBEFOREONCHANGE, DIRTY_VERTEXSHADER_STATE  },
-	{ GE_CMD_LIGHTTYPE0, FLAG_FLUSHBEFOREONCHANGE, DIRTY_VERTEXSHADER_STATE  },
-	{ GE_CMD_LIGHTTYPE1, FLAG_FLUSHBEFOREONCHANGE, DIRTY_VERTEXSHADER_STATE  },
-	{ GE_CMD_LIGHTTYPE2, FLAG_FLUSHBEFOREONCHANGE, DIRTY_VERTEXSHADER_STATE  },
-	{ GE_CMD_LIGHTTYPE3, FLAG_FLUSHBEFOREONCHANGE, DIRTY_VERTEXSHADER_STATE  },
+	{ GE_CMD_LIGHTENABLE0, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_VERTEXSHADER_STATE  },
+	{ GE_CMD_LIGHTENABLE1, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_VERTEXSHADER_STATE  },
+	{ GE_CMD_LIGHTENABLE2, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_VERTEXSHADER_STATE  },
+	{ GE_CMD_LIGHTENABLE3, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_VERTEXSHADER_STATE  },
+	{ GE_CMD_LIGHTTYPE0, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_VERTEXSHADER_STATE  },
+	{ GE_CMD_LIGHTTYPE1, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_VERTEXSHADER_STATE  },
+	{ GE_CMD_LIGHTTYPE2, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_VERTEXSHADER_STATE  },
+	{ GE_CMD_LIGHTTYPE3, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_VERTEXSHADER_STATE  },
 	{ GE_CMD_MATERIALUPDATE, FLAG_FLUSHBEFOREONCHANGE, DIRTY_VERTEXSHADER_STATE | DIRTY_FRAGMENTSHADER_STATE },
 
 	// These change both shaders so need flushing.
-	{ GE_CMD_LIGHTMODE, FLAG_FLUSHBEFOREONCHANGE, DIRTY_VERTEXSHADER_STATE | DIRTY_FRAGMENTSHADER_STATE },
+	{ GE_CMD_LIGHTMODE, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_VERTEXSHADER_STATE | DIRTY_FRAGMENTSHADER_STATE },
 
 	{ GE_CMD_TEXFILTER, FLAG_FLUSHBEFOREONCHANGE, DIRTY_TEXTURE_PARAMS },
 	{ GE_CMD_TEXWRAP, FLAG_FLUSHBEFOREONCHANGE, DIRTY_TEXTURE_PARAMS | DIRTY_FRAGMENTSHADER_STATE },
@@ -196,77 +196,77 @@ const CommonCommandTableEntry commonCommandTable[] = {
 	{ GE_CMD_SCISSOR2, FLAG_FLUSHBEFOREONCHANGE, DIRTY_FRAMEBUF | DIRTY_TEXTURE_PARAMS | DIRTY_VIEWPORTSCISSOR_STATE },
 
 	// Lighting base colors
-	{ GE_CMD_AMBIENTCOLOR, FLAG_FLUSHBEFOREONCHANGE, DIRTY_AMBIENT },
-	{ GE_CMD_AMBIENTALPHA, FLAG_FLUSHBEFOREONCHANGE, DIRTY_AMBIENT },
-	{ GE_CMD_MATERIALDIFFUSE, FLAG_FLUSHBEFOREONCHANGE, DIRTY_MATDIFFUSE },
-	{ GE_CMD_MATERIALEMISSIVE, FLAG_FLUSHBEFOREONCHANGE, DIRTY_MATEMISSIVE },
+	{ GE_CMD_AMBIENTCOLOR, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_AMBIENT },
+	{ GE_CMD_AMBIENTALPHA, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_AMBIENT },
+	{ GE_CMD_MATERIALDIFFUSE, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_MATDIFFUSE },
+	{ GE_CMD_MATERIALEMISSIVE, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_MATEMISSIVE },
 	{ GE_CMD_MATERIALAMBIENT, FLAG_FLUSHBEFOREONCHANGE, DIRTY_MATAMBIENTALPHA },
 	{ GE_CMD_MATERIALALPHA, FLAG_FLUSHBEFOREONCHANGE, DIRTY_MATAMBIENTALPHA },
-	{ GE_CMD_MATERIALSPECULAR, FLAG_FLUSHBEFOREONCHANGE, DIRTY_MATSPECULAR },
-	{ GE_CMD_MATERIALSPECULARCOEF, FLAG_FLUSHBEFOREONCHANGE, DIRTY_MATSPECULAR },
+	{ GE_CMD_MATERIALSPECULAR, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_MATSPECULAR },
+	{ GE_CMD_MATERIALSPECULARCOEF, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_MATSPECULAR },
 
 	// Light parameters
-	{ GE_CMD_LX0, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT0 },
-	{ GE_CMD_LY0, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT0 },
-	{ GE_CMD_LZ0, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT0 },
-	{ GE_CMD_LX1, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT1 },
-	{ GE_CMD_LY1, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT1 },
-	{ GE_CMD_LZ1, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT1 },
-	{ GE_CMD_LX2, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT2 },
-	{ GE_CMD_LY2, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT2 },
-	{ GE_CMD_LZ2, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT2 },
-	{ GE_CMD_LX3, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT3 },
-	{ GE_CMD_LY3, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT3 },
-	{ GE_CMD_LZ3, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT3 },
-
-	{ GE_CMD_LDX0, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT0 },
-	{ GE_CMD_LDY0, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT0 },
-	{ GE_CMD_LDZ0, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT0 },
-	{ GE_CMD_LDX1, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT1 },
-	{ GE_CMD_LDY1, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT1 },
-	{ GE_CMD_LDZ1, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT1 },
-	{ GE_CMD_LDX2, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT2 },
-	{ GE_CMD_LDY2, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT2 },
-	{ GE_CMD_LDZ2, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT2 },
-	{ GE_CMD_LDX3, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT3 },
-	{ GE_CMD_LDY3, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT3 },
-	{ GE_CMD_LDZ3, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT3 },
-
-	{ GE_CMD_LKA0, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT0 },
-	{ GE_CMD_LKB0, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT0 },
-	{ GE_CMD_LKC0, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT0 },
-	{ GE_CMD_LKA1, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT1 },
-	{ GE_CMD_LKB1, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT1 },
-	{ GE_CMD_LKC1, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT1 },
-	{ GE_CMD_LKA2, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT2 },
-	{ GE_CMD_LKB2, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT2 },
-	{ GE_CMD_LKC2, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT2 },
-	{ GE_CMD_LKA3, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT3 },
-	{ GE_CMD_LKB3, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT3 },
-	{ GE_CMD_LKC3, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT3 },
-
-	{ GE_CMD_LKS0, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT0 },
-	{ GE_CMD_LKS1, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT1 },
-	{ GE_CMD_LKS2, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT2 },
-	{ GE_CMD_LKS3, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT3 },
-
-	{ GE_CMD_LKO0, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT0 },
-	{ GE_CMD_LKO1, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT1 },
-	{ GE_CMD_LKO2, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT2 },
-	{ GE_CMD_LKO3, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT3 },
-
-	{ GE_CMD_LAC0, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT0 },
-	{ GE_CMD_LDC0, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT0 },
-	{ GE_CMD_LSC0, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT0 },
-	{ GE_CMD_LAC1, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT1 },
-	{ GE_CMD_LDC1, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT1 },
-	{ GE_CMD_LSC1, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT1 },
-	{ GE_CMD_LAC2, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT2 },
-	{ GE_CMD_LDC2, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT2 },
-	{ GE_CMD_LSC2, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT2 },
-	{ GE_CMD_LAC3, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT3 },
-	{ GE_CMD_LDC3, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT3 },
-	{ GE_CMD_LSC3, FLAG_FLUSHBEFOREONCHANGE, DIRTY_LIGHT3 },
+	{ GE_CMD_LX0, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT0 },
+	{ GE_CMD_LY0, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT0 },
+	{ GE_CMD_LZ0, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT0 },
+	{ GE_CMD_LX1, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT1 },
+	{ GE_CMD_LY1, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT1 },
+	{ GE_CMD_LZ1, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT1 },
+	{ GE_CMD_LX2, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT2 },
+	{ GE_CMD_LY2, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT2 },
+	{ GE_CMD_LZ2, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT2 },
+	{ GE_CMD_LX3, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT3 },
+	{ GE_CMD_LY3, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT3 },
+	{ GE_CMD_LZ3, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT3 },
+
+	{ GE_CMD_LDX0, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT0 },
+	{ GE_CMD_LDY0, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT0 },
+	{ GE_CMD_LDZ0, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT0 },
+	{ GE_CMD_LDX1, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT1 },
+	{ GE_CMD_LDY1, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT1 },
+	{ GE_CMD_LDZ1, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT1 },
+	{ GE_CMD_LDX2, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT2 },
+	{ GE_CMD_LDY2, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT2 },
+	{ GE_CMD_LDZ2, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT2 },
+	{ GE_CMD_LDX3, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT3 },
+	{ GE_CMD_LDY3, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT3 },
+	{ GE_CMD_LDZ3, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT3 },
+
+	{ GE_CMD_LKA0, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT0 },
+	{ GE_CMD_LKB0, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT0 },
+	{ GE_CMD_LKC0, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT0 },
+	{ GE_CMD_LKA1, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT1 },
+	{ GE_CMD_LKB1, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT1 },
+	{ GE_CMD_LKC1, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT1 },
+	{ GE_CMD_LKA2, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT2 },
+	{ GE_CMD_LKB2, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT2 },
+	{ GE_CMD_LKC2, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT2 },
+	{ GE_CMD_LKA3, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT3 },
+	{ GE_CMD_LKB3, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT3 },
+	{ GE_CMD_LKC3, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT3 },
+
+	{ GE_CMD_LKS0, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT0 },
+	{ GE_CMD_LKS1, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT1 },
+	{ GE_CMD_LKS2, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT2 },
+	{ GE_CMD_LKS3, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT3 },
+
+	{ GE_CMD_LKO0, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT0 },
+	{ GE_CMD_LKO1, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT1 },
+	{ GE_CMD_LKO2, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT2 },
+	{ GE_CMD_LKO3, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT3 },
+
+	{ GE_CMD_LAC0, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT0 },
+	{ GE_CMD_LDC0, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT0 },
+	{ GE_CMD_LSC0, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT0 },
+	{ GE_CMD_LAC1, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT1 },
+	{ GE_CMD_LDC1, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT1 },
+	{ GE_CMD_LSC1, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT1 },
+	{ GE_CMD_LAC2, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT2 },
+	{ GE_CMD_LDC2, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT2 },
+	{ GE_CMD_LSC2, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT2 },
+	{ GE_CMD_LAC3, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT3 },
+	{ GE_CMD_LDC3, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT3 },
+	{ GE_CMD_LSC3, FLAG_FLUSHBEFOREONCHANGE | FLAG_FLUSHIFUSED, DIRTY_LIGHT3 },
 
 	// Ignored commands
 	{ GE_CMD_TEXFLUSH, 0 },
@@ -360,6 +360,7 @@ GPUCommon::GPUCommon(GraphicsContext *gfxCtx, Draw::DrawContext *draw) :
 	// you'd expect due to the int64 field, but the Linux ABI apparently does not require that.
 	static_assert(sizeof(DisplayList) == 456, "Bad DisplayList size");
 	listLock.set_enabled(g_Config.bSeparateCPUThread);
+	stateRuns_.resize(STATE_RUN_SETS * STATE_RUN_WAYS);
 
 	Reinitialize();
 	SetupColorConv();
@@ -1005,6 +1006,89 @@ void GPUCommon::SlowRunLoop(DisplayList &list)
 	}
 }
 
+GPUCommon::StateRun &GPUCommon::FindStateRun(u32 pc) {
+	StateRun *set = &stateRuns_[((pc >> 2) & (STATE_RUN_SETS - 1)) * STATE_RUN_WAYS];
+	StateRun *oldest = set;
+	for (int i = 0; i < STATE_RUN_WAYS; ++i) {
+		if (set[i].pc == pc) {
+			set[i].lastUsed = ++stateRunClock_;
+			return set[i];
+		}
+		if (set[i].lastUsed < oldest->lastUsed)
+			oldest = &set[i];
+	}
+	// Not found, the caller records the run in the least recently used way.
+	oldest->pc = 0;
+	oldest->lastUsed = ++stateRunClock_;
+	return *oldest;
+}
+
+void GPUCommon::RecordStateRun(StateRun &run, u32 pc, int numWords, bool complete, const uint64_t *flags) {
+	run.pc = pc;
+	run.numWords = numWords;
+	run.complete = complete;
+	// Kept even for short runs, so we notice if a longer run gets written here later.
+	const u32 *words = (const u32 *)Memory::GetPointerUnchecked(pc);
+	run.words.assign(words, words + numWords);
+	run.ops.clear();
+	if (numWords < STATE_RUN_MIN_WORDS) {
+		// Not worth replaying, just interpret it.
+		return;
+	}
+
+	// Only the last write to each command matters.  Walk backwards to find those.
+	u32 seen[256 / 32]{};
+	for (int i = numWords - 1; i >= 0; --i) {
+		const u32 op = Memory::ReadUnchecked_U32(pc + i * 4);
+		const u32 cmd = op >> 24;
+		if (seen[cmd >> 5] & (1 << (cmd & 31)))
+			continue;
+		seen[cmd >> 5] |= 1 << (cmd & 31);
+		run.ops.push_back({ op, flags[i] });
+	}
+	std::reverse(run.ops.begin(), run.ops.end());
+}
+
+int GPUCommon::ReplayStateRun(const StateRun &run) {
+	// Nothing in the run draws, so one flush up front covers everything the list would have flushed.
+	for (const StateRunOp &entry : run.ops) {
+		const u32 cmd = entry.op >> 24;
+		if ((entry.flags & FLAG_FLUSHBEFOREONCHANGE) && entry.op != gstate.cmdmem[cmd]) {
+			if ((entry.flags & FLAG_FLUSHIFUSED) && !IsStateUsed(cmd))
+				continue;
+			drawEngineCommon_->DispatchFlush();
+			break;
+		}
+	}
+
+	uint64_t dirty = 0;
+	for (const StateRunOp &entry : run.ops) {
+		const u32 cmd = entry.op >> 24;
+		if (entry.op != gstate.cmdmem[cmd]) {
+			gstate.cmdmem[cmd] = entry.op;
+			dirty |= entry.flags >> 8;
+		}
+	}
+	if (dirty)
+		gstate_c.Dirty(dirty);
+
+	gpuStats.numStateRunsReplayed++;
+	gpuStats.numStateRunCommands += run.numWords;
+	return run.numWords;
+}
+
+void GPUCommon::ClearStateRuns() {
+	for (StateRun &run : stateRuns_) {
+		run.pc = 0;
+		run.numWords = 0;
+		run.complete = false;
+		run.lastUsed = 0;
+		run.words.clear();
+		run.ops.clear();
+	}
+	stateRunClock_ = 0;
+}
+
 // The newPC parameter is used for jumps, we don't count cycles between.
 void GPUCommon::UpdatePC(u32 currentPC, u32 newPC) {
 	// Rough estimate, 2 CPU ticks (it's double the clock rate) per GPU instruction.
@@ -1103,6 +1187,7 @@ void GPUCommon::ProcessEvent(GPUEvent ev) {
 		break;
 
 	case GPU_EVENT_REINITIALIZE:
+		ClearStateRuns();
 		break;
 
 	default:
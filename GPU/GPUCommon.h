@@ -1,7 +1,11 @@
 #pragma once
 
+#include <algorithm>
+#include <vector>
+
 #include "Common/Common.h"
 #include "Common/MemoryUtil.h"
+#include "Core/MemMap.h"
 #include "Core/ThreadEventQueue.h"
 #include "GPU/GPUInterface.h"
 #include "GPU/GPUState.h"
@@ -40,8 +44,12 @@ enum {
 	FLAG_READS_PC = 16,
 	FLAG_WRITES_PC = 32,
 	FLAG_DIRTYONCHANGE = 64,  // NOTE: Either this or FLAG_EXECUTE*, not both!
+	FLAG_FLUSHIFUSED = 128,  // With FLAG_FLUSHBEFOREONCHANGE: skip the flush if IsStateUsed() says queued draws can't see it.
 };
 
+// Any of these means the command does more than write cmdmem, so it ends a cached state run.
+static const uint64_t FLAG_ENDS_STATE_RUN = FLAG_FLUSHBEFORE | FLAG_EXECUTE | FLAG_EXECUTEONCHANGE | FLAG_READS_PC | FLAG_WRITES_PC;
+
 class GPUCommon : public GPUThreadEventQueue, public GPUDebugInterface {
 public:
 	GPUCommon(GraphicsContext *gfxCtx, Draw::DrawContext *draw);
@@ -263,6 +271,46 @@ class GPUCommon : public GPUThreadEventQueue, public GPUDebugInterface {
 	// To avoid virtual calls to PreExecuteOp().
 	virtual void FastRunLoop(DisplayList &list) = 0;
 	void SlowRunLoop(DisplayList &list);
+
+	// Only called for commands with FLAG_FLUSHIFUSED.  Queued draws always share the current values of
+	// the enables checked here, since changing those flushes.
+	static bool IsStateUsed(u32 cmd) {
+		switch (cmd) {
+		case GE_CMD_FOGCOLOR:
+		case GE_CMD_FOG1:
+		case GE_CMD_FOG2:
+			return gstate.isFogEnabled();
+		default:
+			// Lighting parameters.  Shade mapping also uses the light positions and types.
+			return gstate.isLightingEnabled() || gstate.getUVGenMode() == GE_TEXMAP_ENVIRONMENT_MAP;
+		}
+	}
+
+	// Static lists tend to set the same long runs of plain state commands every frame.
+	// These runs are remembered by address and applied at once, with repeated commands collapsed.
+	struct StateRunOp {
+		u32 op;
+		uint64_t flags;
+	};
+	struct StateRun {
+		u32 pc = 0;
+		u32 numWords = 0;
+		// False if the run was cut off at the stall address, so it's recorded again next time.
+		bool complete = false;
+		u32 lastUsed = 0;
+		// The command words themselves, compared on every use since the list memory may be rewritten.
+		std::vector<u32> words;
+		// The last write to each command, in list order.  Empty if the run is too short to bother.
+		std::vector<StateRunOp> ops;
+	};
+
+	template <class CommandInfo>
+	int ApplyStateRun(u32 pc, int dc, const CommandInfo *cmdInfo);
+	StateRun &FindStateRun(u32 pc);
+	void RecordStateRun(StateRun &run, u32 pc, int numWords, bool complete, const uint64_t *flags);
+	int ReplayStateRun(const StateRun &run);
+	void ClearStateRuns();
+
 	void UpdatePC(u32 currentPC, u32 newPC);
 	void UpdateState(GPURunState state);
 	void PopDLQueue();
@@ -371,6 +419,16 @@ class GPUCommon : public GPUThreadEventQueue, public GPUDebugInterface {
 	DrawType lastDraw_;
 	GEPrimitiveType lastPrim_;
 
+	enum {
+		STATE_RUN_SETS = 256,
+		STATE_RUN_WAYS = 4,
+		STATE_RUN_MIN_WORDS = 8,
+		STATE_RUN_MAX_WORDS = 256,
+	};
+	// Set associative by list address, so a few lists landing in the same set don't keep evicting each other.
+	std::vector<StateRun> stateRuns_;
+	u32 stateRunClock_ = 0;
+
 private:
 
 	// For CPU/GPU sync.
@@ -399,6 +457,40 @@ class GPUCommon : public GPUThreadEventQueue, public GPUDebugInterface {
 	double timeSpentStepping_;
 };
 
+// Returns how many commands at pc were applied from a cached state run, or 0 to interpret normally.
+// dc is how many commands may run before the stall address.
+template <class CommandInfo>
+inline int GPUCommon::ApplyStateRun(u32 pc, int dc, const CommandInfo *cmdInfo) {
+	StateRun &run = FindStateRun(pc);
+	if (run.pc == pc && run.complete) {
+		if ((int)run.numWords > dc) {
+			// The rest of the run hasn't been written yet.
+			return 0;
+		}
+		if (run.numWords == 0 || memcmp(Memory::GetPointerUnchecked(pc), run.words.data(), run.numWords * 4) == 0) {
+			return run.ops.empty() ? 0 : ReplayStateRun(run);
+		}
+	}
+
+	uint64_t flags[STATE_RUN_MAX_WORDS];
+	const int maxWords = std::min(dc, (int)STATE_RUN_MAX_WORDS);
+	int numWords = 0;
+	bool complete = maxWords == STATE_RUN_MAX_WORDS;
+	while (numWords < maxWords) {
+		const u32 op = Memory::ReadUnchecked_U32(pc + numWords * 4);
+		flags[numWords] = cmdInfo[op >> 24].flags;
+		if (flags[numWords] & FLAG_ENDS_STATE_RUN) {
+			complete = true;
+			break;
+		}
+		numWords++;
+	}
+	RecordStateRun(run, pc, numWords, complete, flags);
+	if (run.ops.empty())
+		return 0;
+	return ReplayStateRun(run);
+}
+
 struct CommonCommandTableEntry {
 	uint8_t cmd;
 	uint8_t flags;
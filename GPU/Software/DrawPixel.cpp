@@ -0,0 +1,849 @@
+// Copyright (c) 2018- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+#include "Common/ColorConv.h"
+#include "Core/Reporting.h"
+#include "GPU/GPUState.h"
+#include "GPU/Software/DrawPixel.h"
+#include "GPU/Software/SoftGpu.h"
+
+#if defined(_M_SSE)
+#include <emmintrin.h>
+#endif
+
+using namespace Math3D;
+
+namespace Rasterizer {
+
+std::mutex jitCacheLock;
+PixelJitCache *jitCache = nullptr;
+
+void Init() {
+	jitCache = new PixelJitCache();
+}
+
+void Shutdown() {
+	delete jitCache;
+	jitCache = nullptr;
+}
+
+bool DescribeCodePtr(const u8 *ptr, std::string &name) {
+	if (!jitCache->IsInSpace(ptr)) {
+		return false;
+	}
+
+	name = jitCache->DescribeCodePtr(ptr);
+	return true;
+}
+
+void ComputePixelFuncID(PixelFuncID *id_out) {
+	PixelFuncID id;
+	memset(&id.cached, 0, sizeof(id.cached));
+
+	id.clearMode = gstate.isModeClear();
+	id.fbFormat = gstate.FrameBufFormat();
+	id.cached.framebufStride = gstate.FrameBufStride();
+	id.cached.depthbufStride = gstate.DepthBufStride();
+
+	// TODO: Clear mode?
+	id.applyDepthRange = !gstate.isModeThrough();
+	if (id.applyDepthRange) {
+		id.cached.minz = gstate.getDepthRangeMin();
+		id.cached.maxz = gstate.getDepthRangeMax();
+	}
+
+	id.alphaTestFunc = GE_COMP_ALWAYS;
+	id.colorTestFunc = GE_COMP_ALWAYS;
+	id.depthTestFunc = GE_COMP_ALWAYS;
+
+	if (id.clearMode) {
+		id.depthWrite = gstate.isClearModeDepthMask();
+		id.cached.colorWriteMask = gstate.getClearModeColorMask();
+	} else {
+		if (gstate.isAlphaTestEnabled()) {
+			id.alphaTestFunc = gstate.getAlphaTestFunction();
+			id.cached.alphaTestMask = gstate.getAlphaTestMask() & 0xFF;
+			id.cached.alphaTestRef = gstate.getAlphaTestRef() & id.cached.alphaTestMask;
+		}
+		if (gstate.isColorTestEnabled()) {
+			id.colorTestFunc = gstate.getColorTestFunction();
+			id.cached.colorTestMask = gstate.getColorTestMask();
+			id.cached.colorTestRef = gstate.getColorTestRef() & id.cached.colorTestMask;
+		}
+
+		id.stencilTest = gstate.isStencilTestEnabled();
+		if (id.stencilTest) {
+			id.stencilTestFunc = gstate.getStencilTestFunction();
+			id.sFail = gstate.getStencilOpSFail();
+			id.zFail = gstate.getStencilOpZFail();
+			id.zPass = gstate.getStencilOpZPass();
+			id.cached.stencilRef = gstate.getStencilTestRef();
+			id.cached.stencilTestMask = gstate.getStencilTestMask();
+		}
+
+		// A disabled depth test passes, but doesn't write.
+		if (gstate.isDepthTestEnabled()) {
+			id.depthTestFunc = gstate.getDepthTestFunction();
+			id.depthWrite = gstate.isDepthWriteEnabled();
+		}
+
+		// Doubling happens only when texturing is enabled.
+		id.colorDoubling = gstate.isTextureMapEnabled() && gstate.isColorDoublingEnabled();
+		id.applyFog = gstate.isFogEnabled() && !gstate.isModeThrough();
+		if (id.applyFog) {
+			id.cached.fogColor = gstate.fogcolor & 0xFFFFFF;
+		}
+
+		id.alphaBlend = gstate.isAlphaBlendEnabled();
+		if (id.alphaBlend) {
+			id.alphaBlendEq = gstate.getBlendEq();
+			// All other factors (> 10) are treated as FIXA/FIXB.
+			id.alphaBlendSrc = std::min((int)gstate.getBlendFuncA(), (int)GE_SRCBLEND_FIXA);
+			id.alphaBlendDst = std::min((int)gstate.getBlendFuncB(), (int)GE_DSTBLEND_FIXB);
+			id.cached.blendFixA = gstate.getFixA();
+			id.cached.blendFixB = gstate.getFixB();
+		}
+
+		id.applyLogicOp = gstate.isLogicOpEnabled();
+		if (id.applyLogicOp) {
+			id.logicOp = gstate.getLogicOp();
+		}
+
+		id.cached.colorWriteMask = gstate.getColorMask();
+	}
+	id.applyColorWriteMask = id.cached.colorWriteMask != 0;
+
+	*id_out = id;
+}
+
+// NOTE: These likely aren't endian safe
+template <GEBufferFormat fbFormat>
+static inline u32 GetPixelColor(int x, int y, int stride) {
+	switch (fbFormat) {
+	case GE_FORMAT_565:
+		return RGB565ToRGBA8888(fb.Get16(x, y, stride));
+
+	case GE_FORMAT_5551:
+		return RGBA5551ToRGBA8888(fb.Get16(x, y, stride));
+
+	case GE_FORMAT_4444:
+		return RGBA4444ToRGBA8888(fb.Get16(x, y, stride));
+
+	case GE_FORMAT_8888:
+		return fb.Get32(x, y, stride);
+
+	case GE_FORMAT_INVALID:
+		_dbg_assert_msg_(G3D, false, "Software: invalid framebuf format.");
+	}
+	return 0;
+}
+
+template <GEBufferFormat fbFormat>
+static inline void SetPixelColor(int x, int y, int stride, u32 value) {
+	switch (fbFormat) {
+	case GE_FORMAT_565:
+		fb.Set16(x, y, stride, RGBA8888ToRGB565(value));
+		break;
+
+	case GE_FORMAT_5551:
+		fb.Set16(x, y, stride, RGBA8888ToRGBA5551(value));
+		break;
+
+	case GE_FORMAT_4444:
+		fb.Set16(x, y, stride, RGBA8888ToRGBA4444(value));
+		break;
+
+	case GE_FORMAT_8888:
+		fb.Set32(x, y, stride, value);
+		break;
+
+	case GE_FORMAT_INVALID:
+		_dbg_assert_msg_(G3D, false, "Software: invalid framebuf format.");
+	}
+}
+
+template <GEBufferFormat fbFormat>
+static inline u8 GetPixelStencil(int x, int y, int stride) {
+	if (fbFormat == GE_FORMAT_565) {
+		// Always treated as 0 for comparison purposes.
+		return 0;
+	} else if (fbFormat == GE_FORMAT_5551) {
+		return ((fb.Get16(x, y, stride) & 0x8000) != 0) ? 0xFF : 0;
+	} else if (fbFormat == GE_FORMAT_4444) {
+		return Convert4To8(fb.Get16(x, y, stride) >> 12);
+	} else {
+		return fb.Get32(x, y, stride) >> 24;
+	}
+}
+
+template <GEBufferFormat fbFormat>
+static inline void SetPixelStencil(int x, int y, int stride, u8 value) {
+	// TODO: This seems like it maybe respects the alpha mask (at least in some scenarios?)
+
+	if (fbFormat == GE_FORMAT_565) {
+		// Do nothing
+	} else if (fbFormat == GE_FORMAT_5551) {
+		u16 pixel = fb.Get16(x, y, stride) & ~0x8000;
+		pixel |= value != 0 ? 0x8000 : 0;
+		fb.Set16(x, y, stride, pixel);
+	} else if (fbFormat == GE_FORMAT_4444) {
+		u16 pixel = fb.Get16(x, y, stride) & ~0xF000;
+		pixel |= (u16)value << 12;
+		fb.Set16(x, y, stride, pixel);
+	} else {
+		u32 pixel = fb.Get32(x, y, stride) & ~0xFF000000;
+		pixel |= (u32)value << 24;
+		fb.Set32(x, y, stride, pixel);
+	}
+}
+
+static inline bool DepthTestPassed(GEComparison func, int x, int y, int stride, u16 z) {
+	u16 reference_z = depthbuf.Get16(x, y, stride);
+
+	switch (func) {
+	case GE_COMP_NEVER:
+		return false;
+
+	case GE_COMP_ALWAYS:
+		return true;
+
+	case GE_COMP_EQUAL:
+		return (z == reference_z);
+
+	case GE_COMP_NOTEQUAL:
+		return (z != reference_z);
+
+	case GE_COMP_LESS:
+		return (z < reference_z);
+
+	case GE_COMP_LEQUAL:
+		return (z <= reference_z);
+
+	case GE_COMP_GREATER:
+		return (z > reference_z);
+
+	case GE_COMP_GEQUAL:
+		return (z >= reference_z);
+
+	default:
+		return 0;
+	}
+}
+
+static inline bool StencilTestPassed(const PixelFuncID &pixelID, u8 stencil) {
+	// TODO: Does the masking logic make any sense?
+	stencil &= pixelID.cached.stencilTestMask;
+	u8 ref = pixelID.cached.stencilRef & pixelID.cached.stencilTestMask;
+	switch (GEComparison(pixelID.stencilTestFunc)) {
+		case GE_COMP_NEVER:
+			return false;
+
+		case GE_COMP_ALWAYS:
+			return true;
+
+		case GE_COMP_EQUAL:
+			return ref == stencil;
+
+		case GE_COMP_NOTEQUAL:
+			return ref != stencil;
+
+		case GE_COMP_LESS:
+			return ref < stencil;
+
+		case GE_COMP_LEQUAL:
+			return ref <= stencil;
+
+		case GE_COMP_GREATER:
+			return ref > stencil;
+
+		case GE_COMP_GEQUAL:
+			return ref >= stencil;
+	}
+	return true;
+}
+
+template <GEBufferFormat fbFormat>
+static inline u8 ApplyStencilOp(int op, int x, int y, const PixelFuncID &pixelID) {
+	u8 old_stencil = GetPixelStencil<fbFormat>(x, y, pixelID.cached.framebufStride); // TODO: Apply mask?
+	u8 reference_stencil = pixelID.cached.stencilRef; // TODO: Apply mask?
+
+	switch (op) {
+		case GE_STENCILOP_KEEP:
+			return old_stencil;
+
+		case GE_STENCILOP_ZERO:
+			return 0;
+
+		case GE_STENCILOP_REPLACE:
+			return reference_stencil;
+
+		case GE_STENCILOP_INVERT:
+			return ~old_stencil;
+
+		case GE_STENCILOP_INCR:
+			switch (fbFormat) {
+			case GE_FORMAT_8888:
+				if (old_stencil != 0xFF) {
+					return old_stencil + 1;
+				}
+				return old_stencil;
+			case GE_FORMAT_5551:
+				return 0xFF;
+			case GE_FORMAT_4444:
+				if (old_stencil < 0xF0) {
+					return old_stencil + 0x10;
+				}
+				return old_stencil;
+			default:
+				return old_stencil;
+			}
+			break;
+
+		case GE_STENCILOP_DECR:
+			switch (fbFormat) {
+			case GE_FORMAT_4444:
+				if (old_stencil >= 0x10)
+					return old_stencil - 0x10;
+				break;
+			default:
+				if (old_stencil != 0)
+					return old_stencil - 1;
+				return old_stencil;
+			}
+			break;
+	}
+
+	return old_stencil;
+}
+
+static inline u32 ApplyLogicOp(GELogicOp op, u32 old_color, u32 new_color) {
+	switch (op) {
+	case GE_LOGIC_CLEAR:
+		new_color = 0;
+		break;
+
+	case GE_LOGIC_AND:
+		new_color = new_color & old_color;
+		break;
+
+	case GE_LOGIC_AND_REVERSE:
+		new_color = new_color & ~old_color;
+		break;
+
+	case GE_LOGIC_COPY:
+		//new_color = new_color;
+		break;
+
+	case GE_LOGIC_AND_INVERTED:
+		new_color = ~new_color & old_color;
+		break;
+
+	case GE_LOGIC_NOOP:
+		new_color = old_color;
+		break;
+
+	case GE_LOGIC_XOR:
+		new_color = new_color ^ old_color;
+		break;
+
+	case GE_LOGIC_OR:
+		new_color = new_color | old_color;
+		break;
+
+	case GE_LOGIC_NOR:
+		new_color = ~(new_color | old_color);
+		break;
+
+	case GE_LOGIC_EQUIV:
+		new_color = ~(new_color ^ old_color);
+		break;
+
+	case GE_LOGIC_INVERTED:
+		new_color = ~old_color;
+		break;
+
+	case GE_LOGIC_OR_REVERSE:
+		new_color = new_color | ~old_color;
+		break;
+
+	case GE_LOGIC_COPY_INVERTED:
+		new_color = ~new_color;
+		break;
+
+	case GE_LOGIC_OR_INVERTED:
+		new_color = ~new_color | old_color;
+		break;
+
+	case GE_LOGIC_NAND:
+		new_color = ~(new_color & old_color);
+		break;
+
+	case GE_LOGIC_SET:
+		new_color = 0xFFFFFFFF;
+		break;
+	}
+
+	return new_color;
+}
+
+static inline bool ColorTestPassed(const PixelFuncID &pixelID, const Vec3<int> &color) {
+	const u32 c = color.ToRGB() & pixelID.cached.colorTestMask;
+	const u32 ref = pixelID.cached.colorTestRef;
+	switch (GEComparison(pixelID.colorTestFunc)) {
+		case GE_COMP_NEVER:
+			return false;
+
+		case GE_COMP_ALWAYS:
+			return true;
+
+		case GE_COMP_EQUAL:
+			return c == ref;
+
+		case GE_COMP_NOTEQUAL:
+			return c != ref;
+
+		default:
+			ERROR_LOG_REPORT(G3D, "Software: Invalid colortest function: %d", pixelID.colorTestFunc);
+			break;
+	}
+	return true;
+}
+
+static inline bool AlphaTestPassed(const PixelFuncID &pixelID, int alpha) {
+	const u8 ref = pixelID.cached.alphaTestRef;
+	alpha &= pixelID.cached.alphaTestMask;
+
+	switch (GEComparison(pixelID.alphaTestFunc)) {
+		case GE_COMP_NEVER:
+			return false;
+
+		case GE_COMP_ALWAYS:
+			return true;
+
+		case GE_COMP_EQUAL:
+			return (alpha == ref);
+
+		case GE_COMP_NOTEQUAL:
+			return (alpha != ref);
+
+		case GE_COMP_LESS:
+			return (alpha < ref);
+
+		case GE_COMP_LEQUAL:
+			return (alpha <= ref);
+
+		case GE_COMP_GREATER:
+			return (alpha > ref);
+
+		case GE_COMP_GEQUAL:
+			return (alpha >= ref);
+	}
+	return true;
+}
+
+static inline Vec3<int> GetSourceFactor(const PixelFuncID &pixelID, const Vec4<int>& source, const Vec4<int>& dst) {
+	switch (GEBlendSrcFactor(pixelID.alphaBlendSrc)) {
+	case GE_SRCBLEND_DSTCOLOR:
+		return dst.rgb();
+
+	case GE_SRCBLEND_INVDSTCOLOR:
+		return Vec3<int>::AssignToAll(255) - dst.rgb();
+
+	case GE_SRCBLEND_SRCALPHA:
+#if defined(_M_SSE)
+		return Vec3<int>(_mm_shuffle_epi32(source.ivec, _MM_SHUFFLE(3, 3, 3, 3)));
+#else
+		return Vec3<int>::AssignToAll(source.a());
+#endif
+
+	case GE_SRCBLEND_INVSRCALPHA:
+#if defined(_M_SSE)
+		return Vec3<int>(_mm_sub_epi32(_mm_set1_epi32(255), _mm_shuffle_epi32(source.ivec, _MM_SHUFFLE(3, 3, 3, 3))));
+#else
+		return Vec3<int>::AssignToAll(255 - source.a());
+#endif
+
+	case GE_SRCBLEND_DSTALPHA:
+		return Vec3<int>::AssignToAll(dst.a());
+
+	case GE_SRCBLEND_INVDSTALPHA:
+		return Vec3<int>::AssignToAll(255 - dst.a());
+
+	case GE_SRCBLEND_DOUBLESRCALPHA:
+		return Vec3<int>::AssignToAll(2 * source.a());
+
+	case GE_SRCBLEND_DOUBLEINVSRCALPHA:
+		return Vec3<int>::AssignToAll(255 - std::min(2 * source.a(), 255));
+
+	case GE_SRCBLEND_DOUBLEDSTALPHA:
+		return Vec3<int>::AssignToAll(2 * dst.a());
+
+	case GE_SRCBLEND_DOUBLEINVDSTALPHA:
+		return Vec3<int>::AssignToAll(255 - std::min(2 * dst.a(), 255));
+
+	case GE_SRCBLEND_FIXA:
+	default:
+		return Vec3<int>::FromRGB(pixelID.cached.blendFixA);
+	}
+}
+
+static inline Vec3<int> GetDestFactor(const PixelFuncID &pixelID, const Vec4<int>& source, const Vec4<int>& dst) {
+	switch (GEBlendDstFactor(pixelID.alphaBlendDst)) {
+	case GE_DSTBLEND_SRCCOLOR:
+		return source.rgb();
+
+	case GE_DSTBLEND_INVSRCCOLOR:
+		return Vec3<int>::AssignToAll(255) - source.rgb();
+
+	case GE_DSTBLEND_SRCALPHA:
+#if defined(_M_SSE)
+		return Vec3<int>(_mm_shuffle_epi32(source.ivec, _MM_SHUFFLE(3, 3, 3, 3)));
+#else
+		return Vec3<int>::AssignToAll(source.a());
+#endif
+
+	case GE_DSTBLEND_INVSRCALPHA:
+#if defined(_M_SSE)
+		return Vec3<int>(_mm_sub_epi32(_mm_set1_epi32(255), _mm_shuffle_epi32(source.ivec, _MM_SHUFFLE(3, 3, 3, 3))));
+#else
+		return Vec3<int>::AssignToAll(255 - source.a());
+#endif
+
+	case GE_DSTBLEND_DSTALPHA:
+		return Vec3<int>::AssignToAll(dst.a());
+
+	case GE_DSTBLEND_INVDSTALPHA:
+		return Vec3<int>::AssignToAll(255 - dst.a());
+
+	case GE_DSTBLEND_DOUBLESRCALPHA:
+		return Vec3<int>::AssignToAll(2 * source.a());
+
+	case GE_DSTBLEND_DOUBLEINVSRCALPHA:
+		return Vec3<int>::AssignToAll(255 - std::min(2 * source.a(), 255));
+
+	case GE_DSTBLEND_DOUBLEDSTALPHA:
+		return Vec3<int>::AssignToAll(2 * dst.a());
+
+	case GE_DSTBLEND_DOUBLEINVDSTALPHA:
+		return Vec3<int>::AssignToAll(255 - std::min(2 * dst.a(), 255));
+
+	case GE_DSTBLEND_FIXB:
+	default:
+		return Vec3<int>::FromRGB(pixelID.cached.blendFixB);
+	}
+}
+
+static inline Vec3<int> AlphaBlendingResult(const PixelFuncID &pixelID, const Vec4<int> &source, const Vec4<int> &dst) {
+	// Note: These factors cannot go below 0, but they can go above 255 when doubling.
+	Vec3<int> srcfactor = GetSourceFactor(pixelID, source, dst);
+	Vec3<int> dstfactor = GetDestFactor(pixelID, source, dst);
+
+	switch (GEBlendMode(pixelID.alphaBlendEq)) {
+	case GE_BLENDMODE_MUL_AND_ADD:
+	{
+#if defined(_M_SSE)
+		const __m128 s = _mm_mul_ps(_mm_cvtepi32_ps(source.ivec), _mm_cvtepi32_ps(srcfactor.ivec));
+		const __m128 d = _mm_mul_ps(_mm_cvtepi32_ps(dst.ivec), _mm_cvtepi32_ps(dstfactor.ivec));
+		return Vec3<int>(_mm_cvtps_epi32(_mm_mul_ps(_mm_add_ps(s, d), _mm_set_ps1(1.0f / 255.0f))));
+#else
+		return (source.rgb() * srcfactor + dst.rgb() * dstfactor) / 255;
+#endif
+	}
+
+	case GE_BLENDMODE_MUL_AND_SUBTRACT:
+	{
+#if defined(_M_SSE)
+		const __m128 s = _mm_mul_ps(_mm_cvtepi32_ps(source.ivec), _mm_cvtepi32_ps(srcfactor.ivec));
+		const __m128 d = _mm_mul_ps(_mm_cvtepi32_ps(dst.ivec), _mm_cvtepi32_ps(dstfactor.ivec));
+		return Vec3<int>(_mm_cvtps_epi32(_mm_mul_ps(_mm_sub_ps(s, d), _mm_set_ps1(1.0f / 255.0f))));
+#else
+		return (source.rgb() * srcfactor - dst.rgb() * dstfactor) / 255;
+#endif
+	}
+
+	case GE_BLENDMODE_MUL_AND_SUBTRACT_REVERSE:
+	{
+#if defined(_M_SSE)
+		const __m128 s = _mm_mul_ps(_mm_cvtepi32_ps(source.ivec), _mm_cvtepi32_ps(srcfactor.ivec));
+		const __m128 d = _mm_mul_ps(_mm_cvtepi32_ps(dst.ivec), _mm_cvtepi32_ps(dstfactor.ivec));
+		return Vec3<int>(_mm_cvtps_epi32(_mm_mul_ps(_mm_sub_ps(d, s), _mm_set_ps1(1.0f / 255.0f))));
+#else
+		return (dst.rgb() * dstfactor - source.rgb() * srcfactor) / 255;
+#endif
+	}
+
+	case GE_BLENDMODE_MIN:
+		return Vec3<int>(std::min(source.r(), dst.r()),
+						std::min(source.g(), dst.g()),
+						std::min(source.b(), dst.b()));
+
+	case GE_BLENDMODE_MAX:
+		return Vec3<int>(std::max(source.r(), dst.r()),
+						std::max(source.g(), dst.g()),
+						std::max(source.b(), dst.b()));
+
+	case GE_BLENDMODE_ABSDIFF:
+		return Vec3<int>(::abs(source.r() - dst.r()),
+						::abs(source.g() - dst.g()),
+						::abs(source.b() - dst.b()));
+
+	default:
+		ERROR_LOG_REPORT(G3D, "Software: Unknown blend function %x", pixelID.alphaBlendEq);
+		return Vec3<int>();
+	}
+}
+
+template <bool clearMode, GEBufferFormat fbFormat>
+static void DrawSinglePixel(int x, int y, int z, int fog, const Vec4<int> &color_in, const PixelFuncID &pixelID) {
+	Vec4<int> prim_color = color_in;
+	// Depth range test
+	if (pixelID.applyDepthRange)
+		if (z < pixelID.cached.minz || z > pixelID.cached.maxz)
+			return;
+
+	if (pixelID.colorTestFunc != GE_COMP_ALWAYS && !clearMode)
+		if (!ColorTestPassed(pixelID, prim_color.rgb()))
+			return;
+
+	// TODO: Does a need to be clamped?
+	if (pixelID.alphaTestFunc != GE_COMP_ALWAYS && !clearMode)
+		if (!AlphaTestPassed(pixelID, prim_color.a()))
+			return;
+
+	const int fbStride = pixelID.cached.framebufStride;
+	const int depthStride = pixelID.cached.depthbufStride;
+
+	// In clear mode, it uses the alpha color as stencil.
+	u8 stencil = clearMode ? prim_color.a() : GetPixelStencil<fbFormat>(x, y, fbStride);
+	// TODO: Is it safe to ignore gstate.isDepthTestEnabled() when clear mode is enabled? Probably yes
+	if (!clearMode) {
+		if (pixelID.stencilTest && !StencilTestPassed(pixelID, stencil)) {
+			stencil = ApplyStencilOp<fbFormat>(pixelID.sFail, x, y, pixelID);
+			SetPixelStencil<fbFormat>(x, y, fbStride, stencil);
+			return;
+		}
+
+		// Also apply depth at the same time.  If disabled, same as passing.
+		if (pixelID.depthTestFunc != GE_COMP_ALWAYS && !DepthTestPassed(GEComparison(pixelID.depthTestFunc), x, y, depthStride, z)) {
+			if (pixelID.stencilTest) {
+				stencil = ApplyStencilOp<fbFormat>(pixelID.zFail, x, y, pixelID);
+				SetPixelStencil<fbFormat>(x, y, fbStride, stencil);
+			}
+			return;
+		} else if (pixelID.stencilTest) {
+			stencil = ApplyStencilOp<fbFormat>(pixelID.zPass, x, y, pixelID);
+		}
+	}
+
+	if (pixelID.depthWrite) {
+		depthbuf.Set16(x, y, depthStride, z);
+	}
+
+	if (pixelID.colorDoubling && !clearMode) {
+		// TODO: Does this need to be clamped before blending?
+		prim_color.r() <<= 1;
+		prim_color.g() <<= 1;
+		prim_color.b() <<= 1;
+	}
+
+	if (pixelID.applyFog && !clearMode) {
+		Vec3<int> fogColor = Vec3<int>::FromRGB(pixelID.cached.fogColor);
+		fogColor = (prim_color.rgb() * fog + fogColor * (255 - fog)) / 255;
+		prim_color.r() = fogColor.r();
+		prim_color.g() = fogColor.g();
+		prim_color.b() = fogColor.b();
+	}
+
+	const bool needsOldColor = (pixelID.alphaBlend || pixelID.applyLogicOp) && !clearMode;
+	const u32 old_color = needsOldColor || pixelID.applyColorWriteMask ? GetPixelColor<fbFormat>(x, y, fbStride) : 0;
+	u32 new_color;
+
+	if (pixelID.alphaBlend && !clearMode) {
+		const Vec4<int> dst = Vec4<int>::FromRGBA(old_color);
+		// ToRGBA() always automatically clamps.
+		new_color = AlphaBlendingResult(pixelID, prim_color, dst).ToRGB();
+		new_color |= stencil << 24;
+	} else {
+#if defined(_M_SSE)
+		new_color = Vec3<int>(prim_color.ivec).ToRGB();
+		new_color |= stencil << 24;
+#else
+		new_color = Vec4<int>(prim_color.r(), prim_color.g(), prim_color.b(), stencil).ToRGBA();
+#endif
+	}
+
+	// TODO: Is alpha blending still performed if logic ops are enabled?
+	if (pixelID.applyLogicOp && !clearMode) {
+		// Logic ops don't affect stencil.
+		new_color = (stencil << 24) | (ApplyLogicOp(GELogicOp(pixelID.logicOp), old_color, new_color) & 0x00FFFFFF);
+	}
+
+	if (pixelID.applyColorWriteMask) {
+		new_color = (new_color & ~pixelID.cached.colorWriteMask) | (old_color & pixelID.cached.colorWriteMask);
+	}
+
+	// TODO: Dither before or inside SetPixelColor
+	SetPixelColor<fbFormat>(x, y, fbStride, new_color);
+}
+
+template <bool clearMode>
+static SingleFunc PickSingleFunc(GEBufferFormat fbFormat) {
+	switch (fbFormat) {
+	case GE_FORMAT_565:
+		return &DrawSinglePixel<clearMode, GE_FORMAT_565>;
+	case GE_FORMAT_5551:
+		return &DrawSinglePixel<clearMode, GE_FORMAT_5551>;
+	case GE_FORMAT_4444:
+		return &DrawSinglePixel<clearMode, GE_FORMAT_4444>;
+	case GE_FORMAT_8888:
+	default:
+		return &DrawSinglePixel<clearMode, GE_FORMAT_8888>;
+	}
+}
+
+SingleFunc GetSingleFunc(const PixelFuncID &id) {
+	SingleFunc jitted = jitCache->GetSingle(id);
+	if (jitted) {
+		return jitted;
+	}
+
+	if (id.clearMode) {
+		return PickSingleFunc<true>(GEBufferFormat(id.fbFormat));
+	}
+	return PickSingleFunc<false>(GEBufferFormat(id.fbFormat));
+}
+
+PixelJitCache::PixelJitCache() {
+	// 256k should be enough.
+	AllocCodeSpace(1024 * 64 * 4);
+
+	// Add some random code to "help" MSVC's buggy disassembler :(
+#if defined(_WIN32) && (defined(_M_IX86) || defined(_M_X64))
+	using namespace Gen;
+	for (int i = 0; i < 100; i++) {
+		MOV(32, R(EAX), R(EBX));
+		RET();
+	}
+#elif defined(ARM)
+	BKPT(0);
+	BKPT(0);
+#endif
+}
+
+void PixelJitCache::Clear() {
+	ClearCodeSpace(0);
+	cache_.clear();
+	addresses_.clear();
+}
+
+static const char *const compareNames[] = { "NEVER", "ALWAYS", "EQ", "NE", "LT", "LE", "GT", "GE" };
+
+std::string PixelJitCache::DescribePixelFuncID(const PixelFuncID &id) {
+	std::string name;
+	switch (GEBufferFormat(id.fbFormat)) {
+	case GE_FORMAT_565: name = "565"; break;
+	case GE_FORMAT_5551: name = "5551"; break;
+	case GE_FORMAT_4444: name = "4444"; break;
+	case GE_FORMAT_8888: name = "8888"; break;
+	case GE_FORMAT_INVALID: break;
+	}
+	if (id.clearMode) {
+		name += ":CLEAR";
+	}
+	if (id.applyDepthRange) {
+		name += ":DRANGE";
+	}
+	if (id.alphaTestFunc != GE_COMP_ALWAYS) {
+		name += std::string(":AT_") + compareNames[id.alphaTestFunc];
+	}
+	if (id.colorTestFunc != GE_COMP_ALWAYS) {
+		name += std::string(":CT_") + compareNames[id.colorTestFunc];
+	}
+	if (id.stencilTest) {
+		name += std::string(":ST_") + compareNames[id.stencilTestFunc];
+	}
+	if (id.depthTestFunc != GE_COMP_ALWAYS) {
+		name += std::string(":ZT_") + compareNames[id.depthTestFunc];
+	}
+	if (id.depthWrite) {
+		name += ":ZWRITE";
+	}
+	if (id.colorDoubling) {
+		name += ":DBL";
+	}
+	if (id.applyFog) {
+		name += ":FOG";
+	}
+	if (id.alphaBlend) {
+		char temp[32];
+		snprintf(temp, sizeof(temp), ":BLEND%d_%d_%d", id.alphaBlendEq, id.alphaBlendSrc, id.alphaBlendDst);
+		name += temp;
+	}
+	if (id.applyLogicOp) {
+		name += ":LOGIC";
+	}
+	if (id.applyColorWriteMask) {
+		name += ":MSK";
+	}
+	return name;
+}
+
+std::string PixelJitCache::DescribeCodePtr(const u8 *ptr) {
+	ptrdiff_t dist = 0x7FFFFFFF;
+	PixelFuncID found{};
+	for (const auto &it : addresses_) {
+		ptrdiff_t it_dist = ptr - it.second;
+		if (it_dist >= 0 && it_dist < dist) {
+			found = it.first;
+			dist = it_dist;
+		}
+	}
+
+	return DescribePixelFuncID(found);
+}
+
+SingleFunc PixelJitCache::GetSingle(const PixelFuncID &id) {
+	std::lock_guard<std::mutex> guard(jitCacheLock);
+
+	auto it = cache_.find(id);
+	if (it != cache_.end()) {
+		return it->second;
+	}
+
+	// TODO: What should be the min size?  Can we even hit this?
+	if (GetSpaceLeft() < 16384) {
+		Clear();
+	}
+
+#if PPSSPP_ARCH(AMD64)
+	addresses_[id] = GetCodePointer();
+	SingleFunc func = CompileSingle(id);
+	if (!func) {
+		addresses_.erase(id);
+	}
+	cache_[id] = func;
+	return func;
+#else
+	return nullptr;
+#endif
+}
+
+};
@@ -0,0 +1,478 @@
+// Copyright (c) 2018- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "ppsspp_config.h"
+#if PPSSPP_ARCH(AMD64)
+
+#include <cstddef>
+#include <emmintrin.h>
+#include "Common/x64Emitter.h"
+#include "GPU/Software/DrawPixel.h"
+#include "GPU/Software/SoftGpu.h"
+#include "GPU/ge_constants.h"
+
+using namespace Gen;
+
+namespace Rasterizer {
+
+// After the prologue, both ABIs use the same registers.
+static const X64Reg xReg = RDI;
+static const X64Reg yReg = RSI;
+static const X64Reg zReg = RDX;
+static const X64Reg fogReg = RCX;
+static const X64Reg colorInReg = R8;
+static const X64Reg idReg = R9;
+
+// Once addresses are calculated, x and y are no longer needed.
+static const X64Reg fbPtrReg = RDI;
+static const X64Reg depthPtrReg = RSI;
+
+static const X64Reg resultReg = RAX;
+static const X64Reg oldColorReg = R10;
+static const X64Reg tempReg1 = R11;
+// z is free after the depth test.
+static const X64Reg tempReg2 = RDX;
+
+static const X64Reg primColorReg = XMM0;
+static const X64Reg dstColorReg = XMM1;
+static const X64Reg srcFactorReg = XMM2;
+static const X64Reg dstFactorReg = XMM3;
+static const X64Reg fpScratchReg1 = XMM4;
+static const X64Reg fpScratchReg2 = XMM5;
+
+alignas(16) static const u32 rgbMask[4] = { 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0, };
+alignas(16) static const u32 alphaMask[4] = { 0, 0, 0, 0xFFFFFFFF, };
+alignas(16) static const int int255[4] = { 255, 255, 255, 255, };
+alignas(16) static const float float255[4] = { 255.0f, 255.0f, 255.0f, 255.0f, };
+alignas(16) static const float by255[4] = { 1.0f / 255.0f, 1.0f / 255.0f, 1.0f / 255.0f, 1.0f / 255.0f, };
+
+#define CACHED_OFFSET(field) (int)offsetof(PixelFuncID, cached.field)
+
+// Returns the condition on which the test fails, given CMP(value, ref).
+static CCFlags FailCondition(GEComparison func) {
+	switch (func) {
+	case GE_COMP_EQUAL: return CC_NE;
+	case GE_COMP_NOTEQUAL: return CC_E;
+	case GE_COMP_LESS: return CC_GE;
+	case GE_COMP_LEQUAL: return CC_G;
+	case GE_COMP_GREATER: return CC_LE;
+	case GE_COMP_GEQUAL: return CC_L;
+	default:
+		_assert_msg_(G3D, false, "Only comparisons with a condition should get here");
+		return CC_NE;
+	}
+}
+
+SingleFunc PixelJitCache::CompileSingle(const PixelFuncID &id) {
+	// The C++ versions handle these for now.
+	if (id.colorTestFunc != GE_COMP_ALWAYS || id.stencilTest || id.applyLogicOp)
+		return nullptr;
+	if (id.fbFormat != GE_FORMAT_8888 && id.fbFormat != GE_FORMAT_565)
+		return nullptr;
+	if (id.alphaBlend && id.alphaBlendEq > GE_BLENDMODE_ABSDIFF)
+		return nullptr;
+
+	BeginWrite();
+	const u8 *start = AlignCode16();
+	discards_.clear();
+
+	// Nothing is written before these tests, so a failing one means there's nothing to do.
+	if (!id.clearMode && (id.alphaTestFunc == GE_COMP_NEVER || id.depthTestFunc == GE_COMP_NEVER)) {
+		RET();
+		EndWrite();
+		return (SingleFunc)start;
+	}
+
+#ifdef _WIN32
+	// RSI and RDI are callee saved, but it's simplest to use the same registers on both ABIs.
+	PUSH(RSI);
+	PUSH(RDI);
+	MOV(32, R(RDI), R(RCX));
+	MOV(32, R(RSI), R(RDX));
+	MOV(32, R(RDX), R(R8));
+	MOV(32, R(RCX), R(R9));
+	// 2 pushes + return address + shadow space.
+	MOV(64, R(colorInReg), MDisp(RSP, 16 + 8 + 32));
+	MOV(64, R(idReg), MDisp(RSP, 16 + 8 + 32 + 8));
+#endif
+
+	bool success = true;
+	success = success && Jit_DepthRange(id);
+	success = success && Jit_AlphaTest(id);
+
+	// Calculate the buffer addresses.
+	bool needsDepth = id.depthTestFunc != GE_COMP_ALWAYS || id.depthWrite;
+	if (needsDepth) {
+		MOVZX(32, 16, resultReg, MDisp(idReg, CACHED_OFFSET(depthbufStride)));
+		IMUL(32, resultReg, R(yReg));
+		ADD(32, R(resultReg), R(xReg));
+	}
+	MOVZX(32, 16, oldColorReg, MDisp(idReg, CACHED_OFFSET(framebufStride)));
+	IMUL(32, oldColorReg, R(yReg));
+	ADD(32, R(oldColorReg), R(xReg));
+	if (needsDepth) {
+		MOV(PTRBITS, R(tempReg1), ImmPtr(&depthbuf.data));
+		MOV(PTRBITS, R(tempReg1), MatR(tempReg1));
+		LEA(64, depthPtrReg, MComplex(tempReg1, resultReg, SCALE_2, 0));
+	}
+	MOV(PTRBITS, R(tempReg1), ImmPtr(&fb.data));
+	MOV(PTRBITS, R(tempReg1), MatR(tempReg1));
+	LEA(64, fbPtrReg, MComplex(tempReg1, oldColorReg, id.fbFormat == GE_FORMAT_8888 ? SCALE_4 : SCALE_2, 0));
+
+	success = success && Jit_DepthTest(id);
+	success = success && Jit_ApplyDoublingAndFog(id);
+	success = success && Jit_ReadColor(id);
+	success = success && Jit_AlphaBlend(id);
+	success = success && Jit_WriteColor(id);
+
+	for (auto &fixup : discards_) {
+		SetJumpTarget(fixup);
+	}
+	discards_.clear();
+
+#ifdef _WIN32
+	POP(RDI);
+	POP(RSI);
+#endif
+	RET();
+
+	if (!success) {
+		EndWrite();
+		SetCodePtr(const_cast<u8 *>(start));
+		return nullptr;
+	}
+
+	EndWrite();
+	return (SingleFunc)start;
+}
+
+bool PixelJitCache::Jit_DepthRange(const PixelFuncID &id) {
+	if (!id.applyDepthRange)
+		return true;
+
+	MOVZX(32, 16, resultReg, MDisp(idReg, CACHED_OFFSET(minz)));
+	CMP(32, R(zReg), R(resultReg));
+	discards_.push_back(J_CC(CC_L, true));
+	MOVZX(32, 16, resultReg, MDisp(idReg, CACHED_OFFSET(maxz)));
+	CMP(32, R(zReg), R(resultReg));
+	discards_.push_back(J_CC(CC_G, true));
+	return true;
+}
+
+bool PixelJitCache::Jit_AlphaTest(const PixelFuncID &id) {
+	if (id.clearMode || id.alphaTestFunc == GE_COMP_ALWAYS)
+		return true;
+
+	// The ref is already masked.
+	MOV(32, R(resultReg), MDisp(colorInReg, 12));
+	MOVZX(32, 8, tempReg1, MDisp(idReg, CACHED_OFFSET(alphaTestMask)));
+	AND(32, R(resultReg), R(tempReg1));
+	MOVZX(32, 8, tempReg1, MDisp(idReg, CACHED_OFFSET(alphaTestRef)));
+	CMP(32, R(resultReg), R(tempReg1));
+	discards_.push_back(J_CC(FailCondition(GEComparison(id.alphaTestFunc)), true));
+	return true;
+}
+
+bool PixelJitCache::Jit_DepthTest(const PixelFuncID &id) {
+	if (!id.clearMode && id.depthTestFunc != GE_COMP_ALWAYS) {
+		MOVZX(32, 16, resultReg, MatR(depthPtrReg));
+		CMP(32, R(zReg), R(resultReg));
+		discards_.push_back(J_CC(FailCondition(GEComparison(id.depthTestFunc)), true));
+	}
+
+	if (id.depthWrite) {
+		MOV(16, MatR(depthPtrReg), R(zReg));
+	}
+	return true;
+}
+
+bool PixelJitCache::Jit_ApplyDoublingAndFog(const PixelFuncID &id) {
+	MOVDQU(primColorReg, MatR(colorInReg));
+	if (id.clearMode)
+		return true;
+
+	if (id.colorDoubling) {
+		MOVDQA(fpScratchReg1, R(primColorReg));
+		PAND(fpScratchReg1, M(rgbMask));  // rip accessible
+		PADDD(primColorReg, R(fpScratchReg1));
+	}
+
+	if (id.applyFog) {
+		// (color * fog + fogColor * (255 - fog)) / 255, all exact in floats.
+		PXOR(fpScratchReg2, R(fpScratchReg2));
+		MOVD_xmm(srcFactorReg, MDisp(idReg, CACHED_OFFSET(fogColor)));
+		PUNPCKLBW(srcFactorReg, R(fpScratchReg2));
+		PUNPCKLWD(srcFactorReg, R(fpScratchReg2));
+		CVTDQ2PS(srcFactorReg, R(srcFactorReg));
+
+		MOVD_xmm(dstFactorReg, R(fogReg));
+		PSHUFD(dstFactorReg, R(dstFactorReg), _MM_SHUFFLE(0, 0, 0, 0));
+		CVTDQ2PS(dstFactorReg, R(dstFactorReg));
+		MOVAPS(fpScratchReg2, M(float255));
+		SUBPS(fpScratchReg2, R(dstFactorReg));
+
+		CVTDQ2PS(fpScratchReg1, R(primColorReg));
+		MULPS(fpScratchReg1, R(dstFactorReg));
+		MULPS(srcFactorReg, R(fpScratchReg2));
+		ADDPS(fpScratchReg1, R(srcFactorReg));
+		DIVPS(fpScratchReg1, M(float255));
+		CVTTPS2DQ(fpScratchReg1, R(fpScratchReg1));
+
+		// Keep the original alpha.
+		PAND(fpScratchReg1, M(rgbMask));
+		PAND(primColorReg, M(alphaMask));
+		POR(primColorReg, R(fpScratchReg1));
+	}
+	return true;
+}
+
+bool PixelJitCache::Jit_ReadColor(const PixelFuncID &id) {
+	// 8888 also needs it for stencil, which is kept in alpha.
+	bool needsOldColor = id.alphaBlend || id.applyColorWriteMask || (!id.clearMode && id.fbFormat == GE_FORMAT_8888);
+	if (!needsOldColor)
+		return true;
+
+	if (id.fbFormat == GE_FORMAT_8888) {
+		MOV(32, R(oldColorReg), MatR(fbPtrReg));
+		return true;
+	}
+
+	// RGB565ToRGBA8888, using resultReg and tempReg2 as temps.
+	MOVZX(32, 16, tempReg1, MatR(fbPtrReg));
+
+	MOV(32, R(resultReg), R(tempReg1));
+	AND(32, R(resultReg), Imm8(0x1F));
+	LEA(32, oldColorReg, MScaled(resultReg, SCALE_8, 0));
+	SHR(32, R(resultReg), Imm8(2));
+	OR(32, R(oldColorReg), R(resultReg));
+
+	MOV(32, R(resultReg), R(tempReg1));
+	SHR(32, R(resultReg), Imm8(5));
+	AND(32, R(resultReg), Imm8(0x3F));
+	MOV(32, R(tempReg2), R(resultReg));
+	SHL(32, R(resultReg), Imm8(2 + 8));
+	SHR(32, R(tempReg2), Imm8(4));
+	SHL(32, R(tempReg2), Imm8(8));
+	OR(32, R(resultReg), R(tempReg2));
+	OR(32, R(oldColorReg), R(resultReg));
+
+	MOV(32, R(resultReg), R(tempReg1));
+	SHR(32, R(resultReg), Imm8(11));
+	MOV(32, R(tempReg2), R(resultReg));
+	SHL(32, R(resultReg), Imm8(3 + 16));
+	SHR(32, R(tempReg2), Imm8(2));
+	SHL(32, R(tempReg2), Imm8(16));
+	OR(32, R(resultReg), R(tempReg2));
+	OR(32, R(oldColorReg), R(resultReg));
+
+	OR(32, R(oldColorReg), Imm32(0xFF000000));
+	return true;
+}
+
+bool PixelJitCache::Jit_BlendFactor(const PixelFuncID &id, X64Reg factorReg, uint8_t factor, bool isSrc) {
+	// The color factors are the only ones that differ between src and dst.
+	X64Reg colorReg = isSrc ? dstColorReg : primColorReg;
+
+	switch (factor) {
+	case GE_SRCBLEND_DSTCOLOR:
+		MOVDQA(factorReg, R(colorReg));
+		break;
+
+	case GE_SRCBLEND_INVDSTCOLOR:
+		MOVDQA(factorReg, M(int255));
+		PSUBD(factorReg, R(colorReg));
+		break;
+
+	case GE_SRCBLEND_SRCALPHA:
+		PSHUFD(factorReg, R(primColorReg), _MM_SHUFFLE(3, 3, 3, 3));
+		break;
+
+	case GE_SRCBLEND_INVSRCALPHA:
+		PSHUFD(fpScratchReg1, R(primColorReg), _MM_SHUFFLE(3, 3, 3, 3));
+		MOVDQA(factorReg, M(int255));
+		PSUBD(factorReg, R(fpScratchReg1));
+		break;
+
+	case GE_SRCBLEND_DSTALPHA:
+		PSHUFD(factorReg, R(dstColorReg), _MM_SHUFFLE(3, 3, 3, 3));
+		break;
+
+	case GE_SRCBLEND_INVDSTALPHA:
+		PSHUFD(fpScratchReg1, R(dstColorReg), _MM_SHUFFLE(3, 3, 3, 3));
+		MOVDQA(factorReg, M(int255));
+		PSUBD(factorReg, R(fpScratchReg1));
+		break;
+
+	case GE_SRCBLEND_DOUBLESRCALPHA:
+		PSHUFD(factorReg, R(primColorReg), _MM_SHUFFLE(3, 3, 3, 3));
+		PADDD(factorReg, R(factorReg));
+		break;
+
+	case GE_SRCBLEND_DOUBLEDSTALPHA:
+		PSHUFD(factorReg, R(dstColorReg), _MM_SHUFFLE(3, 3, 3, 3));
+		PADDD(factorReg, R(factorReg));
+		break;
+
+	case GE_SRCBLEND_DOUBLEINVSRCALPHA:
+	case GE_SRCBLEND_DOUBLEINVDSTALPHA:
+		// 255 - min(2 * a, 255) is the same as max(255 - 2 * a, 0).
+		PSHUFD(factorReg, R(factor == GE_SRCBLEND_DOUBLEINVSRCALPHA ? primColorReg : dstColorReg), _MM_SHUFFLE(3, 3, 3, 3));
+		PADDD(factorReg, R(factorReg));
+		MOVDQA(fpScratchReg1, M(int255));
+		PSUBD(fpScratchReg1, R(factorReg));
+		MOVDQA(factorReg, R(fpScratchReg1));
+		PSRAD(factorReg, 31);
+		PANDN(factorReg, R(fpScratchReg1));
+		break;
+
+	case GE_SRCBLEND_FIXA:
+	default:
+		PXOR(fpScratchReg1, R(fpScratchReg1));
+		MOVD_xmm(factorReg, MDisp(idReg, isSrc ? CACHED_OFFSET(blendFixA) : CACHED_OFFSET(blendFixB)));
+		PUNPCKLBW(factorReg, R(fpScratchReg1));
+		PUNPCKLWD(factorReg, R(fpScratchReg1));
+		break;
+	}
+	return true;
+}
+
+bool PixelJitCache::Jit_AlphaBlend(const PixelFuncID &id) {
+	if (id.clearMode || !id.alphaBlend)
+		return true;
+
+	// Vec4<int>::FromRGBA(old color).
+	PXOR(fpScratchReg1, R(fpScratchReg1));
+	MOVD_xmm(dstColorReg, R(oldColorReg));
+	PUNPCKLBW(dstColorReg, R(fpScratchReg1));
+	PUNPCKLWD(dstColorReg, R(fpScratchReg1));
+
+	switch (GEBlendMode(id.alphaBlendEq)) {
+	case GE_BLENDMODE_MUL_AND_ADD:
+	case GE_BLENDMODE_MUL_AND_SUBTRACT:
+	case GE_BLENDMODE_MUL_AND_SUBTRACT_REVERSE:
+		if (!Jit_BlendFactor(id, srcFactorReg, id.alphaBlendSrc, true))
+			return false;
+		if (!Jit_BlendFactor(id, dstFactorReg, id.alphaBlendDst, false))
+			return false;
+
+		// Same operations as AlphaBlendingResult(), so the rounding matches.
+		CVTDQ2PS(fpScratchReg1, R(primColorReg));
+		CVTDQ2PS(srcFactorReg, R(srcFactorReg));
+		MULPS(fpScratchReg1, R(srcFactorReg));
+		CVTDQ2PS(fpScratchReg2, R(dstColorReg));
+		CVTDQ2PS(dstFactorReg, R(dstFactorReg));
+		MULPS(fpScratchReg2, R(dstFactorReg));
+
+		if (id.alphaBlendEq == GE_BLENDMODE_MUL_AND_ADD) {
+			ADDPS(fpScratchReg1, R(fpScratchReg2));
+		} else if (id.alphaBlendEq == GE_BLENDMODE_MUL_AND_SUBTRACT) {
+			SUBPS(fpScratchReg1, R(fpScratchReg2));
+		} else {
+			SUBPS(fpScratchReg2, R(fpScratchReg1));
+			MOVAPS(fpScratchReg1, R(fpScratchReg2));
+		}
+		MULPS(fpScratchReg1, M(by255));
+		CVTPS2DQ(primColorReg, R(fpScratchReg1));
+		break;
+
+	case GE_BLENDMODE_MIN:
+	case GE_BLENDMODE_MAX:
+		// Lanes where src > dst.
+		MOVDQA(fpScratchReg1, R(primColorReg));
+		PCMPGTD(fpScratchReg1, R(dstColorReg));
+		MOVDQA(fpScratchReg2, R(fpScratchReg1));
+		if (id.alphaBlendEq == GE_BLENDMODE_MIN) {
+			PAND(fpScratchReg2, R(dstColorReg));
+			PANDN(fpScratchReg1, R(primColorReg));
+		} else {
+			PAND(fpScratchReg2, R(primColorReg));
+			PANDN(fpScratchReg1, R(dstColorReg));
+		}
+		POR(fpScratchReg1, R(fpScratchReg2));
+		MOVDQA(primColorReg, R(fpScratchReg1));
+		break;
+
+	case GE_BLENDMODE_ABSDIFF:
+		PSUBD(primColorReg, R(dstColorReg));
+		MOVDQA(fpScratchReg1, R(primColorReg));
+		PSRAD(fpScratchReg1, 31);
+		PXOR(primColorReg, R(fpScratchReg1));
+		PSUBD(primColorReg, R(fpScratchReg1));
+		break;
+
+	default:
+		return false;
+	}
+	return true;
+}
+
+bool PixelJitCache::Jit_WriteColor(const PixelFuncID &id) {
+	// Vec3<int>::ToRGB(), which clamps to 0-255.
+	PACKSSDW(primColorReg, R(primColorReg));
+	PACKUSWB(primColorReg, R(primColorReg));
+	MOVD_xmm(R(resultReg), primColorReg);
+	AND(32, R(resultReg), Imm32(0x00FFFFFF));
+
+	if (id.clearMode) {
+		// The alpha is used as stencil.
+		MOVZX(32, 8, tempReg1, MDisp(colorInReg, 12));
+		SHL(32, R(tempReg1), Imm8(24));
+		OR(32, R(resultReg), R(tempReg1));
+	} else if (id.fbFormat == GE_FORMAT_8888) {
+		// Without a stencil test, the existing stencil is kept.
+		MOV(32, R(tempReg1), R(oldColorReg));
+		AND(32, R(tempReg1), Imm32(0xFF000000));
+		OR(32, R(resultReg), R(tempReg1));
+	}
+
+	if (id.applyColorWriteMask) {
+		MOV(32, R(tempReg1), MDisp(idReg, CACHED_OFFSET(colorWriteMask)));
+		AND(32, R(oldColorReg), R(tempReg1));
+		NOT(32, R(tempReg1));
+		AND(32, R(resultReg), R(tempReg1));
+		OR(32, R(resultReg), R(oldColorReg));
+	}
+
+	if (id.fbFormat == GE_FORMAT_8888) {
+		MOV(32, MatR(fbPtrReg), R(resultReg));
+		return true;
+	}
+
+	// RGBA8888ToRGB565.
+	MOV(32, R(tempReg1), R(resultReg));
+	SHR(32, R(tempReg1), Imm8(3));
+	AND(32, R(tempReg1), Imm8(0x1F));
+
+	MOV(32, R(tempReg2), R(resultReg));
+	SHR(32, R(tempReg2), Imm8(10));
+	AND(32, R(tempReg2), Imm8(0x3F));
+	SHL(32, R(tempReg2), Imm8(5));
+	OR(32, R(tempReg1), R(tempReg2));
+
+	MOV(32, R(tempReg2), R(resultReg));
+	SHR(32, R(tempReg2), Imm8(19));
+	AND(32, R(tempReg2), Imm8(0x1F));
+	SHL(32, R(tempReg2), Imm8(11));
+	OR(32, R(tempReg1), R(tempReg2));
+
+	MOV(16, MatR(fbPtrReg), R(tempReg1));
+	return true;
+}
+
+};
+
+#endif
@@ -21,6 +21,50 @@
 
 namespace Lighting {
 
-void Process(VertexData& vertex, bool hasColor);
+struct LightState {
+	bool enabled;
+	bool directional;
+	bool spot;
+	bool poweredDiffuse;
+	bool specular;
 
-}
\ No newline at end of file
+	// Position, or direction for directional lights.
+	Vec3<float> pos;
+	// Used for environment mapping.
+	Vec3<float> normalizedPos;
+	Vec3<float> spotDir;
+	float att[3];
+	float spotCutoff;
+	float spotConv;
+
+	Vec3<float> ambientColor;
+	Vec3<float> diffuseColor;
+	Vec3<float> specularColor;
+};
+
+// Everything lighting reads from gstate, decoded once per draw rather than per vertex.
+struct State {
+	LightState lights[4];
+
+	bool lightingEnabled;
+	bool envMap;
+	bool secondaryColor;
+	int uvls0;
+	int uvls1;
+	// Already masked by whether the vertices have a color.
+	int materialUpdate;
+
+	Vec3<float> materialEmissive;
+	Vec3<float> materialAmbient;
+	Vec3<float> materialDiffuse;
+	Vec3<float> materialSpecular;
+	Vec3<float> ambientColor;
+	int materialAmbientA;
+	int ambientA;
+	float specularCoef;
+};
+
+void ComputeState(State *state, bool hasColor);
+void Process(VertexData &vertex, const State &state);
+
+}
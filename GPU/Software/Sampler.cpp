@@ -33,9 +33,6 @@ extern u32 clut[4096];
 
 namespace Sampler {
 
-static u32 SampleNearest(int u, int v, const u8 *tptr, int bufw, int level);
-static u32 SampleLinear(int u[4], int v[4], int frac_u, int frac_v, const u8 *tptr, int bufw, int level);
-
 std::mutex jitCacheLock;
 SamplerJitCache *jitCache = nullptr;
 
@@ -214,8 +211,7 @@ NearestFunc SamplerJitCache::GetNearest(const SamplerID &id) {
 		Clear();
 	}
 
-	// TODO
-#ifdef _M_X64
+#if defined(_M_X64) || PPSSPP_ARCH(ARM64)
 	addresses_[id] = GetCodePointer();
 	NearestFunc func = Compile(id);
 	cache_[id] = func;
@@ -238,8 +234,7 @@ LinearFunc SamplerJitCache::GetLinear(const SamplerID &id) {
 		Clear();
 	}
 
-	// TODO
-#ifdef _M_X64
+#if defined(_M_X64) || PPSSPP_ARCH(ARM64)
 	addresses_[id] = GetCodePointer();
 	LinearFunc func = CompileLinear(id);
 	cache_[id] = (NearestFunc)func;
@@ -411,11 +406,11 @@ inline static Nearest4 SampleNearest(int u[N], int v[N], const u8 *srcptr, int t
 	}
 }
 
-static u32 SampleNearest(int u, int v, const u8 *tptr, int bufw, int level) {
+u32 SampleNearest(int u, int v, const u8 *tptr, int bufw, int level) {
 	return SampleNearest<1>(&u, &v, tptr, bufw, level);
 }
 
-static u32 SampleLinear(int u[4], int v[4], int frac_u, int frac_v, const u8 *tptr, int bufw, int texlevel) {
+u32 SampleLinear(int u[4], int v[4], int frac_u, int frac_v, const u8 *tptr, int bufw, int texlevel) {
 	Nearest4 c = SampleNearest<4>(u, v, tptr, bufw, texlevel);
 
 	Vec4<int> texcolor_tl = Vec4<int>::FromRGBA(c.v[0]);
@@ -19,6 +19,7 @@
 
 #include "ppsspp_config.h"
 
+#include <string>
 #include <unordered_map>
 #if PPSSPP_ARCH(ARM)
 #include "Common/ArmEmitter.h"
@@ -77,6 +78,10 @@ NearestFunc GetNearestFunc();
 typedef u32 (*LinearFunc)(int u[4], int v[4], int frac_u, int frac_v, const u8 *tptr, int bufw, int level);
 LinearFunc GetLinearFunc();
 
+// The C++ versions, used when the jit can't handle the current state.  Jitted funcs must match these exactly.
+u32 SampleNearest(int u, int v, const u8 *tptr, int bufw, int level);
+u32 SampleLinear(int u[4], int v[4], int frac_u, int frac_v, const u8 *tptr, int bufw, int level);
+
 struct Funcs {
 	NearestFunc nearest;
 	LinearFunc linear;
@@ -132,6 +137,10 @@ class SamplerJitCache : public FakeGen::FakeXCodeBlock {
 	bool Jit_ReadClutColor(const SamplerID &id);
 
 #if PPSSPP_ARCH(ARM64)
+	void Jit_Expand5To8(Arm64Gen::ARM64Reg reg, Arm64Gen::ARM64Reg temp);
+	void Jit_Expand565(Arm64Gen::ARM64Reg reg, Arm64Gen::ARM64Reg temp1, Arm64Gen::ARM64Reg temp2, Arm64Gen::ARM64Reg temp3, bool swapRB);
+	bool Jit_GetDXTColor(const SamplerID &id, bool dxt3);
+
 	Arm64Gen::ARM64FloatEmitter fp;
 #endif
 
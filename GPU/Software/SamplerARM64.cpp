@@ -0,0 +1,626 @@
+// Copyright (c) 2018- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "ppsspp_config.h"
+#if PPSSPP_ARCH(ARM64)
+
+#include "Common/Arm64Emitter.h"
+#include "GPU/GPUState.h"
+#include "GPU/Software/Sampler.h"
+#include "GPU/ge_constants.h"
+
+using namespace Arm64Gen;
+
+extern u32 clut[4096];
+
+namespace Sampler {
+
+// Nearest: W0=u, W1=v, X2=src, W3=bufw, W4=level.  Only X0-X9 are touched, so linear can keep state in X10+.
+static const ARM64Reg uReg = W0;
+static const ARM64Reg vReg = W1;
+static const ARM64Reg srcReg = X2;
+static const ARM64Reg bufwReg = W3;
+static const ARM64Reg levelReg = W4;
+
+static const ARM64Reg resultReg = W0;
+static const ARM64Reg tempReg1 = W5;
+static const ARM64Reg tempReg1_64 = X5;
+static const ARM64Reg tempReg2 = W6;
+static const ARM64Reg tempReg2_64 = X6;
+static const ARM64Reg tempReg3 = W7;
+static const ARM64Reg tempReg5 = W9;
+
+// Linear keeps its arguments here across the nearest calls.
+static const ARM64Reg uPtrReg = X10;
+static const ARM64Reg vPtrReg = X11;
+static const ARM64Reg fracUReg = W12;
+static const ARM64Reg fracVReg = W13;
+static const ARM64Reg fracVReg64 = X13;
+static const ARM64Reg linSrcReg = X14;
+static const ARM64Reg linBufwReg = W15;
+static const ARM64Reg linLevelReg = W16;
+static const ARM64Reg savedLRReg = X17;
+
+NearestFunc SamplerJitCache::Compile(const SamplerID &id) {
+	BeginWrite();
+	const u8 *start = AlignCode16();
+
+	// Early exit on !srcPtr.
+	FixupBranch zeroSrc;
+	if (id.hasInvalidPtr) {
+		zeroSrc = CBZ(srcReg);
+	}
+
+	if (!Jit_ReadTextureFormat(id)) {
+		EndWrite();
+		SetCodePtr(const_cast<u8 *>(start));
+		return nullptr;
+	}
+
+	RET();
+
+	if (id.hasInvalidPtr) {
+		SetJumpTarget(zeroSrc);
+		MOVI2R(resultReg, 0);
+		RET();
+	}
+
+	FlushIcache();
+	EndWrite();
+	return (NearestFunc)start;
+}
+
+LinearFunc SamplerJitCache::CompileLinear(const SamplerID &id) {
+	_assert_msg_(G3D, id.linear, "Linear should be set on sampler id");
+	BeginWrite();
+
+	// We'll first write the nearest sampler, which we will BL to.
+	const u8 *nearest = AlignCode16();
+
+	if (!Jit_ReadTextureFormat(id)) {
+		EndWrite();
+		SetCodePtr(const_cast<u8 *>(nearest));
+		return nullptr;
+	}
+
+	RET();
+
+	// Now the actual linear func, which is exposed externally.
+	const u8 *start = AlignCode16();
+
+	// X0=uptr, X1=vptr, W2=frac_u, W3=frac_v, X4=src, W5=bufw, W6=level
+	FixupBranch zeroSrc;
+	if (id.hasInvalidPtr) {
+		zeroSrc = CBZ(X4);
+	}
+
+	MOV(uPtrReg, X0);
+	MOV(vPtrReg, X1);
+	MOV(fracUReg, W2);
+	MOV(fracVReg, W3);
+	MOV(linSrcReg, X4);
+	MOV(linBufwReg, W5);
+	MOV(linLevelReg, W6);
+	MOV(savedLRReg, X30);
+
+	// Space for the four nearest results.
+	SUB(SP, SP, 16);
+	for (int off = 0; off < 16; off += 4) {
+		LDR(INDEX_UNSIGNED, uReg, uPtrReg, off);
+		LDR(INDEX_UNSIGNED, vReg, vPtrReg, off);
+		MOV(srcReg, linSrcReg);
+		MOV(bufwReg, linBufwReg);
+		MOV(levelReg, linLevelReg);
+		BL(nearest);
+		STR(INDEX_UNSIGNED, resultReg, SP, off);
+	}
+
+	// This matches the C++ sampler exactly: (tl*(256-fu) + tr*fu)*(256-fv) + (...)*fv, >> 16.
+	// We do it in GPRs, two channels at a time, with a lane for each of R/B and G/A.
+	static const ARM64Reg tlReg = W0;
+	static const ARM64Reg trReg = W1;
+	static const ARM64Reg blReg = W2;
+	static const ARM64Reg brReg = W3;
+	static const ARM64Reg invFracReg = W4;
+	static const ARM64Reg invFracReg64 = X4;
+	LDR(INDEX_UNSIGNED, tlReg, SP, 0);
+	LDR(INDEX_UNSIGNED, trReg, SP, 4);
+	LDR(INDEX_UNSIGNED, blReg, SP, 8);
+	LDR(INDEX_UNSIGNED, brReg, SP, 12);
+	ADD(SP, SP, 16);
+
+	MOVI2R(invFracReg, 0x100);
+	SUB(invFracReg, invFracReg, fracUReg);
+
+	// Leaves 0RRR0BBB in rb and 0GGG0AAA in ga (as 32-bit lanes in 64 bits.)
+	auto lerpHorizontal = [&](ARM64Reg left, ARM64Reg right, ARM64Reg rb, ARM64Reg ga) {
+		ARM64Reg rb64 = EncodeRegTo64(rb);
+		ARM64Reg ga64 = EncodeRegTo64(ga);
+		// Each 16-bit lane is at most 255 * 256, so nothing carries over.
+		ANDI2R(tempReg5, left, 0x00FF00FF);
+		ANDI2R(rb, right, 0x00FF00FF);
+		MUL(rb, rb, fracUReg);
+		MADD(rb, tempReg5, invFracReg, rb);
+		LSR(tempReg5, left, 8);
+		ANDI2R(tempReg5, tempReg5, 0x00FF00FF);
+		LSR(ga, right, 8);
+		ANDI2R(ga, ga, 0x00FF00FF);
+		MUL(ga, ga, fracUReg);
+		MADD(ga, tempReg5, invFracReg, ga);
+
+		// The vertical multiply needs 24 bits per channel, so spread to 32-bit lanes.
+		LSR(tempReg5, rb, 16);
+		UXTH(rb, rb);
+		ORR(rb64, rb64, EncodeRegTo64(tempReg5), ArithOption(EncodeRegTo64(tempReg5), ST_LSL, 32));
+		LSR(tempReg5, ga, 16);
+		UXTH(ga, ga);
+		ORR(ga64, ga64, EncodeRegTo64(tempReg5), ArithOption(EncodeRegTo64(tempReg5), ST_LSL, 32));
+	};
+	lerpHorizontal(tlReg, trReg, W5, W6);
+	lerpHorizontal(blReg, brReg, W7, W8);
+
+	// Writing W4 cleared the top half, so the 64-bit multiplies are safe.
+	MOVI2R(invFracReg, 0x100);
+	SUB(invFracReg, invFracReg, fracVReg);
+	MUL(X7, X7, fracVReg64);
+	MADD(X5, X5, invFracReg64, X7);
+	MUL(X8, X8, fracVReg64);
+	MADD(X6, X6, invFracReg64, X8);
+
+	// Now pick out the top byte of each 24-bit result.
+	UBFX(X0, X5, 16, 8);
+	UBFX(X1, X5, 48, 8);
+	ORR(W0, W0, W1, ArithOption(W1, ST_LSL, 16));
+	UBFX(X1, X6, 16, 8);
+	ORR(W0, W0, W1, ArithOption(W1, ST_LSL, 8));
+	UBFX(X1, X6, 48, 8);
+	ORR(W0, W0, W1, ArithOption(W1, ST_LSL, 24));
+
+	RET(savedLRReg);
+
+	if (id.hasInvalidPtr) {
+		SetJumpTarget(zeroSrc);
+		MOVI2R(resultReg, 0);
+		RET();
+	}
+
+	FlushIcache();
+	EndWrite();
+	return (LinearFunc)start;
+}
+
+bool SamplerJitCache::Jit_ReadTextureFormat(const SamplerID &id) {
+	GETextureFormat fmt = (GETextureFormat)id.texfmt;
+	bool success = true;
+	switch (fmt) {
+	case GE_TFMT_5650:
+		success = Jit_GetTexData(id, 16);
+		if (success)
+			success = Jit_Decode5650();
+		break;
+
+	case GE_TFMT_5551:
+		success = Jit_GetTexData(id, 16);
+		if (success)
+			success = Jit_Decode5551();
+		break;
+
+	case GE_TFMT_4444:
+		success = Jit_GetTexData(id, 16);
+		if (success)
+			success = Jit_Decode4444();
+		break;
+
+	case GE_TFMT_8888:
+		success = Jit_GetTexData(id, 32);
+		break;
+
+	case GE_TFMT_CLUT32:
+		success = Jit_GetTexData(id, 32);
+		if (success)
+			success = Jit_TransformClutIndex(id, 32);
+		if (success)
+			success = Jit_ReadClutColor(id);
+		break;
+
+	case GE_TFMT_CLUT16:
+		success = Jit_GetTexData(id, 16);
+		if (success)
+			success = Jit_TransformClutIndex(id, 16);
+		if (success)
+			success = Jit_ReadClutColor(id);
+		break;
+
+	case GE_TFMT_CLUT8:
+		success = Jit_GetTexData(id, 8);
+		if (success)
+			success = Jit_TransformClutIndex(id, 8);
+		if (success)
+			success = Jit_ReadClutColor(id);
+		break;
+
+	case GE_TFMT_CLUT4:
+		success = Jit_GetTexData(id, 4);
+		if (success)
+			success = Jit_TransformClutIndex(id, 4);
+		if (success)
+			success = Jit_ReadClutColor(id);
+		break;
+
+	case GE_TFMT_DXT1:
+		success = Jit_GetDXTColor(id, false);
+		break;
+
+	case GE_TFMT_DXT3:
+		success = Jit_GetDXTColor(id, true);
+		break;
+
+	// TODO: DXT5's alpha is interpolated with floats, keep that in C++ for now.
+	default:
+		success = false;
+	}
+
+	return success;
+}
+
+bool SamplerJitCache::Jit_GetTexData(const SamplerID &id, int bitsPerTexel) {
+	if (id.swizzle) {
+		return Jit_GetTexDataSwizzled(id, bitsPerTexel);
+	}
+
+	switch (bitsPerTexel) {
+	case 32:
+		MADD(tempReg1, vReg, bufwReg, uReg);
+		LDR(resultReg, srcReg, ArithOption(tempReg1_64, true));
+		break;
+
+	case 16:
+		MADD(tempReg1, vReg, bufwReg, uReg);
+		LDRH(resultReg, srcReg, ArithOption(tempReg1_64, true));
+		break;
+
+	case 8:
+		MADD(tempReg1, vReg, bufwReg, uReg);
+		LDRB(resultReg, srcReg, ArithOption(tempReg1_64));
+		break;
+
+	case 4:
+		// Odd texels are in the high nibble.
+		UBFIZ(tempReg2, uReg, 2, 1);
+		LSR(tempReg3, bufwReg, 1);
+		LSR(tempReg1, uReg, 1);
+		MADD(tempReg1, vReg, tempReg3, tempReg1);
+		LDRB(resultReg, srcReg, ArithOption(tempReg1_64));
+		LSRV(resultReg, resultReg, tempReg2);
+		ANDI2R(resultReg, resultReg, 0x0F);
+		break;
+
+	default:
+		return false;
+	}
+
+	return true;
+}
+
+bool SamplerJitCache::Jit_GetTexDataSwizzled(const SamplerID &id, int bitsPerTexel) {
+	// Each tile is 16 bytes wide and 8 rows tall, stored as a contiguous 128 bytes.
+	int texelsPerWordShift;
+	switch (bitsPerTexel) {
+	case 32: texelsPerWordShift = 0; break;
+	case 16: texelsPerWordShift = 1; break;
+	case 8: texelsPerWordShift = 2; break;
+	case 4: texelsPerWordShift = 3; break;
+	default:
+		return false;
+	}
+
+	// Row within the tile, in words.
+	UBFIZ(tempReg1, vReg, 2, 3);
+	// Then add the tile row, which is (bufw in words) * 8 words.
+	LSR(tempReg2, bufwReg, texelsPerWordShift);
+	LSL(tempReg2, tempReg2, 3);
+	LSR(tempReg3, vReg, 3);
+	MADD(tempReg1, tempReg3, tempReg2, tempReg1);
+
+	// Next the word within the tile, and the tile itself (32 words each.)
+	LSR(tempReg2, uReg, texelsPerWordShift);
+	ANDI2R(tempReg3, tempReg2, 3);
+	ADD(tempReg1, tempReg1, tempReg3);
+	LSR(tempReg2, tempReg2, 2);
+	ADD(tempReg1, tempReg1, tempReg2, ArithOption(tempReg2, ST_LSL, 5));
+	ADD(tempReg1_64, srcReg, tempReg1_64, ArithOption(tempReg1_64, ST_LSL, 2));
+
+	// Last, the byte offset within the word.  We're done with u after this.
+	switch (bitsPerTexel) {
+	case 32:
+		LDR(INDEX_UNSIGNED, resultReg, tempReg1_64, 0);
+		break;
+
+	case 16:
+		UBFIZ(tempReg2, uReg, 1, 1);
+		LDRH(resultReg, tempReg1_64, ArithOption(tempReg2_64));
+		break;
+
+	case 8:
+		ANDI2R(tempReg2, uReg, 3);
+		LDRB(resultReg, tempReg1_64, ArithOption(tempReg2_64));
+		break;
+
+	case 4:
+		UBFX(tempReg2, uReg, 1, 2);
+		UBFIZ(tempReg3, uReg, 2, 1);
+		LDRB(resultReg, tempReg1_64, ArithOption(tempReg2_64));
+		LSRV(resultReg, resultReg, tempReg3);
+		ANDI2R(resultReg, resultReg, 0x0F);
+		break;
+	}
+
+	return true;
+}
+
+// Expands a 5 bit value in reg to 8 bits, using temp.
+void SamplerJitCache::Jit_Expand5To8(ARM64Reg reg, ARM64Reg temp) {
+	LSR(temp, reg, 2);
+	ORR(reg, temp, reg, ArithOption(reg, ST_LSL, 3));
+}
+
+void SamplerJitCache::Jit_Expand565(ARM64Reg reg, ARM64Reg temp1, ARM64Reg temp2, ARM64Reg temp3, bool swapRB) {
+	// The low 5 bits are red normally, but blue in DXT colors.
+	UBFX(temp1, reg, 11, 5);
+	Jit_Expand5To8(temp1, temp3);
+	UBFX(temp2, reg, 5, 6);
+	LSR(temp3, temp2, 4);
+	ORR(temp2, temp3, temp2, ArithOption(temp2, ST_LSL, 2));
+	ANDI2R(reg, reg, 0x1F);
+	Jit_Expand5To8(reg, temp3);
+
+	if (swapRB) {
+		ORR(temp1, temp1, temp2, ArithOption(temp2, ST_LSL, 8));
+		ORR(reg, temp1, reg, ArithOption(reg, ST_LSL, 16));
+	} else {
+		ORR(reg, reg, temp2, ArithOption(temp2, ST_LSL, 8));
+		ORR(reg, reg, temp1, ArithOption(temp1, ST_LSL, 16));
+	}
+}
+
+bool SamplerJitCache::Jit_Decode5650() {
+	Jit_Expand565(resultReg, tempReg1, tempReg2, tempReg3, false);
+	ORRI2R(resultReg, resultReg, 0xFF000000);
+	return true;
+}
+
+bool SamplerJitCache::Jit_Decode5551() {
+	ANDI2R(tempReg1, resultReg, 0x1F);
+	Jit_Expand5To8(tempReg1, tempReg3);
+	UBFX(tempReg2, resultReg, 5, 5);
+	Jit_Expand5To8(tempReg2, tempReg3);
+	ORR(tempReg1, tempReg1, tempReg2, ArithOption(tempReg2, ST_LSL, 8));
+	UBFX(tempReg2, resultReg, 10, 5);
+	Jit_Expand5To8(tempReg2, tempReg3);
+	ORR(tempReg1, tempReg1, tempReg2, ArithOption(tempReg2, ST_LSL, 16));
+
+	// Sign extend the alpha bit, so it's either 0 or 0xFFFFFFFF, then shift it into place.
+	SBFM(tempReg2, resultReg, 15, 15);
+	ORR(resultReg, tempReg1, tempReg2, ArithOption(tempReg2, ST_LSL, 24));
+	return true;
+}
+
+bool SamplerJitCache::Jit_Decode4444() {
+	// Spread each nibble into the low half of its own byte, then copy it to the high half.
+	ANDI2R(tempReg1, resultReg, 0x0F);
+	UBFX(tempReg2, resultReg, 4, 4);
+	ORR(tempReg1, tempReg1, tempReg2, ArithOption(tempReg2, ST_LSL, 8));
+	UBFX(tempReg2, resultReg, 8, 4);
+	ORR(tempReg1, tempReg1, tempReg2, ArithOption(tempReg2, ST_LSL, 16));
+	UBFX(tempReg2, resultReg, 12, 4);
+	ORR(tempReg1, tempReg1, tempReg2, ArithOption(tempReg2, ST_LSL, 24));
+	ORR(resultReg, tempReg1, tempReg1, ArithOption(tempReg1, ST_LSL, 4));
+	return true;
+}
+
+bool SamplerJitCache::Jit_GetDXTColor(const SamplerID &id, bool dxt3) {
+	// Same layout as DXT1Block/DXT3Block: DXT3 has 8 bytes of alpha after the color data.
+	const int blockShift = dxt3 ? 4 : 3;
+	const int colorOffset = 0;
+	const int alphaOffset = 8;
+
+	static const ARM64Reg blockReg = X5;
+	static const ARM64Reg indexReg = W7;
+	static const ARM64Reg alphaReg = W8;
+	static const ARM64Reg color1Reg = W1;
+	static const ARM64Reg color2Reg = W3;
+	static const ARM64Reg modeReg = W5;
+
+	// Block pointer: src + ((v / 4) * (bufw / 4) + u / 4) * blockSize.
+	LSR(tempReg1, vReg, 2);
+	LSR(tempReg2, bufwReg, 2);
+	LSR(tempReg3, uReg, 2);
+	MADD(tempReg1, tempReg1, tempReg2, tempReg3);
+	ADD(blockReg, srcReg, blockReg, ArithOption(blockReg, ST_LSL, blockShift));
+
+	// Each row is a byte of 2-bit color indices.
+	ANDI2R(tempReg2, vReg, 3);
+	ADD(tempReg2_64, blockReg, tempReg2_64);
+	LDRB(INDEX_UNSIGNED, indexReg, tempReg2_64, colorOffset);
+	UBFIZ(tempReg5, uReg, 1, 2);
+	LSRV(indexReg, indexReg, tempReg5);
+	ANDI2R(indexReg, indexReg, 3);
+
+	if (dxt3) {
+		// And for DXT3, each row is 16 bits of 4-bit alpha values, which we expand to 8.
+		ANDI2R(tempReg2, vReg, 3);
+		ADD(tempReg2_64, blockReg, tempReg2_64, ArithOption(tempReg2_64, ST_LSL, 1));
+		LDRH(INDEX_UNSIGNED, alphaReg, tempReg2_64, alphaOffset);
+		UBFIZ(tempReg5, uReg, 2, 2);
+		LSRV(alphaReg, alphaReg, tempReg5);
+		ANDI2R(alphaReg, alphaReg, 0x0F);
+		LSL(alphaReg, alphaReg, 24);
+		ORR(alphaReg, alphaReg, alphaReg, ArithOption(alphaReg, ST_LSL, 4));
+	}
+
+	// We're done with u, v, and bufw now.
+	LDRH(INDEX_UNSIGNED, color1Reg, blockReg, colorOffset + 4);
+	LDRH(INDEX_UNSIGNED, color2Reg, blockReg, colorOffset + 6);
+	if (!dxt3) {
+		// DXT1 only interpolates when color1 > color2, otherwise 3 is transparent.
+		CMP(color1Reg, color2Reg);
+		CSET(modeReg, CC_HI);
+	}
+	Jit_Expand565(color1Reg, W0, W4, W9, true);
+	Jit_Expand565(color2Reg, W0, W4, W9, true);
+
+	auto applyAlpha = [&] {
+		if (dxt3) {
+			ORR(resultReg, resultReg, alphaReg);
+		} else {
+			ORRI2R(resultReg, resultReg, 0xFF000000);
+		}
+	};
+
+	// Indices 0 and 1 are just the colors.
+	CMP(indexReg, 1);
+	FixupBranch mixed = B(CC_HI);
+	CSEL(resultReg, color2Reg, color1Reg, CC_EQ);
+	applyAlpha();
+	FixupBranch done1 = B();
+
+	SetJumpTarget(mixed);
+	FixupBranch average;
+	if (!dxt3) {
+		average = CBZ(modeReg);
+	}
+
+	// Per channel: d = c2 - c1, x = (d >> 1) - (d >> 3), then index 2 is c1 + x and 3 is c2 - x.
+	CMP(indexReg, 2);
+	for (int shift = 0; shift < 24; shift += 8) {
+		UBFX(W4, color1Reg, shift, 8);
+		UBFX(W6, color2Reg, shift, 8);
+		SUB(W9, W6, W4);
+		ASR(W5, W9, 1);
+		SUB(W5, W5, W9, ArithOption(W9, ST_ASR, 3));
+		ADD(W4, W4, W5);
+		SUB(W6, W6, W5);
+		CSEL(W4, W4, W6, CC_EQ);
+		if (shift == 0) {
+			MOV(resultReg, W4);
+		} else {
+			ORR(resultReg, resultReg, W4, ArithOption(W4, ST_LSL, shift));
+		}
+	}
+	applyAlpha();
+
+	if (!dxt3) {
+		FixupBranch done2 = B();
+
+		// Index 2 is the rounded average, and index 3 is color2 with zero alpha.
+		SetJumpTarget(average);
+		CMP(indexReg, 2);
+		FixupBranch transparent = B(CC_NEQ);
+		for (int shift = 0; shift < 24; shift += 8) {
+			UBFX(W4, color1Reg, shift, 8);
+			UBFX(W6, color2Reg, shift, 8);
+			ADD(W4, W4, W6);
+			ADD(W4, W4, 1);
+			LSR(W4, W4, 1);
+			if (shift == 0) {
+				MOV(resultReg, W4);
+			} else {
+				ORR(resultReg, resultReg, W4, ArithOption(W4, ST_LSL, shift));
+			}
+		}
+		applyAlpha();
+		FixupBranch done3 = B();
+
+		SetJumpTarget(transparent);
+		MOV(resultReg, color2Reg);
+
+		SetJumpTarget(done2);
+		SetJumpTarget(done3);
+	}
+
+	SetJumpTarget(done1);
+	return true;
+}
+
+bool SamplerJitCache::Jit_TransformClutIndex(const SamplerID &id, int bitsPerIndex) {
+	GEPaletteFormat fmt = (GEPaletteFormat)id.clutfmt;
+	if (!id.hasClutShift && !id.hasClutMask && !id.hasClutOffset) {
+		// This is simple - just mask if necessary.
+		if (bitsPerIndex > 8) {
+			ANDI2R(resultReg, resultReg, 0xFF);
+		}
+		return true;
+	}
+
+	MOVP2R(tempReg1_64, &gstate.clutformat);
+	LDR(INDEX_UNSIGNED, tempReg1, tempReg1_64, 0);
+
+	// Shift = (clutformat >> 2) & 0x1F
+	if (id.hasClutShift) {
+		UBFX(tempReg2, tempReg1, 2, 5);
+		LSRV(resultReg, resultReg, tempReg2);
+	}
+
+	// Mask = (clutformat >> 8) & 0xFF
+	if (id.hasClutMask) {
+		UBFX(tempReg2, tempReg1, 8, 8);
+		AND(resultReg, resultReg, tempReg2);
+	} else if (bitsPerIndex > 8) {
+		ANDI2R(resultReg, resultReg, 0xFF);
+	}
+
+	// Offset = (clutformat >> 12) & 0x01F0, but we need to wrap any entries beyond the first 1024 bytes.
+	if (id.hasClutOffset) {
+		UBFX(tempReg2, tempReg1, 16, fmt == GE_CMODE_32BIT_ABGR8888 ? 4 : 5);
+		ORR(resultReg, resultReg, tempReg2, ArithOption(tempReg2, ST_LSL, 4));
+	}
+	return true;
+}
+
+bool SamplerJitCache::Jit_ReadClutColor(const SamplerID &id) {
+	if (!id.useSharedClut) {
+		// Each level has its own 16 entries.
+		ADD(resultReg, resultReg, levelReg, ArithOption(levelReg, ST_LSL, 4));
+	}
+
+	MOVP2R(tempReg1_64, clut);
+
+	switch ((GEPaletteFormat)id.clutfmt) {
+	case GE_CMODE_16BIT_BGR5650:
+		LDRH(resultReg, tempReg1_64, ArithOption(EncodeRegTo64(resultReg), true));
+		return Jit_Decode5650();
+
+	case GE_CMODE_16BIT_ABGR5551:
+		LDRH(resultReg, tempReg1_64, ArithOption(EncodeRegTo64(resultReg), true));
+		return Jit_Decode5551();
+
+	case GE_CMODE_16BIT_ABGR4444:
+		LDRH(resultReg, tempReg1_64, ArithOption(EncodeRegTo64(resultReg), true));
+		return Jit_Decode4444();
+
+	case GE_CMODE_32BIT_ABGR8888:
+		LDR(resultReg, tempReg1_64, ArithOption(EncodeRegTo64(resultReg), true));
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+};
+
+#endif
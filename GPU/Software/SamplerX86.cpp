@@ -93,9 +93,6 @@ NearestFunc SamplerJitCache::Compile(const SamplerID &id) {
 	return (NearestFunc)start;
 }
 
-alignas(16) static const float by256[4] = { 1.0f / 256.0f, 1.0f / 256.0f, 1.0f / 256.0f, 1.0f / 256.0f, };
-alignas(16) static const float ones[4] = { 1.0f, 1.0f, 1.0f, 1.0f, };
-
 LinearFunc SamplerJitCache::CompileLinear(const SamplerID &id) {
 	_assert_msg_(G3D, id.linear, "Linear should be set on sampler id");
 	BeginWrite();
@@ -176,73 +173,55 @@ LinearFunc SamplerJitCache::CompileLinear(const SamplerID &id) {
 	doNearestCall(8);
 	doNearestCall(12);
 
-	// Convert TL, TR, BL, BR to floats for easier blending.
-	if (!cpu_info.bSSE4_1) {
-		PXOR(XMM0, R(XMM0));
-	}
-
+	// This matches the C++ sampler exactly: (tl*(256-fu) + tr*fu)*(256-fv) + (...)*fv, >> 16.
+	// Start with TL/BL and TR/BR side by side, as 16-bit lanes.
+	PXOR(XMM0, R(XMM0));
 	MOVD_xmm(fpScratchReg1, MDisp(RSP, 0));
 	MOVD_xmm(fpScratchReg2, MDisp(RSP, 4));
 	MOVD_xmm(fpScratchReg3, MDisp(RSP, 8));
 	MOVD_xmm(fpScratchReg4, MDisp(RSP, 12));
-
-	if (cpu_info.bSSE4_1) {
-		PMOVZXBD(fpScratchReg1, R(fpScratchReg1));
-		PMOVZXBD(fpScratchReg2, R(fpScratchReg2));
-		PMOVZXBD(fpScratchReg3, R(fpScratchReg3));
-		PMOVZXBD(fpScratchReg4, R(fpScratchReg4));
-	} else {
-		PUNPCKLBW(fpScratchReg1, R(XMM0));
-		PUNPCKLBW(fpScratchReg2, R(XMM0));
-		PUNPCKLBW(fpScratchReg3, R(XMM0));
-		PUNPCKLBW(fpScratchReg4, R(XMM0));
-		PUNPCKLWD(fpScratchReg1, R(XMM0));
-		PUNPCKLWD(fpScratchReg2, R(XMM0));
-		PUNPCKLWD(fpScratchReg3, R(XMM0));
-		PUNPCKLWD(fpScratchReg4, R(XMM0));
-	}
-	CVTDQ2PS(fpScratchReg1, R(fpScratchReg1));
-	CVTDQ2PS(fpScratchReg2, R(fpScratchReg2));
-	CVTDQ2PS(fpScratchReg3, R(fpScratchReg3));
-	CVTDQ2PS(fpScratchReg4, R(fpScratchReg4));
-
-	// Okay, now multiply the R sides by frac_u, and L by (256 - frac_u)...
-	MOVD_xmm(fpScratchReg5, MDisp(RSP, 24));
-	CVTDQ2PS(fpScratchReg5, R(fpScratchReg5));
-	SHUFPS(fpScratchReg5, R(fpScratchReg5), _MM_SHUFFLE(0, 0, 0, 0));
-	if (RipAccessible(by256)) {
-		MULPS(fpScratchReg5, M(by256));  // rip accessible
-	} else {
-		Crash();  // TODO
-	}
-	MOVAPS(XMM0, M(ones));
-	SUBPS(XMM0, R(fpScratchReg5));
-
-	MULPS(fpScratchReg1, R(XMM0));
-	MULPS(fpScratchReg2, R(fpScratchReg5));
-	MULPS(fpScratchReg3, R(XMM0));
-	MULPS(fpScratchReg4, R(fpScratchReg5));
-
-	// Now set top=fpScratchReg1, bottom=fpScratchReg3.
-	ADDPS(fpScratchReg1, R(fpScratchReg2));
-	ADDPS(fpScratchReg3, R(fpScratchReg4));
-
-	// Next, time for frac_v.
-	MOVD_xmm(fpScratchReg5, MDisp(RSP, 32));
-	CVTDQ2PS(fpScratchReg5, R(fpScratchReg5));
-	SHUFPS(fpScratchReg5, R(fpScratchReg5), _MM_SHUFFLE(0, 0, 0, 0));
-	MULPS(fpScratchReg5, M(by256));
-	MOVAPS(XMM0, M(ones));
-	SUBPS(XMM0, R(fpScratchReg5));
-
-	MULPS(fpScratchReg1, R(XMM0));
-	MULPS(fpScratchReg3, R(fpScratchReg5));
-
-	// Still at the 255 scale, now we're interpolated.
-	ADDPS(fpScratchReg1, R(fpScratchReg3));
+	PUNPCKLDQ(fpScratchReg1, R(fpScratchReg3));
+	PUNPCKLDQ(fpScratchReg2, R(fpScratchReg4));
+	PUNPCKLBW(fpScratchReg1, R(XMM0));
+	PUNPCKLBW(fpScratchReg2, R(XMM0));
+
+	// Broadcast frac_u and 256 - frac_u to every lane.
+	MOV(32, R(resultReg), MDisp(RSP, 24));
+	MOVD_xmm(fpScratchReg5, R(resultReg));
+	NEG(32, R(resultReg));
+	ADD(32, R(resultReg), Imm32(0x100));
+	MOVD_xmm(fpScratchReg3, R(resultReg));
+	PSHUFLW(fpScratchReg5, R(fpScratchReg5), _MM_SHUFFLE(0, 0, 0, 0));
+	PSHUFLW(fpScratchReg3, R(fpScratchReg3), _MM_SHUFFLE(0, 0, 0, 0));
+	PUNPCKLQDQ(fpScratchReg5, R(fpScratchReg5));
+	PUNPCKLQDQ(fpScratchReg3, R(fpScratchReg3));
+
+	// At most 255 * 256, so this all fits in unsigned 16 bits.  Now top=low, bottom=high.
+	PMULLW(fpScratchReg1, R(fpScratchReg3));
+	PMULLW(fpScratchReg2, R(fpScratchReg5));
+	PADDW(fpScratchReg1, R(fpScratchReg2));
+
+	// Next, time for frac_v: 256 - frac_v for the top lanes, frac_v for the bottom.
+	MOV(32, R(resultReg), MDisp(RSP, 32));
+	MOVD_xmm(fpScratchReg5, R(resultReg));
+	NEG(32, R(resultReg));
+	ADD(32, R(resultReg), Imm32(0x100));
+	MOVD_xmm(fpScratchReg3, R(resultReg));
+	PSHUFLW(fpScratchReg5, R(fpScratchReg5), _MM_SHUFFLE(0, 0, 0, 0));
+	PSHUFLW(fpScratchReg3, R(fpScratchReg3), _MM_SHUFFLE(0, 0, 0, 0));
+	PUNPCKLQDQ(fpScratchReg3, R(fpScratchReg5));
+
+	// The products need 32 bits, so combine the low and high halves of each.
+	MOVDQA(fpScratchReg2, R(fpScratchReg1));
+	PMULLW(fpScratchReg1, R(fpScratchReg3));
+	PMULHUW(fpScratchReg2, R(fpScratchReg3));
+	MOVDQA(fpScratchReg4, R(fpScratchReg1));
+	PUNPCKLWD(fpScratchReg1, R(fpScratchReg2));
+	PUNPCKHWD(fpScratchReg4, R(fpScratchReg2));
+	PADDD(fpScratchReg1, R(fpScratchReg4));
 
 	// Time to convert back to a single 32 bit value.
-	CVTPS2DQ(fpScratchReg1, R(fpScratchReg1));
+	PSRLD(fpScratchReg1, 16);
 	PACKSSDW(fpScratchReg1, R(fpScratchReg1));
 	PACKUSWB(fpScratchReg1, R(fpScratchReg1));
 	MOVD_xmm(R(resultReg), fpScratchReg1);
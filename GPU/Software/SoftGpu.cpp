@@ -30,7 +30,9 @@
 #include "Core/Reporting.h"
 #include "profiler/profiler.h"
 #include "thin3d/thin3d.h"
+#include "thread/threadutil.h"
 
+#include "GPU/Software/DrawPixel.h"
 #include "GPU/Software/Rasterizer.h"
 #include "GPU/Software/Sampler.h"
 #include "GPU/Software/SoftGpu.h"
@@ -52,6 +54,11 @@ u32 clut[4096];
 FormatBuffer fb;
 FormatBuffer depthbuf;
 
+static inline u32 IndexSize(u32 vtype) {
+	// 8, 16, or 32 bit indices, when there are any.
+	return 1 << (((vtype & GE_VTYPE_IDX_MASK) >> GE_VTYPE_IDX_SHIFT) - 1);
+}
+
 SoftGPU::SoftGPU(GraphicsContext *gfxCtx, Draw::DrawContext *draw)
 	: GPUCommon(gfxCtx, draw)
 {
@@ -102,8 +109,36 @@ SoftGPU::SoftGPU(GraphicsContext *gfxCtx, Draw::DrawContext *draw)
 	displayFormat_ = GE_FORMAT_8888;
 
 	Sampler::Init();
+	Rasterizer::Init();
 	drawEngine_ = new SoftwareDrawEngine();
 	drawEngineCommon_ = drawEngine_;
+
+	geThreadExit_ = false;
+	ClearGEMarks();
+	// With bSeparateCPUThread, the emu thread already runs our events off the CPU thread.
+	if (g_Config.bSoftwareRenderingThread && !g_Config.bSeparateCPUThread) {
+		useGEThread_ = true;
+		listLock.set_enabled(true);
+		SetThreadEnabled(true);
+		geThread_ = new std::thread(&SoftGPU::GEThreadFunc, this);
+	}
+}
+
+void SoftGPU::GEThreadFunc() {
+	setCurrentThreadName("SoftGE");
+
+	// Lists are kicked by GPU_EVENT_PROCESS_QUEUE, scheduled from the CPU thread.
+	while (!geThreadExit_) {
+		RunEventsUntil((u64)-1);
+	}
+}
+
+bool SoftGPU::ShouldExitEventLoop() {
+	if (useGEThread_) {
+		// Our thread should keep waiting for events even while the core is paused.
+		return geThreadExit_;
+	}
+	return GPUCommon::ShouldExitEventLoop();
 }
 
 void SoftGPU::DeviceLost() {
@@ -115,6 +150,16 @@ void SoftGPU::DeviceRestore() {
 }
 
 SoftGPU::~SoftGPU() {
+	if (geThread_) {
+		geThreadExit_ = true;
+		// This wakes the thread and makes RunEventsUntil() return.
+		ScheduleEvent(GPU_EVENT_FINISH_EVENT_LOOP);
+		geThread_->join();
+		delete geThread_;
+		geThread_ = nullptr;
+		SetThreadEnabled(false);
+	}
+
 	texColor->Release();
 	texColor = nullptr;
 
@@ -132,6 +177,7 @@ SoftGPU::~SoftGPU() {
 	samplerLinear = nullptr;
 
 	Sampler::Shutdown();
+	Rasterizer::Shutdown();
 }
 
 void SoftGPU::SetDisplayFramebuffer(u32 framebuf, u32 stride, GEBufferFormat format) {
@@ -283,9 +329,75 @@ void SoftGPU::CopyToCurrentFboFromDisplayRam(int srcwidth, int srcheight) {
 
 void SoftGPU::CopyDisplayToOutput()
 {
+	if (useGEThread_) {
+		// Presenting has to happen on this thread, so let the GE finish the frame first.
+		// The core is already at CORE_NEXTFRAME here, so this has to be forced.
+		SyncThread(true);
+		CopyDisplayToOutputInternal();
+		// Anything the next frame touches will be marked again.
+		ClearGEMarks();
+		return;
+	}
 	ScheduleEvent(GPU_EVENT_COPY_DISPLAY_TO_OUTPUT);
 }
 
+void SoftGPU::ReapplyGfxState() {
+	if (useGEThread_) {
+		// Don't run ops here while the GE thread may be in the middle of a list.
+		ScheduleEvent(GPU_EVENT_REAPPLY_GFX_STATE);
+	} else {
+		GPUCommon::ReapplyGfxState();
+	}
+}
+
+void SoftGPU::DoState(PointerWrap &p) {
+	if (useGEThread_) {
+		// The GE state must not change under us while it's saved or loaded.
+		SyncThread(true);
+	}
+	GPUCommon::DoState(p);
+}
+
+void SoftGPU::MarkGERange(u32 addr, u32 size) {
+	if (useGEThread_)
+		geHazards_.Mark(addr, size);
+}
+
+void SoftGPU::MarkGEDrawRanges() {
+	if (!useGEThread_)
+		return;
+
+	const u32 h = gstate.getRegionY2() + 1;
+	const u32 fbBpp = gstate.FrameBufFormat() == GE_FORMAT_8888 ? 4 : 2;
+	MarkGERange(gstate.getFrameBufAddress(), gstate.FrameBufStride() * h * fbBpp);
+	MarkGERange(gstate.getDepthBufAddress(), gstate.DepthBufStride() * h * 2);
+
+	if (gstate.isTextureMapEnabled() && !gstate.isModeClear()) {
+		GETextureFormat texfmt = gstate.getTextureFormat();
+		const u32 bitsPerPixel = textureBitsPerPixel[texfmt];
+		for (int i = 0; i <= gstate.getTextureMaxLevel(); ++i) {
+			u32 texaddr = gstate.getTextureAddress(i);
+			u32 bufw = std::max((u32)GetTextureBufw(i, texaddr, texfmt), (u32)gstate.getTextureWidth(i));
+			MarkGERange(texaddr, (bufw * gstate.getTextureHeight(i) * bitsPerPixel) / 8);
+		}
+	}
+}
+
+void SoftGPU::SyncGERange(u32 addr, int size) {
+	// Syncing from the GE thread itself would never finish.
+	if (!useGEThread_ || std::this_thread::get_id() == geThread_->get_id())
+		return;
+
+	if (geHazards_.NeedsSync(addr, size)) {
+		// Even when paused or stepping, the data has to be there before it's read.
+		SyncThread(true);
+	}
+}
+
+void SoftGPU::ClearGEMarks() {
+	geHazards_.Clear();
+}
+
 void SoftGPU::CopyDisplayToOutputInternal()
 {
 	// The display always shows 480x272.
@@ -302,12 +414,26 @@ void SoftGPU::CopyDisplayToOutputInternal()
 	}
 }
 
+bool SoftGPU::ProcessDLQueue() {
+	// Until the GE thread has run the lists, we don't know what memory they use.
+	if (useGEThread_)
+		geHazards_.BeginRun();
+	return GPUCommon::ProcessDLQueue();
+}
+
 void SoftGPU::ProcessEvent(GPUEvent ev) {
 	switch (ev.type) {
 	case GPU_EVENT_COPY_DISPLAY_TO_OUTPUT:
 		CopyDisplayToOutputInternal();
 		break;
 
+	case GPU_EVENT_PROCESS_QUEUE:
+		GPUCommon::ProcessEvent(ev);
+		// Everything the lists touched is marked by now.
+		if (useGEThread_)
+			geHazards_.EndRun();
+		break;
+
 	default:
 		GPUCommon::ProcessEvent(ev);
 	}
@@ -370,6 +496,11 @@ void SoftGPU::ExecuteOp(u32 op, u32 diff) {
 			drawEngine_->transformUnit.SubmitPrimitive(verts, indices, prim, count, gstate.vertType, &bytesRead, drawEngine_);
 			framebufferDirty_ = true;
 
+			if (indices)
+				MarkGERange(gstate_c.indexAddr, count * IndexSize(gstate.vertType));
+			MarkGERange(gstate_c.vertexAddr, bytesRead);
+			MarkGEDrawRanges();
+
 			// After drawing, we advance the vertexAddr (when non indexed) or indexAddr (when indexed).
 			// Some games rely on this, they don't bother reloading VADDR and IADDR.
 			// The VADDR/IADDR registers are NOT updated.
@@ -424,6 +555,10 @@ void SoftGPU::ExecuteOp(u32 op, u32 diff) {
 
 			// After drawing, we advance pointers - see SubmitPrim which does the same.
 			int count = bz_ucount * bz_vcount;
+			if (indices)
+				MarkGERange(gstate_c.indexAddr, count * IndexSize(gstate.vertType));
+			MarkGERange(gstate_c.vertexAddr, bytesRead);
+			MarkGEDrawRanges();
 			AdvanceVerts(gstate.vertType, count, bytesRead);
 		}
 		break;
@@ -477,6 +612,10 @@ void SoftGPU::ExecuteOp(u32 op, u32 diff) {
 
 			// After drawing, we advance pointers - see SubmitPrim which does the same.
 			int count = sp_ucount * sp_vcount;
+			if (indices)
+				MarkGERange(gstate_c.indexAddr, count * IndexSize(gstate.vertType));
+			MarkGERange(gstate_c.vertexAddr, bytesRead);
+			MarkGEDrawRanges();
 			AdvanceVerts(gstate.vertType, count, bytesRead);
 		}
 		break;
@@ -585,6 +724,7 @@ void SoftGPU::ExecuteOp(u32 op, u32 diff) {
 		{
 			u32 clutAddr = gstate.getClutAddress();
 			u32 clutTotalBytes = gstate.getClutLoadBytes();
+			MarkGERange(clutAddr, clutTotalBytes);
 
 			if (Memory::IsValidAddress(clutAddr)) {
 				u32 validSize = Memory::ValidSize(clutAddr, clutTotalBytes);
@@ -631,6 +771,8 @@ void SoftGPU::ExecuteOp(u32 op, u32 diff) {
 			int bpp = gstate.getTransferBpp();
 
 			DEBUG_LOG(G3D, "Block transfer: %08x/%x -> %08x/%x, %ix%ix%i (%i,%i)->(%i,%i)", srcBasePtr, srcStride, dstBasePtr, dstStride, width, height, bpp, srcX, srcY, dstX, dstY);
+			MarkGERange(srcBasePtr + (srcY * srcStride + srcX) * bpp, ((height - 1) * srcStride + width) * bpp);
+			MarkGERange(dstBasePtr + (dstY * dstStride + dstX) * bpp, ((height - 1) * dstStride + width) * bpp);
 
 			for (int y = 0; y < height; y++) {
 				const u8 *src = Memory::GetPointer(srcBasePtr + ((y + srcY) * srcStride + srcX) * bpp);
@@ -865,17 +1007,19 @@ void SoftGPU::GetStats(char *buffer, size_t bufsize) {
 
 void SoftGPU::InvalidateCache(u32 addr, int size, GPUInvalidationType type)
 {
-	// Nothing to invalidate.
+	// Nothing to invalidate, but the GE thread may still be using this memory.
+	SyncGERange(addr, size);
 }
 
 void SoftGPU::NotifyVideoUpload(u32 addr, int size, int width, int format)
 {
-	// Ignore.
+	SyncGERange(addr, size);
 }
 
 bool SoftGPU::PerformMemoryCopy(u32 dest, u32 src, int size)
 {
 	// Nothing to update.
+	SyncGERange(src, size);
 	InvalidateCache(dest, size, GPU_INVALIDATE_HINT);
 	GPURecord::NotifyMemcpy(dest, src, size);
 	// Let's just be safe.
@@ -914,9 +1058,9 @@ bool SoftGPU::PerformStencilUpload(u32 dest, int size)
 }
 
 bool SoftGPU::FramebufferDirty() {
-	if (g_Config.bSeparateCPUThread) {
+	if (ThreadEnabled()) {
 		// Allow it to process fully before deciding if it's dirty.
-		SyncThread();
+		SyncThread(true);
 	}
 
 	if (g_Config.iFrameSkip != 0) {
@@ -1010,5 +1154,9 @@ bool SoftGPU::DescribeCodePtr(const u8 *ptr, std::string &name) {
 		name = "SamplerJit:" + subname;
 		return true;
 	}
+	if (Rasterizer::DescribeCodePtr(ptr, subname)) {
+		name = "PixelJit:" + subname;
+		return true;
+	}
 	return false;
 }
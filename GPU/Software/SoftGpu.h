@@ -17,6 +17,10 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
 #include "GPU/GPUCommon.h"
 #include "GPU/Common/GPUDebugInterface.h"
 #include "thin3d/thin3d.h"
@@ -48,6 +52,70 @@ struct FormatBuffer {
 
 class SoftwareDrawEngine;
 
+// What PSP memory the GE thread may be using, at 64KB page granularity, so the CPU only waits when it has to.
+class GEHazardTracker {
+public:
+	GEHazardTracker() : queuedRuns_(0) {
+		Clear();
+	}
+
+	// A queued run could touch anything, so until it's done every range counts as in use.
+	void BeginRun() {
+		queuedRuns_++;
+	}
+	void EndRun() {
+		queuedRuns_--;
+	}
+
+	void Mark(u32 addr, u32 size) {
+		if (size == 0)
+			return;
+		u32 first, last;
+		Pages(addr, size, first, last);
+		for (u32 page = first; page <= last; ++page) {
+			std::atomic<u32> &word = pages_[page >> 5];
+			const u32 bit = 1U << (page & 31);
+			// Most pages are already marked after the first few draws.
+			if ((word.load(std::memory_order_relaxed) & bit) == 0)
+				word.fetch_or(bit);
+		}
+	}
+
+	// A size of 0 or less means everything, e.g. for InvalidateCache().
+	bool NeedsSync(u32 addr, int size) const {
+		// Check the runs first, marks made during a run are visible once it has ended.
+		if (size <= 0 || queuedRuns_ != 0)
+			return true;
+		u32 first, last;
+		Pages(addr, size, first, last);
+		for (u32 page = first; page <= last; ++page) {
+			if (pages_[page >> 5].load(std::memory_order_relaxed) & (1U << (page & 31)))
+				return true;
+		}
+		return false;
+	}
+
+	void Clear() {
+		for (int i = 0; i < PAGE_WORDS; ++i) {
+			pages_[i].store(0, std::memory_order_relaxed);
+		}
+	}
+
+private:
+	static void Pages(u32 addr, u32 size, u32 &first, u32 &last) {
+		addr &= 0x0FFFFFFF;
+		// Fold the VRAM mirrors together.
+		if ((addr & 0x0F000000) == 0x04000000)
+			addr &= 0x041FFFFF;
+		first = addr >> PAGE_SHIFT;
+		last = std::min(addr + (size - 1), (u32)0x0FFFFFFF) >> PAGE_SHIFT;
+	}
+
+	enum { PAGE_SHIFT = 16, PAGE_WORDS = (0x10000000 >> PAGE_SHIFT) / 32 };
+	std::atomic<u32> pages_[PAGE_WORDS];
+	std::atomic<int> queuedRuns_;
+};
+
 class SoftGPU : public GPUCommon {
 public:
 	SoftGPU(GraphicsContext *gfxCtx, Draw::DrawContext *_thin3D);
@@ -57,6 +125,8 @@ class SoftGPU : public GPUCommon {
 
 	void SetDisplayFramebuffer(u32 framebuf, u32 stride, GEBufferFormat format) override;
 	void CopyDisplayToOutput() override;
+	void ReapplyGfxState() override;
+	void DoState(PointerWrap &p) override;
 	void GetStats(char *buffer, size_t bufsize) override;
 	void InvalidateCache(u32 addr, int size, GPUInvalidationType type) override;
 	void NotifyVideoUpload(u32 addr, int size, int width, int format) override;
@@ -94,12 +164,21 @@ class SoftGPU : public GPUCommon {
 
 protected:
 	void FastRunLoop(DisplayList &list) override;
+	bool ProcessDLQueue() override;
 	void ProcessEvent(GPUEvent ev) override;
+	bool ShouldExitEventLoop() override;
 	void CopyToCurrentFboFromDisplayRam(int srcwidth, int srcheight);
 
 private:
 	void CopyDisplayToOutputInternal() override;
 
+	void GEThreadFunc();
+	// Hazard tracking for the GE thread.
+	void MarkGERange(u32 addr, u32 size);
+	void MarkGEDrawRanges();
+	void SyncGERange(u32 addr, int size);
+	void ClearGEMarks();
+
 	bool framebufferDirty_;
 	u32 displayFramebuf_;
 	u32 displayStride_;
@@ -115,6 +194,13 @@ class SoftGPU : public GPUCommon {
 	Draw::SamplerState *samplerLinear = nullptr;
 	Draw::Buffer *vdata = nullptr;
 	Draw::Buffer *idata = nullptr;
+
+	// Only set when display lists run on our own thread (not with bSeparateCPUThread.)
+	bool useGEThread_ = false;
+	std::thread *geThread_ = nullptr;
+	std::atomic<bool> geThreadExit_;
+	// What the GE thread has read or written since the last flip, and whether lists are still queued.
+	GEHazardTracker geHazards_;
 };
 
 // TODO: These shouldn't be global.
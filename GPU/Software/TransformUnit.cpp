@@ -27,14 +27,25 @@
 #include "GPU/Software/Clipper.h"
 #include "GPU/Software/Lighting.h"
 
+#if defined(_M_SSE)
+#include <emmintrin.h>
+#elif PPSSPP_ARCH(ARM64)
+#include <arm_neon.h>
+#endif
+
 #define TRANSFORM_BUF_SIZE (65536 * 48)
+#define TRANSFORMED_BUF_SIZE (65536 * sizeof(VertexData))
 
 TransformUnit::TransformUnit() {
 	buf = (u8 *)AllocateMemoryPages(TRANSFORM_BUF_SIZE, MEM_PROT_READ | MEM_PROT_WRITE);
+	transformed = (VertexData *)AllocateMemoryPages(TRANSFORMED_BUF_SIZE, MEM_PROT_READ | MEM_PROT_WRITE);
+	outsideRange = new u8[65536];
 }
 
 TransformUnit::~TransformUnit() {
-	FreeMemoryPages(buf, DECODED_VERTEX_BUFFER_SIZE);
+	FreeMemoryPages(buf, TRANSFORM_BUF_SIZE);
+	FreeMemoryPages(transformed, TRANSFORMED_BUF_SIZE);
+	delete [] outsideRange;
 }
 
 SoftwareDrawEngine::SoftwareDrawEngine() {
@@ -144,10 +155,10 @@ ScreenCoords TransformUnit::DrawingToScreen(const DrawingCoords& coords)
 	return ret;
 }
 
-VertexData TransformUnit::ReadVertex(VertexReader& vreader)
-{
-	VertexData vertex;
+static Lighting::State lightState;
 
+static void ReadVertexAttributes(VertexReader &vreader, VertexData &vertex)
+{
 	float pos[3];
 	// VertexDecoder normally scales z, but we want it unscaled.
 	vreader.ReadPosThroughZ16(pos);
@@ -204,37 +215,240 @@ VertexData TransformUnit::ReadVertex(VertexReader& vreader)
 		vertex.color1 = Vec3<int>(0, 0, 0);
 	}
 
-	if (!gstate.isModeThrough()) {
-		vertex.modelpos = ModelCoords(pos[0], pos[1], pos[2]);
-		vertex.worldpos = WorldCoords(TransformUnit::ModelToWorld(vertex.modelpos));
-		ModelCoords viewpos = TransformUnit::WorldToView(vertex.worldpos);
-		vertex.clippos = ClipCoords(TransformUnit::ViewToClip(viewpos));
-		if (gstate.isFogEnabled()) {
-			// TODO: Validate inf/nan.
-			vertex.fogdepth = (viewpos.z + getFloat24(gstate.fog1)) * getFloat24(gstate.fog2);
-		} else {
-			vertex.fogdepth = 1.0f;
+	vertex.modelpos = ModelCoords(pos[0], pos[1], pos[2]);
+}
+
+static void TransformVertexThrough(VertexData &vertex)
+{
+	vertex.screenpos.x = (int)(vertex.modelpos.x * 16) + gstate.getOffsetX16();
+	vertex.screenpos.y = (int)(vertex.modelpos.y * 16) + gstate.getOffsetY16();
+	vertex.screenpos.z = vertex.modelpos.z;
+	vertex.clippos.w = 1.f;
+	vertex.fogdepth = 1.f;
+}
+
+static void TransformVertex(VertexData &vertex, bool hasNormal, bool *outside)
+{
+	vertex.worldpos = WorldCoords(TransformUnit::ModelToWorld(vertex.modelpos));
+	ModelCoords viewpos = TransformUnit::WorldToView(vertex.worldpos);
+	vertex.clippos = ClipCoords(TransformUnit::ViewToClip(viewpos));
+	if (gstate.isFogEnabled()) {
+		// TODO: Validate inf/nan.
+		vertex.fogdepth = (viewpos.z + getFloat24(gstate.fog1)) * getFloat24(gstate.fog2);
+	} else {
+		vertex.fogdepth = 1.0f;
+	}
+	vertex.screenpos = ClipToScreenInternal(vertex.clippos, outside);
+
+	if (hasNormal) {
+		vertex.worldnormal = TransformUnit::ModelToWorldNormal(vertex.normal);
+		// TODO: Isn't there a flag that controls whether to normalize the normal?
+		vertex.worldnormal /= vertex.worldnormal.Length();
+	} else {
+		vertex.worldnormal = Vec3<float>(0.0f, 0.0f, 1.0f);
+	}
+}
+
+#if defined(_M_SSE)
+#define TRANSFORM_LANES 1
+typedef __m128 Lanes;
+static inline Lanes LanesSet1(float f) { return _mm_set1_ps(f); }
+static inline Lanes LanesLoad(const float *f) { return _mm_load_ps(f); }
+static inline void LanesStore(float *f, Lanes v) { _mm_store_ps(f, v); }
+static inline Lanes LanesAdd(Lanes a, Lanes b) { return _mm_add_ps(a, b); }
+static inline Lanes LanesMul(Lanes a, Lanes b) { return _mm_mul_ps(a, b); }
+static inline Lanes LanesDiv(Lanes a, Lanes b) { return _mm_div_ps(a, b); }
+static inline Lanes LanesSqrt(Lanes a) { return _mm_sqrt_ps(a); }
+#elif PPSSPP_ARCH(ARM64)
+#define TRANSFORM_LANES 1
+typedef float32x4_t Lanes;
+static inline Lanes LanesSet1(float f) { return vdupq_n_f32(f); }
+static inline Lanes LanesLoad(const float *f) { return vld1q_f32(f); }
+static inline void LanesStore(float *f, Lanes v) { vst1q_f32(f, v); }
+static inline Lanes LanesAdd(Lanes a, Lanes b) { return vaddq_f32(a, b); }
+static inline Lanes LanesMul(Lanes a, Lanes b) { return vmulq_f32(a, b); }
+static inline Lanes LanesDiv(Lanes a, Lanes b) { return vdivq_f32(a, b); }
+static inline Lanes LanesSqrt(Lanes a) { return vsqrtq_f32(a); }
+#endif
+
+#ifdef TRANSFORM_LANES
+
+// Read once per draw, so the per vertex work doesn't need to convert from float24.
+struct TransformLanesState {
+	Lanes viewportScale[3];
+	Lanes viewportCenter[3];
+	bool fog;
+	Lanes fog1;
+	Lanes fog2;
+	bool hasNormal;
+};
+
+// Same operations in the same order as Mat3x3/Mat4x4, so the results match TransformVertex().
+static inline void Mul3x3Lanes(Lanes out[3], const float *m, const Lanes in[3]) {
+	for (int i = 0; i < 3; ++i) {
+		out[i] = LanesAdd(LanesAdd(LanesMul(LanesSet1(m[i]), in[0]), LanesMul(LanesSet1(m[3 + i]), in[1])), LanesMul(LanesSet1(m[6 + i]), in[2]));
+	}
+}
+
+static inline void Mul4x3Lanes(Lanes out[3], const float *m, const Lanes in[3]) {
+	Mul3x3Lanes(out, m, in);
+	for (int i = 0; i < 3; ++i) {
+		out[i] = LanesAdd(out[i], LanesSet1(m[9 + i]));
+	}
+}
+
+static inline void Mul4x4Lanes(Lanes out[4], const float *m, const Lanes in[3]) {
+	// The w of the view position is always 1.0.
+	for (int i = 0; i < 4; ++i) {
+		Lanes r = LanesAdd(LanesAdd(LanesMul(LanesSet1(m[i]), in[0]), LanesMul(LanesSet1(m[4 + i]), in[1])), LanesMul(LanesSet1(m[8 + i]), in[2]));
+		out[i] = LanesAdd(r, LanesSet1(m[12 + i]));
+	}
+}
+
+// Transforms four vertices at once, one per lane.
+static void TransformVertexLanes(VertexData *verts, u8 *outside, const TransformLanesState &state)
+{
+	alignas(16) float temp[4][4];
+
+	Lanes pos[3];
+	for (int c = 0; c < 3; ++c) {
+		for (int i = 0; i < 4; ++i)
+			temp[c][i] = verts[i].modelpos.AsArray()[c];
+		pos[c] = LanesLoad(temp[c]);
+	}
+
+	Lanes world[3];
+	Mul4x3Lanes(world, gstate.worldMatrix, pos);
+	Lanes view[3];
+	Mul4x3Lanes(view, gstate.viewMatrix, world);
+	Lanes clip[4];
+	Mul4x4Lanes(clip, gstate.projMatrix, view);
+
+	for (int c = 0; c < 3; ++c) {
+		LanesStore(temp[c], world[c]);
+		for (int i = 0; i < 4; ++i)
+			verts[i].worldpos.AsArray()[c] = temp[c][i];
+	}
+	for (int c = 0; c < 4; ++c) {
+		LanesStore(temp[c], clip[c]);
+		for (int i = 0; i < 4; ++i)
+			verts[i].clippos.AsArray()[c] = temp[c][i];
+	}
+
+	if (state.fog) {
+		LanesStore(temp[0], LanesMul(LanesAdd(view[2], state.fog1), state.fog2));
+		for (int i = 0; i < 4; ++i)
+			verts[i].fogdepth = temp[0][i];
+	} else {
+		for (int i = 0; i < 4; ++i)
+			verts[i].fogdepth = 1.0f;
+	}
+
+	// See ClipToScreenInternal(), the range checks and conversions are done per vertex below.
+	for (int c = 0; c < 3; ++c) {
+		Lanes screen = LanesAdd(LanesDiv(LanesMul(clip[c], state.viewportScale[c]), clip[3]), state.viewportCenter[c]);
+		LanesStore(temp[c], screen);
+	}
+	const bool clampZ = (gstate.clipEnable & 0x1) != 0;
+	for (int i = 0; i < 4; ++i) {
+		float x = temp[0][i];
+		float y = temp[1][i];
+		float z = temp[2][i];
+		if (clampZ) {
+			if (z < 0.f)
+				z = 0.f;
+			if (z > 65535.f)
+				z = 65535.f;
 		}
-		vertex.screenpos = ClipToScreenInternal(vertex.clippos, &outside_range_flag);
+		if (x > 4095.9375f || y > 4095.9375f || x < 0 || y < 0 || z < 0 || z > 65535.f)
+			outside[i] = true;
+		verts[i].screenpos = ScreenCoords(x * 16.0f + 0.375f, y * 16.0f + 0.375f, z);
+	}
 
-		if (vreader.hasNormal()) {
-			vertex.worldnormal = TransformUnit::ModelToWorldNormal(vertex.normal);
-			// TODO: Isn't there a flag that controls whether to normalize the normal?
-			vertex.worldnormal /= vertex.worldnormal.Length();
-		} else {
-			vertex.worldnormal = Vec3<float>(0.0f, 0.0f, 1.0f);
+	if (!state.hasNormal) {
+		for (int i = 0; i < 4; ++i)
+			verts[i].worldnormal = Vec3<float>(0.0f, 0.0f, 1.0f);
+		return;
+	}
+
+	Lanes normal[3];
+	for (int c = 0; c < 3; ++c) {
+		for (int i = 0; i < 4; ++i)
+			temp[c][i] = verts[i].normal.AsArray()[c];
+		normal[c] = LanesLoad(temp[c]);
+	}
+	Lanes worldnormal[3];
+	Mul3x3Lanes(worldnormal, gstate.worldMatrix, normal);
+
+	// Summed in the same order as Vec3<float>::Length().
+	Lanes sq[3];
+	for (int c = 0; c < 3; ++c)
+		sq[c] = LanesMul(worldnormal[c], worldnormal[c]);
+#if defined(_M_SSE)
+	Lanes length = LanesSqrt(LanesAdd(sq[0], LanesAdd(sq[1], sq[2])));
+#else
+	Lanes length = LanesSqrt(LanesAdd(LanesAdd(sq[0], sq[1]), sq[2]));
+#endif
+	for (int c = 0; c < 3; ++c) {
+		LanesStore(temp[c], LanesDiv(worldnormal[c], length));
+		for (int i = 0; i < 4; ++i)
+			verts[i].worldnormal.AsArray()[c] = temp[c][i];
+	}
+}
+
+#endif
+
+void TransformUnit::ReadVertices(VertexReader &vreader, int count)
+{
+	for (int i = 0; i < count; ++i) {
+		vreader.Goto(i);
+		ReadVertexAttributes(vreader, transformed[i]);
+	}
+
+	memset(outsideRange, 0, count);
+	if (gstate.isModeThrough()) {
+		for (int i = 0; i < count; ++i) {
+			TransformVertexThrough(transformed[i]);
 		}
+		return;
+	}
 
-		Lighting::Process(vertex, vreader.hasColor0());
-	} else {
-		vertex.screenpos.x = (int)(pos[0] * 16) + gstate.getOffsetX16();
-		vertex.screenpos.y = (int)(pos[1] * 16) + gstate.getOffsetY16();
-		vertex.screenpos.z = pos[2];
-		vertex.clippos.w = 1.f;
-		vertex.fogdepth = 1.f;
+	const bool hasNormal = vreader.hasNormal();
+
+	int i = 0;
+#ifdef TRANSFORM_LANES
+	TransformLanesState state;
+	state.viewportScale[0] = LanesSet1(gstate.getViewportXScale());
+	state.viewportScale[1] = LanesSet1(gstate.getViewportYScale());
+	state.viewportScale[2] = LanesSet1(gstate.getViewportZScale());
+	state.viewportCenter[0] = LanesSet1(gstate.getViewportXCenter());
+	state.viewportCenter[1] = LanesSet1(gstate.getViewportYCenter());
+	state.viewportCenter[2] = LanesSet1(gstate.getViewportZCenter());
+	state.fog = gstate.isFogEnabled();
+	state.fog1 = LanesSet1(getFloat24(gstate.fog1));
+	state.fog2 = LanesSet1(getFloat24(gstate.fog2));
+	state.hasNormal = hasNormal;
+
+	for (; i + 4 <= count; i += 4) {
+		TransformVertexLanes(&transformed[i], &outsideRange[i], state);
+	}
+#endif
+	for (; i < count; ++i) {
+		bool outside = false;
+		TransformVertex(transformed[i], hasNormal, &outside);
+		outsideRange[i] = outside;
+	}
+
+	for (i = 0; i < count; ++i) {
+		Lighting::Process(transformed[i], lightState);
 	}
+}
 
-	return vertex;
+const VertexData &TransformUnit::TransformedVertex(int index)
+{
+	if (outsideRange[index])
+		outside_range_flag = true;
+	return transformed[index];
 }
 
 #define START_OPEN_U 1
@@ -271,6 +485,12 @@ void TransformUnit::SubmitPrimitive(void* vertices, void* indices, GEPrimitiveTy
 
 	VertexReader vreader(buf, vtxfmt, vertex_type);
 
+	// Transform and light each vertex in range once, then assemble the prims from the results.
+	Lighting::ComputeState(&lightState, vreader.hasColor0());
+	if (vertex_count > 0) {
+		ReadVertices(vreader, index_upper_bound - index_lower_bound + 1);
+	}
+
 	const int max_vtcs_per_prim = 3;
 	static VertexData data[max_vtcs_per_prim];
 	// This is the index of the next vert in data (or higher, may need modulus.)
@@ -293,9 +513,6 @@ void TransformUnit::SubmitPrimitive(void* vertices, void* indices, GEPrimitiveTy
 	default: vtcs_per_prim = 0; break;
 	}
 
-	// TODO: Do this in two passes - first process the vertices (before indexing/stripping),
-	// then resolve the indices. This lets us avoid transforming shared vertices twice.
-
 	switch (prim_type) {
 	case GE_PRIM_POINTS:
 	case GE_PRIM_LINES:
@@ -303,13 +520,7 @@ void TransformUnit::SubmitPrimitive(void* vertices, void* indices, GEPrimitiveTy
 	case GE_PRIM_RECTANGLES:
 		{
 			for (int vtx = 0; vtx < vertex_count; ++vtx) {
-				if (indices) {
-					vreader.Goto(idxConv.convert(vtx) - index_lower_bound);
-				} else {
-					vreader.Goto(vtx);
-				}
-
-				data[data_index++] = ReadVertex(vreader);
+				data[data_index++] = TransformedVertex(indices ? idxConv.convert(vtx) - index_lower_bound : vtx);
 				if (data_index < vtcs_per_prim) {
 					// Keep reading.  Note: an incomplete prim will stay read for GE_PRIM_KEEP_PREVIOUS.
 					continue;
@@ -362,13 +573,7 @@ void TransformUnit::SubmitPrimitive(void* vertices, void* indices, GEPrimitiveTy
 			// If data_index is 1 or 2, etc., it means we're continuing a line strip.
 			int skip_count = data_index == 0 ? 1 : 0;
 			for (int vtx = 0; vtx < vertex_count; ++vtx) {
-				if (indices) {
-					vreader.Goto(idxConv.convert(vtx) - index_lower_bound);
-				} else {
-					vreader.Goto(vtx);
-				}
-
-				data[(data_index++) & 1] = ReadVertex(vreader);
+				data[(data_index++) & 1] = TransformedVertex(indices ? idxConv.convert(vtx) - index_lower_bound : vtx);
 				if (outside_range_flag) {
 					// Drop all primitives containing the current vertex
 					skip_count = 2;
@@ -392,13 +597,7 @@ void TransformUnit::SubmitPrimitive(void* vertices, void* indices, GEPrimitiveTy
 			int skip_count = data_index >= 2 ? 0 : 2 - data_index;
 
 			for (int vtx = 0; vtx < vertex_count; ++vtx) {
-				if (indices) {
-					vreader.Goto(idxConv.convert(vtx) - index_lower_bound);
-				} else {
-					vreader.Goto(vtx);
-				}
-
-				data[(data_index++) % 3] = ReadVertex(vreader);
+				data[(data_index++) % 3] = TransformedVertex(indices ? idxConv.convert(vtx) - index_lower_bound : vtx);
 				if (outside_range_flag) {
 					// Drop all primitives containing the current vertex
 					skip_count = 2;
@@ -434,24 +633,13 @@ void TransformUnit::SubmitPrimitive(void* vertices, void* indices, GEPrimitiveTy
 
 			// Only read the central vertex if we're not continuing.
 			if (data_index == 0) {
-				if (indices) {
-					vreader.Goto(idxConv.convert(0) - index_lower_bound);
-				} else {
-					vreader.Goto(0);
-				}
-				data[0] = ReadVertex(vreader);
+				data[0] = TransformedVertex(indices ? idxConv.convert(0) - index_lower_bound : 0);
 				data_index++;
 				start_vtx = 1;
 			}
 
 			for (int vtx = start_vtx; vtx < vertex_count; ++vtx) {
-				if (indices) {
-					vreader.Goto(idxConv.convert(vtx) - index_lower_bound);
-				} else {
-					vreader.Goto(vtx);
-				}
-
-				data[2 - ((data_index++) % 2)] = ReadVertex(vreader);
+				data[2 - ((data_index++) % 2)] = TransformedVertex(indices ? idxConv.convert(vtx) - index_lower_bound : vtx);
 				if (outside_range_flag) {
 					// Drop all primitives containing the current vertex
 					skip_count = 2;
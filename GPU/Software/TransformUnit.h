@@ -132,10 +132,17 @@ class TransformUnit {
 	void SubmitPrimitive(void* vertices, void* indices, GEPrimitiveType prim_type, int vertex_count, u32 vertex_type, int *bytesRead, SoftwareDrawEngine *drawEngine);
 
 	bool GetCurrentSimpleVertices(int count, std::vector<GPUDebugVertex> &vertices, std::vector<u16> &indices);
-	VertexData ReadVertex(VertexReader& vreader);
 
 	bool outside_range_flag = false;
 	u8 *buf;
+
+private:
+	// Transforms and lights the first count decoded vertices into transformed.
+	void ReadVertices(VertexReader &vreader, int count);
+	const VertexData &TransformedVertex(int index);
+
+	VertexData *transformed;
+	u8 *outsideRange;
 };
 
 class SoftwareDrawEngine : public DrawEngineCommon {
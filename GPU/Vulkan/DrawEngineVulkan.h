@@ -141,9 +141,10 @@ class DrawEngineVulkan : public DrawEngineCommon {
 	void SetupVertexDecoderInternal(u32 vertType);
 
 	// So that this can be inlined
-	void Flush() {
+	void Flush(FlushReason reason = FLUSH_REASON_OTHER) {
 		if (!numDrawCalls)
 			return;
+		gpuStats.numFlushesByReason[reason]++;
 		DoFlush();
 	}
 
@@ -185,6 +185,7 @@ void ShaderManagerVulkan::Clear() {
 	});
 	fsCache_.Clear();
 	vsCache_.Clear();
+	recentShaders_.Clear();
 	lastFSID_.set_invalid();
 	lastVSID_.set_invalid();
 	gstate_c.Dirty(DIRTY_VERTEXSHADER_STATE | DIRTY_FRAGMENTSHADER_STATE);
@@ -230,6 +231,9 @@ void ShaderManagerVulkan::GetShaders(int prim, u32 vertType, VulkanVertexShader
 		ComputeVertexShaderID(&VSID, vertType, useHWTransform);
 	} else {
 		VSID = lastVSID_;
+#ifdef _DEBUG
+		ValidateVertexShaderID(VSID, vertType, useHWTransform);
+#endif
 	}
 
 	ShaderID FSID;
@@ -238,6 +242,9 @@ void ShaderManagerVulkan::GetShaders(int prim, u32 vertType, VulkanVertexShader
 		ComputeFragmentShaderID(&FSID);
 	} else {
 		FSID = lastFSID_;
+#ifdef _DEBUG
+		ValidateFragmentShaderID(FSID);
+#endif
 	}
 
 	// Just update uniforms if this is the same shader as last time.
@@ -248,6 +255,17 @@ void ShaderManagerVulkan::GetShaders(int prim, u32 vertType, VulkanVertexShader
 		return;
 	}
 
+	ShaderPair recent;
+	if (recentShaders_.Get(VSID, FSID, &recent)) {
+		lastVSID_ = VSID;
+		lastFSID_ = FSID;
+		lastVShader_ = recent.vs;
+		lastFShader_ = recent.fs;
+		*vshader = recent.vs;
+		*fshader = recent.fs;
+		return;
+	}
+
 	VulkanVertexShader *vs = vsCache_.Get(VSID);
 	if (!vs)	{
 		// Vertex shader not in cache. Let's compile it.
@@ -270,6 +288,7 @@ void ShaderManagerVulkan::GetShaders(int prim, u32 vertType, VulkanVertexShader
 
 	lastVShader_ = vs;
 	lastFShader_ = fs;
+	recentShaders_.Set(VSID, FSID, { vs, fs });
 
 	*vshader = vs;
 	*fshader = fs;
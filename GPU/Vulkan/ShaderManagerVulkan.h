@@ -149,4 +149,10 @@ class ShaderManagerVulkan : public ShaderManagerCommon {
 
 	ShaderID lastFSID_;
 	ShaderID lastVSID_;
+
+	struct ShaderPair {
+		VulkanVertexShader *vs;
+		VulkanFragmentShader *fs;
+	};
+	ShaderPairCache<ShaderPair> recentShaders_;
 };
@@ -801,6 +801,9 @@ void EmuScreen::update() {
 
 	UIScreen::update();
 
+	// Only pay for audio profiling while the overlay shows it.
+	__AudioSetProfiling(g_Config.bShowAudioDebug);
+
 	// Simply forcibly update to the current screen size every frame. Doesn't cost much.
 	// If bounds is set to be smaller than the actual pixel resolution of the display, respect that.
 	// TODO: Should be able to use g_dpi_scale here instead. Might want to store the dpi scale in the UI context too.
@@ -915,15 +918,36 @@ static void DrawAudioDebugStats(DrawBuffer *draw2d) {
 	const AudioDebugStats *stats = __AudioGetDebugStats();
 	snprintf(statbuf, sizeof(statbuf),
 		"Audio buffer: %d/%d (low watermark: %d)\n"
+		"Latency: %d ms\n"
 		"Underruns: %d\n"
 		"Overruns: %d\n"
-		"Sample rate: %d\n"
+		"Sample rate: %d (drift: %+d)\n"
 		"Push size: %d\n",
 		stats->buffered, stats->bufsize, stats->watermark,
+		stats->latencyMs,
 		stats->underrunCount,
 		stats->overrunCount,
-		stats->instantSampleRate,
+		stats->instantSampleRate, stats->drift,
 		stats->lastPushSize);
+
+	// Where the time goes, against how long the audio lasts.
+	static AudioProfileFrame frames[120];
+	const int count = __AudioGetProfileHistory(frames, ARRAY_SIZE(frames));
+	if (count > 0) {
+		size_t len = strlen(statbuf);
+		snprintf(statbuf + len, sizeof(statbuf) - len, "\nAudio CPU (us per %d samples, %d us of audio):\n", frames[0].samples, frames[0].samples * 1000000 / 44100);
+		for (int s = 0; s < (int)AudioProfileStage::COUNT; ++s) {
+			float total = 0.0f;
+			float peak = 0.0f;
+			for (int i = 0; i < count; ++i) {
+				total += frames[i].us[s];
+				peak = std::max(peak, frames[i].us[s]);
+			}
+			len = strlen(statbuf);
+			snprintf(statbuf + len, sizeof(statbuf) - len, "%s: %0.0f avg, %0.0f peak\n", __AudioProfileStageName((AudioProfileStage)s), total / count, peak);
+		}
+	}
+
 	draw2d->SetFontScale(0.7f, 0.7f);
 	draw2d->DrawText(UBUNTU24, statbuf, 11, 31, 0xc0000000, FLAG_DYNAMIC_ASCII);
 	draw2d->DrawText(UBUNTU24, statbuf, 10, 30, 0xFFFFFFFF, FLAG_DYNAMIC_ASCII);
@@ -242,6 +242,12 @@ void GameSettingsScreen::CreateViews() {
 		softwareGPU->OnClick.Handle(this, &GameSettingsScreen::OnSoftwareRendering);
 		if (PSP_IsInited())
 			softwareGPU->SetEnabled(false);
+
+		CheckBox *softwareGPUThread = graphicsSettings->Add(new CheckBox(&g_Config.bSoftwareRenderingThread, gr->T("Software Rendering on thread (experimental)")));
+		if (PSP_IsInited())
+			softwareGPUThread->SetEnabled(false);
+		else
+			softwareGPUThread->SetEnabledPtr(&g_Config.bSoftwareRendering);
 	}
 
 	graphicsSettings->Add(new ItemHeader(gr->T("Frame Rate Control")));
@@ -403,6 +409,15 @@ void GameSettingsScreen::CreateViews() {
 	});
 	deposterize->SetDisabledPtr(&g_Config.bSoftwareRendering);
 
+	CheckBox *scalingCache = graphicsSettings->Add(new CheckBox(&g_Config.bTexScalingCache, gr->T("Cache upscaled textures")));
+	scalingCache->OnClick.Add([=](EventParams &e) {
+		if (g_Config.bTexScalingCache) {
+			settingInfo_->Show(gr->T("Cache upscaled textures Tip", "Saves upscaled textures to disk, so they load faster next time"), e.v);
+		}
+		return UI::EVENT_CONTINUE;
+	});
+	scalingCache->SetDisabledPtr(&g_Config.bSoftwareRendering);
+
 	graphicsSettings->Add(new ItemHeader(gr->T("Texture Filtering")));
 	static const char *anisoLevels[] = { "Off", "2x", "4x", "8x", "16x" };
 	PopupMultiChoice *anisoFiltering = graphicsSettings->Add(new PopupMultiChoice(&g_Config.iAnisotropyLevel, gr->T("Anisotropic Filtering"), anisoLevels, 0, ARRAY_SIZE(anisoLevels), gr->GetName(), screenManager()));
@@ -1287,6 +1302,8 @@ void DeveloperToolsScreen::CreateViews() {
 	list->Add(new ItemHeader(dev->T("Texture Replacement")));
 	list->Add(new CheckBox(&g_Config.bSaveNewTextures, dev->T("Save new textures")));
 	list->Add(new CheckBox(&g_Config.bReplaceTextures, dev->T("Replace textures")));
+	CheckBox *decodedCache = list->Add(new CheckBox(&g_Config.bReplaceTexturesDecodedCache, dev->T("Cache decoded replacement textures")));
+	decodedCache->SetEnabledPtr(&g_Config.bReplaceTextures);
 #if !defined(MOBILE_DEVICE)
 	Choice *createTextureIni = list->Add(new Choice(dev->T("Create/Open textures.ini file for current game")));
 	createTextureIni->OnClick.Handle(this, &DeveloperToolsScreen::OnOpenTexturesIniFile);
@@ -29,6 +29,7 @@ ARCH_FILES := \
   $(SRC)/Core/MIPS/x86/RegCache.cpp \
   $(SRC)/Core/MIPS/x86/RegCacheFPU.cpp \
   $(SRC)/GPU/Common/VertexDecoderX86.cpp \
+  $(SRC)/GPU/Software/DrawPixelX86.cpp \
   $(SRC)/GPU/Software/SamplerX86.cpp
 endif
 
@@ -50,6 +51,7 @@ ARCH_FILES := \
   $(SRC)/Core/MIPS/x86/RegCache.cpp \
   $(SRC)/Core/MIPS/x86/RegCacheFPU.cpp \
   $(SRC)/GPU/Common/VertexDecoderX86.cpp \
+  $(SRC)/GPU/Software/DrawPixelX86.cpp \
   $(SRC)/GPU/Software/SamplerX86.cpp
 endif
 
@@ -96,6 +98,7 @@ ARCH_FILES := \
   $(SRC)/Core/MIPS/ARM64/Arm64RegCacheFPU.cpp \
   $(SRC)/Core/Util/DisArm64.cpp \
   $(SRC)/GPU/Common/VertexDecoderArm64.cpp \
+  $(SRC)/GPU/Software/SamplerARM64.cpp \
   Arm64EmitterTest.cpp
 endif
 
@@ -246,6 +249,7 @@ EXEC_AND_LIB_FILES := \
   $(SRC)/GPU/Null/NullGpu.cpp \
   $(SRC)/GPU/Software/Clipper.cpp \
   $(SRC)/GPU/Software/Lighting.cpp \
+  $(SRC)/GPU/Software/DrawPixel.cpp \
   $(SRC)/GPU/Software/Rasterizer.cpp.arm \
   $(SRC)/GPU/Software/Sampler.cpp \
   $(SRC)/GPU/Software/SoftGpu.cpp \
@@ -527,6 +531,15 @@ ifeq ($(UNITTEST),1)
     $(LIBARMIPS_FILES) \
     $(SRC)/Core/MIPS/MIPSAsm.cpp \
     $(SRC)/unittest/JitHarness.cpp \
+    $(SRC)/unittest/TestIndexGenerator.cpp \
+    $(SRC)/unittest/TestSasReverb.cpp \
+    $(SRC)/unittest/TestVideoConvert.cpp \
+    $(SRC)/unittest/TestStereoResampler.cpp \
+    $(SRC)/unittest/TestMpegDemux.cpp \
+    $(SRC)/unittest/TestSasAudio.cpp \
+    $(SRC)/unittest/TestGEHazards.cpp \
+    $(SRC)/unittest/TestTessCache.cpp \
+    $(SRC)/unittest/TestSoftwareGPUJit.cpp \
     $(SRC)/unittest/TestVertexJit.cpp \
     $(TESTARMEMITTER_FILE) \
     $(SRC)/unittest/UnitTest.cpp
@@ -0,0 +1,170 @@
+#!/usr/bin/env python
+# Runs CPU-bound pspautotests under each CPU core and collects the stats
+# PPSSPPHeadless prints with --bench-cpu, as JSON.
+#
+# Usage: bench.py [--out=FILE] [--runs=N] [-i] [--ir] [-j] [tests...]
+
+import sys
+import os
+import subprocess
+import glob
+import json
+
+
+PPSSPP_EXECUTABLES = [
+  # Windows
+  "Windows\\Release\\PPSSPPHeadless.exe",
+  "Windows\\x64\\Release\\PPSSPPHeadless.exe",
+  "Windows\\Debug\\PPSSPPHeadless.exe",
+  "Windows\\x64\\Debug\\PPSSPPHeadless.exe",
+  # Mac
+  "build*/Release/PPSSPPHeadless",
+  "build*/RelWithDebInfo/PPSSPPHeadless",
+  "build*/MinSizeRel/PPSSPPHeadless",
+  "build*/Debug/PPSSPPHeadless",
+  # Linux
+  "build*/PPSSPPHeadless",
+  "./PPSSPPHeadless"
+]
+
+PPSSPP_EXE = None
+TEST_ROOT = "pspautotests/tests/"
+TIMEOUT = 60
+
+CPU_CORES = {
+  "-i": "interpreter",
+  "--ir": "ir",
+  "-j": "jit",
+}
+
+# Tests that spend nearly all their time executing MIPS code, rather than waiting
+# on vblanks or HLE.  Timing these gives a decent picture of interpreter/JIT speed.
+tests_bench = [
+  "cpu/cpu_alu/cpu_alu",
+  "cpu/cpu_alu/cpu_branch",
+  "cpu/fpu/fpu",
+  "cpu/fpu/fcr",
+  "cpu/icache/icache",
+  "cpu/lsu/lsu",
+  "cpu/vfpu/colors",
+  "cpu/vfpu/convert",
+  "cpu/vfpu/gum",
+  "cpu/vfpu/matrix",
+  "cpu/vfpu/prefixes",
+  "cpu/vfpu/vector",
+  "hash/hash",
+  "misc/libc",
+]
+
+
+def init():
+  global PPSSPP_EXE, TEST_ROOT
+  if not os.path.exists("pspautotests"):
+    if os.path.exists(os.path.dirname(__file__) + "/pspautotests"):
+      TEST_ROOT = os.path.dirname(__file__) + "/pspautotests/tests/";
+    else:
+      print("Please run git submodule init; git submodule update;")
+      sys.exit(1)
+
+  if not os.path.exists(TEST_ROOT + "cpu/cpu_alu/cpu_alu.prx"):
+    print("Please install the pspsdk and run make in common/ and in all the tests")
+    print("(checked for existence of cpu/cpu_alu/cpu_alu.prx)")
+    sys.exit(1)
+
+  possible_exes = [glob.glob(f) for f in PPSSPP_EXECUTABLES]
+  possible_exes = [x for sublist in possible_exes for x in sublist]
+  existing = list(filter(os.path.exists, possible_exes))
+  if existing:
+    PPSSPP_EXE = max((os.path.getmtime(f), f) for f in existing)[1]
+  else:
+    PPSSPP_EXE = None
+
+  if not PPSSPP_EXE:
+    print("PPSSPPHeadless executable missing, please build one.")
+    sys.exit(1)
+
+def test_filename(test):
+  # Try prx first
+  elf_filename = TEST_ROOT + test + ".prx"
+  if not os.path.exists(elf_filename):
+    elf_filename = TEST_ROOT + test + ".elf"
+  return elf_filename
+
+def run_one(test, core_arg):
+  # One process per test, so peak memory isn't shared between tests.
+  cmdline = [PPSSPP_EXE, '--root', TEST_ROOT + '../', '--bench-cpu', '--timeout=' + str(TIMEOUT), core_arg, test_filename(test)]
+  process = subprocess.Popen(cmdline, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+  output, _ = process.communicate()
+
+  for line in output.splitlines():
+    if line.startswith("BENCHRESULT "):
+      result = json.loads(line[len("BENCHRESULT "):])
+      result["test"] = test
+      result["timeout"] = "TIMEOUT" in output
+      return result
+  return None
+
+def median_run(samples):
+  # A whole run, so the numbers reported together were also measured together.
+  ordered = sorted(samples, key=lambda s: s["cycles_per_second"])
+  return ordered[(len(ordered) - 1) // 2]
+
+def run_bench(tests, cores, runs):
+  results = []
+  for test in tests:
+    for core_arg in cores:
+      samples = []
+      for i in range(runs):
+        result = run_one(test, core_arg)
+        if result is None:
+          break
+        samples.append(result)
+
+      if not samples:
+        print("%-28s %-12s FAILED" % (test, CPU_CORES[core_arg]))
+        results.append({"test": test, "cpu": CPU_CORES[core_arg], "failed": True})
+        continue
+
+      # Report the run with the median speed, keeping every run's speed for reference.
+      summary = dict(median_run(samples))
+      summary["runs"] = len(samples)
+      summary["samples_cycles_per_second"] = [s["cycles_per_second"] for s in samples]
+      results.append(summary)
+
+      print("%-28s %-12s %8.1f Mcycles/s  compile %7.3f ms  %6d blocks  %7d KB" % (
+        test, summary["cpu"], summary["cycles_per_second"] / 1000000.0,
+        summary["compile_seconds"] * 1000.0, summary["blocks_compiled"], summary["peak_memory_kb"]))
+  return results
+
+
+def main():
+  init()
+  tests = []
+  cores = []
+  runs = 3
+  out_filename = "bench_results.json"
+  for arg in sys.argv[1:]:
+    if arg in CPU_CORES:
+      cores.append(arg)
+    elif arg.startswith("--runs="):
+      runs = max(1, int(arg[len("--runs="):]))
+    elif arg.startswith("--out="):
+      out_filename = arg[len("--out="):]
+    elif arg[0] == '-':
+      print("Unknown option " + arg)
+      sys.exit(1)
+    else:
+      tests.append(arg)
+
+  if not tests:
+    tests = tests_bench
+  if not cores:
+    cores = ["-i", "--ir", "-j"]
+
+  results = run_bench(tests, cores, runs)
+
+  with open(out_filename, "w") as f:
+    json.dump({"executable": PPSSPP_EXE, "runs": runs, "results": results}, f, indent=2, sort_keys=True)
+  print("Wrote " + out_filename)
+
+main()
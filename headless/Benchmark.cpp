@@ -0,0 +1,274 @@
+// Copyright (c) 2018- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#ifdef _WIN32
+#include "Common/CommonWindows.h"
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+#include "ext/xxhash.h"
+#include "base/timeutil.h"
+#include "profiler/profiler.h"
+#include "Common/FileUtil.h"
+#include "Core/Config.h"
+#include "Core/Core.h"
+#include "Core/CoreTiming.h"
+#include "Core/Host.h"
+#include "Core/System.h"
+#include "Core/HLE/__sceAudio.h"
+#include "Core/MIPS/JitCommon/JitCommon.h"
+#include "GPU/GPUInterface.h"
+#include "GPU/Common/GPUDebugInterface.h"
+#include "GPU/Debugger/Record.h"
+
+#include "headless/Benchmark.h"
+#include "headless/Compare.h"
+#include "headless/StubHost.h"
+
+static int benchIterations;
+static std::vector<double> benchFrameTimes;
+
+#ifdef USE_PROFILER
+// Category totals when the first (warmup) replay finished, and at the end.
+static std::vector<float> benchStageStart;
+static std::vector<float> benchStageEnd;
+
+static void SnapshotProfiler(std::vector<float> &totals) {
+	// We never end a profiler frame during the benchmark, so the latest entry holds everything so far.
+	std::vector<float> history(Profiler_GetHistoryLength());
+	int numCategories = Profiler_GetNumCategories();
+	totals.resize(numCategories);
+	for (int i = 0; i < numCategories; ++i) {
+		Profiler_GetHistory(i, &history[0], (int)history.size());
+		totals[i] = history.back();
+	}
+}
+#endif
+
+static void BenchReplayFrame(double seconds) {
+	benchFrameTimes.push_back(seconds);
+
+#ifdef USE_PROFILER
+	if (benchFrameTimes.size() == 1) {
+		SnapshotProfiler(benchStageStart);
+	}
+#endif
+
+	// The first replay warms up caches and isn't counted.
+	if ((int)benchFrameTimes.size() > benchIterations) {
+#ifdef USE_PROFILER
+		SnapshotProfiler(benchStageEnd);
+#endif
+		Core_Stop();
+	}
+}
+
+static double Percentile(const std::vector<double> &sorted, double p) {
+	size_t index = (size_t)(p * (sorted.size() - 1) + 0.5);
+	return sorted[std::min(index, sorted.size() - 1)];
+}
+
+static void PrintResults(const std::string &filename) {
+	if (benchFrameTimes.size() < 2) {
+		printf("GE dump benchmark: %s did not replay\n", filename.c_str());
+		return;
+	}
+
+	std::vector<double> times(benchFrameTimes.begin() + 1, benchFrameTimes.end());
+	double total = 0.0;
+	for (double t : times) {
+		total += t;
+	}
+	std::sort(times.begin(), times.end());
+
+	printf("GE dump benchmark: %s\n", filename.c_str());
+	printf("  iterations: %d (warmup: %.3f ms)\n", (int)times.size(), benchFrameTimes[0] * 1000.0);
+	printf("  frame ms: min %.3f  median %.3f  p99 %.3f  max %.3f  mean %.3f\n", times.front() * 1000.0, Percentile(times, 0.5) * 1000.0, Percentile(times, 0.99) * 1000.0, times.back() * 1000.0, total * 1000.0 / times.size());
+
+#ifdef USE_PROFILER
+	if (!benchStageEnd.empty()) {
+		printf("  stage ms per frame:\n");
+		for (size_t i = 0; i < benchStageEnd.size(); ++i) {
+			float start = i < benchStageStart.size() ? benchStageStart[i] : 0.0f;
+			double perFrame = (benchStageEnd[i] - start) * 1000.0 / times.size();
+			if (perFrame > 0.0) {
+				printf("    %-16s %.3f\n", Profiler_GetCategoryName((int)i), perFrame);
+			}
+		}
+	}
+#endif
+}
+
+static void PrintChecksum() {
+	GPUDebugBuffer buffer;
+	if (!gpuDebug || !gpuDebug->GetCurrentFramebuffer(buffer, GPU_DBG_FRAMEBUF_DISPLAY)) {
+		printf("  framebuffer checksum: unavailable with this GPU backend\n");
+		return;
+	}
+
+	// Normalize the format and orientation, so backends can be compared.
+	const std::vector<u32> pixels = TranslateDebugBufferToCompare(&buffer, 512, 272);
+	printf("  framebuffer checksum: %08x\n", XXH32(&pixels[0], pixels.size() * sizeof(u32), 0));
+}
+
+bool RunGEDumpBenchmark(HeadlessHost *headlessHost, CoreParameter &coreParameter, int iterations, bool checksum) {
+	benchIterations = std::max(1, iterations);
+	benchFrameTimes.clear();
+#ifdef USE_PROFILER
+	benchStageStart.clear();
+	benchStageEnd.clear();
+#endif
+
+	std::string error_string;
+	if (!PSP_Init(coreParameter, &error_string)) {
+		fprintf(stderr, "Failed to start %s. Error: %s\n", coreParameter.fileToStart.c_str(), error_string.c_str());
+		return false;
+	}
+
+	host->BootDone();
+	GPURecord::SetReplayFrameCallback(&BenchReplayFrame);
+
+	PSP_BeginHostFrame();
+
+	coreState = CORE_RUNNING;
+	while (coreState == CORE_RUNNING) {
+		int blockTicks = usToCycles(1000000 / 10);
+		PSP_RunLoopFor(blockTicks);
+
+		if (coreState == CORE_NEXTFRAME) {
+			coreState = CORE_RUNNING;
+			headlessHost->SwapBuffers();
+		}
+	}
+
+	GPURecord::SetReplayFrameCallback(nullptr);
+
+	bool success = (int)benchFrameTimes.size() > benchIterations;
+	PrintResults(coreParameter.fileToStart);
+	if (checksum && success) {
+		PrintChecksum();
+	}
+
+	PSP_EndHostFrame();
+	PSP_Shutdown();
+
+	headlessHost->FlushDebugOutput();
+	return success;
+}
+
+static double cpuBenchStart;
+static s64 cpuBenchStartTicks;
+
+static s64 PeakMemoryKB() {
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return (s64)(counters.PeakWorkingSetSize / 1024);
+	return -1;
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return -1;
+#if defined(__APPLE__)
+	// Reported in bytes here, but kilobytes on Linux.
+	return (s64)usage.ru_maxrss / 1024;
+#else
+	return (s64)usage.ru_maxrss;
+#endif
+#endif
+}
+
+static const char *CPUCoreName(CPUCore cpuCore) {
+	switch (cpuCore) {
+	case CPUCore::INTERPRETER: return "interpreter";
+	case CPUCore::JIT: return "jit";
+	case CPUCore::IR_JIT: return "ir";
+	default: return "unknown";
+	}
+}
+
+static std::string JSONEscape(const std::string &str) {
+	std::string escaped;
+	for (char c : str) {
+		if (c == '"' || c == '\\') {
+			escaped += '\\';
+			escaped += c;
+		} else if ((unsigned char)c < 0x20) {
+			char temp[8];
+			snprintf(temp, sizeof(temp), "\\u%04x", (unsigned char)c);
+			escaped += temp;
+		} else {
+			escaped += c;
+		}
+	}
+	return escaped;
+}
+
+void BeginCPUBenchmark() {
+	MIPSComp::compileStats.enabled = true;
+	MIPSComp::compileStats.blocks = 0;
+	MIPSComp::compileStats.seconds = 0.0;
+	cpuBenchStartTicks = CoreTiming::GetTicks();
+	cpuBenchStart = real_time_now();
+}
+
+void PrintCPUBenchmark(const CoreParameter &coreParameter) {
+	double seconds = real_time_now() - cpuBenchStart;
+	s64 cycles = CoreTiming::GetTicks() - cpuBenchStartTicks;
+	double cyclesPerSecond = seconds > 0.0 ? cycles / seconds : 0.0;
+
+	printf("BENCHRESULT {\"test\": \"%s\", \"cpu\": \"%s\", \"cycles\": %lld, \"seconds\": %.6f, \"cycles_per_second\": %.1f, \"compile_seconds\": %.6f, \"blocks_compiled\": %u, \"peak_memory_kb\": %lld}\n",
+		JSONEscape(coreParameter.fileToStart).c_str(), CPUCoreName(coreParameter.cpuCore), (long long)cycles, seconds, cyclesPerSecond,
+		MIPSComp::compileStats.seconds, MIPSComp::compileStats.blocks, (long long)PeakMemoryKB());
+	fflush(stdout);
+	MIPSComp::compileStats.enabled = false;
+}
+
+void WriteAudioProfile(const CoreParameter &coreParameter, const char *filename) {
+	FILE *f = File::OpenCFile(filename, "a");
+	if (!f) {
+		fprintf(stderr, "Unable to open %s for the audio profile\n", filename);
+		return;
+	}
+
+	// Only write the header into a new file, so several tests can share one.
+	fseek(f, 0, SEEK_END);
+	if (ftell(f) == 0) {
+		fprintf(f, "test,frame,samples");
+		for (int s = 0; s < (int)AudioProfileStage::COUNT; ++s)
+			fprintf(f, ",%s us", __AudioProfileStageName((AudioProfileStage)s));
+		fprintf(f, "\n");
+	}
+
+	std::vector<AudioProfileFrame> frames(1024);
+	frames.resize(__AudioGetProfileHistory(&frames[0], (int)frames.size()));
+	const std::string testName = GetTestName(coreParameter.fileToStart);
+	for (size_t i = 0; i < frames.size(); ++i) {
+		fprintf(f, "%s,%d,%d", testName.c_str(), (int)i, frames[i].samples);
+		for (int s = 0; s < (int)AudioProfileStage::COUNT; ++s)
+			fprintf(f, ",%.1f", frames[i].us[s]);
+		fprintf(f, "\n");
+	}
+	fclose(f);
+}
@@ -0,0 +1,34 @@
+// Copyright (c) 2018- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include "Core/CoreParameter.h"
+
+class HeadlessHost;
+
+// Replays a GE dump (coreParameter.fileToStart) the given number of times and prints frame timing.
+bool RunGEDumpBenchmark(HeadlessHost *headlessHost, CoreParameter &coreParameter, int iterations, bool checksum);
+
+// Starts measuring a CPU benchmark run.  Call once the game is booted, right before running.
+void BeginCPUBenchmark();
+// Prints a single line JSON summary of the run, prefixed with BENCHRESULT, and stops measuring.
+// Call before PSP_Shutdown().
+void PrintCPUBenchmark(const CoreParameter &coreParameter);
+
+// Appends the audio profile history as CSV rows, one per host audio block.  Call before PSP_Shutdown().
+void WriteAudioProfile(const CoreParameter &coreParameter, const char *filename);
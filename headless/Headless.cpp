@@ -14,6 +14,7 @@
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
 #include "Core/System.h"
+#include "Core/HLE/__sceAudio.h"
 #include "Core/HLE/sceUtility.h"
 #include "Core/Host.h"
 #include "Core/SaveState.h"
@@ -22,6 +23,7 @@
 #include "base/NativeApp.h"
 #include "base/timeutil.h"
 
+#include "Benchmark.h"
 #include "Compare.h"
 #include "StubHost.h"
 #if defined(_WIN32)
@@ -106,6 +108,11 @@ int printUsage(const char *progname, const char *reason)
 	fprintf(stderr, "  --ir                  use ir interpreter\n");
 	fprintf(stderr, "  -j                    use jit (default)\n");
 	fprintf(stderr, "  -c, --compare         compare with output in file.expected\n");
+	fprintf(stderr, "  --bench-gedump=FILE   replay a GE dump repeatedly and report frame times\n");
+	fprintf(stderr, "  --iterations=N        number of timed replays for --bench-gedump (default 100)\n");
+	fprintf(stderr, "  --checksum            print a checksum of the final framebuffer after benchmarking\n");
+	fprintf(stderr, "  --bench-cpu           print CPU/JIT statistics for each test as a JSON line\n");
+	fprintf(stderr, "  --audio-profile=FILE  append recent per-stage audio timings to a CSV file after each test\n");
 	fprintf(stderr, "\nSee headless.txt for details.\n");
 
 	return 1;
@@ -125,7 +132,7 @@ static HeadlessHost *getHost(GPUCore gpuCore) {
 	}
 }
 
-bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, bool autoCompare, bool verbose, double timeout)
+bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, bool autoCompare, bool verbose, double timeout, bool benchCPU, const char *audioProfileFile)
 {
 	if (teamCityMode) {
 		// Kinda ugly, trying to guesstimate the test name from filename...
@@ -159,6 +166,8 @@ bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, bool
 	deadline = time_now() + timeout;
 
 	PSP_BeginHostFrame();
+	if (benchCPU)
+		BeginCPUBenchmark();
 
 	coreState = CORE_RUNNING;
 	while (coreState == CORE_RUNNING)
@@ -185,6 +194,11 @@ bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, bool
 
 	PSP_EndHostFrame();
 
+	if (benchCPU)
+		PrintCPUBenchmark(coreParameter);
+	if (audioProfileFile)
+		WriteAudioProfile(coreParameter, audioProfileFile);
+
 	PSP_Shutdown();
 
 	headlessHost->FlushDebugOutput();
@@ -223,6 +237,11 @@ int main(int argc, const char* argv[])
 	const char *mountRoot = 0;
 	const char *screenshotFilename = 0;
 	float timeout = std::numeric_limits<float>::infinity();
+	const char *benchGEDump = 0;
+	int benchIterations = 100;
+	bool benchChecksum = false;
+	bool benchCPU = false;
+	const char *audioProfileFile = 0;
 
 	for (int i = 1; i < argc; i++)
 	{
@@ -275,6 +294,16 @@ int main(int argc, const char* argv[])
 			screenshotFilename = argv[i] + strlen("--screenshot=");
 		else if (!strncmp(argv[i], "--timeout=", strlen("--timeout=")) && strlen(argv[i]) > strlen("--timeout="))
 			timeout = strtod(argv[i] + strlen("--timeout="), NULL);
+		else if (!strncmp(argv[i], "--bench-gedump=", strlen("--bench-gedump=")) && strlen(argv[i]) > strlen("--bench-gedump="))
+			benchGEDump = argv[i] + strlen("--bench-gedump=");
+		else if (!strncmp(argv[i], "--iterations=", strlen("--iterations=")) && strlen(argv[i]) > strlen("--iterations="))
+			benchIterations = (int)strtol(argv[i] + strlen("--iterations="), NULL, 10);
+		else if (!strcmp(argv[i], "--checksum"))
+			benchChecksum = true;
+		else if (!strcmp(argv[i], "--bench-cpu"))
+			benchCPU = true;
+		else if (!strncmp(argv[i], "--audio-profile=", strlen("--audio-profile=")) && strlen(argv[i]) > strlen("--audio-profile="))
+			audioProfileFile = argv[i] + strlen("--audio-profile=");
 		else if (!strcmp(argv[i], "--teamcity"))
 			teamCityMode = true;
 		else if (!strncmp(argv[i], "--state=", strlen("--state=")) && strlen(argv[i]) > strlen("--state="))
@@ -296,7 +325,7 @@ int main(int argc, const char* argv[])
 			testFilenames.push_back(temp);
 	}
 
-	if (testFilenames.empty())
+	if (testFilenames.empty() && !benchGEDump)
 		return printUsage(argv[0], argc <= 1 ? NULL : "No executables specified");
 
 	HeadlessHost *headlessHost = getHost(gpuCore);
@@ -402,6 +431,17 @@ int main(int argc, const char* argv[])
 	if (stateToLoad != NULL)
 		SaveState::Load(stateToLoad);
 
+	int exitCode = 0;
+	if (benchGEDump) {
+		coreParameter.fileToStart = benchGEDump;
+		coreParameter.printfEmuLog = false;
+		if (!RunGEDumpBenchmark(headlessHost, coreParameter, benchIterations, benchChecksum))
+			exitCode = 1;
+	}
+
+	if (audioProfileFile)
+		__AudioSetProfiling(true);
+
 	std::vector<std::string> failedTests;
 	std::vector<std::string> passedTests;
 	for (size_t i = 0; i < testFilenames.size(); ++i)
@@ -409,7 +449,7 @@ int main(int argc, const char* argv[])
 		coreParameter.fileToStart = testFilenames[i];
 		if (autoCompare)
 			printf("%s:\n", coreParameter.fileToStart.c_str());
-		bool passed = RunAutoTest(headlessHost, coreParameter, autoCompare, verbose, timeout);
+		bool passed = RunAutoTest(headlessHost, coreParameter, autoCompare, verbose, timeout, benchCPU, audioProfileFile);
 		if (autoCompare)
 		{
 			std::string testName = GetTestName(coreParameter.fileToStart);
@@ -448,5 +488,5 @@ int main(int argc, const char* argv[])
 	moncleanup();
 #endif
 
-	return 0;
+	return exitCode;
 }
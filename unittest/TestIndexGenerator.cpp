@@ -0,0 +1,252 @@
+// Copyright (c) 2018- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "base/timeutil.h"
+#include "Common/Common.h"
+#include "GPU/Common/IndexGenerator.h"
+#include "GPU/ge_constants.h"
+#include "unittest/UnitTest.h"
+
+static const int MAX_INDS = 1024;
+// Strips and fans can expand to three indices per input.
+static const int MAX_OUT_INDS = MAX_INDS * 3 + 64;
+
+// Straightforward versions of what IndexGenerator produces, one index at a time.
+// Returns the number of indices written.
+template <class ITypeLE>
+static int ReferenceTranslate(u16 *out, int prim, const ITypeLE *inds, int numInds, u16 offset) {
+	u16 *start = out;
+	switch (prim) {
+	case GE_PRIM_POINTS:
+		for (int i = 0; i < numInds; i++)
+			*out++ = offset + inds[i];
+		break;
+	case GE_PRIM_LINES:
+	case GE_PRIM_RECTANGLES:
+		for (int i = 0; i < (numInds & ~1); i++)
+			*out++ = offset + inds[i];
+		break;
+	case GE_PRIM_LINE_STRIP:
+		for (int i = 0; i < numInds - 1; i++) {
+			*out++ = offset + inds[i];
+			*out++ = offset + inds[i + 1];
+		}
+		break;
+	case GE_PRIM_TRIANGLES:
+		for (int i = 0; i < (numInds / 3) * 3; i++)
+			*out++ = offset + inds[i];
+		break;
+	case GE_PRIM_TRIANGLE_STRIP:
+		for (int i = 0; i < numInds - 2; i++) {
+			*out++ = offset + inds[i];
+			*out++ = offset + inds[i + ((i & 1) ? 2 : 1)];
+			*out++ = offset + inds[i + ((i & 1) ? 1 : 2)];
+		}
+		break;
+	case GE_PRIM_TRIANGLE_FAN:
+		for (int i = 0; i < numInds - 2; i++) {
+			*out++ = offset + inds[0];
+			*out++ = offset + inds[i + 1];
+			*out++ = offset + inds[i + 2];
+		}
+		break;
+	}
+	return (int)(out - start);
+}
+
+// Only the prims that write exactly what they count.
+static int ReferenceAdd(u16 *out, int prim, int numVerts, u16 startIndex) {
+	u16 *start = out;
+	switch (prim) {
+	case GE_PRIM_POINTS:
+		for (int i = 0; i < numVerts; i++)
+			*out++ = startIndex + i;
+		break;
+	case GE_PRIM_TRIANGLE_STRIP:
+		for (int i = 0; i < numVerts - 2; i++) {
+			*out++ = startIndex + i;
+			*out++ = startIndex + i + ((i & 1) ? 2 : 1);
+			*out++ = startIndex + i + ((i & 1) ? 1 : 2);
+		}
+		break;
+	case GE_PRIM_TRIANGLE_FAN:
+		for (int i = 0; i < numVerts - 2; i++) {
+			*out++ = startIndex;
+			*out++ = startIndex + i + 1;
+			*out++ = startIndex + i + 2;
+		}
+		break;
+	}
+	return (int)(out - start);
+}
+
+static bool CompareIndices(const char *title, int prim, int numInds, const u16 *expected, int expectedCount, const u16 *actual, int actualCount) {
+	if (expectedCount != actualCount) {
+		printf("%s: prim %d, %d inputs: count %d != expected %d\n", title, prim, numInds, actualCount, expectedCount);
+		return false;
+	}
+	for (int i = 0; i < expectedCount; ++i) {
+		if (expected[i] != actual[i]) {
+			printf("%s: prim %d, %d inputs: index %d is %d != expected %d\n", title, prim, numInds, i, actual[i], expected[i]);
+			return false;
+		}
+	}
+	return true;
+}
+
+template <class ITypeLE>
+static bool FuzzTranslate(const char *title, IndexGenerator &gen, u16 *actual, u16 *expected, ITypeLE *inds, u32 mask) {
+	static const int prims[] = {
+		GE_PRIM_POINTS, GE_PRIM_LINES, GE_PRIM_LINE_STRIP, GE_PRIM_TRIANGLES,
+		GE_PRIM_TRIANGLE_STRIP, GE_PRIM_TRIANGLE_FAN, GE_PRIM_RECTANGLES,
+	};
+
+	for (int round = 0; round < 2000; ++round) {
+		int prim = prims[rand() % ARRAY_SIZE(prims)];
+		// Mostly short draws, like games send, with the occasional big one.
+		int numInds = (round & 7) == 0 ? rand() % MAX_INDS : rand() % 40;
+		for (int i = 0; i < numInds; ++i) {
+			inds[i] = ((u32)rand() ^ ((u32)rand() << 15)) & mask;
+		}
+		int index = rand() & 0xFFFF;
+		int indexOffset = rand() % 1024;
+
+		gen.Setup(actual);
+		gen.SetIndex(index);
+		gen.TranslatePrim(prim, numInds, inds, indexOffset);
+
+		int expectedCount = ReferenceTranslate(expected, prim, inds, numInds, (u16)(index - indexOffset));
+		if (!CompareIndices(title, prim, numInds, expected, expectedCount, actual, gen.VertexCount())) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool FuzzAdd(IndexGenerator &gen, u16 *actual, u16 *expected) {
+	static const int prims[] = { GE_PRIM_POINTS, GE_PRIM_TRIANGLE_STRIP, GE_PRIM_TRIANGLE_FAN };
+
+	for (int round = 0; round < 2000; ++round) {
+		int prim = prims[rand() % ARRAY_SIZE(prims)];
+		int numVerts = (round & 7) == 0 ? rand() % MAX_INDS : rand() % 40;
+		int index = rand() & 0xFFFF;
+
+		gen.Setup(actual);
+		gen.SetIndex(index);
+		gen.AddPrim(prim, numVerts);
+
+		int expectedCount = ReferenceAdd(expected, prim, numVerts, (u16)index);
+		if (!CompareIndices("AddPrim", prim, numVerts, expected, expectedCount, actual, gen.VertexCount())) {
+			return false;
+		}
+	}
+	return true;
+}
+
+template <typename F>
+static double IndicesPerSecond(int indsPerCall, F func) {
+	int total = 0;
+	double st = real_time_now();
+	do {
+		for (int j = 0; j < 1000; ++j) {
+			func();
+		}
+		total += 1000;
+	} while (real_time_now() - st < 0.25);
+	double elapsed = real_time_now() - st;
+	return total * (double)indsPerCall / elapsed;
+}
+
+// Not part of the test, since it takes a few seconds.  Run as IndexGeneratorBenchmark.
+bool BenchmarkIndexGenerator() {
+	const int numVerts = 512;
+	IndexGenerator gen;
+	u16 *actual = new u16[MAX_OUT_INDS];
+	u16 *expected = new u16[MAX_OUT_INDS];
+	u16_le *inds = new u16_le[numVerts];
+	for (int i = 0; i < numVerts; ++i) {
+		inds[i] = (u16)(rand() & 0x3FF);
+	}
+
+	struct Bench {
+		const char *name;
+		int prim;
+		bool indexed;
+	};
+	static const Bench benches[] = {
+		{ "strip", GE_PRIM_TRIANGLE_STRIP, false },
+		{ "fan", GE_PRIM_TRIANGLE_FAN, false },
+		{ "indexed strip", GE_PRIM_TRIANGLE_STRIP, true },
+		{ "indexed fan", GE_PRIM_TRIANGLE_FAN, true },
+		{ "indexed list", GE_PRIM_TRIANGLES, true },
+	};
+
+	for (const Bench &b : benches) {
+		double fast, slow;
+		if (b.indexed) {
+			fast = IndicesPerSecond(numVerts, [&] {
+				gen.Setup(actual);
+				gen.SetIndex(16);
+				gen.TranslatePrim(b.prim, numVerts, inds, 0);
+			});
+			slow = IndicesPerSecond(numVerts, [&] {
+				ReferenceTranslate(expected, b.prim, inds, numVerts, 16);
+			});
+		} else {
+			fast = IndicesPerSecond(numVerts, [&] {
+				gen.Setup(actual);
+				gen.AddPrim(b.prim, numVerts);
+			});
+			slow = IndicesPerSecond(numVerts, [&] {
+				ReferenceAdd(expected, b.prim, numVerts, 0);
+			});
+		}
+		printf("IndexGenerator %s: %.1f M inputs/s, %.2fx the plain loop.\n", b.name, fast / 1000000.0, fast / slow);
+	}
+
+	delete [] actual;
+	delete [] expected;
+	delete [] inds;
+	return true;
+}
+
+bool TestIndexGenerator() {
+	IndexGenerator gen;
+	u16 *actual = new u16[MAX_OUT_INDS];
+	u16 *expected = new u16[MAX_OUT_INDS];
+	u8 *inds8 = new u8[MAX_INDS];
+	u16_le *inds16 = new u16_le[MAX_INDS];
+	u32_le *inds32 = new u32_le[MAX_INDS];
+
+	srand(1234);
+	bool success = FuzzAdd(gen, actual, expected);
+	success = success && FuzzTranslate("TranslatePrim u8", gen, actual, expected, inds8, 0xFF);
+	success = success && FuzzTranslate("TranslatePrim u16", gen, actual, expected, inds16, 0xFFFF);
+	// Upper bits should simply be dropped.
+	success = success && FuzzTranslate("TranslatePrim u32", gen, actual, expected, inds32, 0xFFFFFFFF);
+
+	delete [] actual;
+	delete [] expected;
+	delete [] inds8;
+	delete [] inds16;
+	delete [] inds32;
+	return success;
+}
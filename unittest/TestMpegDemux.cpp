@@ -0,0 +1,249 @@
+// Copyright (c) 2018- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Core/HW/MpegDemux.h"
+#include "unittest/UnitTest.h"
+
+static const int HEADER_SIZE = 2048;
+static const int PACK_SIZE = 2048;
+static const int FRAME_COUNT = 300;
+// Like AT3+ at 64 kbps, which doesn't fit packs evenly, so frames get split and wrap around.
+static const u8 FRAME_CODE1 = 0x28;
+static const u8 FRAME_CODE2 = 0x5C;
+static const int FRAME_SIZE = (((FRAME_CODE1 & 3) << 8) | (FRAME_CODE2 * 8)) + 0x10;
+
+static u32 NextRandom(u32 &seed) {
+	seed = seed * 1664525 + 1013904223;
+	return seed >> 8;
+}
+
+static void Put32(std::vector<u8> &v, u32 x) {
+	v.push_back(x >> 24);
+	v.push_back(x >> 16);
+	v.push_back(x >> 8);
+	v.push_back(x);
+}
+
+static void PutPts(std::vector<u8> &v, s64 pts) {
+	v.push_back(0x21 | ((pts >> 29) & 0x0E));
+	v.push_back(pts >> 22);
+	v.push_back(((pts >> 14) & 0xFE) | 1);
+	v.push_back(pts >> 7);
+	v.push_back(((pts << 1) & 0xFE) | 1);
+}
+
+// A PSMF-like stream: a header, then packs of either video or audio plus some padding.
+static std::vector<u8> BuildStream(u32 &seed) {
+	std::vector<u8> audio;
+	for (int f = 0; f < FRAME_COUNT; ++f) {
+		audio.push_back(0x0F);
+		audio.push_back(0xD0);
+		audio.push_back(FRAME_CODE1);
+		audio.push_back(FRAME_CODE2);
+		for (int i = 4; i < FRAME_SIZE; ++i)
+			audio.push_back(NextRandom(seed) % 0xC0);
+	}
+
+	std::vector<u8> stream;
+	for (int i = 0; i < HEADER_SIZE; ++i)
+		stream.push_back(NextRandom(seed));
+
+	static const u8 packHeader[10] = { 0x44, 0x00, 0x04, 0x00, 0x04, 0x01, 0x01, 0x89, 0xC3, 0xF8 };
+	size_t audioPos = 0;
+	s64 pts = 90000;
+	while (audioPos < audio.size()) {
+		Put32(stream, 0x1BA);
+		stream.insert(stream.end(), packHeader, packHeader + 10);
+		if ((NextRandom(seed) & 3) == 0) {
+			const int payload = PACK_SIZE - 14 - 6 - 3 - 5 - 4 - 8;
+			const int length = payload + 3 + 5 + 4;
+			Put32(stream, 0x1BD);
+			stream.push_back(length >> 8);
+			stream.push_back(length & 0xFF);
+			stream.push_back(0x81);
+			stream.push_back(0x80);
+			stream.push_back(5);
+			PutPts(stream, pts);
+			pts += 4180;
+			Put32(stream, 0x00FF0001);
+			for (int i = 0; i < payload; ++i)
+				stream.push_back(audioPos < audio.size() ? audio[audioPos++] : 0xFF);
+			Put32(stream, 0x1BE);
+			Put32(stream, 0x0002FFFF);
+		} else {
+			const int length = PACK_SIZE - 14 - 6;
+			Put32(stream, 0x1E0);
+			stream.push_back(length >> 8);
+			stream.push_back(length & 0xFF);
+			// Just the PES header marker, the rest is never looked at.
+			stream.push_back(0x81);
+			for (int i = 1; i < length; ++i)
+				stream.push_back(NextRandom(seed));
+		}
+	}
+	return stream;
+}
+
+struct DemuxedFrame {
+	std::vector<u8> data;
+	s64 pts;
+};
+
+static bool NextFrame(MpegDemux &demux, DemuxedFrame &frame) {
+	u8 *buf;
+	int code1, code2;
+	int size = demux.getNextAudioFrame(&buf, &code1, &code2, &frame.pts);
+	frame.data.assign(buf, buf + size);
+	return size != 0;
+}
+
+// Feeds the stream in pieces, the way the ringbuffer does, pulling frames whenever there's room.
+// Keeping the whole stream is how the demuxer always used to work, so the audio-only one has to match it
+// exactly, including how much room it reports, since that decides how much the PSMF player reads in.
+static bool Demux(const std::vector<u8> &stream, u32 &seed, int minChunk, int maxChunk, std::vector<DemuxedFrame> &frames) {
+	MpegDemux demux(0x10000 + HEADER_SIZE, HEADER_SIZE);
+	MpegDemux whole(0x10000 + HEADER_SIZE, HEADER_SIZE, true);
+	size_t pos = 0;
+	frames.clear();
+	while (true) {
+		if (pos < stream.size()) {
+			int chunk = minChunk + NextRandom(seed) % (maxChunk - minChunk + 1);
+			if (pos == 0)
+				chunk += HEADER_SIZE;
+			chunk = std::min(chunk, (int)(stream.size() - pos));
+			if (demux.getRemainSize() >= chunk) {
+				const bool added = demux.addStreamData(&stream[pos], chunk);
+				if (whole.addStreamData(&stream[pos], chunk) != added) {
+					printf("MpegDemux: adding %d bytes at %d differs\n", chunk, (int)pos);
+					return false;
+				}
+				if (added)
+					pos += chunk;
+			}
+		}
+
+		demux.demux(-1);
+		whole.demux(-1);
+		if (demux.getRemainSize() != whole.getRemainSize()) {
+			printf("MpegDemux: %d bytes free at %d, expected %d\n", demux.getRemainSize(), (int)pos, whole.getRemainSize());
+			return false;
+		}
+
+		DemuxedFrame frame, wholeFrame;
+		const bool gotFrame = NextFrame(demux, frame);
+		if (NextFrame(whole, wholeFrame) != gotFrame || frame.data != wholeFrame.data || frame.pts != wholeFrame.pts) {
+			printf("MpegDemux: frame %d at %d differs\n", (int)frames.size(), (int)pos);
+			return false;
+		}
+		if (!gotFrame) {
+			if (pos >= stream.size())
+				break;
+			continue;
+		}
+		frames.push_back(frame);
+	}
+	return true;
+}
+
+// Like sceMpegRingbufferPut() on older libraries, which rejects the data if any pack doesn't look valid.
+static bool LooksValid(const std::vector<u8> &packs) {
+	MpegDemux whole((int)packs.size(), 0, true);
+	bool valid = true;
+	for (size_t pos = 0; pos < packs.size(); pos += PACK_SIZE) {
+		whole.addStreamData(&packs[pos], PACK_SIZE);
+		if (!whole.demux(0xFFFF))
+			valid = false;
+	}
+	return valid;
+}
+
+static bool TestValidation(const std::vector<u8> &stream) {
+	std::vector<u8> packs(stream.begin() + HEADER_SIZE, stream.end());
+	if (!LooksValid(packs)) {
+		printf("MpegDemux: stream doesn't look valid\n");
+		return false;
+	}
+
+	// A pack with only video has no audio at all, but it's still fine.
+	size_t videoPack = 0;
+	while (packs[videoPack + 17] != 0xE0)
+		videoPack += PACK_SIZE;
+	std::vector<u8> video(packs.begin() + videoPack, packs.begin() + videoPack + PACK_SIZE);
+	if (!LooksValid(video)) {
+		printf("MpegDemux: video pack doesn't look valid\n");
+		return false;
+	}
+
+	// Without the pack header, it comes down to the PES header marker.
+	std::vector<u8> packet(video.begin() + 14, video.end());
+	packet.resize(PACK_SIZE, 0xFF);
+	packet[6] = 0x81;
+	if (!LooksValid(packet)) {
+		printf("MpegDemux: video packet doesn't look valid\n");
+		return false;
+	}
+	packet[6] = 0x41;
+	if (LooksValid(packet)) {
+		printf("MpegDemux: video packet with a bad marker looks valid\n");
+		return false;
+	}
+
+	std::vector<u8> garbage(PACK_SIZE, 0x42);
+	if (LooksValid(garbage)) {
+		printf("MpegDemux: garbage looks valid\n");
+		return false;
+	}
+	return true;
+}
+
+bool TestMpegDemux() {
+	u32 seed = 0x5053;
+	const std::vector<u8> stream = BuildStream(seed);
+
+	// Only whole packs at once, nothing ever splits a packet.
+	std::vector<DemuxedFrame> reference;
+	if (!Demux(stream, seed, PACK_SIZE, PACK_SIZE, reference))
+		return false;
+	if ((int)reference.size() != FRAME_COUNT) {
+		printf("MpegDemux: got %d frames, expected %d\n", (int)reference.size(), FRAME_COUNT);
+		return false;
+	}
+
+	// However the stream is split up, the same frames should come out.
+	for (int trial = 0; trial < 8; ++trial) {
+		std::vector<DemuxedFrame> frames;
+		if (!Demux(stream, seed, 1, trial & 1 ? 37 : 5000, frames))
+			return false;
+		if (frames.size() != reference.size()) {
+			printf("MpegDemux: trial %d got %d frames, expected %d\n", trial, (int)frames.size(), (int)reference.size());
+			return false;
+		}
+		for (size_t i = 0; i < frames.size(); ++i) {
+			if (frames[i].data != reference[i].data || frames[i].pts != reference[i].pts) {
+				printf("MpegDemux: trial %d frame %d differs\n", trial, (int)i);
+				return false;
+			}
+		}
+	}
+
+	return TestValidation(stream);
+}
@@ -0,0 +1,402 @@
+// Copyright (c) 2018- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "Common/Common.h"
+#include "Core/Config.h"
+#include "Core/HW/SasAudio.h"
+#include "Core/MIPS/MIPS.h"
+#include "Core/MemMap.h"
+#include "Core/Util/AudioFormat.h"
+#include "unittest/UnitTest.h"
+
+// Enough source for a full grain at the highest pitch, plus the sample after it.
+static const int RESAMPLE_SOURCE = PSP_SAS_MAX_GRAIN * (PSP_SAS_PITCH_MAX / PSP_SAS_PITCH_BASE) + 8;
+static const int ENVELOPE_SAMPLES = 60000;
+// Where the voices read VAG and PCM data from, and where the mix goes.
+static const u32 MIX_SOURCE_ADDR = 0x08800000;
+static const u32 MIX_SOURCE_SIZE = 0x00100000;
+static const u32 MIX_OUTPUT_ADDR = 0x09000000;
+
+static uint32_t NextRandom(uint32_t &seed) {
+	seed = seed * 1664525 + 1013904223;
+	return seed >> 8;
+}
+
+// The plain sample by sample version, which the SIMD paths must match exactly.
+static u32 ResampleReference(int *out, const int16_t *src, u32 sampleFrac, int pitch, int count) {
+	for (int i = 0; i < count; i++) {
+		const int16_t *s = src + (sampleFrac >> PSP_SAS_PITCH_BASE_SHIFT);
+		int f = sampleFrac & PSP_SAS_PITCH_MASK;
+		out[i] = (s[0] * (PSP_SAS_PITCH_MASK - f) + s[1] * f) >> PSP_SAS_PITCH_BASE_SHIFT;
+		sampleFrac += pitch;
+	}
+	return sampleFrac;
+}
+
+static bool TestResampleVoice() {
+	// The whole steps have their own paths, the rest are there to check the general one.
+	static const int pitches[] = { 0x1000, 0x2000, 0x4000, 0x0800, 0x0FFF, 0x1001, 0x1234, 0x3FFF };
+
+	uint32_t seed = 0x5A5;
+	std::vector<int16_t> src(RESAMPLE_SOURCE);
+	for (size_t i = 0; i < src.size(); ++i) {
+		// Include the extremes, since the products are summed in 32 bits.
+		src[i] = (i & 15) == 0 ? (i & 16 ? -32768 : 32767) : (int16_t)NextRandom(seed);
+	}
+
+	std::vector<int> out(PSP_SAS_MAX_GRAIN);
+	std::vector<int> expected(PSP_SAS_MAX_GRAIN);
+	for (int pitch : pitches) {
+		for (int trial = 0; trial < 64; ++trial) {
+			// Odd counts leave a tail for the scalar loop after the SIMD part.
+			int count = trial < 16 ? trial + 1 : 1 + NextRandom(seed) % PSP_SAS_MAX_GRAIN;
+			if (pitch > PSP_SAS_PITCH_BASE)
+				count = std::min(count, PSP_SAS_MAX_GRAIN * PSP_SAS_PITCH_BASE / pitch);
+			const u32 sampleFrac = NextRandom(seed) & (PSP_SAS_PITCH_BASE * 4 - 1);
+
+			const u32 frac = ResampleVoice(&out[0], &src[0], sampleFrac, pitch, count);
+			const u32 expectedFrac = ResampleReference(&expected[0], &src[0], sampleFrac, pitch, count);
+			if (frac != expectedFrac) {
+				printf("ResampleVoice: pitch %04x count %d frac %08x, expected %08x\n", pitch, count, frac, expectedFrac);
+				return false;
+			}
+			for (int i = 0; i < count; ++i) {
+				if (out[i] != expected[i]) {
+					printf("ResampleVoice: pitch %04x count %d sample %d: %d, expected %d\n", pitch, count, i, out[i], expected[i]);
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+static int RandomRate(uint32_t &seed) {
+	switch (NextRandom(seed) % 4) {
+	case 0: return 0;
+	case 1: return 1 + NextRandom(seed) % 0x100;
+	case 2: return 0x7FFFFFFF;
+	default: return 1 << (10 + NextRandom(seed) % 20);
+	}
+}
+
+static bool TestEnvelopeBlocks() {
+	uint32_t seed = 0xAD5;
+	std::vector<int> block(PSP_SAS_MAX_GRAIN);
+	for (int trial = 0; trial < 400; ++trial) {
+		ADSREnvelope blocked;
+		if (trial & 1) {
+			blocked.SetSimpleEnvelope(NextRandom(seed) & 0xFFFF, NextRandom(seed) & 0xFFFF);
+		} else {
+			// Anything goes, so the linear phases get to end in every way.
+			blocked.attackType = NextRandom(seed) % 6;
+			blocked.decayType = NextRandom(seed) % 6;
+			blocked.sustainType = NextRandom(seed) % 6;
+			blocked.releaseType = NextRandom(seed) % 6;
+			blocked.attackRate = RandomRate(seed);
+			blocked.decayRate = RandomRate(seed);
+			blocked.sustainRate = RandomRate(seed);
+			blocked.releaseRate = RandomRate(seed);
+			blocked.sustainLevel = ((NextRandom(seed) & 0xF) + 1) << 26;
+		}
+		ADSREnvelope stepped = blocked;
+		blocked.KeyOn();
+		stepped.KeyOn();
+
+		const int keyOffAt = NextRandom(seed) % ENVELOPE_SAMPLES;
+		bool keyedOff = false;
+		for (int pos = 0; pos < ENVELOPE_SAMPLES; ) {
+			if (!keyedOff && pos >= keyOffAt) {
+				blocked.KeyOff();
+				stepped.KeyOff();
+				keyedOff = true;
+			}
+
+			const int count = 1 + NextRandom(seed) % PSP_SAS_MAX_GRAIN;
+			blocked.StepBlock(&block[0], count);
+			for (int i = 0; i < count; ++i) {
+				const int expected = (stepped.GetHeight() + (1 << 14)) >> 15;
+				stepped.Step();
+				if (block[i] != expected) {
+					printf("ADSREnvelope: trial %d sample %d: %d, expected %d\n", trial, pos + i, block[i], expected);
+					return false;
+				}
+			}
+			if (blocked.GetHeight() != stepped.GetHeight() || blocked.HasEnded() != stepped.HasEnded()) {
+				printf("ADSREnvelope: trial %d state differs after sample %d\n", trial, pos + count);
+				return false;
+			}
+			pos += count;
+		}
+	}
+	return true;
+}
+
+// The plain block by block decoder, which decoding from the VAG cache must match exactly.
+struct ReferenceVag {
+	void Start(u32 data, u32 vagSize, bool loopEnabled) {
+		data_ = data;
+		read_ = data;
+		numBlocks_ = vagSize / 16;
+		curBlock_ = -1;
+		loopStartBlock_ = -1;
+		curSample_ = 28;
+		s1_ = 0;
+		s2_ = 0;
+		loopEnabled_ = loopEnabled;
+		loopAtNextBlock_ = false;
+		end_ = false;
+	}
+
+	void DecodeBlock() {
+		const u8 *readp = Memory::GetPointer(read_);
+		const int predict = readp[0] >> 4;
+		const int shift = readp[0] & 0xF;
+		const int flags = readp[1];
+		if (flags == 7) {
+			end_ = true;
+			return;
+		} else if (flags == 6) {
+			loopStartBlock_ = curBlock_;
+		} else if (flags == 3 && loopEnabled_) {
+			loopAtNextBlock_ = true;
+		}
+
+		static const int coefs[5][2] = { { 0, 0 }, { 60, 0 }, { 115, -52 }, { 98, -55 }, { 122, -60 } };
+		for (int i = 0; i < 28; ++i) {
+			const u8 d = readp[2 + i / 2];
+			const int nibble = (short)((i & 1 ? d & 0xF0 : d << 4) << 8) >> shift;
+			const int s = clamp_s16(nibble + ((s1_ * coefs[predict][0] + s2_ * coefs[predict][1]) >> 6));
+			s2_ = s1_;
+			s1_ = s;
+			samples_[i] = s;
+		}
+		read_ += 16;
+		curSample_ = 0;
+		if (++curBlock_ == numBlocks_)
+			end_ = true;
+	}
+
+	void GetSamples(s16 *out, int count) {
+		for (int i = 0; i < count; ++i) {
+			if (!end_ && curSample_ == 28) {
+				if (loopAtNextBlock_) {
+					read_ = data_ + 16 * loopStartBlock_ + 16;
+					curBlock_ = loopStartBlock_;
+					loopAtNextBlock_ = false;
+				}
+				DecodeBlock();
+			}
+			out[i] = end_ ? 0 : samples_[curSample_++];
+		}
+	}
+
+	s16 samples_[28];
+	int curSample_;
+	u32 data_;
+	u32 read_;
+	int numBlocks_;
+	int curBlock_;
+	int loopStartBlock_;
+	int s1_;
+	int s2_;
+	bool loopEnabled_;
+	bool loopAtNextBlock_;
+	bool end_;
+};
+
+// Mostly plain blocks, with the odd loop start, loop end or ending block thrown in.
+static void WriteRandomVag(u32 addr, int numBlocks, uint32_t &seed) {
+	u8 *p = Memory::GetPointer(addr);
+	for (int b = 0; b < numBlocks + 1; ++b, p += 16) {
+		p[0] = (u8)(((NextRandom(seed) % 5) << 4) | (NextRandom(seed) % 13));
+		const uint32_t kind = NextRandom(seed) % 1024;
+		p[1] = kind < 4 ? 6 : (kind < 6 ? 3 : (kind < 7 ? 7 : 0));
+		for (int i = 2; i < 16; ++i)
+			p[i] = (u8)NextRandom(seed);
+	}
+}
+
+// Plays the same sound through the cache and through the reference, in random sized pieces.
+static bool CompareVagDecode(const char *what, u32 addr, u32 vagSize, bool loop, uint32_t &seed) {
+	VagDecoder decoder;
+	ReferenceVag reference;
+	decoder.Start(addr, vagSize, loop);
+	reference.Start(addr, vagSize, loop);
+
+	s16 out[600];
+	s16 expected[600];
+	// Long enough to go around a loop a couple of times, or to play out past the end.
+	const int total = (vagSize / 16) * 28 * 3 + 1000;
+	for (int pos = 0; pos < total; ) {
+		const int count = 1 + NextRandom(seed) % ARRAY_SIZE(out);
+		decoder.GetSamples(out, count);
+		reference.GetSamples(expected, count);
+		for (int i = 0; i < count; ++i) {
+			if (out[i] != expected[i]) {
+				printf("VagDecoder: %s, %d blocks%s, sample %d: %d, expected %d\n", what, vagSize / 16, loop ? " looped" : "", pos + i, out[i], expected[i]);
+				return false;
+			}
+		}
+		if (decoder.End() != reference.end_) {
+			printf("VagDecoder: %s, %d blocks%s, end differs after sample %d\n", what, vagSize / 16, loop ? " looped" : "", pos + count);
+			return false;
+		}
+		pos += count;
+	}
+	return true;
+}
+
+static bool TestVagCache() {
+	currentMIPS = &mipsr4k;
+	Memory::g_MemorySize = Memory::RAM_NORMAL_SIZE;
+	Memory::Init();
+	VagCache_Clear();
+
+	uint32_t seed = 0x7A6;
+	bool success = true;
+	for (int trial = 0; trial < 200 && success; ++trial) {
+		// Some go past what gets cached, so the rest has to be decoded from memory.
+		const int numBlocks = trial % 10 == 0 ? 4000 + NextRandom(seed) % 300 : 1 + NextRandom(seed) % 300;
+		const u32 addr = MIX_SOURCE_ADDR + (NextRandom(seed) % 256) * 16;
+		const bool loop = (trial & 1) != 0;
+		WriteRandomVag(addr, numBlocks, seed);
+
+		// The first one fills the cache, the second one plays from it.
+		success = CompareVagDecode("first play", addr, numBlocks * 16, loop, seed) && CompareVagDecode("cached", addr, numBlocks * 16, loop, seed);
+		if (success) {
+			// Changed behind our back, without any dcache call to tell us.
+			Memory::GetPointer(addr)[16 * (NextRandom(seed) % std::min(numBlocks, 4096)) + 2 + NextRandom(seed) % 14] ^= 0x11;
+			success = CompareVagDecode("changed", addr, numBlocks * 16, loop, seed);
+		}
+	}
+
+	VagCache_Clear();
+	Memory::Shutdown();
+	currentMIPS = nullptr;
+	return success;
+}
+
+static void SetupRandomVoice(SasVoice &voice, uint32_t &seed) {
+	static const int pitches[] = { 0x1000, 0x2000, 0x4000, 0x0800, 0x1234, 0x3FFF };
+
+	voice.type = NextRandom(seed) & 1 ? VOICETYPE_PCM : VOICETYPE_VAG;
+	voice.pcmAddr = MIX_SOURCE_ADDR + (NextRandom(seed) % (MIX_SOURCE_SIZE / 4)) * 2;
+	voice.pcmSize = 1 + NextRandom(seed) % 4000;
+	voice.pcmLoopPos = NextRandom(seed) % voice.pcmSize;
+	voice.vagAddr = MIX_SOURCE_ADDR + (NextRandom(seed) % (MIX_SOURCE_SIZE / 32)) * 16;
+	voice.vagSize = 16 * (1 + NextRandom(seed) % 300);
+	voice.loop = (NextRandom(seed) & 1) != 0;
+	voice.pitch = NextRandom(seed) & 1 ? pitches[NextRandom(seed) % ARRAY_SIZE(pitches)] : NextRandom(seed) % (PSP_SAS_PITCH_MAX + 1);
+	voice.volumeLeft = (int)(NextRandom(seed) % 0x2001) - 0x1000;
+	voice.volumeRight = (int)(NextRandom(seed) % 0x2001) - 0x1000;
+	voice.effectLeft = (int)(NextRandom(seed) % 0x2001) - 0x1000;
+	voice.effectRight = (int)(NextRandom(seed) % 0x2001) - 0x1000;
+	voice.envelope.SetSimpleEnvelope(NextRandom(seed) & 0xFFFF, NextRandom(seed) & 0xFFFF);
+	if (NextRandom(seed) % 4 != 0)
+		voice.KeyOn();
+}
+
+// Hashes the output and the voices after each grain, so any difference shows up.
+static uint32_t RunMix(bool parallel, uint32_t seed) {
+	static const int grains[] = { 64, 256, 100, 2048, 7 };
+
+	g_Config.bParallelSASVoices = parallel;
+	uint32_t hash = 2166136261U;
+	for (int round = 0; round < 20; ++round) {
+		SasInstance *sas = new SasInstance();
+		const int grain = grains[round % ARRAY_SIZE(grains)];
+		sas->SetGrainSize(grain);
+		// Raw output has the effect send too, without any reverb to mask it.
+		sas->outputMode = round & 1 ? PSP_SAS_OUTPUTMODE_RAW : PSP_SAS_OUTPUTMODE_MIXED;
+		const int outputSamples = sas->outputMode == PSP_SAS_OUTPUTMODE_RAW ? grain * 4 : grain * 2;
+		for (int v = 0; v < PSP_SAS_VOICES_MAX; ++v)
+			SetupRandomVoice(sas->voices[v], seed);
+
+		for (int step = 0; step < 30; ++step) {
+			for (int v = 0; v < PSP_SAS_VOICES_MAX; ++v) {
+				SasVoice &voice = sas->voices[v];
+				if (NextRandom(seed) % 16 == 0)
+					voice.KeyOff();
+				if (NextRandom(seed) % 32 == 0)
+					voice.KeyOn();
+				if (NextRandom(seed) % 64 == 0)
+					voice.paused = !voice.paused;
+			}
+
+			sas->Mix(MIX_OUTPUT_ADDR);
+			const s16 *out = (const s16 *)Memory::GetPointer(MIX_OUTPUT_ADDR);
+			for (int i = 0; i < outputSamples; ++i)
+				hash = (hash ^ (u16)out[i]) * 16777619;
+			for (int v = 0; v < PSP_SAS_VOICES_MAX; ++v) {
+				const SasVoice &voice = sas->voices[v];
+				hash = (hash ^ voice.envelope.GetHeight() ^ voice.sampleFrac ^ voice.playing) * 16777619;
+			}
+		}
+		delete sas;
+	}
+	return hash;
+}
+
+static bool TestParallelMix() {
+	const bool wasParallel = g_Config.bParallelSASVoices;
+	const int wasThreads = g_Config.iNumWorkerThreads;
+	currentMIPS = &mipsr4k;
+	Memory::g_MemorySize = Memory::RAM_NORMAL_SIZE;
+	Memory::Init();
+
+	uint32_t seed = 0x5A5;
+	u8 *source = Memory::GetPointer(MIX_SOURCE_ADDR);
+	for (u32 i = 0; i < MIX_SOURCE_SIZE; ++i)
+		source[i] = (u8)NextRandom(seed);
+
+	// The slices are summed in voice order, so any number of threads must match exactly.
+	bool success = true;
+	const uint32_t expected = RunMix(false, 0x1234);
+	for (int threads = 1; threads <= 8 && success; threads *= 2) {
+		g_Config.iNumWorkerThreads = threads;
+		const uint32_t hash = RunMix(true, 0x1234);
+		if (hash != expected) {
+			printf("SasInstance: mixing on %d threads gave %08x, expected %08x\n", threads, hash, expected);
+			success = false;
+		}
+	}
+
+	VagCache_Clear();
+	Memory::Shutdown();
+	currentMIPS = nullptr;
+	g_Config.bParallelSASVoices = wasParallel;
+	g_Config.iNumWorkerThreads = wasThreads;
+	return success;
+}
+
+bool TestSasAudio() {
+	if (!TestResampleVoice())
+		return false;
+	if (!TestEnvelopeBlocks())
+		return false;
+	if (!TestVagCache())
+		return false;
+	if (!TestParallelMix())
+		return false;
+	return true;
+}
@@ -0,0 +1,158 @@
+// Copyright (c) 2018- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <cstdio>
+#include <string>
+#include "Common/Common.h"
+#include "GPU/ge_constants.h"
+#include "GPU/GPUState.h"
+#include "GPU/Software/Sampler.h"
+#include "unittest/TestSoftwareGPUJit.h"
+#include "unittest/UnitTest.h"
+
+extern u32 clut[4096];
+
+// The jitted samplers must produce exactly what the C++ sampler does, for every format and option.
+class SamplerJitTestHarness {
+	static const int TEX_SIZE = 64;
+	static const int SAMPLES = 256;
+
+public:
+	SamplerJitTestHarness() : seed_(0x12345678), jitted_(0) {
+		// Largest case is 64x64 at 32 bits, but DXT reads a bit past a small bufw.
+		tex_ = new u8[TEX_SIZE * TEX_SIZE * 4 * 2];
+		cache_ = new Sampler::SamplerJitCache();
+	}
+	~SamplerJitTestHarness() {
+		delete [] tex_;
+		delete cache_;
+	}
+
+	// Returns false on a mismatch.  Formats the jit doesn't handle are skipped.
+	bool Test(GETextureFormat fmt, GEPaletteFormat clutfmt, bool swizzle, int clutOptions, bool mipClut, bool invalidPtr) {
+		for (int i = 0; i < TEX_SIZE * TEX_SIZE * 4 * 2; ++i) {
+			tex_[i] = (u8)Rand();
+		}
+		for (int i = 0; i < 4096; ++i) {
+			clut[i] = Rand();
+		}
+
+		gstate.texformat = (GE_CMD_TEXFORMAT << 24) | fmt;
+		gstate.texmode = (GE_CMD_TEXMODE << 24) | (swizzle ? 1 : 0) | (mipClut ? 0x100 | (7 << 16) : 0);
+		gstate.texfilter = (GE_CMD_TEXFILTER << 24) | (mipClut ? 4 : 0);
+		u32 clutformat = clutfmt | 0xFF00;
+		if (clutOptions & 1) {
+			clutformat = (clutformat & ~0xFF00) | ((Rand() & 0xFF) << 8);
+		}
+		if (clutOptions & 2) {
+			clutformat |= (1 + Rand() % 31) << 2;
+		}
+		if (clutOptions & 4) {
+			clutformat |= (1 + Rand() % 31) << 16;
+		}
+		gstate.clutformat = (GE_CMD_CLUTFORMAT << 24) | clutformat;
+		for (int i = 0; i < 8; ++i) {
+			gstate.texaddr[i] = ((GE_CMD_TEXADDR0 + i) << 24) | (invalidPtr ? 0 : 0x100000);
+			gstate.texbufwidth[i] = ((GE_CMD_TEXBUFWIDTH0 + i) << 24) | TEX_SIZE;
+		}
+
+		const u8 *src = invalidPtr ? nullptr : tex_;
+		SamplerID id;
+		cache_->ComputeSamplerID(&id, false);
+		Sampler::NearestFunc nearest = cache_->GetNearest(id);
+		if (nearest) {
+			for (int i = 0; i < SAMPLES; ++i) {
+				int u = Rand() % TEX_SIZE;
+				int v = Rand() % TEX_SIZE;
+				int level = mipClut ? Rand() % 8 : 0;
+				u32 expected = Sampler::SampleNearest(u, v, src, TEX_SIZE, level);
+				u32 result = nearest(u, v, src, TEX_SIZE, level);
+				if (result != expected) {
+					printf("%s: nearest %d,%d level %d: %08x != expected %08x\n", cache_->DescribeSamplerID(id).c_str(), u, v, level, result, expected);
+					return false;
+				}
+			}
+		}
+
+		cache_->ComputeSamplerID(&id, true);
+		Sampler::LinearFunc linear = cache_->GetLinear(id);
+		if (linear) {
+			for (int i = 0; i < SAMPLES; ++i) {
+				int u[4], v[4];
+				for (int j = 0; j < 4; ++j) {
+					u[j] = Rand() % TEX_SIZE;
+					v[j] = Rand() % TEX_SIZE;
+				}
+				int frac_u = Rand() & 0xFF;
+				int frac_v = Rand() & 0xFF;
+				int level = mipClut ? Rand() % 8 : 0;
+				u32 expected = Sampler::SampleLinear(u, v, frac_u, frac_v, src, TEX_SIZE, level);
+				u32 result = linear(u, v, frac_u, frac_v, src, TEX_SIZE, level);
+				if (result != expected) {
+					printf("%s: linear %d,%d frac %d,%d level %d: %08x != expected %08x\n", cache_->DescribeSamplerID(id).c_str(), u[0], v[0], frac_u, frac_v, level, result, expected);
+					return false;
+				}
+			}
+		}
+
+		if (nearest || linear) {
+			++jitted_;
+		}
+		return true;
+	}
+
+	int Jitted() const {
+		return jitted_;
+	}
+
+private:
+	u32 Rand() {
+		seed_ = seed_ * 1103515245 + 12345;
+		return (seed_ >> 16) | (seed_ << 16);
+	}
+
+	u32 seed_;
+	u8 *tex_;
+	Sampler::SamplerJitCache *cache_;
+	int jitted_;
+};
+
+bool TestSoftwareGPUJit() {
+	SamplerJitTestHarness harness;
+	bool pass = true;
+
+	for (int fmt = GE_TFMT_5650; fmt <= GE_TFMT_DXT5; ++fmt) {
+		bool indexed = fmt >= GE_TFMT_CLUT4 && fmt <= GE_TFMT_CLUT32;
+		for (int clutfmt = 0; clutfmt < (indexed ? 4 : 1); ++clutfmt) {
+			for (int clutOptions = 0; clutOptions < (indexed ? 8 : 1); ++clutOptions) {
+				for (int swizzle = 0; swizzle < 2; ++swizzle) {
+					for (int mipClut = 0; mipClut < (fmt == GE_TFMT_CLUT4 ? 2 : 1); ++mipClut) {
+						if (!harness.Test((GETextureFormat)fmt, (GEPaletteFormat)clutfmt, swizzle != 0, clutOptions, mipClut != 0, false)) {
+							pass = false;
+						}
+					}
+				}
+			}
+		}
+		if (!harness.Test((GETextureFormat)fmt, GE_CMODE_16BIT_BGR5650, false, 0, false, true)) {
+			pass = false;
+		}
+	}
+
+	printf("Sampler jit checked %d configurations.\n", harness.Jitted());
+	return pass;
+}
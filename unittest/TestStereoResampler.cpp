@@ -0,0 +1,169 @@
+// Copyright (c) 2018- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include "base/timeutil.h"
+#include "Common/CommonTypes.h"
+#include "Core/Config.h"
+#include "Core/HLE/__sceAudio.h"
+#include "Core/HW/StereoResampler.h"
+#include "unittest/UnitTest.h"
+
+// One 60 Hz frame of audio at each rate, the way the emulator pushes and a typical host pulls.
+static const int PUSH_FRAMES = 735;
+static const int MIX_FRAMES = 800;
+static const int OUTPUT_RATE = 48000;
+static const double TONE_HZ = 10000.0;
+static const double AMPLITUDE = 16000.0;
+
+struct ToneSource {
+	s32 buffer[PUSH_FRAMES * 2];
+	double phase = 0.0;
+
+	void Push(StereoResampler &resampler) {
+		for (int i = 0; i < PUSH_FRAMES; ++i) {
+			const s32 s = (s32)floor(AMPLITUDE * sin(phase) + 0.5);
+			buffer[i * 2] = s;
+			buffer[i * 2 + 1] = -s;
+			phase += 2.0 * 3.14159265358979323846 * TONE_HZ / 44100.0;
+		}
+		resampler.PushSamples(buffer, PUSH_FRAMES);
+	}
+};
+
+// For a pure tone, y[n - 1] + y[n + 1] = k y[n] for some k, whatever the phase or amplitude.
+// Fitting k per block soaks up the drift control's pitch bending, leaving noise and images.
+static double ToneResidual(const s16 *samples, int frames, int channel) {
+	double yy = 0.0;
+	double ny = 0.0;
+	for (int i = 1; i < frames - 1; ++i) {
+		const double y = samples[i * 2 + channel];
+		yy += y * y;
+		ny += (samples[(i - 1) * 2 + channel] + samples[(i + 1) * 2 + channel]) * y;
+	}
+	const double k = ny / yy;
+	double sum = 0.0;
+	for (int i = 1; i < frames - 1; ++i) {
+		const double r = samples[(i - 1) * 2 + channel] + samples[(i + 1) * 2 + channel] - k * samples[i * 2 + channel];
+		sum += r * r;
+	}
+	return sqrt(sum / (frames - 2)) / AMPLITUDE;
+}
+
+static bool TestSteadyTone(StereoResampler &resampler, ToneSource &tone) {
+	s16 out[MIX_FRAMES * 2];
+	AudioDebugStats stats;
+	memset(&stats, 0, sizeof(stats));
+
+	// Let it settle from empty, then it should run clean and have lowered the latency.
+	for (int n = 0; n < 60 * 20; ++n) {
+		tone.Push(resampler);
+		resampler.Mix(out, MIX_FRAMES, false, OUTPUT_RATE);
+	}
+	resampler.GetAudioDebugStats(&stats);
+	const int settledWatermark = stats.watermark;
+
+	memset(&stats, 0, sizeof(stats));
+	double worst = 0.0;
+	double st = real_time_now();
+	for (int n = 0; n < 60 * 10; ++n) {
+		tone.Push(resampler);
+		if (resampler.Mix(out, MIX_FRAMES, false, OUTPUT_RATE) != MIX_FRAMES) {
+			printf("Short mix at %d\n", n);
+			return false;
+		}
+		for (int c = 0; c < 2; ++c) {
+			double residual = ToneResidual(out, MIX_FRAMES, c);
+			if (residual > worst)
+				worst = residual;
+		}
+	}
+	double elapsed = real_time_now() - st;
+	resampler.GetAudioDebugStats(&stats);
+
+	printf("StereoResampler: watermark %d (%d ms latency), residual %f, %.1f M frames/s\n", stats.watermark, stats.latencyMs, worst, 60 * 10 * MIX_FRAMES / elapsed / 1000000.0);
+	if (stats.underrunCount != 0 || stats.overrunCount != 0) {
+		printf("Steady tone: %d underruns, %d overruns\n", stats.underrunCount, stats.overrunCount);
+		return false;
+	}
+	// Straight linear interpolation comes out around 0.06 here, mostly from images.
+	if (worst > 0.005) {
+		printf("Steady tone: residual %f too high\n", worst);
+		return false;
+	}
+	// Pushes and pulls line up perfectly, so it should get well under the old fixed 1680.
+	if (settledWatermark > 1024 || stats.watermark > 1024) {
+		printf("Steady tone: watermark didn't come down (%d, %d)\n", settledWatermark, stats.watermark);
+		return false;
+	}
+	return true;
+}
+
+static bool TestJitter(StereoResampler &resampler, ToneSource &tone) {
+	s16 out[MIX_FRAMES * 2];
+	AudioDebugStats stats;
+	memset(&stats, 0, sizeof(stats));
+	resampler.GetAudioDebugStats(&stats);
+	const int before = stats.watermark;
+
+	// Every fourth frame, the host is a frame late and catches up with two.
+	for (int n = 0; n < 60 * 10; ++n) {
+		if ((n & 3) != 3)
+			tone.Push(resampler);
+		if ((n & 3) == 0)
+			tone.Push(resampler);
+		resampler.Mix(out, MIX_FRAMES, false, OUTPUT_RATE);
+	}
+
+	// That makes the buffer dip most of a frame below its average.
+	memset(&stats, 0, sizeof(stats));
+	resampler.GetAudioDebugStats(&stats);
+	if (stats.watermark < before + PUSH_FRAMES / 2) {
+		printf("Jitter: watermark only went from %d to %d\n", before, stats.watermark);
+		return false;
+	}
+	// Having adapted, it shouldn't keep underrunning.
+	memset(&stats, 0, sizeof(stats));
+	for (int n = 0; n < 60 * 10; ++n) {
+		if ((n & 3) != 3)
+			tone.Push(resampler);
+		if ((n & 3) == 0)
+			tone.Push(resampler);
+		resampler.Mix(out, MIX_FRAMES, false, OUTPUT_RATE);
+	}
+	resampler.GetAudioDebugStats(&stats);
+	if (stats.underrunCount != 0) {
+		printf("Jitter: still %d underruns at watermark %d\n", stats.underrunCount, stats.watermark);
+		return false;
+	}
+	return true;
+}
+
+bool TestStereoResampler() {
+	g_Config.iGlobalVolume = VOLUME_MAX;
+	g_Config.bAudioResampler = true;
+	g_Config.bExtraAudioBuffering = false;
+
+	StereoResampler resampler;
+	ToneSource tone;
+	if (!TestSteadyTone(resampler, tone))
+		return false;
+	return TestJitter(resampler, tone);
+}
@@ -0,0 +1,156 @@
+// Copyright (c) 2018- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <cstdio>
+#include <unordered_set>
+#include <vector>
+
+#include "GPU/Common/SplineCommon.h"
+#include "GPU/ge_constants.h"
+#include "unittest/UnitTest.h"
+
+static const int POINT_COUNT = 64;
+static const int INDEX_COUNT = 16;
+
+static u32 NextRandom(u32 &seed) {
+	seed = seed * 1664525 + 1013904223;
+	return seed >> 8;
+}
+
+static void RandomPoints(std::vector<SimpleVertex> &points, u32 &seed) {
+	points.resize(POINT_COUNT);
+	for (SimpleVertex &v : points) {
+		v.uv[0] = (float)(NextRandom(seed) & 0xFFFF);
+		v.uv[1] = (float)(NextRandom(seed) & 0xFFFF);
+		v.color_32 = NextRandom(seed);
+		v.nrm = Vec3Packedf(0.0f, 0.0f, 1.0f);
+		v.pos = Vec3Packedf((float)(NextRandom(seed) & 0xFFF), (float)(NextRandom(seed) & 0xFFF), (float)(NextRandom(seed) & 0xFFF));
+	}
+}
+
+static bool TestPointsHash() {
+	u32 seed = 0x7E55;
+	std::vector<SimpleVertex> points;
+	RandomPoints(points, seed);
+	std::vector<u16> indices(INDEX_COUNT + 4);
+	for (u16 &i : indices)
+		i = 8 + NextRandom(seed) % 32;
+
+	const u32 vertType = GE_VTYPE_IDX_16BIT;
+	const u64 base = ComputeTessPointsHash(&points[0], 8, 39, &indices[0], INDEX_COUNT, vertType);
+	if (base != ComputeTessPointsHash(&points[0], 8, 39, &indices[0], INDEX_COUNT, vertType)) {
+		printf("TessCache: hash isn't stable\n");
+		return false;
+	}
+
+	// Only the points between the bounds and the indices up to the count are used.
+	std::vector<SimpleVertex> outside = points;
+	outside[7].pos.x += 1.0f;
+	outside[40].color_32 ^= 1;
+	std::vector<u16> extra = indices;
+	extra[INDEX_COUNT] ^= 1;
+	if (ComputeTessPointsHash(&outside[0], 8, 39, &extra[0], INDEX_COUNT, vertType) != base) {
+		printf("TessCache: unused data changed the hash\n");
+		return false;
+	}
+
+	std::vector<SimpleVertex> inside = points;
+	inside[39].pos.z += 1.0f;
+	if (ComputeTessPointsHash(&inside[0], 8, 39, &indices[0], INDEX_COUNT, vertType) == base) {
+		printf("TessCache: changed point kept the hash\n");
+		return false;
+	}
+
+	// The same points in another order make a different patch.
+	std::vector<u16> swapped = indices;
+	std::swap(swapped[0], swapped[1]);
+	if (swapped[0] != swapped[1] && ComputeTessPointsHash(&points[0], 8, 39, &swapped[0], INDEX_COUNT, vertType) == base) {
+		printf("TessCache: reordered indices kept the hash\n");
+		return false;
+	}
+	if (ComputeTessPointsHash(&points[0], 8, 39, &indices[0], INDEX_COUNT, GE_VTYPE_IDX_8BIT) == base) {
+		printf("TessCache: index size didn't change the hash\n");
+		return false;
+	}
+	if (ComputeTessPointsHash(&points[0], 8, 39, nullptr, INDEX_COUNT, 0) == base) {
+		printf("TessCache: indices didn't change the hash\n");
+		return false;
+	}
+
+	// The hash is the whole key, so it must use all 64 bits and not collide on similar patches.
+	std::unordered_set<u64> seen;
+	std::unordered_set<u32> seenHigh;
+	for (int i = 0; i < 20000; ++i) {
+		points[8 + i % 32].pos.x = (float)i;
+		const u64 hash = ComputeTessPointsHash(&points[0], 8, 39, nullptr, 0, 0);
+		if (!seen.insert(hash).second) {
+			printf("TessCache: collision after %d patches\n", i);
+			return false;
+		}
+		seenHigh.insert((u32)(hash >> 32));
+	}
+	if (seenHigh.size() < 19000) {
+		printf("TessCache: only %d different upper halves\n", (int)seenHigh.size());
+		return false;
+	}
+	return true;
+}
+
+static bool TestKey() {
+	TessCacheKey a{};
+	a.pointsHash = 0x0123456789ABCDEFULL;
+	a.vertType = GE_VTYPE_IDX_16BIT | GE_VTYPE_POS_FLOAT;
+	a.tess_u = 4;
+	a.tess_v = 4;
+	a.count_u = 4;
+	a.count_v = 4;
+	a.primType = GE_PATCHPRIM_TRIANGLES;
+
+	TessCacheKey b = a;
+	if (!(a == b) || std::hash<TessCacheKey>()(a) != std::hash<TessCacheKey>()(b)) {
+		printf("TessCache: equal keys differ\n");
+		return false;
+	}
+
+	// Points differing only in the upper half of the hash are different points.
+	b.pointsHash ^= 1ULL << 40;
+	if (a == b) {
+		printf("TessCache: keys with different points are equal\n");
+		return false;
+	}
+	b = a;
+	b.quality = 1;
+	if (a == b) {
+		printf("TessCache: keys with different quality are equal\n");
+		return false;
+	}
+	b = a;
+	b.spline = true;
+	if (a == b) {
+		printf("TessCache: spline and bezier keys are equal\n");
+		return false;
+	}
+	return true;
+}
+
+bool TestTessCache() {
+	if (!TestPointsHash())
+		return false;
+	if (!TestKey())
+		return false;
+	return true;
+}
@@ -0,0 +1,238 @@
+// Copyright (c) 2018- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "base/timeutil.h"
+#include "Common/ColorConv.h"
+#include "Common/CommonTypes.h"
+#include "unittest/UnitTest.h"
+
+#ifdef USE_FFMPEG
+extern "C" {
+#include "libswscale/swscale.h"
+}
+#endif
+
+// Wide enough for the SIMD paths and the tails, and odd like some videos after cropping.
+static const int WIDTH = 483;
+static const int HEIGHT = 67;
+
+static uint32_t NextRandom(uint32_t &seed) {
+	seed = seed * 1664525 + 1013904223;
+	return seed >> 8;
+}
+
+static int FloatToRGB(float f) {
+	int c = (int)floorf(f + 0.5f);
+	return c < 0 ? 0 : (c > 255 ? 255 : c);
+}
+
+// Textbook BT.601 at MPEG range, what the fixed point should be within 1 of.
+static void ReferenceYUVToRGB(int y, int u, int v, int rgb[3]) {
+	const float yf = 1.164383f * (y - 16);
+	rgb[0] = FloatToRGB(yf + 1.596027f * (v - 128));
+	rgb[1] = FloatToRGB(yf - 0.391762f * (u - 128) - 0.812968f * (v - 128));
+	rgb[2] = FloatToRGB(yf + 2.017232f * (u - 128));
+}
+
+static bool ChannelsNear(u32 px, const int rgb[3], int tolerance) {
+	for (int c = 0; c < 3; ++c) {
+		if (abs((int)((px >> (c * 8)) & 0xFF) - rgb[c]) > tolerance)
+			return false;
+	}
+	return (px >> 24) == 0;
+}
+
+// Every YUV combination, a row of Y at a time.
+static bool TestAllColors() {
+	u8 y[256];
+	u8 u[128];
+	u8 v[128];
+	u32 dst[256];
+	for (int i = 0; i < 256; ++i)
+		y[i] = i;
+
+	for (int uc = 0; uc < 256; ++uc) {
+		memset(u, uc, sizeof(u));
+		for (int vc = 0; vc < 256; ++vc) {
+			memset(v, vc, sizeof(v));
+			ConvertYUV420ToRGBA8888(dst, y, u, v, 0, 256);
+			for (int i = 0; i < 256; ++i) {
+				int rgb[3];
+				ReferenceYUVToRGB(i, uc, vc, rgb);
+				if (!ChannelsNear(dst[i], rgb, 1)) {
+					printf("YUV %d,%d,%d: got %08x, expected %02x%02x%02x\n", i, uc, vc, dst[i], rgb[2], rgb[1], rgb[0]);
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+static u16 Pack16(u32 px, int rbits, int gbits, int bbits) {
+	const int r = (px >> 0) & 0xFF;
+	const int g = (px >> 8) & 0xFF;
+	const int b = (px >> 16) & 0xFF;
+	return (r >> (8 - rbits)) | ((g >> (8 - gbits)) << rbits) | ((b >> (8 - bbits)) << (rbits + gbits));
+}
+
+// Pieces of a row at any offset (which moves what goes through SIMD) must match the whole row,
+// and the 16-bit formats must match the 32-bit one with the low bits dropped.
+static bool TestRowPieces(const u8 *y, const u8 *u, const u8 *v, uint32_t &seed) {
+	u32 whole[WIDTH];
+	u32 piece32[WIDTH];
+	u16 piece16[WIDTH];
+	ConvertYUV420ToRGBA8888(whole, y, u, v, 0, WIDTH);
+
+	for (int n = 0; n < 200; ++n) {
+		u32 x = NextRandom(seed) % WIDTH;
+		u32 count = NextRandom(seed) % (WIDTH - x + 1);
+
+		ConvertYUV420ToRGBA8888(piece32, y, u, v, x, count);
+		for (u32 i = 0; i < count; ++i) {
+			if (piece32[i] != whole[x + i]) {
+				printf("RGBA8888 at %d (from %d): %08x != %08x\n", x + i, x, piece32[i], whole[x + i]);
+				return false;
+			}
+		}
+
+		ConvertYUV420ToRGB565(piece16, y, u, v, x, count);
+		for (u32 i = 0; i < count; ++i) {
+			if (piece16[i] != Pack16(whole[x + i], 5, 6, 5)) {
+				printf("RGB565 at %d (from %d): %04x != %04x\n", x + i, x, piece16[i], Pack16(whole[x + i], 5, 6, 5));
+				return false;
+			}
+		}
+
+		ConvertYUV420ToRGBA5551(piece16, y, u, v, x, count);
+		for (u32 i = 0; i < count; ++i) {
+			if (piece16[i] != Pack16(whole[x + i], 5, 5, 5)) {
+				printf("RGBA5551 at %d (from %d): %04x != %04x\n", x + i, x, piece16[i], Pack16(whole[x + i], 5, 5, 5));
+				return false;
+			}
+		}
+
+		ConvertYUV420ToRGBA4444(piece16, y, u, v, x, count);
+		for (u32 i = 0; i < count; ++i) {
+			if (piece16[i] != Pack16(whole[x + i], 4, 4, 4)) {
+				printf("RGBA4444 at %d (from %d): %04x != %04x\n", x + i, x, piece16[i], Pack16(whole[x + i], 4, 4, 4));
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+#ifdef USE_FFMPEG
+// What MediaEngine did before converting directly, except for masking out alpha.
+static bool TestAgainstSws(u8 *planes[3], int linesizes[3], u32 *dst) {
+	u32 *swsOut = new u32[WIDTH * HEIGHT];
+	SwsContext *ctx = sws_getCachedContext(NULL, WIDTH, HEIGHT, AV_PIX_FMT_YUV420P, WIDTH, HEIGHT, AV_PIX_FMT_RGBA, SWS_BILINEAR, NULL, NULL, NULL);
+	int *inv_coefficients;
+	int *coefficients;
+	int srcRange, dstRange;
+	int brightness, contrast, saturation;
+	if (sws_getColorspaceDetails(ctx, &inv_coefficients, &srcRange, &coefficients, &dstRange, &brightness, &contrast, &saturation) != -1) {
+		sws_setColorspaceDetails(ctx, inv_coefficients, 0, coefficients, 0, brightness, contrast, saturation);
+	}
+	u8 *outPlanes[1] = { (u8 *)swsOut };
+	int outLinesizes[1] = { WIDTH * 4 };
+	sws_scale(ctx, planes, linesizes, 0, HEIGHT, outPlanes, outLinesizes);
+	sws_freeContext(ctx);
+
+	bool success = true;
+	for (int i = 0; i < WIDTH * HEIGHT && success; ++i) {
+		// swscale has less precision, and may filter the chroma a bit.
+		int rgb[3] = { (int)(swsOut[i] & 0xFF), (int)((swsOut[i] >> 8) & 0xFF), (int)((swsOut[i] >> 16) & 0xFF) };
+		if (!ChannelsNear(dst[i], rgb, 6)) {
+			printf("Pixel %d,%d: %08x too far from swscale's %08x\n", i % WIDTH, i / WIDTH, dst[i], swsOut[i]);
+			success = false;
+		}
+	}
+	delete [] swsOut;
+	return success;
+}
+#endif
+
+bool TestVideoConvert() {
+	uint32_t seed = 0x601;
+	if (!TestAllColors())
+		return false;
+
+	const int chromaWidth = (WIDTH + 1) / 2;
+	const int chromaHeight = (HEIGHT + 1) / 2;
+	u8 *y = new u8[WIDTH * HEIGHT];
+	u8 *u = new u8[chromaWidth * chromaHeight];
+	u8 *v = new u8[chromaWidth * chromaHeight];
+	u32 *dst = new u32[WIDTH * HEIGHT];
+
+	bool success = true;
+	// Noise, to hit every path with every kind of value.
+	for (int i = 0; i < WIDTH * HEIGHT; ++i)
+		y[i] = NextRandom(seed) & 0xFF;
+	for (int i = 0; i < chromaWidth * chromaHeight; ++i) {
+		u[i] = NextRandom(seed) & 0xFF;
+		v[i] = NextRandom(seed) & 0xFF;
+	}
+	for (int row = 0; row < HEIGHT && success; ++row) {
+		const int c = (row / 2) * chromaWidth;
+		success = TestRowPieces(y + row * WIDTH, u + c, v + c, seed);
+	}
+
+	// Smooth gradients, more like a video and so it doesn't matter how swscale filters chroma.
+	for (int row = 0; row < HEIGHT; ++row) {
+		for (int x = 0; x < WIDTH; ++x)
+			y[row * WIDTH + x] = 16 + (x * 219) / WIDTH;
+	}
+	for (int row = 0; row < chromaHeight; ++row) {
+		for (int x = 0; x < chromaWidth; ++x) {
+			u[row * chromaWidth + x] = 16 + (x * 224) / chromaWidth;
+			v[row * chromaWidth + x] = 16 + (row * 224) / chromaHeight;
+		}
+	}
+
+	double st = real_time_now();
+	const int frames = 50;
+	for (int n = 0; n < frames; ++n) {
+		for (int row = 0; row < HEIGHT; ++row) {
+			const int c = (row / 2) * chromaWidth;
+			ConvertYUV420ToRGBA8888(dst + row * WIDTH, y + row * WIDTH, u + c, v + c, 0, WIDTH);
+		}
+	}
+	double elapsed = real_time_now() - st;
+	printf("VideoConvert RGBA8888: %.1f M pixels/s\n", frames * WIDTH * HEIGHT / elapsed / 1000000.0);
+
+#ifdef USE_FFMPEG
+	if (success) {
+		u8 *planes[3] = { y, u, v };
+		int linesizes[3] = { WIDTH, chromaWidth, chromaWidth };
+		success = TestAgainstSws(planes, linesizes, dst);
+	}
+#endif
+
+	delete [] y;
+	delete [] u;
+	delete [] v;
+	delete [] dst;
+	return success;
+}
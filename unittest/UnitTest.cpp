@@ -45,6 +45,7 @@
 #include "Core/FileSystems/ISOFileSystem.h"
 
 #include "unittest/JitHarness.h"
+#include "unittest/TestSoftwareGPUJit.h"
 #include "unittest/TestVertexJit.h"
 #include "unittest/UnitTest.h"
 
@@ -405,13 +406,25 @@ typedef bool (*TestFunc)();
 struct TestItem {
 	const char *name;
 	TestFunc func;
+	// Only run when asked for by name, not as part of "all".
+	bool benchmark;
 };
 
-#define TEST_ITEM(name) { #name, &Test ##name, }
+#define TEST_ITEM(name) { #name, &Test ##name, false, }
+#define BENCHMARK_ITEM(name) { #name "Benchmark", &Benchmark ##name, true, }
 
 bool TestArmEmitter();
 bool TestArm64Emitter();
 bool TestX64Emitter();
+bool TestIndexGenerator();
+bool BenchmarkIndexGenerator();
+bool TestSasReverb();
+bool TestVideoConvert();
+bool TestStereoResampler();
+bool TestMpegDemux();
+bool TestSasAudio();
+bool TestGEHazards();
+bool TestTessCache();
 
 TestItem availableTests[] = {
 #if defined(ARM64) || defined(_M_X64) || defined(_M_IX86)
@@ -424,6 +437,16 @@ TestItem availableTests[] = {
 	TEST_ITEM(X64Emitter),
 #endif
 	TEST_ITEM(VertexJit),
+	TEST_ITEM(SoftwareGPUJit),
+	TEST_ITEM(IndexGenerator),
+	BENCHMARK_ITEM(IndexGenerator),
+	TEST_ITEM(SasReverb),
+	TEST_ITEM(VideoConvert),
+	TEST_ITEM(StereoResampler),
+	TEST_ITEM(MpegDemux),
+	TEST_ITEM(SasAudio),
+	TEST_ITEM(GEHazards),
+	TEST_ITEM(TessCache),
 	TEST_ITEM(Asin),
 	TEST_ITEM(SinCos),
 	TEST_ITEM(VFPUSinCos),
@@ -459,6 +482,9 @@ int main(int argc, const char *argv[]) {
 		int passes = 0;
 		int fails = 0;
 		for (auto f : availableTests) {
+			if (f.benchmark) {
+				continue;
+			}
 			if (f.func()) {
 				++passes;
 			} else {